@@ -0,0 +1,27 @@
+#version 330 core
+in vec4 ourColor;
+in vec2 Local;
+flat in uint Flags;
+
+out vec4 FragColor;
+
+// 1 inside [r0, r1], anti-aliased over one pixel (aa = radii per pixel)
+float band(float r, float r0, float r1, float aa) {
+    return smoothstep(r0 - aa, r0, r) * (1.0 - smoothstep(r1, r1 + aa, r));
+}
+
+void main() {
+    float r = length(Local);
+    float aa = max(fwidth(r), 1e-4);
+    vec4 c = vec4(ourColor.rgb, ourColor.a * (1.0 - smoothstep(1.0 - aa, 1.0, r)));
+    if ((Flags & 2u) != 0u) {   // connected: green ring hugging the dot
+        float a = band(r, 1.1, 1.4, aa);
+        c = vec4(mix(c.rgb, vec3(0.3, 1.0, 0.45), a), max(c.a, a));
+    }
+    if ((Flags & 1u) != 0u) {   // selected: white outer ring
+        float a = band(r, 1.45, 1.75, aa);
+        c = vec4(mix(c.rgb, vec3(1.0), a), max(c.a, a));
+    }
+    if (c.a <= 0.0) discard;
+    FragColor = c;
+}
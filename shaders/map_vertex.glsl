@@ -0,0 +1,23 @@
+#version 330 core
+// one instance per server, expanded to a quad from gl_VertexID (triangle strip, no vertex buffer)
+layout (location = 0) in vec2 aPos;     // map units: x = 0..2 west to east, y = 0..1 north to south
+layout (location = 1) in vec4 aColor;   // latency colour
+layout (location = 2) in uint aFlags;   // 1 = selected, 2 = connected
+
+uniform mat4 ProjMtx;   // copied from the ImGui program
+uniform vec2 Origin;    // screen position of map (0,0)
+uniform float Scale;    // screen units per map unit
+uniform float Radius;   // marker radius in screen units
+
+out vec4 ourColor;
+out vec2 Local;         // offset from the marker centre, in radii
+flat out uint Flags;
+
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    float extent = aFlags != 0u ? 1.8 : 1.0;   // room for the rings
+    Local = corner * extent;
+    ourColor = aColor;
+    Flags = aFlags;
+    gl_Position = ProjMtx * vec4(Origin + aPos * Scale + Local * Radius, 0.0, 1.0);
+}
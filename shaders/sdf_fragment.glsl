@@ -0,0 +1,18 @@
+#version 330 core
+in vec2 Frag_UV;
+in vec4 Frag_Color;
+
+uniform sampler2D Texture;   // single channel distance field, 0.5 = glyph edge
+uniform float DistPerTexel;  // change of the stored distance per atlas texel
+
+out vec4 Out_Color;
+
+void main() {
+    float d = texture(Texture, Frag_UV).r;
+    // Anti-alias over one screen pixel at any size. UV is linear across the quad, so its
+    // derivative is exact everywhere (fwidth(d) would vary with the pixel quad alignment).
+    vec2 texels = fwidth(Frag_UV) * vec2(textureSize(Texture, 0));
+    float w = max(0.5 * DistPerTexel * 0.5 * (texels.x + texels.y), 1e-4);
+    float a = smoothstep(0.5 - w, 0.5 + w, d);
+    Out_Color = vec4(Frag_Color.rgb, Frag_Color.a * a);
+}
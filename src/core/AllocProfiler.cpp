@@ -0,0 +1,97 @@
+#include "AllocProfiler.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <imgui.h>
+
+namespace {
+constexpr size_t kTags = AllocFrame::kTags;
+std::atomic<uint64_t> g_allocs[kTags];
+std::atomic<uint64_t> g_bytes[kTags];
+std::atomic<uint64_t> g_frees[kTags];
+thread_local AllocTag t_tag = AllocTag::Other;
+
+inline void count(AllocTag t, size_t n) {
+    g_allocs[(size_t)t].fetch_add(1, std::memory_order_relaxed);
+    g_bytes[(size_t)t].fetch_add(n, std::memory_order_relaxed);
+}
+
+void* imguiAlloc(size_t n, void*) { count(AllocTag::ImGui, n); return std::malloc(n); }
+void imguiFree(void* p, void*) {
+    if (p) g_frees[(size_t)AllocTag::ImGui].fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+void read(AllocFrame& f) {
+    for (size_t i = 0; i < kTags; ++i) {
+        f.allocs[i] = g_allocs[i].load(std::memory_order_relaxed);
+        f.bytes[i] = g_bytes[i].load(std::memory_order_relaxed);
+        f.frees[i] = g_frees[i].load(std::memory_order_relaxed);
+    }
+}
+} // namespace
+
+AllocFrame AllocProfiler::start_;
+AllocFrame AllocProfiler::last_;
+std::array<float, AllocProfiler::kHistory> AllocProfiler::history_{};
+size_t AllocProfiler::head_ = 0;
+
+void AllocProfiler::installImGuiHooks() { ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree, nullptr); }
+
+void AllocProfiler::beginFrame() { read(start_); }
+
+const AllocFrame& AllocProfiler::endFrame() {
+    AllocFrame now;
+    read(now);
+    last_ = AllocFrame{};
+    for (size_t i = 0; i < kTags; ++i) {
+        last_.allocs[i] = now.allocs[i] - start_.allocs[i];
+        last_.bytes[i] = now.bytes[i] - start_.bytes[i];
+        last_.frees[i] = now.frees[i] - start_.frees[i];
+        if (i == (size_t)AllocTag::Other) continue;
+        last_.frameAllocs += last_.allocs[i];
+        last_.frameBytes += last_.bytes[i];
+    }
+    history_[head_] = (float)last_.frameAllocs;
+    head_ = (head_ + 1) % kHistory;
+    return last_;
+}
+
+const char* AllocProfiler::tagName(AllocTag t) {
+    static const char* names[kTags] = { "other", "ui", "imgui", "logs", "vpn", "net" };
+    return (size_t)t < kTags ? names[(size_t)t] : "?";
+}
+
+void* AllocProfiler::allocate(size_t n) {
+    count(t_tag, n);
+    return std::malloc(n ? n : 1);
+}
+
+void AllocProfiler::release(void* p) {
+    if (!p) return;
+    g_frees[(size_t)t_tag].fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+AllocScope::AllocScope(AllocTag t) : prev_(t_tag) { t_tag = t; }
+AllocScope::~AllocScope() { t_tag = prev_; }
+
+// ---------- global operator new/delete ----------
+#ifndef VPNGUI_NO_ALLOC_PROFILER
+void* operator new(size_t n) {
+    if (void* p = AllocProfiler::allocate(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n) {
+    if (void* p = AllocProfiler::allocate(n)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return AllocProfiler::allocate(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return AllocProfiler::allocate(n); }
+void operator delete(void* p) noexcept { AllocProfiler::release(p); }
+void operator delete[](void* p) noexcept { AllocProfiler::release(p); }
+void operator delete(void* p, size_t) noexcept { AllocProfiler::release(p); }
+void operator delete[](void* p, size_t) noexcept { AllocProfiler::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { AllocProfiler::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { AllocProfiler::release(p); }
+#endif
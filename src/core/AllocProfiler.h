@@ -0,0 +1,51 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// --------- heap allocation profiler ----------
+// Replaces global operator new/delete and hooks ImGui's allocator so every allocation is counted
+// against the calling thread's current tag. The UI thread tags its work with AllocScope; background
+// threads stay on Other, so "what did this frame allocate" is the sum of all tags but Other.
+// Define VPNGUI_NO_ALLOC_PROFILER to compile the operator replacements out.
+
+enum class AllocTag : uint8_t { Other, Ui, ImGui, Logs, Vpn, Net, Count };
+
+struct AllocFrame {
+    static constexpr size_t kTags = (size_t)AllocTag::Count;
+    std::array<uint64_t, kTags> allocs{}, bytes{}, frees{};
+    uint64_t frameAllocs{ 0 }, frameBytes{ 0 };   // UI thread: everything except Other
+};
+
+class AllocProfiler {
+public:
+    static constexpr size_t kHistory = 240;
+
+    static void installImGuiHooks();           // before ImGui::CreateContext()
+    static void beginFrame();
+    static const AllocFrame& endFrame();
+    static const AllocFrame& last() { return last_; }
+    static const float* history() { return history_.data(); }   // frameAllocs ring, oldest at historyHead()
+    static size_t historyHead() { return head_; }
+    static const char* tagName(AllocTag t);
+
+    static void* allocate(size_t n);           // used by the operator new replacements
+    static void release(void* p);
+
+private:
+    static AllocFrame start_, last_;
+    static std::array<float, kHistory> history_;
+    static size_t head_;
+};
+
+// Tags allocations made on this thread until the scope ends
+class AllocScope {
+public:
+    explicit AllocScope(AllocTag t);
+    ~AllocScope();
+    AllocScope(const AllocScope&) = delete;
+    AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+    AllocTag prev_;
+};
@@ -0,0 +1,81 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+FrameArena::FrameArena(size_t blockBytes) {
+    blocks_.reserve(8);
+    grow(blockBytes);
+}
+
+FrameArena::~FrameArena() {
+    for (auto& b : blocks_) std::free(b.data);
+}
+
+void FrameArena::grow(size_t minBytes) {
+    size_t size = std::max<size_t>(minBytes, blocks_.empty() ? 0 : blocks_.back().size * 2);
+    char* p = static_cast<char*>(std::malloc(size));
+    if (!p) throw std::bad_alloc();
+    blocks_.push_back({ p, size });
+    off_ = 0;
+}
+
+char* FrameArena::bump(size_t n, size_t align) {
+    const Block& b = blocks_.back();
+    uintptr_t base = (uintptr_t)b.data;
+    size_t start = (size_t)((base + off_ + align - 1) & ~(uintptr_t)(align - 1)) - base;
+    if (start + n > b.size) {
+        grow(n + align);
+        return bump(n, align);
+    }
+    off_ = start + n;
+    used_ += n;
+    highWater_ = std::max(highWater_, used_);
+    return blocks_.back().data + start;
+}
+
+void* FrameArena::alloc(size_t n, size_t align) { return bump(n ? n : 1, align); }
+
+std::string_view FrameArena::copy(std::string_view s) {
+    char* p = bump(s.size() + 1, 1);
+    std::memcpy(p, s.data(), s.size());
+    p[s.size()] = '\0';
+    return std::string_view(p, s.size());
+}
+
+std::string_view FrameArena::format(const char* fmt, ...) {
+    // try to print straight into what is left of the block; only re-run when it didn't fit
+    const Block& b = blocks_.back();
+    size_t room = b.size - off_;
+    va_list args, again;
+    va_start(args, fmt);
+    va_copy(again, args);
+    int n = std::vsnprintf(b.data + off_, room, fmt, args);
+    va_end(args);
+    if (n < 0) { va_end(again); return {}; }
+    char* p = bump((size_t)n + 1, 1);   // same address as the first attempt when it fit
+    if ((size_t)n >= room) std::vsnprintf(p, (size_t)n + 1, fmt, again);
+    va_end(again);
+    return std::string_view(p, (size_t)n);
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const auto& b : blocks_) total += b.size;
+    return total;
+}
+
+void FrameArena::reset() {
+    if (blocks_.size() > 1) {
+        size_t total = capacity();
+        for (auto& b : blocks_) std::free(b.data);
+        blocks_.clear();
+        grow(total);
+    }
+    off_ = 0;
+    used_ = 0;
+}
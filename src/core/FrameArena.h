@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// --------- per-frame bump allocator ----------
+// Transient UI data (formatted labels, search scratch) is carved out of one block and released all
+// at once by reset() at the start of the next frame. A frame that outgrows the block spills into
+// extra blocks; reset() then folds them into a single larger block, so after warm-up a frame costs
+// no heap allocations at all. Nothing allocated here survives reset(): never store the pointers.
+class FrameArena {
+public:
+    explicit FrameArena(size_t blockBytes = 256u << 10);
+    ~FrameArena();
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* alloc(size_t n, size_t align = alignof(std::max_align_t));
+    template <class T> T* allocArray(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "arena memory is never destructed");
+        T* p = static_cast<T*>(alloc(n * sizeof(T), alignof(T)));
+        for (size_t i = 0; i < n; ++i) new (p + i) T();
+        return p;
+    }
+    std::string_view copy(std::string_view s);
+    std::string_view format(const char* fmt, ...);   // printf into the arena; result is NUL-terminated
+
+    void reset();
+    size_t used() const { return used_; }
+    size_t capacity() const;
+    size_t highWater() const { return highWater_; }
+
+private:
+    struct Block { char* data; size_t size; };
+    char* bump(size_t n, size_t align);
+    void grow(size_t minBytes);
+
+    std::vector<Block> blocks_;   // blocks_.back() is the one being filled
+    size_t off_{ 0 };             // offset into blocks_.back()
+    size_t used_{ 0 }, highWater_{ 0 };
+};
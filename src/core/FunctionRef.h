@@ -0,0 +1,29 @@
+#pragma once
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// --------- non-owning callable reference ----------
+// Two pointers, never allocates: use for callbacks that are only invoked during the call they
+// are passed to (e.g. UI button handlers). The referenced callable must outlive the FunctionRef.
+template <class Sig> class FunctionRef;
+
+template <class R, class... Args>
+class FunctionRef<R(Args...)> {
+public:
+    FunctionRef() = default;
+
+    template <class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, FunctionRef>::value>>
+    FunctionRef(F&& f) noexcept
+        : obj_((void*)std::addressof(f)),
+          call_([](void* obj, Args... args) -> R {
+              return (*static_cast<std::add_pointer_t<std::remove_reference_t<F>>>(obj))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call_(obj_, std::forward<Args>(args)...); }
+    explicit operator bool() const { return call_ != nullptr; }
+
+private:
+    void* obj_{ nullptr };
+    R (*call_)(void*, Args...){ nullptr };
+};
@@ -0,0 +1,279 @@
+#include "FuzzyIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FUZZY_SSE2 1
+#endif
+
+static constexpr int kNoMatch = INT_MIN;
+static constexpr size_t kMaxWord = 64;   // longer words are cut; nobody types more than that
+
+static char lower(char c) { return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c; }
+static bool isWordChar(char c) { return (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || (unsigned char)c >= 0x80; }
+
+// Scores one query word as a subsequence of s: the earliest end found by a forward pass, then the
+// shortest window ending there by a backward pass, scored greedily inside that window. Matches at
+// word starts and runs of consecutive characters score higher, skipped characters cost a little.
+// A one-character word takes its best occurrence (name start, else a word start, else the first).
+// pos (optional) receives the byte offset of every matched character.
+static int scoreWord(const char* s, size_t n, std::string_view w, uint16_t* pos) {
+    if (w.size() == 1) {
+        size_t best = n;
+        for (size_t i = 0; i < n; ++i) {
+            if (s[i] != w[0]) continue;
+            if (best == n) best = i;
+            if (i == 0 || !isWordChar(s[i - 1])) { best = i; break; }
+        }
+        if (best == n) return kNoMatch;
+        if (pos) pos[0] = (uint16_t)best;
+        return 16 + (best == 0 ? 8 : 0) + (best == 0 || !isWordChar(s[best - 1]) ? 10 : 0);
+    }
+    // forward: jump from character to character with memchr (vectorized in every CRT)
+    const char* p = s;
+    const char* const e = s + n;
+    for (char c : w) {
+        p = static_cast<const char*>(memchr(p, c, e - p));
+        if (!p) return kNoMatch;
+        ++p;
+    }
+    const size_t end = p - s;
+    size_t j = w.size(), start = end;
+    for (size_t i = end; i-- > 0;)
+        if (s[i] == w[j - 1] && --j == 0) { start = i; break; }
+
+    int score = start == 0 ? 8 : 0;
+    bool prev = false;
+    j = 0;
+    for (size_t i = start; i < end && j < w.size(); ++i) {
+        if (s[i] != w[j]) { score -= prev ? 3 : 1; prev = false; continue; }
+        int b = 16;
+        if (i == 0 || !isWordChar(s[i - 1])) b += 10;   // "tok" in "jp-tok"
+        else if (prev) b += 8;                          // consecutive run
+        score += b;
+        prev = true;
+        if (pos) pos[j] = (uint16_t)i;
+        ++j;
+    }
+    return score;
+}
+
+void FuzzyIndex::clear() {
+    text_.clear(); orig_.clear(); off_.clear(); len_.clear(); first_.clear(); mask_.clear(); startMask_.clear();
+    query_.clear(); words_.clear(); level_.clear(); top_.clear();
+    job_.active = false;
+}
+
+void FuzzyIndex::reserve(size_t names, size_t textBytes) {
+    text_.reserve(textBytes); orig_.reserve(textBytes);
+    off_.reserve(names); len_.reserve(names); first_.reserve(names); mask_.reserve(names); startMask_.reserve(names);
+}
+
+uint32_t FuzzyIndex::add(std::string_view name) {
+    name = name.substr(0, 0xFFFF);
+    const uint32_t i = (uint32_t)off_.size();
+    const size_t at = text_.size();
+    off_.push_back((uint32_t)at);
+    len_.push_back((uint16_t)name.size());
+    orig_.insert(orig_.end(), name.begin(), name.end());
+    uint32_t starts = 0;
+    for (size_t k = 0; k < name.size(); ++k) {
+        const char c = lower(name[k]);
+        text_.push_back(c);
+        if (c >= 'a' && c <= 'z' && (k == 0 || !isWordChar(text_[at + k - 1]))) starts |= 1u << (c - 'a');
+    }
+    first_.push_back(name.empty() ? 0 : text_[at]);
+    mask_.push_back(maskOf(std::string_view(text_.data() + at, name.size())));
+    startMask_.push_back(starts);
+    level_.clear();   // stored result sets no longer cover every name
+    job_.active = false;
+    return i;
+}
+
+// bits 0..25 = a..z, 26..31 = digits folded mod 6; other bytes are not prefiltered
+uint32_t FuzzyIndex::maskOf(std::string_view lower) {
+    uint32_t m = 0;
+    for (char c : lower) {
+        if (c >= 'a' && c <= 'z') m |= 1u << (c - 'a');
+        else if (c >= '0' && c <= '9') m |= 1u << (26 + (c - '0') % 6);
+    }
+    return m;
+}
+
+// Caller has checked mask_[i] against the query mask, so one-letter words are known to be present
+bool FuzzyIndex::score(uint32_t i, int& total) const {
+    total = 0;
+    for (std::string_view w : words_) {
+        const char c = w[0];
+        if (w.size() == 1 && c >= 'a' && c <= 'z') {   // same result as scoreWord, without the text
+            total += first_[i] == c ? 34 : (startMask_[i] >> (c - 'a')) & 1 ? 26 : 16;
+            continue;
+        }
+        int sc = scoreWord(text_.data() + off_[i], len_[i], w, nullptr);
+        if (sc == kNoMatch) return false;
+        total += sc;
+    }
+    return true;
+}
+
+void FuzzyIndex::scanAll(size_t from, size_t to) {
+    std::vector<Hit>& out = job_.out.matches;
+    const uint32_t qmask = job_.qmask;
+    uint32_t i = (uint32_t)from;
+    int sc = 0;
+#ifdef FUZZY_SSE2
+    const __m128i q = _mm_set1_epi32((int)qmask);
+    for (; i + 4 <= to; i += 4) {
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask_.data() + i));
+        const int pass = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(m, q), q)));
+        if (!pass) continue;
+        for (uint32_t k = 0; k < 4; ++k)
+            if ((pass >> k) & 1 && score(i + k, sc)) out.push_back({ i + k, sc });
+    }
+#endif
+    for (; i < to; ++i)
+        if ((mask_[i] & qmask) == qmask && score(i, sc)) out.push_back({ i, sc });
+}
+
+void FuzzyIndex::run(double budgetUs) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::micro>(budgetUs));
+    constexpr size_t kChunk = 1024;   // names between clock checks
+    std::vector<Hit>& out = job_.out.matches;
+    const size_t before = out.size();
+    size_t& c = job_.cursor;
+    int sc = 0;
+    if (job_.refine) {   // only the previous matches can still match
+        const std::vector<Hit>& base = level_.back().matches;
+        while (c < base.size()) {
+            const size_t end = std::min(c + kChunk, base.size());
+            for (; c < end; ++c) {
+                const uint32_t i = base[c].index;
+                if ((mask_[i] & job_.qmask) == job_.qmask && score(i, sc)) out.push_back({ i, sc });
+            }
+            if (clock::now() >= deadline) break;
+        }
+        scanned_ = c;
+    }
+    else {
+        while (c < size()) {
+            const size_t end = std::min(c + kChunk, size());
+            scanAll(c, end);
+            c = end;
+            if (clock::now() >= deadline) break;
+        }
+        scanned_ = c;
+    }
+    merge(out.data() + before, out.data() + out.size());
+    if (c < (job_.refine ? level_.back().matches.size() : size())) return;
+
+    job_.active = false;
+    if (level_.size() == kMaxLevels) {   // forget the broadest set; its query is the shortest prefix
+        spare_.push_back(std::move(level_.front()));
+        level_.erase(level_.begin());
+    }
+    level_.push_back(std::move(job_.out));
+}
+
+// best score first; among equals the shorter name, then list order
+bool FuzzyIndex::better(const Hit& a, const Hit& b) const {
+    if (a.score != b.score) return a.score > b.score;
+    if (len_[a.index] != len_[b.index]) return len_[a.index] < len_[b.index];
+    return a.index < b.index;
+}
+
+void FuzzyIndex::rank(const std::vector<Hit>& all) {
+    top_.resize(std::min(limit_, all.size()));
+    std::partial_sort_copy(all.begin(), all.end(), top_.begin(), top_.end(),
+                           [this](const Hit& a, const Hit& b) { return better(a, b); });
+}
+
+// Folds the hits of one scan step into top_, so a partial scan costs only its new hits
+void FuzzyIndex::merge(const Hit* b, const Hit* e) {
+    if (b == e) return;
+    scratch_.assign(top_.begin(), top_.end());
+    scratch_.insert(scratch_.end(), b, e);
+    top_.resize(std::min(limit_, scratch_.size()));
+    std::partial_sort_copy(scratch_.begin(), scratch_.end(), top_.begin(), top_.end(),
+                           [this](const Hit& x, const Hit& y) { return better(x, y); });
+}
+
+size_t FuzzyIndex::matchCount() const {
+    if (job_.active) return job_.out.matches.size();
+    if (query_.empty()) return size();
+    return level_.empty() ? 0 : level_.back().matches.size();
+}
+
+bool FuzzyIndex::search(std::string_view query, double budgetUs, size_t limit) {
+    limit_ = limit;
+    // normalize: lowercase, words separated by single spaces, no leading/trailing space
+    query_.clear();
+    words_.clear();
+    for (char c : query) {
+        c = lower(c);
+        if (c == ' ' || c == '\t') { if (!query_.empty() && query_.back() != ' ') query_.push_back(' '); }
+        else query_.push_back(c);
+    }
+    if (!query_.empty() && query_.back() == ' ') query_.pop_back();
+    for (size_t p = 0; p < query_.size();) {
+        size_t e = query_.find(' ', p);
+        if (e == std::string::npos) e = query_.size();
+        words_.push_back(std::string_view(query_).substr(p, std::min(e - p, kMaxWord)));
+        p = e + 1;
+    }
+
+    if (job_.active) {
+        if (job_.out.query == query_) return resume(budgetUs);   // same query (e.g. a trailing space)
+        job_.active = false;                                      // superseded: its partial set is useless
+        spare_.push_back(std::move(job_.out));
+    }
+    // drop stored sets that the new query does not refine (backspace, edits in the middle)
+    while (!level_.empty() && query_.compare(0, level_.back().query.size(), level_.back().query) != 0) {
+        spare_.push_back(std::move(level_.back()));
+        level_.pop_back();
+    }
+    if (query_.empty()) {   // everything, in list order
+        scanned_ = 0;
+        top_.resize(std::min(limit, size()));
+        for (size_t i = 0; i < top_.size(); ++i) top_[i] = { (uint32_t)i, 0 };
+        return true;
+    }
+    if (!level_.empty() && level_.back().query == query_) { scanned_ = 0; rank(level_.back().matches); return true; }
+
+    if (!spare_.empty()) { job_.out = std::move(spare_.back()); spare_.pop_back(); }
+    job_.out.query = query_;
+    job_.out.matches.clear();
+    job_.refine = !level_.empty();
+    job_.cursor = 0;
+    job_.qmask = maskOf(query_);
+    job_.active = true;
+    top_.clear();
+    run(budgetUs);
+    return !job_.active;
+}
+
+bool FuzzyIndex::resume(double budgetUs) {
+    if (job_.active) run(budgetUs);
+    return !job_.active;
+}
+
+void FuzzyIndex::highlights(uint32_t i, std::vector<Range>& out) const {
+    out.clear();
+    uint16_t pos[kMaxWord];
+    for (std::string_view w : words_) {
+        if (scoreWord(text_.data() + off_[i], len_[i], w, pos) == kNoMatch) continue;
+        for (size_t k = 0; k < w.size(); ++k) out.push_back({ pos[k], 1 });
+    }
+    std::sort(out.begin(), out.end(), [](const Range& a, const Range& b) { return a.start < b.start; });
+    size_t m = 0;
+    for (const Range& r : out) {
+        if (m && out[m - 1].start + out[m - 1].len >= r.start) {
+            const int end = std::max(out[m - 1].start + out[m - 1].len, r.start + r.len);
+            out[m - 1].len = (uint16_t)(end - out[m - 1].start);
+        }
+        else out[m++] = r;
+    }
+    out.resize(m);
+}
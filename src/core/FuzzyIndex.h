@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// --------- type-ahead fuzzy finder ----------
+// Names are stored structure-of-arrays: one contiguous lowercase text buffer, offsets, lengths, the
+// first byte and two 32-bit masks per name ("letters present", "letters that start a word"). A query
+// first drops every name whose mask lacks one of the query's letters (four names per SSE2 compare on
+// a full scan), then the survivors are scored as fzf-style subsequence matches. One-letter words are
+// scored from the masks alone, so a first keystroke never reads the text. Space-separated query
+// words must all match, in any order.
+// Each finished result set is kept on a small stack: a query that extends the previous one ("jp-t" ->
+// "jp-to") only re-checks the previous matches, and backspacing returns to a stored set. Scans are
+// budgeted: search() returns after budgetUs with the best hits so far, resume() continues next frame.
+class FuzzyIndex {
+public:
+    struct Hit {
+        uint32_t index{ 0 };   // add() order
+        int score{ 0 };
+    };
+    struct Range {
+        uint16_t start{ 0 }, len{ 0 };   // byte range of the name
+    };
+
+    void clear();
+    void reserve(size_t names, size_t textBytes);
+    uint32_t add(std::string_view name);   // keeps the original spelling for display
+    size_t size() const { return off_.size(); }
+    std::string_view name(uint32_t i) const { return std::string_view(orig_.data() + off_[i], len_[i]); }
+
+    // Starts `query` (ASCII case-insensitive); true when the scan finished within budgetUs.
+    // results() holds the best `limit` hits found so far, best first.
+    bool search(std::string_view query, double budgetUs = 1000, size_t limit = 200);
+    bool resume(double budgetUs = 1000);   // continues an unfinished scan; true when done
+    bool pending() const { return job_.active; }
+    const std::vector<Hit>& results() const { return top_; }
+    size_t matchCount() const;
+    size_t scanned() const { return scanned_; }   // names the current query has looked at
+    // matched bytes of name i for the current query, merged into ranges for highlighting
+    void highlights(uint32_t i, std::vector<Range>& out) const;
+
+private:
+    struct Level {
+        std::string query;              // normalized: lowercase, single spaces, no leading space
+        std::vector<Hit> matches;       // every name that matches, in index order
+    };
+    struct Job {
+        bool active{ false };
+        bool refine{ false };           // scanning level_.back().matches instead of every name
+        size_t cursor{ 0 };
+        uint32_t qmask{ 0 };
+        Level out;
+    };
+    static constexpr size_t kMaxLevels = 32;
+
+    static uint32_t maskOf(std::string_view lower);
+    bool score(uint32_t i, int& total) const;
+    void scanAll(size_t from, size_t to);
+    void run(double budgetUs);
+    bool better(const Hit& a, const Hit& b) const;
+    void rank(const std::vector<Hit>& all);
+    void merge(const Hit* b, const Hit* e);
+
+    std::vector<char> text_, orig_;     // lowercase / original bytes, names back to back
+    std::vector<uint32_t> off_;
+    std::vector<uint16_t> len_;
+    std::vector<char> first_;           // text_[off_[i]], 0 for an empty name
+    std::vector<uint32_t> mask_, startMask_;
+
+    std::string query_;                 // current normalized query
+    std::vector<std::string_view> words_;   // into query_
+    std::vector<Level> level_;          // finished result sets of successive refinements
+    std::vector<Level> spare_;          // popped levels, storage reused
+    Job job_;
+    size_t limit_{ 200 };
+    std::vector<Hit> top_, scratch_;
+    size_t scanned_{ 0 };
+};
@@ -0,0 +1,144 @@
+#include "Gzip.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+const uint16_t kLenBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99,
+    115, 131, 163, 195, 227, 258 };
+const uint8_t kLenExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025,
+    1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12,
+    12, 13, 13 };
+
+const std::array<uint32_t, 256>& crcTable() {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+} // namespace
+
+GzipEncoder::GzipEncoder() : head_((size_t)1 << kHashBits, -1), prev_(kWindow + kBlock, -1) {
+    buf_.reserve(kWindow + kBlock);
+}
+
+void GzipEncoder::putBits(uint32_t bits, int n, std::string& out) {
+    bitBuf_ |= (uint64_t)bits << bitCount_;
+    bitCount_ += n;
+    while (bitCount_ >= 8) {
+        out.push_back((char)(bitBuf_ & 0xFF));
+        bitBuf_ >>= 8;
+        bitCount_ -= 8;
+    }
+}
+
+void GzipEncoder::putCode(uint32_t code, int len, std::string& out) {
+    uint32_t rev = 0;
+    for (int i = 0; i < len; ++i) rev |= ((code >> i) & 1u) << (len - 1 - i);
+    putBits(rev, len, out);
+}
+
+void GzipEncoder::literal(uint8_t c, std::string& out) {
+    if (c < 144) putCode(0x30u + c, 8, out);
+    else putCode(0x190u + (c - 144u), 9, out);
+}
+
+void GzipEncoder::match(size_t len, size_t dist, std::string& out) {
+    int li = 28;
+    while (kLenBase[li] > len) --li;
+    uint32_t sym = 257 + li;
+    if (sym < 280) putCode(sym - 256, 7, out); else putCode(0xC0u + (sym - 280), 8, out);
+    putBits((uint32_t)(len - kLenBase[li]), kLenExtra[li], out);
+    int di = 29;
+    while (kDistBase[di] > dist) --di;
+    putCode((uint32_t)di, 5, out);
+    putBits((uint32_t)(dist - kDistBase[di]), kDistExtra[di], out);
+}
+
+uint32_t GzipEncoder::hashAt(size_t pos) const {
+    return ((uint32_t)buf_[pos] << 10 ^ (uint32_t)buf_[pos + 1] << 5 ^ buf_[pos + 2]) & ((1u << kHashBits) - 1);
+}
+
+void GzipEncoder::insert(size_t pos) {
+    uint32_t h = hashAt(pos);
+    prev_[pos] = head_[h];
+    head_[h] = (int32_t)pos;
+}
+
+void GzipEncoder::write(const void* data, size_t len, std::string& out) {
+    if (!headerDone_) {
+        static const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+        out.append(header, sizeof(header));
+        headerDone_ = true;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    const auto& table = crcTable();
+    for (size_t i = 0; i < len; ++i) crc_ = table[(crc_ ^ p[i]) & 0xFF] ^ (crc_ >> 8);
+    total_ += (uint32_t)len;
+    while (len) {
+        size_t take = std::min(len, hist_ + kBlock - buf_.size());
+        buf_.insert(buf_.end(), p, p + take);
+        p += take;
+        len -= take;
+        if (buf_.size() - hist_ == kBlock) compress(false, out);
+    }
+}
+
+void GzipEncoder::compress(bool final, std::string& out) {
+    putBits(final ? 1 : 0, 1, out);
+    putBits(1, 2, out);   // BTYPE 01: fixed Huffman codes
+    const size_t end = buf_.size();
+    for (size_t pos = hist_; pos < end;) {
+        size_t bestLen = 0, bestDist = 0;
+        if (pos + 2 < end) {
+            const size_t maxLen = std::min<size_t>(258, end - pos);
+            int32_t cand = head_[hashAt(pos)];
+            for (int chain = 0; cand >= 0 && chain < kMaxChain; ++chain) {
+                size_t dist = pos - (size_t)cand;
+                if (dist > kWindow) break;
+                if (buf_[cand + bestLen] == buf_[pos + bestLen]) {
+                    size_t l = 0;
+                    while (l < maxLen && buf_[cand + l] == buf_[pos + l]) ++l;
+                    if (l > bestLen) { bestLen = l; bestDist = dist; if (l == maxLen) break; }
+                }
+                cand = prev_[cand];
+            }
+            insert(pos);
+        }
+        if (bestLen >= 3) {
+            match(bestLen, bestDist, out);
+            for (size_t k = 1; k < bestLen; ++k) if (pos + k + 2 < end) insert(pos + k);
+            pos += bestLen;
+        }
+        else {
+            literal(buf_[pos], out);
+            ++pos;
+        }
+    }
+    putCode(0, 7, out);   // end of block
+
+    // keep the last 32 KB as history and re-hash it at its new offsets
+    size_t keep = std::min(kWindow, end);
+    std::memmove(buf_.data(), buf_.data() + end - keep, keep);
+    buf_.resize(keep);
+    hist_ = keep;
+    std::fill(head_.begin(), head_.end(), -1);
+    for (size_t i = 0; i + 2 < keep; ++i) insert(i);
+}
+
+void GzipEncoder::finish(std::string& out) {
+    write(nullptr, 0, out);   // header, if nothing was written yet
+    compress(true, out);
+    if (bitCount_ > 0) putBits(0, 8 - bitCount_, out);
+    uint32_t crc = crc_ ^ 0xFFFFFFFFu;
+    for (int i = 0; i < 4; ++i) out.push_back((char)((crc >> (8 * i)) & 0xFF));
+    for (int i = 0; i < 4; ++i) out.push_back((char)((total_ >> (8 * i)) & 0xFF));
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --------- streaming gzip encoder ----------
+// Self-contained DEFLATE (RFC 1951) with fixed Huffman codes and hash-chain LZ77 over a 32 KB
+// window, wrapped as gzip (RFC 1952) so any gunzip/7-Zip reads the output. Fixed codes keep it
+// small and fast; repetitive text like logs still compresses several-fold.
+class GzipEncoder {
+public:
+    GzipEncoder();
+    void write(const void* data, size_t len, std::string& out);   // appends compressed bytes to out
+    void finish(std::string& out);                                // final block + trailer; encoder is done
+
+private:
+    static constexpr size_t kWindow = 32768;
+    static constexpr size_t kBlock = 65536;       // new input compressed per deflate block
+    static constexpr int kHashBits = 15;
+    static constexpr int kMaxChain = 32;
+
+    void compress(bool final, std::string& out);
+    void putBits(uint32_t bits, int n, std::string& out);
+    void putCode(uint32_t code, int len, std::string& out);   // Huffman codes go MSB first
+    void literal(uint8_t c, std::string& out);
+    void match(size_t len, size_t dist, std::string& out);
+    uint32_t hashAt(size_t pos) const;
+    void insert(size_t pos);
+
+    std::vector<uint8_t> buf_;     // [0, hist_) history, [hist_, size) pending input
+    size_t hist_{ 0 };
+    std::vector<int32_t> head_, prev_;
+    uint64_t bitBuf_{ 0 };
+    int bitCount_{ 0 };
+    uint32_t crc_{ 0xFFFFFFFFu };
+    uint32_t total_{ 0 };
+    bool headerDone_{ false };
+};
@@ -0,0 +1,61 @@
+#include "HdrHistogram.h"
+#include <algorithm>
+#include <cmath>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static inline int floorLog2(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0; _BitScanReverse64(&idx, v); return (int)idx;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+HdrHistogram::HdrHistogram(uint64_t maxValue) : maxValue_(std::max<uint64_t>(maxValue, kSubCount)) {
+    counts_.assign(indexOf(maxValue_) + 1, 0);
+}
+
+size_t HdrHistogram::indexOf(uint64_t v) const {
+    if (v > maxValue_) v = maxValue_;
+    int bucket = floorLog2(v | (kSubCount - 1)) - kSubHalfMag;
+    uint64_t sub = v >> bucket;
+    return ((size_t)bucket << kSubHalfMag) + (size_t)sub;
+}
+
+uint64_t HdrHistogram::highestEquivalent(size_t index) const {
+    int bucket = (int)(index >> kSubHalfMag) - 1;
+    if (bucket < 0) bucket = 0;
+    uint64_t sub = index - ((size_t)bucket << kSubHalfMag);
+    return (sub << bucket) + ((1ull << bucket) - 1);
+}
+
+void HdrHistogram::record(uint64_t v) { ++counts_[indexOf(v)]; ++total_; }
+
+void HdrHistogram::remove(uint64_t v) {
+    uint32_t& c = counts_[indexOf(v)];
+    if (c) { --c; --total_; }
+}
+
+void HdrHistogram::reset() { std::fill(counts_.begin(), counts_.end(), 0u); total_ = 0; }
+
+void HdrHistogram::merge(const HdrHistogram& other) {
+    size_t n = std::min(counts_.size(), other.counts_.size());
+    for (size_t i = 0; i < n; ++i) counts_[i] += other.counts_[i];
+    for (size_t i = n; i < other.counts_.size(); ++i) counts_.back() += other.counts_[i];
+    total_ += other.total_;
+}
+
+uint64_t HdrHistogram::percentile(double p) const {
+    if (!total_) return 0;
+    p = std::clamp(p, 0.0, 100.0);
+    uint64_t target = (uint64_t)std::ceil(p / 100.0 * (double)total_);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= target) return std::min(highestEquivalent(i), maxValue_);
+    }
+    return maxValue_;
+}
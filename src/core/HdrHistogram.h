@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --------- HDR histogram (log-linear buckets, ~1% precision) ----------
+// Values are unsigned integers in whatever unit the caller picks (we use microseconds).
+// Every power-of-two range is split into 128 linear sub-buckets, so the relative error is
+// below 1/128 across the whole range while the counts array stays a few KB.
+// record()/remove() are O(1); percentile() walks the counts once.
+class HdrHistogram {
+public:
+    explicit HdrHistogram(uint64_t maxValue = 60ull * 1000 * 1000);
+
+    void record(uint64_t v);
+    void remove(uint64_t v);       // undo a previous record() (rolling windows)
+    void reset();
+    void merge(const HdrHistogram& other);
+
+    uint64_t count() const { return total_; }
+    uint64_t percentile(double p) const;  // p in [0,100]; 0 if empty
+    uint64_t min() const { return percentile(0.0); }
+    uint64_t max() const { return percentile(100.0); }
+
+private:
+    static constexpr int kSubHalfMag = 7;                  // 128 sub-buckets per half
+    static constexpr uint64_t kSubCount = 1ull << (kSubHalfMag + 1);
+    static constexpr uint64_t kSubHalf = 1ull << kSubHalfMag;
+
+    size_t indexOf(uint64_t v) const;
+    uint64_t highestEquivalent(size_t index) const;
+
+    uint64_t maxValue_;
+    uint64_t total_{ 0 };
+    std::vector<uint32_t> counts_;
+};
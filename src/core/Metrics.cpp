@@ -0,0 +1,105 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+MetricsRegistry::Slot MetricsRegistry::sink_;
+
+static uint64_t bitsOf(double v) { uint64_t b; std::memcpy(&b, &v, sizeof(b)); return b; }
+static double doubleOf(uint64_t b) { double v; std::memcpy(&v, &b, sizeof(v)); return v; }
+
+void MetricsRegistry::Gauge::set(double v) const { s_->v[0].store(bitsOf(v), std::memory_order_relaxed); }
+
+void MetricsRegistry::Histogram::observe(double v) const {
+    uint32_t i = 0;
+    while (i < s_->buckets && v > s_->bounds[i]) ++i;   // i == buckets: only +Inf holds it
+    s_->v[i].fetch_add(1, std::memory_order_relaxed);
+    std::atomic<uint64_t>& sum = s_->v[s_->buckets + 1];
+    uint64_t old = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(old, bitsOf(doubleOf(old) + v), std::memory_order_relaxed)) {}
+}
+
+MetricsRegistry::Slot* MetricsRegistry::claim(Kind kind, const char* name, const char* help, const char* labels) {
+    const size_t i = count_.fetch_add(1, std::memory_order_relaxed);
+    if (i >= kMaxMetrics) return &sink_;
+    Slot& s = slots_[i];
+    s.kind = kind;
+    s.name = name;
+    s.help = help;
+    s.labels = labels;
+    return &s;
+}
+
+MetricsRegistry::Counter MetricsRegistry::counter(const char* name, const char* help, const char* labels) {
+    Counter c;
+    c.s_ = claim(kCounter, name, help, labels);
+    if (c.s_ != &sink_) c.s_->ready.store(true, std::memory_order_release);
+    return c;
+}
+
+MetricsRegistry::Gauge MetricsRegistry::gauge(const char* name, const char* help, const char* labels) {
+    Gauge g;
+    g.s_ = claim(kGauge, name, help, labels);
+    if (g.s_ != &sink_) g.s_->ready.store(true, std::memory_order_release);
+    return g;
+}
+
+MetricsRegistry::Histogram MetricsRegistry::histogram(const char* name, const char* help, std::initializer_list<double> bounds,
+    const char* labels) {
+    Histogram h;
+    h.s_ = claim(kHistogram, name, help, labels);
+    if (h.s_ == &sink_) return h;
+    h.s_->buckets = (uint32_t)std::min(bounds.size(), kMaxBuckets);
+    std::copy(bounds.begin(), bounds.begin() + h.s_->buckets, h.s_->bounds);
+    h.s_->ready.store(true, std::memory_order_release);
+    return h;
+}
+
+void MetricsRegistry::render(std::string& out) const {
+    static const char* const kTypes[] = { "counter", "gauge", "histogram" };
+    out.clear();
+    char buf[512];
+    const char* prev = nullptr;
+    const size_t n = std::min(count_.load(std::memory_order_acquire), kMaxMetrics);
+    for (size_t i = 0; i < n; ++i) {
+        const Slot& s = slots_[i];
+        if (!s.ready.load(std::memory_order_acquire)) continue;   // claimed, still being filled in
+        if (!prev || std::strcmp(prev, s.name) != 0) {
+            std::snprintf(buf, sizeof(buf), "# HELP %s %s\n# TYPE %s %s\n", s.name, s.help, s.name, kTypes[s.kind]);
+            out += buf;
+            prev = s.name;
+        }
+        const char* open = *s.labels ? "{" : "";
+        const char* close = *s.labels ? "}" : "";
+        if (s.kind == kCounter) {
+            std::snprintf(buf, sizeof(buf), "%s%s%s%s %llu\n", s.name, open, s.labels, close,
+                (unsigned long long)s.v[0].load(std::memory_order_relaxed));
+            out += buf;
+        }
+        else if (s.kind == kGauge) {
+            std::snprintf(buf, sizeof(buf), "%s%s%s%s %.9g\n", s.name, open, s.labels, close,
+                doubleOf(s.v[0].load(std::memory_order_relaxed)));
+            out += buf;
+        }
+        else {
+            const char* sep = *s.labels ? "," : "";
+            uint64_t cumulative = 0;
+            for (uint32_t b = 0; b <= s.buckets; ++b) {
+                cumulative += s.v[b].load(std::memory_order_relaxed);
+                if (b < s.buckets) {
+                    std::snprintf(buf, sizeof(buf), "%s_bucket{%s%sle=\"%.9g\"} %llu\n", s.name, s.labels, sep, s.bounds[b],
+                        (unsigned long long)cumulative);
+                }
+                else {
+                    std::snprintf(buf, sizeof(buf), "%s_bucket{%s%sle=\"+Inf\"} %llu\n", s.name, s.labels, sep,
+                        (unsigned long long)cumulative);
+                }
+                out += buf;
+            }
+            std::snprintf(buf, sizeof(buf), "%s_sum%s%s%s %.9g\n%s_count%s%s%s %llu\n", s.name, open, s.labels, close,
+                doubleOf(s.v[s.buckets + 1].load(std::memory_order_relaxed)), s.name, open, s.labels, close,
+                (unsigned long long)cumulative);
+            out += buf;
+        }
+    }
+}
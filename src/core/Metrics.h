@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+
+// --------- metrics registry (Prometheus text exposition) ----------
+// A fixed table of metric slots; registering claims the next slot with one fetch_add and publishes
+// it with a release store, so there is no lock anywhere. Hot paths hold a small handle and update
+// the slot's atomics with relaxed operations; render() reads them on the scraping thread. Names,
+// labels and help texts must be string literals (or otherwise outlive the registry).
+//
+// Series of one metric share a name and differ in labels (`state="CONNECTED"`); register them one
+// after another so HELP/TYPE are written once. When the table is full, handles point at a sink slot
+// that is never rendered, so callers need no checks.
+class MetricsRegistry {
+    struct Slot;
+
+public:
+    static constexpr size_t kMaxMetrics = 128;
+    static constexpr size_t kMaxBuckets = 16;   // histogram upper bounds, +Inf excluded
+
+    class Counter {
+    public:
+        void add(uint64_t n = 1) const { s_->v[0].fetch_add(n, std::memory_order_relaxed); }
+        void set(uint64_t total) const { s_->v[0].store(total, std::memory_order_relaxed); }   // mirrors a total kept elsewhere
+    private:
+        friend class MetricsRegistry;
+        Slot* s_{ &sink_ };
+    };
+    class Gauge {
+    public:
+        void set(double v) const;
+    private:
+        friend class MetricsRegistry;
+        Slot* s_{ &sink_ };
+    };
+    class Histogram {
+    public:
+        void observe(double v) const;
+    private:
+        friend class MetricsRegistry;
+        Slot* s_{ &sink_ };
+    };
+
+    Counter counter(const char* name, const char* help, const char* labels = "");
+    Gauge gauge(const char* name, const char* help, const char* labels = "");
+    // bounds ascending; at most kMaxBuckets are used
+    Histogram histogram(const char* name, const char* help, std::initializer_list<double> bounds, const char* labels = "");
+
+    // Text format 0.0.4 into out (cleared first); out keeps its capacity, so once it has grown to the
+    // exposition's size a scrape does not allocate
+    void render(std::string& out) const;
+
+private:
+    enum Kind : uint8_t { kCounter, kGauge, kHistogram };
+    struct Slot {
+        Kind kind{ kCounter };
+        const char* name{ "" };
+        const char* help{ "" };
+        const char* labels{ "" };
+        uint32_t buckets{ 0 };
+        double bounds[kMaxBuckets]{};
+        // counter: v[0]; gauge: v[0] = double bits; histogram: per-bucket counts, then +Inf, then
+        // the sum as double bits
+        std::atomic<uint64_t> v[kMaxBuckets + 2]{};
+        std::atomic<bool> ready{ false };
+    };
+
+    Slot* claim(Kind kind, const char* name, const char* help, const char* labels);
+
+    static Slot sink_;
+    Slot slots_[kMaxMetrics];
+    std::atomic<size_t> count_{ 0 };
+};
@@ -0,0 +1,63 @@
+#include "PrivateDir.h"
+#include "Utf8.h"
+#include <windows.h>
+#include <bcrypt.h>
+#include <sddl.h>
+#include <vector>
+#pragma comment(lib, "bcrypt.lib")
+#pragma comment(lib, "advapi32.lib")
+
+static bool userSid(std::wstring& out) {
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token)) return false;
+    DWORD len = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &len);
+    std::vector<BYTE> buf(len);
+    const bool ok = len && GetTokenInformation(token, TokenUser, buf.data(), len, &len);
+    CloseHandle(token);
+    wchar_t* s = nullptr;
+    if (!ok || !ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(buf.data())->User.Sid, &s)) return false;
+    out = s;
+    LocalFree(s);
+    return true;
+}
+
+bool PrivateDir(std::wstring& dir, std::string& err) {
+    wchar_t base[MAX_PATH];
+    const DWORD n = GetEnvironmentVariableW(L"LOCALAPPDATA", base, MAX_PATH);
+    if (!n || n >= MAX_PATH) { err = "LOCALAPPDATA is not set"; return false; }
+    std::wstring sid;
+    if (!userSid(sid)) { err = "cannot read the user's SID"; return false; }
+    // P: protected; OICI: files and subdirectories created inside get the same two entries
+    const std::wstring sddl = L"D:P(A;OICI;FA;;;" + sid + L")(A;OICI;FA;;;SY)";
+    PSECURITY_DESCRIPTOR sd = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1, &sd, nullptr)) {
+        err = "cannot build the security descriptor";
+        return false;
+    }
+    dir.assign(base, n);
+    dir += L"\\VPN_GUI";
+    SECURITY_ATTRIBUTES sa{ sizeof(sa), sd, FALSE };
+    bool ok = CreateDirectoryW(dir.c_str(), &sa) != 0;
+    if (!ok && GetLastError() == ERROR_ALREADY_EXISTS) {   // an earlier run made it: make sure it is still ours alone
+        const DWORD attr = GetFileAttributesW(dir.c_str());
+        ok = attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY) && !(attr & FILE_ATTRIBUTE_REPARSE_POINT) &&
+            SetFileSecurityW(dir.c_str(), DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION, sd);
+    }
+    LocalFree(sd);
+    if (!ok) err = "cannot create " + WideToUtf8(dir) + " (error " + std::to_string(GetLastError()) + ")";
+    return ok;
+}
+
+std::string RandomHex(size_t n) {
+    std::vector<unsigned char> bytes(n);
+    if (!BCRYPT_SUCCESS(BCryptGenRandom(nullptr, bytes.data(), (ULONG)n, BCRYPT_USE_SYSTEM_PREFERRED_RNG))) return {};
+    static const char kHex[] = "0123456789abcdef";
+    std::string s;
+    s.reserve(n * 2);
+    for (unsigned char b : bytes) {
+        s += kHex[b >> 4];
+        s += kHex[b & 15];
+    }
+    return s;
+}
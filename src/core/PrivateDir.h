@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// --------- per-user private directory ----------
+// Secrets and rendezvous files (the management password, the tunnel journal, the control socket)
+// live in %LOCALAPPDATA%\VPN_GUI. Its DACL is protected (nothing inherited from the parent) and
+// grants the current user and SYSTEM only, and files created inside inherit exactly that, so other
+// local users can neither read them nor plant their own.
+
+// The directory without a trailing backslash, created and locked down on first use.
+bool PrivateDir(std::wstring& dir, std::string& err);
+
+// n bytes from the system RNG as 2n hex digits; empty on failure.
+std::string RandomHex(size_t n);
@@ -0,0 +1,100 @@
+#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING   // the baseline is the deprecated converter
+#include "TextBench.h"
+#include "Utf8.h"
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cstring>
+#include <locale>
+#include <string>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// what OpenVpnRunner used to do
+std::wstring widenOld(const std::string& s) {
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> cv; return cv.from_bytes(s);
+}
+std::string narrowOld(const std::wstring& w) {
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> cv; return cv.to_bytes(w);
+}
+
+// runs f for ~200 ms; ns per call
+template <class F> double timeIt(F&& f) {
+    uint64_t calls = 0;
+    const auto t0 = Clock::now();
+    auto t = t0;
+    do {
+        for (int k = 0; k < 64; ++k) f();
+        calls += 64;
+        t = Clock::now();
+    } while (t - t0 < std::chrono::milliseconds(200));
+    return std::chrono::duration<double, std::nano>(t - t0).count() / calls;
+}
+
+volatile size_t g_sink;   // keeps results alive
+
+void row(const char* name, size_t bytes, double oldNs, double newNs) {
+    std::printf("%-24s %8zu %10.1f %10.1f %9.0f %9.0f %7.1fx\n", name, bytes, oldNs, newNs, bytes / oldNs * 1e3, bytes / newNs * 1e3,
+        oldNs / newNs);
+    std::fflush(stdout);
+}
+
+// OpenVPN-looking output in `reads` of 64 KB; every `dirtyEvery`th line gets color codes and a stray
+// Latin-1 byte (0 = all clean)
+std::string makeOutput(size_t bytes, int dirtyEvery) {
+    std::string s;
+    char line[256];
+    uint32_t x = 12345;
+    for (int i = 0; s.size() < bytes; ++i) {
+        x = x * 1664525u + 1013904223u;
+        const bool dirty = dirtyEvery && i % dirtyEvery == 0;
+        std::snprintf(line, sizeof(line), "%s2025-01-01 12:00:%02u us=%u UDPv4 read [%u] from [AF_INET]185.%u.7.3:1194%s%s\r\n",
+            dirty ? "\x1b[33m" : "", x % 60, x % 1000000, x >> 8 & 0xFFFF, x >> 4 & 0xFF, dirty ? " caf\xe9" : "",
+            dirty ? "\x1b[0m" : "");
+        s += line;
+    }
+    s.resize(bytes);
+    return s;
+}
+} // namespace
+
+int TextBench::Run() {
+    std::printf("%-24s %8s %10s %10s %9s %9s %8s\n", "case", "bytes", "old_ns", "new_ns", "old_MB/s", "new_MB/s", "speedup");
+
+    const std::wstring paths[] = {
+        L"C:/Program Files/OpenVPN/config/jp-tok.prod.surfshark.com_udp.ovpn",
+        L"C:/Users/\u7528\u6237/\u4e0b\u8f7d/\u65e5\u672c-\u4e1c\u4eac-\u8282\u70b9 01.ovpn",
+    };
+    const char* pathNames[] = { "ascii path", "cjk path" };
+    for (int i = 0; i < 2; ++i) {
+        const std::wstring& w = paths[i];
+        const std::string u = WideToUtf8(w);
+        if (u != narrowOld(w) || Utf8ToWide(u) != widenOld(u)) { std::printf("%s: results differ\n", pathNames[i]); return 1; }
+        char name[64];
+        std::snprintf(name, sizeof(name), "narrow %s", pathNames[i]);
+        row(name, u.size(), timeIt([&] { g_sink = narrowOld(w).size(); }), timeIt([&] { g_sink = WideToUtf8(w).size(); }));
+        std::snprintf(name, sizeof(name), "widen %s", pathNames[i]);
+        row(name, u.size(), timeIt([&] { g_sink = widenOld(u).size(); }), timeIt([&] { g_sink = Utf8ToWide(u).size(); }));
+    }
+
+    // per read: the old path only looked for newlines; the new one validates and cleans the read first
+    constexpr size_t kRead = 64 << 10;
+    for (int dirty : { 0, 100, 10 }) {
+        const std::string out = makeOutput(kRead, dirty);
+        TextSanitizer san;
+        std::string clean;
+        auto split = [](const char* p, size_t n) {
+            size_t lines = 0;
+            for (const char* end = p + n; (p = static_cast<const char*>(std::memchr(p, '\n', end - p))); ++p) ++lines;
+            return lines;
+        };
+        char name[64];
+        std::snprintf(name, sizeof(name), dirty ? "output 1/%d dirty" : "output clean", dirty);
+        row(name, out.size(), timeIt([&] { g_sink = split(out.data(), out.size()); }), timeIt([&] {
+            const std::string_view t = san.feed(out.data(), out.size(), clean);
+            g_sink = split(t.data(), t.size());
+        }));
+    }
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// --------- text conversion benchmark (--text-bench) ----------
+// Headless throughput comparison of the Utf8 module against what it replaced: std::wstring_convert
+// with a converter built per call (widen/narrow of profile paths and arguments), and splitting child
+// output without validation versus TextSanitizer::feed on the same 64 KB reads.
+class TextBench {
+public:
+    static int Run();   // prints one row per case to stdout; returns exit code
+};
@@ -0,0 +1,248 @@
+#include "Utf8.h"
+#include <cstdint>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF8_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static constexpr size_t kMaxEscape = 64;   // longer "escape sequences" are garbage: only the ESC goes
+
+static inline int lowestBit(uint32_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0; _BitScanForward(&idx, v); return (int)idx;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+// Length of the UTF-8 sequence at s: > 0 valid, 0 cut off by the end of the buffer, < 0 invalid,
+// with -result bytes (the maximal subpart) to replace by one U+FFFD
+static int sequenceLength(const char* s, size_t n) {
+    const uint8_t c = (uint8_t)s[0];
+    int len;
+    uint8_t lo = 0x80, hi = 0xBF;   // allowed range of the next byte
+    if (c >= 0xC2 && c <= 0xDF) len = 2;
+    else if (c >= 0xE0 && c <= 0xEF) { len = 3; if (c == 0xE0) lo = 0xA0; else if (c == 0xED) hi = 0x9F; }   // overlong / surrogate
+    else if (c >= 0xF0 && c <= 0xF4) { len = 4; if (c == 0xF0) lo = 0x90; else if (c == 0xF4) hi = 0x8F; }   // overlong / > U+10FFFF
+    else return -1;
+    for (int k = 1; k < len; ++k) {
+        if ((size_t)k >= n) return 0;
+        const uint8_t b = (uint8_t)s[k];
+        if (b < lo || b > hi) return -k;
+        lo = 0x80; hi = 0xBF;
+    }
+    return len;
+}
+
+static uint32_t decode(const char* s, int len) {
+    const uint8_t* u = (const uint8_t*)s;
+    switch (len) {
+    case 2: return (u[0] & 0x1Fu) << 6 | (u[1] & 0x3Fu);
+    case 3: return (u[0] & 0x0Fu) << 12 | (u[1] & 0x3Fu) << 6 | (u[2] & 0x3Fu);
+    default: return (u[0] & 0x07u) << 18 | (u[1] & 0x3Fu) << 12 | (u[2] & 0x3Fu) << 6 | (u[3] & 0x3Fu);
+    }
+}
+
+// printable ASCII, \t, \r and \n from the start of p: the bytes that pass through untouched
+static inline bool plain(uint8_t c) { return (c >= 0x20 && c < 0x7F) || c == '\n' || c == '\r' || c == '\t'; }
+
+static size_t plainPrefix(const char* p, size_t n) {
+    size_t i = 0;
+#ifdef UTF8_SSE2
+    const __m128i space = _mm_set1_epi8(0x20), del = _mm_set1_epi8(0x7F);
+    const __m128i lf = _mm_set1_epi8('\n'), cr = _mm_set1_epi8('\r'), tab = _mm_set1_epi8('\t');
+    auto bad = [&](size_t at) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + at));
+        // signed compare: bytes >= 0x80 are negative, so "< 0x20" also flags them
+        const __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)), _mm_cmpeq_epi8(v, tab));
+        return _mm_or_si128(_mm_andnot_si128(ws, _mm_cmplt_epi8(v, space)), _mm_cmpeq_epi8(v, del));
+    };
+    for (; i + 64 <= n; i += 64) {   // one branch per 64 bytes while everything is plain
+        const __m128i any = _mm_or_si128(_mm_or_si128(bad(i), bad(i + 16)), _mm_or_si128(bad(i + 32), bad(i + 48)));
+        if (_mm_movemask_epi8(any)) break;
+    }
+    for (; i + 16 <= n; i += 16)
+        if (const int m = _mm_movemask_epi8(bad(i))) return i + lowestBit((uint32_t)m);
+#endif
+    while (i < n && plain((uint8_t)p[i])) ++i;
+    return i;
+}
+
+// ESC at p[0]: bytes to drop, 0 = cut off by the end of the buffer (more may follow)
+static size_t escapeLength(const char* p, size_t n, bool final) {
+    if (n < 2) return final ? 1 : 0;
+    if (p[1] == '[') {   // CSI: parameters 0x30-0x3F, intermediates 0x20-0x2F, final byte 0x40-0x7E
+        size_t j = 2;
+        while (j < n && j < kMaxEscape && (uint8_t)p[j] >= 0x20 && (uint8_t)p[j] <= 0x3F) ++j;
+        if (j < n && (uint8_t)p[j] >= 0x40 && (uint8_t)p[j] <= 0x7E) return j + 1;
+        return j == n && !final && j < kMaxEscape ? 0 : 1;
+    }
+    if (p[1] == ']') {   // OSC: up to BEL or ESC '\'
+        for (size_t j = 2; j < n && j < kMaxEscape; ++j) {
+            if (p[j] == '\a') return j + 1;
+            if (p[j] == '\x1b') return j + 1 < n && p[j + 1] == '\\' ? j + 2 : 1;
+        }
+        return n < kMaxEscape && !final ? 0 : 1;
+    }
+    return 2;   // two-byte sequence (ESC c, ESC =, ...)
+}
+
+// Cleans p[0, n) into out (only written once something changes; changed says whether it did).
+// Returns where the text ends: n, unless !final and a sequence is cut off at the end.
+static size_t sanitize(const char* p, size_t n, bool final, std::string& out, bool& changed) {
+    size_t i = 0, copied = 0;   // p[0, copied) is already reflected in out
+    changed = false;
+    auto skip = [&](size_t from, size_t to, const char* replacement) {
+        if (!changed) { out.clear(); changed = true; }
+        out.append(p + copied, from - copied);
+        out += replacement;
+        copied = to;
+    };
+    for (;;) {
+        i += plainPrefix(p + i, n - i);
+        if (i >= n) break;
+        const uint8_t c = (uint8_t)p[i];
+        if (c < 0x80) {   // other C0 controls, DEL, escape sequences
+            const size_t len = c == 0x1B ? escapeLength(p + i, n - i, final) : 1;
+            if (!len) break;
+            skip(i, i + len, "");
+            i += len;
+            continue;
+        }
+        const int len = sequenceLength(p + i, n - i);
+        if (len > 0) {
+            if (c == 0xC2 && (uint8_t)p[i + 1] < 0xA0) skip(i, i + 2, "");   // C1 control
+            i += len;
+            continue;
+        }
+        if (len == 0 && !final) break;
+        const size_t bad = len ? (size_t)-len : n - i;
+        skip(i, i + bad, "\xEF\xBF\xBD");
+        i += bad;
+    }
+    if (changed) out.append(p + copied, i - copied);
+    return i;
+}
+
+bool TextSanitizer::clean(std::string_view s, std::string& out) {
+    bool changed;
+    sanitize(s.data(), s.size(), true, out, changed);
+    return changed;
+}
+
+std::string_view TextSanitizer::feed(const char* data, size_t len, std::string& out) {
+    if (!held_.empty()) {   // rare: the previous chunk ended inside a sequence
+        joined_.assign(held_);
+        joined_.append(data, len);
+        held_.clear();
+        data = joined_.data();
+        len = joined_.size();
+    }
+    bool changed;
+    const size_t end = sanitize(data, len, false, out, changed);
+    held_.assign(data + end, len - end);
+    if (changed) return out;
+    return std::string_view(data, end);   // joined_ stays valid until the next feed()
+}
+
+std::string_view TextSanitizer::finish(std::string& out) {
+    bool changed;
+    const size_t end = sanitize(held_.data(), held_.size(), true, out, changed);
+    if (!changed) out.assign(held_, 0, end);
+    held_.clear();
+    return out;
+}
+
+int Utf8SequenceLength(std::string_view s) {
+    if ((uint8_t)s[0] < 0x80) return 1;
+    const int len = sequenceLength(s.data(), s.size());
+    return len ? len : -(int)s.size();
+}
+
+std::wstring Utf8ToWide(std::string_view s) {
+    std::wstring w(s.size(), L'\0');   // never more code units than bytes
+    wchar_t* o = &w[0];
+    const char* p = s.data();
+    const size_t n = s.size();
+    size_t i = 0;
+    while (i < n) {
+#ifdef UTF8_SSE2
+        if constexpr (sizeof(wchar_t) == 2) {
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= n; i += 16, o += 16) {   // ASCII: zero-extend 16 bytes to 16 code units
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                if (_mm_movemask_epi8(v)) break;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 8), _mm_unpackhi_epi8(v, zero));
+            }
+            if (i >= n) break;
+        }
+#endif
+        const uint8_t c = (uint8_t)p[i];
+        if (c < 0x80) { *o++ = (wchar_t)c; ++i; continue; }
+        const int len = sequenceLength(p + i, n - i);
+        if (len <= 0) {
+            *o++ = (wchar_t)0xFFFD;
+            i += len ? (size_t)-len : n - i;
+            continue;
+        }
+        const uint32_t cp = decode(p + i, len);
+        i += len;
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            *o++ = (wchar_t)(0xD800 + ((cp - 0x10000) >> 10));
+            *o++ = (wchar_t)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        }
+        else *o++ = (wchar_t)cp;
+    }
+    w.resize(o - w.data());
+    return w;
+}
+
+std::string WideToUtf8(std::wstring_view w) {
+    std::string s(w.size() * (sizeof(wchar_t) == 2 ? 3 : 4), '\0');   // a surrogate pair (2 units) takes 4 bytes
+    char* o = &s[0];
+    const wchar_t* p = w.data();
+    const size_t n = w.size();
+    size_t i = 0;
+    while (i < n) {
+#ifdef UTF8_SSE2
+        if constexpr (sizeof(wchar_t) == 2) {
+            const __m128i high = _mm_set1_epi16((short)0xFF80), zero = _mm_setzero_si128();
+            for (; i + 8 <= n; i += 8, o += 8) {   // ASCII: narrow 8 code units to 8 bytes
+                const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, high), zero)) != 0xFFFF) break;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(o), _mm_packus_epi16(v, v));
+            }
+            if (i >= n) break;
+        }
+#endif
+        uint32_t cp = (uint32_t)p[i++];
+        if (cp < 0x80) { *o++ = (char)cp; continue; }
+        if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp <= 0xDFFF) {
+            if (cp <= 0xDBFF && i < n && (uint32_t)p[i] >= 0xDC00 && (uint32_t)p[i] <= 0xDFFF)
+                cp = 0x10000 + ((cp - 0xD800) << 10) + ((uint32_t)p[i++] - 0xDC00);
+            else cp = 0xFFFD;
+        }
+        else if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) cp = 0xFFFD;
+        if (cp < 0x800) {
+            *o++ = (char)(0xC0 | cp >> 6);
+            *o++ = (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            *o++ = (char)(0xE0 | cp >> 12);
+            *o++ = (char)(0x80 | (cp >> 6 & 0x3F));
+            *o++ = (char)(0x80 | (cp & 0x3F));
+        }
+        else {
+            *o++ = (char)(0xF0 | cp >> 18);
+            *o++ = (char)(0x80 | (cp >> 12 & 0x3F));
+            *o++ = (char)(0x80 | (cp >> 6 & 0x3F));
+            *o++ = (char)(0x80 | (cp & 0x3F));
+        }
+    }
+    s.resize(o - s.data());
+    return s;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// --------- UTF-8 text: validation, sanitizing, UTF-16 transcoding ----------
+// Replaces std::wstring_convert (deprecated, and it builds a converter per call). Runs of ASCII are
+// handled 16 bytes at a time with SSE2; everything else goes through one table-free decoder that
+// follows the Unicode "maximal subpart" rule, so each invalid sequence becomes exactly one U+FFFD.
+
+std::wstring Utf8ToWide(std::string_view s);    // invalid sequences become U+FFFD
+std::string WideToUtf8(std::wstring_view w);    // unpaired surrogates become U+FFFD
+// The UTF-8 sequence at the start of s (non-empty): > 0 = a valid one of that many bytes, < 0 = that
+// many invalid bytes that stand for one U+FFFD (a sequence cut off by the end of s is invalid too)
+int Utf8SequenceLength(std::string_view s);
+
+// Makes child output safe to show: invalid UTF-8 becomes U+FFFD; ANSI escape sequences (CSI, OSC)
+// and control characters other than \t \r \n are removed.
+class TextSanitizer {
+public:
+    // One complete piece of text. False = s is already clean and out is left alone.
+    static bool clean(std::string_view s, std::string& out);
+
+    // A stream of pipe reads: a UTF-8 or escape sequence cut off by the end of a chunk is held back
+    // and completed by the next one. Returns the text to use, which is data itself when it is clean
+    // (the common case: no copy) or points into out.
+    std::string_view feed(const char* data, size_t len, std::string& out);
+    std::string_view finish(std::string& out);     // end of stream: the held-back bytes, cleaned
+    void reset() { held_.clear(); }
+
+private:
+    std::string held_, joined_;
+};
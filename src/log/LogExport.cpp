@@ -0,0 +1,245 @@
+#include "LogExport.h"
+#include "../core/Gzip.h"
+#include "../core/Utf8.h"
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <malloc.h>
+
+namespace {
+// Unbuffered sequential writer: the cache manager never sees the data, so a multi-GB export doesn't
+// evict everything else from the file cache. Writes must be whole sectors from aligned memory; the
+// padding of the last one is trimmed with SetFileInformationByHandle at close.
+class AlignedWriter {
+public:
+    static constexpr size_t kBuf = 1u << 20;
+    static constexpr size_t kSector = 4096;   // covers 512e and 4Kn disks
+
+    ~AlignedWriter() { abandon(); }
+
+    bool open(const std::string& utf8Path, std::string& err) {
+        int n = MultiByteToWideChar(CP_UTF8, 0, utf8Path.c_str(), -1, nullptr, 0);
+        std::wstring path(n > 0 ? n - 1 : 0, L'\0');
+        if (n > 1) MultiByteToWideChar(CP_UTF8, 0, utf8Path.c_str(), -1, &path[0], n);
+        h_ = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (h_ == INVALID_HANDLE_VALUE) { err = "cannot create file (error " + std::to_string(GetLastError()) + ")"; return false; }
+        for (int k = 0; k < 2; ++k) {
+            buf_[k] = static_cast<char*>(_aligned_malloc(kBuf, kSector));
+            ev_[k] = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (!buf_[k] || !ev_[k]) { err = "out of memory"; return false; }
+        }
+        return true;
+    }
+
+    void append(const char* p, size_t n) {
+        while (n && !failed_) {
+            size_t take = std::min(n, kBuf - fill_);
+            std::memcpy(buf_[cur_] + fill_, p, take);
+            fill_ += take; p += take; n -= take;
+            if (fill_ == kBuf) flush(kBuf);
+        }
+    }
+    void append(const std::string& s) { append(s.data(), s.size()); }
+
+    bool close(std::string& err) {
+        uint64_t size = written_ + fill_;
+        if (fill_ && !failed_) {
+            size_t padded = (fill_ + kSector - 1) & ~(kSector - 1);
+            std::memset(buf_[cur_] + fill_, 0, padded - fill_);
+            flush(padded);
+        }
+        wait(0); wait(1);
+        if (!failed_) {
+            FILE_END_OF_FILE_INFO eof{};
+            eof.EndOfFile.QuadPart = (LONGLONG)size;
+            if (!SetFileInformationByHandle(h_, FileEndOfFileInfo, &eof, sizeof(eof))) fail(GetLastError());
+        }
+        abandon();
+        if (failed_) { err = "write failed (error " + std::to_string(error_) + ")"; return false; }
+        return true;
+    }
+
+    uint64_t bytes() const { return written_ + fill_; }
+
+private:
+    void fail(DWORD e) { if (!failed_) { failed_ = true; error_ = e; } }
+
+    // hands the current buffer to the OS and switches to the other one once its last write is done
+    void flush(size_t len) {
+        OVERLAPPED& ov = ov_[cur_];
+        ov = OVERLAPPED{};
+        ov.Offset = (DWORD)(offset_ & 0xFFFFFFFFu);
+        ov.OffsetHigh = (DWORD)(offset_ >> 32);
+        ov.hEvent = ev_[cur_];
+        if (!WriteFile(h_, buf_[cur_], (DWORD)len, nullptr, &ov) && GetLastError() != ERROR_IO_PENDING) {
+            fail(GetLastError());
+            return;
+        }
+        pending_[cur_] = true;
+        offset_ += len;
+        written_ += fill_;
+        cur_ ^= 1;
+        wait(cur_);
+        fill_ = 0;
+    }
+
+    void wait(int k) {
+        if (!pending_[k]) return;
+        DWORD n = 0;
+        if (!GetOverlappedResult(h_, &ov_[k], &n, TRUE)) fail(GetLastError());
+        pending_[k] = false;
+    }
+
+    void abandon() {
+        if (h_ != INVALID_HANDLE_VALUE) {
+            if (pending_[0] || pending_[1]) { CancelIo(h_); wait(0); wait(1); }
+            CloseHandle(h_);
+            h_ = INVALID_HANDLE_VALUE;
+        }
+        for (int k = 0; k < 2; ++k) {
+            if (buf_[k]) { _aligned_free(buf_[k]); buf_[k] = nullptr; }
+            if (ev_[k]) { CloseHandle(ev_[k]); ev_[k] = nullptr; }
+        }
+    }
+
+    HANDLE h_{ INVALID_HANDLE_VALUE };
+    char* buf_[2]{};
+    HANDLE ev_[2]{};
+    OVERLAPPED ov_[2]{};
+    bool pending_[2]{};
+    int cur_{ 0 };
+    size_t fill_{ 0 };
+    uint64_t offset_{ 0 }, written_{ 0 };
+    bool failed_{ false };
+    DWORD error_{ 0 };
+};
+
+// JSON wants valid UTF-8: an invalid sequence in a log line is written as one \ufffd
+void appendJsonString(std::string& out, std::string_view s) {
+    out += '"';
+    for (size_t i = 0; i < s.size();) {
+        const char ch = s[i];
+        const unsigned char c = (unsigned char)ch;
+        if (c >= 0x80) {
+            const int len = Utf8SequenceLength(s.substr(i));
+            if (len > 0) out.append(s.data() + i, (size_t)len);
+            else out += "\\ufffd";
+            i += (size_t)(len > 0 ? len : -len);
+            continue;
+        }
+        if (c == '"' || c == '\\') { out += '\\'; out += ch; }
+        else if (c < 0x20) {
+            char esc[8];
+            std::snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        }
+        else out += ch;
+        ++i;
+    }
+    out += '"';
+}
+} // namespace
+
+LogExporter::~LogExporter() { cancel(); }
+
+bool LogExporter::start(LogStore::Snapshot snap, const std::string& path, ExportFormat format) {
+    if (running_.load()) return false;
+    if (worker_.joinable()) worker_.join();
+    cancel_ = false;
+    done_ = 0;
+    total_ = snap.end() - snap.begin();
+    running_ = true;
+    worker_ = std::thread(&LogExporter::run, this, std::move(snap), path, format);
+    return true;
+}
+
+void LogExporter::cancel() {
+    cancel_ = true;
+    if (worker_.joinable()) worker_.join();
+}
+
+float LogExporter::progress() const {
+    uint64_t total = total_.load();
+    return total ? (float)((double)done_.load() / (double)total) : 1.0f;
+}
+
+bool LogExporter::takeResult(std::string& message) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!hasResult_) return false;
+    message.swap(result_);
+    hasResult_ = false;
+    return true;
+}
+
+void LogExporter::finish(std::string message) {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        result_ = std::move(message);
+        hasResult_ = true;
+    }
+    running_ = false;
+}
+
+void LogExporter::run(LogStore::Snapshot snap, std::string path, ExportFormat format) {
+    auto t0 = std::chrono::steady_clock::now();
+    AlignedWriter out;
+    std::string err;
+    if (!out.open(path, err)) { finish("export to " + path + " failed: " + err); return; }
+
+    const LogTemplates& templates = snap.templates();
+    std::string text, record, packed;
+    GzipEncoder gz;
+    uint64_t n = 0;
+    snap.forEach([&](const LogStore::LineRef& r) {
+        if (cancel_.load(std::memory_order_relaxed)) return false;
+        templates.render(r.tid, r.fields, text);
+        switch (format) {
+        case ExportFormat::Text:
+            text += '\n';
+            out.append(text);
+            break;
+        case ExportFormat::JsonLines: {
+            char head[96];
+            std::snprintf(head, sizeof(head), "{\"n\":%llu,\"t\":%.9f,\"tid\":%u,\"fields\":[", (unsigned long long)r.index,
+                (r.ns - snap.originNs()) / 1e9, r.tid);
+            record = head;
+            if (r.tid != LogTemplates::kRaw) {
+                const char* f = r.fields.data();
+                const char* end = f + r.fields.size();
+                for (bool first = true; f < end; first = false) {
+                    const char* z = static_cast<const char*>(std::memchr(f, '\0', end - f));
+                    if (!z) z = end;
+                    if (!first) record += ',';
+                    appendJsonString(record, std::string_view(f, z - f));
+                    f = z + 1;
+                }
+            }
+            record += "],\"text\":";
+            appendJsonString(record, text);
+            record += "}\n";
+            out.append(record);
+            break;
+        }
+        case ExportFormat::GzipText:
+            text += '\n';
+            gz.write(text.data(), text.size(), packed);
+            if (packed.size() >= (256u << 10)) { out.append(packed); packed.clear(); }
+            break;
+        }
+        if ((++n & 1023) == 0) done_.store(n, std::memory_order_relaxed);
+        return true;
+    });
+    if (format == ExportFormat::GzipText) { gz.finish(packed); out.append(packed); }
+    done_ = n;
+
+    uint64_t bytes = out.bytes();
+    if (!out.close(err)) { finish("export to " + path + " failed: " + err); return; }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    char msg[160];
+    std::snprintf(msg, sizeof(msg), "%s %llu lines (%.1f MB) in %.2f s to ", cancel_.load() ? "cancelled after" : "wrote",
+        (unsigned long long)n, bytes / 1048576.0, secs);
+    finish(msg + path);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "LogStore.h"
+
+// --------- background log export ----------
+// start() takes a LogStore snapshot (O(chunks) on the UI thread) and streams it to disk on a worker.
+// Output goes through two 1 MB sector-aligned buffers written with unbuffered overlapped I/O: one
+// fills while the other is on its way to disk. The UI polls progress() and takeResult().
+
+enum class ExportFormat { Text, JsonLines, GzipText };
+
+class LogExporter {
+public:
+    LogExporter() = default;
+    ~LogExporter();
+
+    // path is UTF-8; false if an export is already running
+    bool start(LogStore::Snapshot snap, const std::string& path, ExportFormat format);
+    void cancel();                                  // stops and joins the worker
+    bool running() const { return running_.load(); }
+    float progress() const;                         // 0..1 of the snapshot's lines
+    bool takeResult(std::string& message);          // once per finished/failed/cancelled export
+
+private:
+    void run(LogStore::Snapshot snap, std::string path, ExportFormat format);
+    void finish(std::string message);
+
+    std::thread worker_;
+    std::atomic<bool> running_{ false }, cancel_{ false };
+    std::atomic<uint64_t> done_{ 0 }, total_{ 0 };
+    std::mutex mu_;
+    std::string result_;      // guarded by mu_
+    bool hasResult_{ false };
+};
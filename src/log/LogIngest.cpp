@@ -0,0 +1,75 @@
+#include "LogIngest.h"
+#include "LogShare.h"
+#include "LogStore.h"
+#include "../ui/Panels.h"
+#include <algorithm>
+#include <chrono>
+
+int64_t LogIngest::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void LogIngest::submit(std::string_view line) { submit(line, nowNs()); }
+
+void LogIngest::submit(std::string_view line, int64_t recvNs) {
+    std::lock_guard<std::mutex> lk(mu_);
+    pending_.bytes.append(line.data(), line.size());
+    pending_.ends.push_back((uint32_t)pending_.bytes.size());
+    pending_.times.push_back(recvNs);
+}
+
+void LogIngest::setBudget(uint32_t minLines, uint32_t maxLines, double targetUs) {
+    minBudget_ = std::max<uint32_t>(minLines, 2);
+    maxBudget_ = std::max(maxLines, minBudget_);
+    budget_ = std::clamp(budget_, minBudget_, maxBudget_);
+    targetUs_ = targetUs;
+}
+
+void LogIngest::pump(LogStore& store, LogBuffer& view) {
+    auto t0 = std::chrono::steady_clock::now();
+    if (workAt_ == work_.size()) {
+        work_.clear();
+        workAt_ = 0;
+        std::lock_guard<std::mutex> lk(mu_);
+        std::swap(pending_, work_);   // work_ was just cleared, so the reader keeps its capacity
+    }
+    // the view stride is planned for everything waiting; storing may stop early, the stride stays
+    const size_t from = workAt_, waiting = work_.size() - from;
+    // over budget: keep budget-1 evenly spaced lines (always including the newest) plus one summary row
+    const size_t stride = waiting <= budget_ ? 1 : (waiting + budget_ - 2) / (budget_ - 1);
+    size_t shown = 0, i = from;
+    pumped_.clear();   // keeps its capacity
+    for (; i < work_.size(); ++i) {
+        if (i - from >= minBudget_ && (i - from) % kStoreCheck == 0 &&
+            std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() > targetUs_)
+            break;
+        uint32_t tid = 0;
+        uint64_t idx = store.append(work_.line(i), work_.times[i], &tid);
+        if (share_) share_->publish(work_.line(i), work_.times[i]);
+        if ((work_.size() - 1 - i) % stride == 0) {
+            view.push(idx, tid);
+            pumped_.push_back(work_.times[i]);
+            ++shown;
+        }
+    }
+    const size_t n = i - from;
+    workAt_ = i;
+    if (shown < n) {
+        view.add({ n, LogRow::kBurst, (uint32_t)(n - shown) });
+        stats_.hiddenLines += n - shown;
+    }
+
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    // AIMD: back off hard when a frame blew the target, creep up while bursts are being sampled
+    if (us > targetUs_) budget_ = std::max(minBudget_, budget_ / 2);
+    else if (n > budget_) budget_ = std::min(maxBudget_, budget_ + budget_ / 8 + 1);
+
+    stats_.lastUs = us;
+    stats_.avgUs += (us - stats_.avgUs) * 0.05;
+    stats_.maxUs = std::max(stats_.maxUs, us);
+    stats_.lastLines = (uint32_t)n;
+    stats_.lastShown = (uint32_t)shown;
+    stats_.budget = budget_;
+    stats_.backlog = (uint32_t)(work_.size() - workAt_);
+    stats_.totalLines += n;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct LogBuffer;
+class LogShareWriter;
+class LogStore;
+
+struct IngestStats {
+    double lastUs{ 0 }, avgUs{ 0 }, maxUs{ 0 };   // pump() cost per frame
+    uint32_t lastLines{ 0 }, lastShown{ 0 };       // stored / pushed to the live view this frame
+    uint32_t budget{ 0 };                          // current per-frame view budget
+    uint32_t backlog{ 0 };                         // arrived but not stored yet (carried to the next frame)
+    uint64_t totalLines{ 0 }, hiddenLines{ 0 };    // hidden = stored but sampled out of the live view
+};
+
+// --------- reader thread -> UI thread log handoff ----------
+// submit() appends into a packed byte batch under a mutex; pump() swaps the batch out once per
+// frame, writes its lines to the LogStore and forwards at most `budget` of them to the live view.
+// Storing is bounded too: pump() stops after targetUs (checked every kStoreCheck lines, at least
+// minLines per frame) and carries the rest of the batch over; the next batch is only swapped in
+// once it is drained, so lines stay in order. Bursts beyond the view budget are sampled at a
+// uniform stride and closed by one summary row with the exact number of hidden lines. The view
+// budget adapts (AIMD) to keep pump() under targetUs.
+// submit() runs on the reader thread, so that is where each line gets its receive time.
+class LogIngest {
+public:
+    static constexpr size_t kStoreCheck = 64;
+    static int64_t nowNs();                          // steady clock, the time base of LogStore
+    void submit(std::string_view line);              // any thread; stamped with nowNs()
+    void submit(std::string_view line, int64_t recvNs);
+    void pump(LogStore& store, LogBuffer& view);     // UI thread, once per frame
+
+    void setBudget(uint32_t minLines, uint32_t maxLines, double targetUs);
+    // Optional: every line pump() stores is also published to the shared-memory ring (--log-share)
+    void setShare(LogShareWriter* share) { share_ = share; }
+    const IngestStats& stats() const { return stats_; }
+    bool idle() const { return workAt_ == work_.size(); }   // UI thread: no backlog carried over
+    // receive times of the lines the last pump() pushed to the live view (sampled-out ones never
+    // reach the screen): main measures when they are drawn
+    const std::vector<int64_t>& pumpedTimes() const { return pumped_; }
+
+private:
+    struct Batch {
+        std::string bytes;
+        std::vector<uint32_t> ends;
+        std::vector<int64_t> times;
+        size_t size() const { return ends.size(); }
+        std::string_view line(size_t i) const {
+            uint32_t b = i ? ends[i - 1] : 0;
+            return std::string_view(bytes.data() + b, ends[i] - b);
+        }
+        void clear() { bytes.clear(); ends.clear(); times.clear(); }
+    };
+
+    std::mutex mu_;
+    Batch pending_;       // guarded by mu_
+    Batch work_;          // UI thread only
+    size_t workAt_{ 0 };  // UI thread: work_ lines already stored
+    std::vector<int64_t> pumped_;   // UI thread: times of the lines shown last frame
+    uint32_t minBudget_{ 50 }, maxBudget_{ 2000 }, budget_{ 200 };
+    double targetUs_{ 2000 };
+    IngestStats stats_;
+    LogShareWriter* share_{ nullptr };
+};
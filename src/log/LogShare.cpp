@@ -0,0 +1,175 @@
+#include "LogShare.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace LogShare;
+
+static bool processAlive(DWORD pid) {
+    HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    if (!h) return false;
+    const bool alive = WaitForSingleObject(h, 0) == WAIT_TIMEOUT;
+    CloseHandle(h);
+    return alive;
+}
+
+static size_t viewSize(const void* view) {
+    MEMORY_BASIC_INFORMATION mbi{};
+    return VirtualQuery(view, &mbi, sizeof(mbi)) ? (size_t)mbi.RegionSize : 0;
+}
+
+bool LogShareWriter::open(const char* name, uint32_t slots, std::string& err) {
+    close();
+    uint32_t count = 64;
+    while (count < slots && count < (1u << 20)) count <<= 1;
+    const uint64_t bytes = sizeof(Header) + (uint64_t)count * kSlotBytes;
+    mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)(bytes >> 32), (DWORD)bytes, name);
+    if (!mapping_) { err = std::string("cannot create shared memory ") + name; return false; }
+    const bool existed = GetLastError() == ERROR_ALREADY_EXISTS;   // a reader (or a crashed run's reader) kept it
+    void* view = MapViewOfFile(mapping_, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, 0);   // all of it: an existing one keeps its size
+    if (!view) { err = std::string("cannot map ") + name; close(); return false; }
+    hdr_ = static_cast<Header*>(view);
+    const size_t size = viewSize(view);
+    if (existed && hdr_->magic.load(std::memory_order_acquire) == kMagic) {
+        const DWORD pid = hdr_->writerPid.load(std::memory_order_relaxed);
+        if (hdr_->version != kVersion || hdr_->slotBytes != kSlotBytes || !hdr_->slotCount || (hdr_->slotCount & (hdr_->slotCount - 1)) ||
+            sizeof(Header) + (uint64_t)hdr_->slotCount * kSlotBytes > size) {
+            err = std::string(name) + " is in use with another layout";
+            close();
+            return false;
+        }
+        if (pid && pid != GetCurrentProcessId() && processAlive(pid)) {   // one writer per ring
+            err = std::string(name) + " is already written by pid " + std::to_string(pid);
+            close();
+            return false;
+        }
+        count = hdr_->slotCount;
+        next_ = hdr_->next.load(std::memory_order_relaxed);   // a line cut off by a crash was never published
+    }
+    else {
+        if (size < bytes) { err = std::string(name) + " is too small"; close(); return false; }
+        hdr_->version = kVersion;
+        hdr_->slotBytes = kSlotBytes;
+        hdr_->slotCount = count;
+        hdr_->next.store(0, std::memory_order_relaxed);
+        hdr_->magic.store(kMagic, std::memory_order_release);
+        next_ = 0;
+    }
+    slots_ = reinterpret_cast<Slot*>(hdr_ + 1);
+    mask_ = count - 1;
+    const auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+    const auto steady = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+    unixOffsetNs_ = wall.count() - steady.count();
+    hdr_->writerPid.store(GetCurrentProcessId(), std::memory_order_relaxed);
+    hdr_->epoch.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void LogShareWriter::close() {
+    if (hdr_) {
+        if (slots_) hdr_->writerPid.store(0, std::memory_order_release);
+        UnmapViewOfFile(hdr_);
+    }
+    hdr_ = nullptr;
+    slots_ = nullptr;
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+}
+
+void LogShareWriter::publish(std::string_view line, int64_t steadyNs) {
+    if (!slots_) return;
+    const int64_t unixNs = steadyNs + unixOffsetNs_;
+    uint16_t flags = 0;
+    do {
+        const size_t n = std::min(line.size(), Slot::kText);
+        Slot& s = slots_[next_ & mask_];
+        s.seq.store(Slot::kBusy, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);   // readers see kBusy before any new byte
+        s.unixNs = unixNs;
+        s.len = (uint16_t)n;
+        s.flags = flags | (n < line.size() ? kMore : 0);
+        std::memcpy(s.text, line.data(), n);
+        s.seq.store(next_++, std::memory_order_release);
+        line.remove_prefix(n);
+        flags = kContinued;
+    } while (!line.empty());
+    hdr_->next.store(next_, std::memory_order_release);   // whole lines only
+}
+
+bool LogShareReader::open(const char* name, std::string& err) {
+    close();
+    mapping_ = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+    if (!mapping_) { err = std::string("no shared log ") + name + " (start the GUI with --log-share)"; return false; }
+    const void* view = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { err = std::string("cannot map ") + name; close(); return false; }
+    hdr_ = static_cast<const Header*>(view);
+    if (hdr_->magic.load(std::memory_order_acquire) != kMagic || hdr_->version != kVersion || hdr_->slotBytes != kSlotBytes ||
+        !hdr_->slotCount || (hdr_->slotCount & (hdr_->slotCount - 1)) ||
+        sizeof(Header) + (uint64_t)hdr_->slotCount * kSlotBytes > viewSize(view)) {
+        err = std::string(name) + ": unknown log layout (version " + std::to_string(hdr_->version) + ")";
+        close();
+        return false;
+    }
+    slots_ = reinterpret_cast<const Slot*>(hdr_ + 1);
+    count_ = hdr_->slotCount;
+    pos_ = hdr_->next.load(std::memory_order_acquire);
+    lost_ = 0;
+    return true;
+}
+
+void LogShareReader::close() {
+    if (hdr_) UnmapViewOfFile(hdr_);
+    hdr_ = nullptr;
+    slots_ = nullptr;
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+}
+
+bool LogShareReader::copy(uint64_t seq, Slot& out) const {
+    const Slot& s = slots_[seq & (count_ - 1)];
+    if (s.seq.load(std::memory_order_acquire) != seq) return false;
+    out.unixNs = s.unixNs;
+    out.len = std::min<uint16_t>(s.len, (uint16_t)Slot::kText);
+    out.flags = s.flags;
+    std::memcpy(out.text, s.text, out.len);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.seq.load(std::memory_order_relaxed) == seq;   // not rewritten while we copied
+}
+
+void LogShareReader::rewind(uint64_t lines) {
+    const uint64_t end = hdr_->next.load(std::memory_order_acquire);
+    const uint64_t keep = count_ - count_ / 8;   // leave the writer room before it laps us
+    const uint64_t oldest = end > keep ? end - keep : 0;
+    pos_ = end;
+    Slot s;
+    for (uint64_t at = end; lines && at > oldest;) {   // back to the head of the lines-th newest line
+        if (!copy(--at, s)) break;
+        if (!(s.flags & kContinued)) { pos_ = at; --lines; }
+    }
+}
+
+bool LogShareReader::next(std::string& line, int64_t& unixNs) {
+    Slot s;
+    for (;;) {
+        const uint64_t end = hdr_->next.load(std::memory_order_acquire);
+        if (pos_ >= end) return false;
+        if (end - pos_ > count_) {   // lapped: skip to what is still there, with some slack
+            const uint64_t to = end - count_ + count_ / 8;
+            lost_ += to - pos_;
+            pos_ = to;
+        }
+        if (!copy(pos_, s) || (s.flags & kContinued)) { ++lost_; ++pos_; continue; }   // gone, or its head is
+        line.assign(s.text, s.len);
+        unixNs = s.unixNs;
+        uint64_t at = pos_ + 1;
+        bool whole = true;
+        for (bool more = s.flags & kMore; more; ++at) {
+            if (at >= end || !copy(at, s)) { whole = false; break; }
+            line.append(s.text, s.len);
+            more = s.flags & kMore;
+        }
+        if (!whole) { lost_ += at - pos_; pos_ = at; continue; }
+        pos_ = at;
+        return true;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// --------- shared-memory log ring (--log-share) ----------
+// The GUI publishes every ingested line into a named, pagefile-backed file mapping so other
+// processes (tools/logtail.cpp) can follow the log without talking to the GUI. The segment is a
+// header plus a power-of-two array of fixed 256-byte slots. One writer (LogIngest::pump, on the UI
+// thread) and any number of readers, which map it read-only and never block the writer:
+//   - a line takes one slot, longer lines continue in the following slots (kMore / kContinued);
+//   - each slot carries the sequence number it holds, written last (seqlock): a reader copies the
+//     slot and re-checks the sequence, so a slot overwritten mid-copy is detected, not shown torn;
+//   - Header::next, the sequence after the newest complete line, is stored after the whole line.
+// Readers poll Header::next, so following the log costs no system call per line. A reader that
+// falls more than a ring behind skips ahead and counts what it lost.
+// Crash safety: a writer that dies mid-line never advanced next, so readers never see that line;
+// the next writer (a readers' handle keeps the segment alive) resumes at next and bumps epoch.
+namespace LogShare {
+constexpr uint32_t kMagic = 0x474F4C56;      // "VLOG"
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kSlotBytes = 256;
+constexpr const char* kDefaultName = "Local\\OpenVpnGuiLog";
+
+enum SlotFlags : uint16_t { kMore = 1, kContinued = 2 };
+
+struct Header {
+    std::atomic<uint32_t> magic;   // stored last when the layout is initialized
+    uint32_t version;
+    uint32_t slotBytes, slotCount;
+    std::atomic<uint64_t> next;    // sequence of the next slot to be written, always at a line boundary
+    std::atomic<uint32_t> writerPid;   // 0 = the writer closed the log
+    std::atomic<uint32_t> epoch;       // bumped by every writer that opens the segment
+    uint8_t reserved[32];
+};
+static_assert(sizeof(Header) == 64, "the header is part of the shared layout");
+
+struct Slot {
+    static constexpr uint64_t kBusy = ~0ull;   // being rewritten
+    static constexpr size_t kText = kSlotBytes - 24;
+    std::atomic<uint64_t> seq;
+    int64_t unixNs;                // receive time, wall clock
+    uint16_t len, flags;
+    uint32_t reserved;
+    char text[kText];
+};
+static_assert(sizeof(Slot) == kSlotBytes, "the slot is part of the shared layout");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock-free");
+}
+
+class LogShareWriter {
+public:
+    LogShareWriter() = default;
+    LogShareWriter(const LogShareWriter&) = delete;
+    LogShareWriter& operator=(const LogShareWriter&) = delete;
+    ~LogShareWriter() { close(); }
+
+    bool open(const char* name, uint32_t slots, std::string& err);   // slots: rounded up to a power of two
+    void close();
+    bool isOpen() const { return hdr_ != nullptr; }
+    void publish(std::string_view line, int64_t steadyNs);           // steadyNs: LogIngest::nowNs() time base
+    uint64_t published() const { return next_; }
+
+private:
+    HANDLE mapping_{ nullptr };
+    LogShare::Header* hdr_{ nullptr };
+    LogShare::Slot* slots_{ nullptr };
+    uint64_t mask_{ 0 }, next_{ 0 };
+    int64_t unixOffsetNs_{ 0 };    // steady -> wall clock
+};
+
+class LogShareReader {
+public:
+    LogShareReader() = default;
+    LogShareReader(const LogShareReader&) = delete;
+    LogShareReader& operator=(const LogShareReader&) = delete;
+    ~LogShareReader() { close(); }
+
+    bool open(const char* name, std::string& err);   // read-only; starts at the newest line
+    void close();
+    void rewind(uint64_t lines);                       // back up `lines` lines (as far as the ring holds)
+    // The next complete line; false when caught up. Never blocks.
+    bool next(std::string& line, int64_t& unixNs);
+    uint64_t lost() const { return lost_; }            // slots overwritten before this reader got to them
+    uint32_t writerPid() const { return hdr_->writerPid.load(std::memory_order_relaxed); }
+    uint32_t epoch() const { return hdr_->epoch.load(std::memory_order_relaxed); }
+
+private:
+    bool copy(uint64_t seq, LogShare::Slot& out) const;   // false: overwritten
+
+    HANDLE mapping_{ nullptr };
+    const LogShare::Header* hdr_{ nullptr };
+    const LogShare::Slot* slots_{ nullptr };
+    uint64_t count_{ 0 }, pos_{ 0 }, lost_{ 0 };
+};
@@ -0,0 +1,393 @@
+#include "LogStore.h"
+#include "../core/FrameArena.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+static inline int lowestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0; _BitScanForward64(&idx, v); return (int)idx;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+template <class Out>
+static inline void putVarint(Out& out, uint64_t v) {
+    for (; v >= 0x80; v >>= 7) out.push_back((char)(v | 0x80));
+    out.push_back((char)v);
+}
+
+static inline uint64_t getVarint(const char* p, size_t& off) {
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+        uint8_t b = (uint8_t)p[off++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// A field stored as a number must print back identically: digits only, no leading zero, < 10^18
+static inline bool plainNumber(std::string_view f, uint64_t& v) {
+    if (f.empty() || f.size() > 18 || (f[0] == '0' && f.size() > 1)) return false;
+    v = 0;
+    for (char ch : f) {
+        if (ch < '0' || ch > '9') return false;
+        v = v * 10 + (uint64_t)(ch - '0');
+    }
+    return true;
+}
+
+// Field encoding, one LEB128 header per field:
+//   h & 1 == 0   plain number h >> 1
+//   h & 3 == 1   dictionary value h >> 2
+//   h & 3 == 3   inline text of h >> 2 bytes, which follow
+enum : uint64_t { kTagNumber = 0, kTagDict = 1, kTagInline = 3 };
+
+LogStore::LogStore(size_t maxBytes) : dictSlots_(kDictSlots), maxBytes_(std::max(maxBytes, kChunkBytes)) {}
+
+uint64_t LogStore::append(std::string_view line, int64_t recvNs, uint32_t* tidOut) {
+    uint32_t tid = templates_.split(line, fields_);
+    if (tidOut) *tidOut = tid;
+
+    // no field encodes to more than twice its packed size, plus the line's length and tid
+    const size_t bound = 2 * fields_.size() + 16;
+    Chunk* c = chunks_.empty() ? nullptr : chunks_.back().get();
+    if (!c || sealed_ || c->data.size() + bound > c->data.capacity()) {
+        sealed_ = false;
+        while (!chunks_.empty() && bytes_ + std::max(bound, kChunkBytes) > maxBytes_) {
+            bytes_ -= chunks_.front()->cost();
+            chunks_.pop_front();
+        }
+        auto fresh = std::make_shared<Chunk>();
+        fresh->first = end_;
+        fresh->data.reserve(std::max(bound, kChunkBytes));   // oversized lines get their own chunk
+        chunks_.push_back(std::move(fresh));
+        c = chunks_.back().get();
+        bytes_ += c->data.capacity();
+        std::fill(dictSlots_.begin(), dictSlots_.end(), 0u);
+    }
+    size_t before = c->cost();
+    if (originNs_ < 0) originNs_ = lastNs_ = recvNs;
+    lastNs_ = std::max(lastNs_, recvNs);
+    if (c->count % kMarkEvery == 0) c->marks.push_back({ lastNs_, (uint32_t)c->times.size(), (uint32_t)c->data.size() });
+    else for (uint64_t d = (uint64_t)(lastNs_ - c->lastNs); ; d >>= 7) {
+        if (d < 0x80) { c->times.push_back((uint8_t)d); break; }
+        c->times.push_back((uint8_t)(d | 0x80));
+    }
+    c->lastNs = lastNs_;
+    encode(*c, tid);
+    ++c->count;
+    bytes_ += c->cost() - before;
+    rawBytes_ += line.size();
+    return end_++;
+}
+
+uint32_t LogStore::dictCode(Chunk& c, std::string_view value) {
+    if (value.size() > kDictValueMax) return kDictMax;
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (char ch : value) h = (h ^ (uint8_t)ch) * 16777619u;
+    for (size_t slot = h & (kDictSlots - 1); ; slot = (slot + 1) & (kDictSlots - 1)) {
+        const uint32_t code = dictSlots_[slot];
+        if (code) {
+            const uint32_t b = code > 1 ? c.dictEnds[code - 2] : 0;
+            if (std::string_view(c.dict.data() + b, c.dictEnds[code - 1] - b) == value) return code - 1;
+            continue;
+        }
+        // at most kDictMax of kDictSlots slots are taken, so probing always ends at a free one
+        if (c.dictEnds.size() >= kDictMax) return kDictMax;
+        c.dict.append(value.data(), value.size());
+        c.dictEnds.push_back((uint32_t)c.dict.size());
+        dictSlots_[slot] = (uint32_t)c.dictEnds.size();
+        return (uint32_t)c.dictEnds.size() - 1;
+    }
+}
+
+void LogStore::encode(Chunk& c, uint32_t tid) {
+    encoded_.clear();
+    putVarint(encoded_, tid);
+    if (tid == LogTemplates::kRaw) encoded_ += fields_;
+    else for (size_t a = 0; a < fields_.size();) {
+        size_t z = fields_.find('\0', a);
+        if (z == std::string::npos) z = fields_.size();
+        const std::string_view f(fields_.data() + a, z - a);
+        uint64_t v = 0;
+        uint32_t code = kDictMax;
+        if (plainNumber(f, v)) putVarint(encoded_, v << 1 | kTagNumber);
+        else if ((code = dictCode(c, f)) < kDictMax) putVarint(encoded_, (uint64_t)code << 2 | kTagDict);
+        else {
+            putVarint(encoded_, (uint64_t)f.size() << 2 | kTagInline);
+            encoded_.append(f.data(), f.size());
+            ++c.inlined;
+        }
+        a = z + 1;
+    }
+    putVarint(c.data, encoded_.size());
+    c.data.insert(c.data.end(), encoded_.begin(), encoded_.end());
+}
+
+size_t LogStore::decodeAt(const Chunk& c, size_t off, uint32_t& tid, std::string* out) {
+    const char* p = c.data.data();
+    const size_t len = (size_t)getVarint(p, off), end = off + len;
+    tid = (uint32_t)getVarint(p, off);
+    if (!out) return end;
+    std::string& fields = *out;
+    if (tid == LogTemplates::kRaw) { fields.assign(p + off, end - off); return end; }
+    fields.clear();
+    char digits[20];
+    while (off < end) {
+        const uint64_t h = getVarint(p, off);
+        if ((h & 1) == kTagNumber) {
+            fields.append(digits, std::to_chars(digits, digits + sizeof(digits), h >> 1).ptr);
+        }
+        else if ((h & 3) == kTagDict) {
+            const uint32_t code = (uint32_t)(h >> 2), b = code ? c.dictEnds[code - 1] : 0;
+            fields.append(c.dict.data() + b, c.dictEnds[code] - b);
+        }
+        else {
+            fields.append(p + off, (size_t)(h >> 2));
+            off += (size_t)(h >> 2);
+        }
+        fields += '\0';
+    }
+    return end;
+}
+
+void LogStore::matchDict(const Chunk& c, FieldPatterns& p) {
+    p.possible = p.digitsOnly | (c.inlined ? ~0ull : 0ull);
+    for (size_t k = 0; k < c.dictEnds.size(); ++k) {
+        const uint32_t b = k ? c.dictEnds[k - 1] : 0;
+        const std::string_view v(c.dict.data() + b, c.dictEnds[k] - b);
+        p.dict[k] = 0;
+        for (size_t q = 0; q < p.n; ++q)
+            if (v.find(p.pats[q]) != std::string_view::npos) p.dict[k] |= 1ull << q;
+        p.possible |= p.dict[k];
+    }
+}
+
+bool LogStore::fieldsHave(const Chunk& c, size_t off, const FieldPatterns& p, uint64_t want) {
+    const char* d = c.data.data();
+    const size_t len = (size_t)getVarint(d, off), end = off + len;
+    uint64_t found = 0;
+    auto scan = [&](std::string_view text, uint64_t which) {
+        for (uint64_t m = which & want & ~found; m; m &= m - 1)
+            if (text.find(p.pats[lowestBit(m)]) != std::string_view::npos) found |= m & (~m + 1);
+    };
+    if (getVarint(d, off) == LogTemplates::kRaw) { scan(std::string_view(d + off, end - off), ~0ull); return (found & want) == want; }
+    if (want & ~p.possible) return false;
+    while (off < end && (found & want) != want) {
+        const uint64_t h = getVarint(d, off);
+        if ((h & 1) == kTagNumber) {
+            // the pattern's digits appear in v when some v / 10^k, at least as long as the pattern,
+            // ends in them: no text needed
+            for (uint64_t m = p.digitsOnly & want & ~found; m; m &= m - 1) {
+                const int q = lowestBit(m);
+                uint64_t v = h >> 1;
+                bool hit = v == 0 && p.scale[q] == 10 && p.value[q] == 0;   // 0 is the one-digit number "0"
+                for (; !hit && v >= p.scale[q] / 10; v /= 10) hit = v % p.scale[q] == p.value[q];
+                if (hit) found |= 1ull << q;
+            }
+        }
+        else if ((h & 3) == kTagDict) found |= p.dict[h >> 2];
+        else {
+            scan(std::string_view(d + off, (size_t)(h >> 2)), ~0ull);
+            off += (size_t)(h >> 2);
+        }
+    }
+    return (found & want) == want;
+}
+
+size_t LogStore::dataOffset(const Chunk& c, size_t i) {
+    size_t off = c.marks[i / kMarkEvery].dataOff;
+    for (size_t k = i % kMarkEvery; k; --k) off += (size_t)getVarint(c.data.data(), off);
+    return off;
+}
+
+void LogStore::clear() {
+    chunks_.clear();
+    bytes_ = 0;
+    rawBytes_ = 0;
+    // end_ keeps counting so indices handed out earlier never alias new lines
+}
+
+const LogStore::Chunk* LogStore::chunkFor(uint64_t index) const {
+    if (index < begin() || index >= end_) return nullptr;
+    auto it = std::upper_bound(chunks_.begin(), chunks_.end(), index,
+        [](uint64_t i, const std::shared_ptr<Chunk>& c) { return i < c->first; });
+    return (--it)->get();
+}
+
+bool LogStore::line(uint64_t index, std::string& out) const {
+    const Chunk* c = chunkFor(index);
+    if (!c) { out.clear(); return false; }
+    uint32_t tid = 0;
+    decodeAt(*c, dataOffset(*c, (size_t)(index - c->first)), tid, &decoded_);
+    templates_.render(tid, decoded_, out);
+    return true;
+}
+
+uint32_t LogStore::templateOf(uint64_t index) const {
+    const Chunk* c = chunkFor(index);
+    uint32_t tid = LogTemplates::kRaw;
+    if (c) decodeAt(*c, dataOffset(*c, (size_t)(index - c->first)), tid, nullptr);
+    return tid;
+}
+
+static inline uint64_t readDelta(const uint8_t* p, size_t& off) {
+    uint64_t v = 0;
+    for (int shift = 0; ; shift += 7) {
+        uint8_t b = p[off++];
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+int64_t LogStore::timeOf(uint64_t index) const {
+    const Chunk* c = chunkFor(index);
+    if (!c) return -1;
+    size_t i = (size_t)(index - c->first);
+    const Mark& m = c->marks[i / kMarkEvery];
+    int64_t ns = m.ns;
+    size_t off = m.timeOff;
+    for (size_t k = i % kMarkEvery; k; --k) ns += (int64_t)readDelta(c->times.data(), off);
+    return ns;
+}
+
+uint64_t LogStore::lowerBoundTime(int64_t ns) const {
+    if (chunks_.empty()) return end_;
+    // the answer is in the last chunk (and after the last mark) that starts strictly before ns; times
+    // can repeat, so anything starting at exactly ns may still have equal lines in front of it
+    auto it = std::lower_bound(chunks_.begin(), chunks_.end(), ns,
+        [](const std::shared_ptr<Chunk>& c, int64_t t) { return c->marks.front().ns < t; });
+    if (it == chunks_.begin()) return begin();
+    const Chunk& c = **--it;
+    auto mk = std::lower_bound(c.marks.begin(), c.marks.end(), ns,
+        [](const Mark& m, int64_t t) { return m.ns < t; });
+    size_t mi = (size_t)(mk - c.marks.begin()) - 1;
+    size_t i = mi * kMarkEvery, n = c.count;
+    int64_t t = c.marks[mi].ns;
+    size_t off = c.marks[mi].timeOff;
+    while (t < ns) {
+        if (++i == n || i % kMarkEvery == 0) break;   // the next mark / chunk is already known to be >= ns
+        t += (int64_t)readDelta(c.times.data(), off);
+    }
+    return c.first + i;
+}
+
+void LogStore::search(std::string_view needle, uint64_t from, uint64_t to, std::vector<uint64_t>& hits,
+    FrameArena& scratch) const {
+    if (needle.empty()) return;
+    from = std::max(from, begin());
+    to = std::min(to, end_);
+    if (from >= to) return;
+
+    // Decide per template once: a literal hit matches every line of the template, and a needle with
+    // delimiters that can't line up with the template skips it entirely. A needle without delimiters
+    // can only sit inside a single field, so scan the packed fields; only needles straddling literal
+    // text and a field need the line rendered.
+    enum : uint8_t { kSkip, kAll, kFields, kRender };
+    bool simple = std::none_of(needle.begin(), needle.end(), [](char ch) { return LogTemplates::isDelimiter(ch); });
+    const uint32_t nt = (uint32_t)templates_.size();
+    uint8_t* mode = scratch.allocArray<uint8_t>(nt);
+    for (uint32_t t = 0; t < nt; ++t) {
+        if (templates_.literalContains(t, needle)) mode[t] = kAll;
+        else if (simple || t == LogTemplates::kRaw) mode[t] = kFields;
+        else mode[t] = templates_.spansFields(t, needle) ? kRender : kSkip;
+    }
+    // before rendering, every needle piece that isn't in the template text must be in the fields;
+    // inFields[t] is a bitmask over the first 64 pieces (the rest are left to the render check)
+    std::string_view* pieces = scratch.allocArray<std::string_view>(std::min<size_t>(needle.size() / 2 + 1, 64));
+    size_t np = 0;
+    for (size_t a = 0; a < needle.size();) {
+        size_t b = a;
+        while (b < needle.size() && !LogTemplates::isDelimiter(needle[b])) ++b;
+        if (b > a && np < 64) pieces[np++] = needle.substr(a, b - a);
+        a = b + 1;
+    }
+    uint64_t* inFields = scratch.allocArray<uint64_t>(nt);
+    for (uint32_t t = 0; t < nt; ++t)
+        if (mode[t] == kRender)
+            for (size_t k = 0; k < np; ++k)
+                if (!templates_.literalContains(t, pieces[k])) inFields[t] |= 1ull << k;
+
+    // fields are matched in their encoded form: dictionary values once per chunk, numbers only when
+    // the pattern is all digits; only lines that still need rendering get decoded
+    auto digitsOnly = [](std::string_view v) { return std::all_of(v.begin(), v.end(), [](char ch) { return ch >= '0' && ch <= '9'; }); };
+    auto numbers = [&](FieldPatterns& p) {
+        p.value = scratch.allocArray<uint64_t>(p.n);
+        p.scale = scratch.allocArray<uint64_t>(p.n);
+        for (size_t k = 0; k < p.n; ++k) {
+            // a stored number has at most 18 digits, so a longer pattern never matches one
+            if (p.pats[k].size() > 18 || !digitsOnly(p.pats[k])) continue;
+            p.digitsOnly |= 1ull << k;
+            p.value[k] = 0;
+            p.scale[k] = 1;
+            for (char ch : p.pats[k]) { p.value[k] = p.value[k] * 10 + (uint64_t)(ch - '0'); p.scale[k] *= 10; }
+        }
+    };
+    FieldPatterns whole{ &needle, 1, 0, nullptr, nullptr, scratch.allocArray<uint64_t>(kDictMax) };
+    FieldPatterns parts{ pieces, np, 0, nullptr, nullptr, scratch.allocArray<uint64_t>(kDictMax) };
+    numbers(whole);
+    numbers(parts);
+    const bool anyRender = std::find(mode, mode + nt, (uint8_t)kRender) != mode + nt;
+    std::string& f = decoded_;
+    for (const Chunk* c = chunkFor(from); c; ) {
+        size_t n = c->count;
+        size_t i = (size_t)(from - c->first);
+        size_t off = dataOffset(*c, i);
+        matchDict(*c, whole);
+        if (anyRender) matchDict(*c, parts);
+        for (; i < n && c->first + i < to; ++i) {
+            const size_t at = off;
+            uint32_t tid = 0;
+            off = decodeAt(*c, at, tid, nullptr);   // only lines that need their fields get them decoded
+            bool hit = false;
+            switch (mode[tid]) {
+            case kAll: hit = true; break;
+            case kFields: hit = fieldsHave(*c, at, whole, 1); break;
+            case kRender:
+                hit = fieldsHave(*c, at, parts, inFields[tid]);
+                if (hit) {
+                    decodeAt(*c, at, tid, &f);
+                    templates_.render(tid, f, render_);
+                    hit = render_.find(needle) != std::string::npos;
+                }
+                break;
+            default: break;
+            }
+            if (hit) hits.push_back(c->first + i);
+        }
+        from = c->first + n;
+        c = from < to ? chunkFor(from) : nullptr;
+    }
+}
+
+LogStore::Snapshot LogStore::snapshot() {
+    Snapshot s;
+    s.chunks_.assign(chunks_.begin(), chunks_.end());
+    s.templates_ = &templates_;
+    s.begin_ = begin();
+    s.end_ = end_;
+    s.originNs_ = originNs_;
+    sealed_ = !chunks_.empty();
+    return s;
+}
+
+void LogStore::Snapshot::forEach(FunctionRef<bool(const LineRef&)> f) const {
+    std::string fields;
+    for (const auto& cp : chunks_) {
+        const Chunk& c = *cp;
+        size_t off = 0, dataOff = 0;
+        int64_t ns = 0;
+        uint32_t tid = 0;
+        for (size_t i = 0; i < c.count; ++i) {
+            if (i % kMarkEvery == 0) { ns = c.marks[i / kMarkEvery].ns; off = c.marks[i / kMarkEvery].timeOff; }
+            else ns += (int64_t)readDelta(c.times.data(), off);
+            dataOff = decodeAt(c, dataOff, tid, &fields);
+            if (!f(LineRef{ c.first + i, tid, fields, ns })) return;
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LogTemplates.h"
+#include "../core/FunctionRef.h"
+
+class FrameArena;
+
+// --------- full-fidelity session log ----------
+// Every ingested line ends up here, even when the live view (LogBuffer) shows only a sample.
+// Lines are stored interned: each line is its template id plus its variable fields, encoded per
+// chunk: a plain decimal number as a LEB128 integer, any other field as a code into the chunk's
+// value dictionary (dates, ciphers, addresses repeat), so a typical field costs one or two bytes.
+// Each line is prefixed with its encoded length. Chunks of 1 MB never move once written; when the
+// byte budget is exceeded the oldest chunk is dropped. Lines are addressed by absolute index (0 =
+// first line of the session), so indices stay valid while old chunks are evicted.
+// Each line also carries its monotonic receive time in ns, stored as a LEB128 delta from the previous
+// line (2-4 bytes typically) with an absolute mark every 64 lines, so time lookups binary-search the
+// chunks and marks and decode at most 63 deltas. The marks also hold the line's data offset, so
+// reaching any line skips at most 63 length prefixes.
+class LogStore {
+    struct Chunk;
+
+public:
+    explicit LogStore(size_t maxBytes = 256u << 20);
+
+    // returns the line's index; recvNs is clamped to be non-decreasing
+    uint64_t append(std::string_view line, int64_t recvNs, uint32_t* tidOut = nullptr);
+    void clear();
+
+    uint64_t begin() const { return chunks_.empty() ? end_ : chunks_.front()->first; }   // oldest retained
+    uint64_t end() const { return end_; }                                               // one past newest
+    size_t bytes() const { return bytes_; }
+    uint64_t rawBytes() const { return rawBytes_; }    // what the same lines would take as plain text
+    const LogTemplates& templates() const { return templates_; }
+
+    bool line(uint64_t index, std::string& out) const;   // false if evicted / out of range
+    uint32_t templateOf(uint64_t index) const;
+
+    // ---------- receive times (steady clock ns) ----------
+    int64_t originNs() const { return originNs_; }    // receive time of the first line of the session
+    int64_t timeOf(uint64_t index) const;             // -1 if evicted / out of range
+    uint64_t lowerBoundTime(int64_t ns) const;        // first retained line received at or after ns; end() if none
+    // [first, last) lines received in [t1, t2]
+    void timeRange(int64_t t1, int64_t t2, uint64_t& first, uint64_t& last) const {
+        first = lowerBoundTime(t1);
+        last = t2 < t1 ? first : lowerBoundTime(t2 + 1);
+    }
+
+    // appends indices in [from, to) whose text contains `needle` (case-sensitive); per-call tables
+    // come from `scratch`, so an incremental search every frame doesn't touch the heap
+    void search(std::string_view needle, uint64_t from, uint64_t to, std::vector<uint64_t>& hits,
+        FrameArena& scratch) const;
+
+    // ---------- snapshots ----------
+    // A read-only view of the retained lines that another thread can walk while appends continue:
+    // it shares the chunks (eviction can't free them under it) and seals the open chunk, so the next
+    // append starts a new one and nothing the snapshot sees is ever written again.
+    // fields is the packed form LogTemplates::split() produces, valid during the callback only.
+    struct LineRef { uint64_t index; uint32_t tid; std::string_view fields; int64_t ns; };
+    class Snapshot {
+    public:
+        uint64_t begin() const { return begin_; }
+        uint64_t end() const { return end_; }
+        int64_t originNs() const { return originNs_; }
+        const LogTemplates& templates() const { return *templates_; }   // every tid of these lines is stable
+        void forEach(FunctionRef<bool(const LineRef&)> f) const;        // in order; false stops early
+
+    private:
+        friend class LogStore;
+        std::vector<std::shared_ptr<const Chunk>> chunks_;
+        const LogTemplates* templates_{ nullptr };
+        uint64_t begin_{ 0 }, end_{ 0 };
+        int64_t originNs_{ -1 };
+    };
+    Snapshot snapshot();   // O(chunks); the store must outlive the snapshot (templates are shared)
+
+private:
+    // line k*kMarkEvery: its time, where its successors' time deltas start, where its data starts
+    struct Mark { int64_t ns; uint32_t timeOff; uint32_t dataOff; };
+    struct Chunk {
+        uint64_t first{ 0 };
+        uint32_t count{ 0 };              // lines
+        std::vector<char> data;           // per line: LEB128 length, LEB128 tid, fields; reserved once, never reallocated
+        std::vector<uint8_t> times;       // LEB128 receive-time deltas, except for marked lines
+        std::vector<Mark> marks;
+        std::string dict;                 // value dictionary, packed
+        std::vector<uint32_t> dictEnds;   // end offset of each value in dict
+        uint32_t inlined{ 0 };            // fields stored as text (not numbers, not in the dictionary)
+        int64_t lastNs{ 0 };
+        size_t cost() const {
+            return data.capacity() + times.size() + marks.size() * sizeof(Mark)
+                + dict.size() + dictEnds.size() * sizeof(uint32_t);
+        }
+    };
+    static constexpr size_t kChunkBytes = 1u << 20;
+    static constexpr size_t kMarkEvery = 64;
+    static constexpr uint32_t kDictMax = 4096;        // values per chunk; later new values are stored inline
+    static constexpr size_t kDictValueMax = 64;       // longer values are always stored inline
+    static constexpr size_t kDictSlots = 2 * kDictMax;
+
+    const Chunk* chunkFor(uint64_t index) const;
+    static size_t dataOffset(const Chunk& c, size_t i);
+    // reads the line at data offset off: its tid and, unless fields is null, its fields in split()'s
+    // packed form; returns the next line's offset
+    static size_t decodeAt(const Chunk& c, size_t off, uint32_t& tid, std::string* fields);
+    // search(): patterns looked for inside single fields; dict[code] has bit k set when pattern k is in
+    // that dictionary value of the chunk at hand
+    struct FieldPatterns {
+        const std::string_view* pats;
+        size_t n;
+        uint64_t digitsOnly;              // bit k: pattern k could be inside a number
+        uint64_t* value;                  // digitsOnly patterns: their value and 10^length
+        uint64_t* scale;
+        uint64_t* dict;
+        uint64_t possible{ 0 };           // patterns any field of the chunk could hold
+    };
+    static void matchDict(const Chunk& c, FieldPatterns& p);
+    // whether the fields of the line at data offset off hold every pattern in want, without decoding them
+    static bool fieldsHave(const Chunk& c, size_t off, const FieldPatterns& p, uint64_t want);
+    void encode(Chunk& c, uint32_t tid);    // fields_ -> c.data
+    uint32_t dictCode(Chunk& c, std::string_view value);   // kDictMax = not in the dictionary
+
+    LogTemplates templates_;
+    std::string fields_;                  // append() scratch
+    std::string encoded_;                 // append() scratch
+    std::vector<uint32_t> dictSlots_;     // the open chunk's dictionary: hash -> code + 1
+    mutable std::string decoded_;         // line()/search() scratch
+    mutable std::string render_;          // search() scratch
+    std::deque<std::shared_ptr<Chunk>> chunks_;
+    size_t maxBytes_;
+    size_t bytes_{ 0 };
+    uint64_t rawBytes_{ 0 };
+    uint64_t end_{ 0 };
+    int64_t originNs_{ -1 }, lastNs_{ 0 };
+    bool sealed_{ false };     // the last chunk is shared with a snapshot
+};
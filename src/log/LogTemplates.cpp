@@ -0,0 +1,131 @@
+#include "LogTemplates.h"
+#include <cstring>
+
+LogTemplates::LogTemplates() {
+    add(std::string(1, kField));   // not in ids_: a one-field line gets its own template
+}
+
+void LogTemplates::add(const std::string& text) {
+    uint32_t id = size_.load(std::memory_order_relaxed);
+    auto& block = blocks_[id / kBlock];
+    if (!block) block.reset(new std::string[kBlock]);
+    block[id % kBlock] = text;
+    size_.store(id + 1, std::memory_order_release);
+}
+
+bool LogTemplates::isDelimiter(char c) {
+    switch (c) {
+    case ' ': case '\t': case '=': case ':': case ',': case ';': case '/': case '[': case ']':
+    case '(': case ')': case '<': case '>': case '\'': case '"': case '|':
+        return true;
+    default:
+        return false;
+    }
+}
+
+uint32_t LogTemplates::split(std::string_view line, std::string& fields) {
+    fields.clear();
+    if (memchr(line.data(), '\0', line.size()) || memchr(line.data(), kField, line.size())) {
+        fields.assign(line.data(), line.size());
+        return kRaw;
+    }
+    scratch_.clear();
+    size_t i = 0, n = line.size();
+    while (i < n) {
+        if (isDelimiter(line[i])) { scratch_ += line[i++]; continue; }
+        size_t j = i;
+        bool digit = false;
+        while (j < n && !isDelimiter(line[j])) { digit |= (line[j] >= '0' && line[j] <= '9'); ++j; }
+        if (digit) {
+            scratch_ += kField;
+            fields.append(line.data() + i, j - i);
+            fields += '\0';
+        }
+        else scratch_.append(line.data() + i, j - i);
+        i = j;
+    }
+    auto it = ids_.find(scratch_);
+    if (it != ids_.end()) return it->second;
+    uint32_t id = (uint32_t)size();
+    if (id >= kMaxTemplates) { fields.assign(line.data(), line.size()); return kRaw; }
+    add(scratch_);
+    ids_.emplace(at(id), id);
+    bytes_ += scratch_.size();
+    return id;
+}
+
+void LogTemplates::render(uint32_t tid, std::string_view fields, std::string& out) const {
+    out.clear();
+    if (tid == kRaw || tid >= size()) { out.assign(fields.data(), fields.size()); return; }
+    const char* f = fields.data();
+    const char* fend = f + fields.size();
+    for (char c : at(tid)) {
+        if (c != kField) { out += c; continue; }
+        const char* z = static_cast<const char*>(memchr(f, '\0', fend - f));
+        if (!z) z = fend;
+        out.append(f, z);
+        f = z < fend ? z + 1 : fend;
+    }
+}
+
+bool LogTemplates::literalContains(uint32_t tid, std::string_view needle) const {
+    if (tid == kRaw) return false;
+    std::string_view tx = at(tid);
+    for (size_t a = 0; a <= tx.size();) {
+        size_t b = tx.find(kField, a);
+        if (b == std::string_view::npos) b = tx.size();
+        if (tx.substr(a, b - a).find(needle) != std::string_view::npos) return true;
+        a = b + 1;
+    }
+    return false;
+}
+
+// Fields never contain delimiters, so every delimiter of the needle has to line up with a delimiter
+// of the template text, and every piece between two needle delimiters is a whole token: either the
+// same literal or a field (which must then contain a digit). Only the outer pieces may be partial.
+bool LogTemplates::spansFields(uint32_t tid, std::string_view needle) const {
+    if (tid == kRaw) return true;
+    std::string_view tx = at(tid);
+    auto tokenAt = [&](size_t pos) {
+        size_t e = pos;
+        while (e < tx.size() && !isDelimiter(tx[e])) ++e;
+        return tx.substr(pos, e - pos);
+    };
+    auto hasDigit = [](std::string_view v) {
+        for (char c : v) if (c >= '0' && c <= '9') return true;
+        return false;
+    };
+    size_t d0 = 0;
+    while (d0 < needle.size() && !isDelimiter(needle[d0])) ++d0;
+    if (d0 == needle.size()) return true;   // no delimiter: caller scans fields directly
+    std::string_view head = needle.substr(0, d0);
+
+    for (size_t j = 0; j < tx.size(); ++j) {
+        if (tx[j] != needle[d0]) continue;
+        size_t s = j;
+        while (s > 0 && !isDelimiter(tx[s - 1])) --s;
+        std::string_view before = tx.substr(s, j - s);
+        bool ok = before == std::string_view(&kField, 1)
+            ? true
+            : before.size() >= head.size() && before.substr(before.size() - head.size()) == head;
+        size_t pos = j + 1, n = d0 + 1;
+        while (ok) {
+            size_t e = n;
+            while (e < needle.size() && !isDelimiter(needle[e])) ++e;
+            std::string_view piece = needle.substr(n, e - n);
+            std::string_view tok = tokenAt(pos);
+            bool field = tok == std::string_view(&kField, 1);
+            if (e == needle.size()) {   // last piece: prefix of the next token
+                ok = field || tok.substr(0, piece.size()) == piece;
+                break;
+            }
+            ok = field ? hasDigit(piece) : tok == piece;
+            pos += tok.size();
+            ok = ok && pos < tx.size() && tx[pos] == needle[e];
+            ++pos;
+            n = e + 1;
+        }
+        if (ok) return true;
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// --------- message template interning ----------
+// A line is split into a template and its variable fields: every token (run of characters between
+// delimiters such as ' ', '=', ':', '/') that contains a digit becomes a field and is replaced by
+// kField in the template. "TLS: soft reset sec=3600/3600 bytes=4201/-1" and the next soft reset share
+// one template and differ only in the packed fields ("3600\0" "3600\0" "4201\0" "-1\0").
+// Template 0 is the raw passthrough used for lines we can't split (control bytes, dictionary full).
+// Texts live in fixed blocks that never move, so another thread may read any id below a size() it
+// observed earlier (LogStore snapshots) while the UI thread keeps adding templates.
+class LogTemplates {
+public:
+    static constexpr char kField = '\x01';
+    static constexpr uint32_t kRaw = 0;
+    static constexpr size_t kMaxTemplates = 1u << 16;
+
+    LogTemplates();
+
+    uint32_t split(std::string_view line, std::string& fields);           // fields: overwritten
+    void render(uint32_t tid, std::string_view fields, std::string& out) const;   // out: overwritten
+    std::string_view text(uint32_t tid) const { return at(tid); }
+    size_t size() const { return size_.load(std::memory_order_acquire); }
+    size_t bytes() const { return bytes_; }
+
+    // search helpers: a literal hit matches every line of the template; spansFields says whether a
+    // needle containing delimiters could still match once the fields are filled in
+    bool literalContains(uint32_t tid, std::string_view needle) const;
+    bool spansFields(uint32_t tid, std::string_view needle) const;
+
+    static bool isDelimiter(char c);
+
+private:
+    static constexpr size_t kBlock = 1024;
+    const std::string& at(uint32_t tid) const { return blocks_[tid / kBlock][tid % kBlock]; }
+    void add(const std::string& text);
+
+    std::array<std::unique_ptr<std::string[]>, kMaxTemplates / kBlock> blocks_;   // stable storage behind ids_ keys
+    std::atomic<uint32_t> size_{ 0 };
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    std::string scratch_;
+    size_t bytes_{ 0 };
+};
@@ -1,7 +1,14 @@
 // main.cpp
+#include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
 #include <string>
 #include <stdexcept>
+#include <vector>
 
 #ifndef APIENTRY
 #define APIENTRY
@@ -17,7 +24,37 @@
 #include <backends/imgui_impl_opengl3.h>
 
 // --- Your modules ---
+#include "core/AllocProfiler.h"
+#include "core/PrivateDir.h"
+#include "core/FrameArena.h"
+#include "core/FuzzyIndex.h"
+#include "core/HdrHistogram.h"
+#include "core/Metrics.h"
+#include "core/TextBench.h"
+#include "log/LogExport.h"
+#include "log/LogIngest.h"
+#include "log/LogShare.h"
+#include "log/LogStore.h"
+#include "vpn/ConnectionHistory.h"
+#include "vpn/HistoryBench.h"
 #include "vpn/OpenVpnRunner.h"  //  src/core/ĳ "core/OpenVpnRunner.h"
+#include "net/ControlServer.h"
+#include "net/DnsBench.h"
+#include "net/EchoServer.h"
+#include "net/LatencyMonitor.h"
+#include "net/MetricsServer.h"
+#include "net/NetWatcher.h"
+#include "net/ResolverCache.h"
+#include "net/ServerProber.h"
+#include "net/SpeedBench.h"
+#include "net/SpeedTest.h"
+#include "net/SpeedTestServer.h"
+#include "vpn/ProcessMonitor.h"
+#include "vpn/ServerList.h"
+#include "ui/LogPaneCache.h"
+#include "ui/SdfFont.h"
+#include "ui/ServerMap.h"
+#include "ui/UiBench.h"
 #include "ui/Panels.h"          // ͬʵ·
 
 // --------------- Globals ---------------
@@ -26,7 +63,15 @@ static int g_Width = 1280, g_Height = 720;
 
 // VPN globals
 static OpenVpnRunner g_vpn;
-static LogBuffer     g_log;
+static LogBuffer     g_log;      // live view
+static LogStore      g_logStore; // every line of the session
+static LogIngest     g_ingest;   // reader thread -> store + view, budgeted per frame
+static LogExporter   g_exporter; // "Export logs": snapshot of g_logStore written on a worker
+static ExportControls g_exportUi;
+// --log-share [--log-share-name NAME]: the log also goes to a shared-memory ring that tools/logtail
+// follows from another process (see LogShare.h)
+static LogShareWriter g_logShare;
+static const char* g_logShareName = nullptr;
 
 static OpenVpnConfig g_cfg{
     L"C:/Program Files/OpenVPN/bin/openvpn.exe",
@@ -34,6 +79,153 @@ static OpenVpnConfig g_cfg{
     {},
 };
 
+// Latency probes through the tunnel (TCP connect time unless the target runs a UDP echo)
+static std::vector<LatencyTarget> g_latencyTargets{
+    { "cloudflare", "1.1.1.1", 443, ProbeKind::Tcp, 150.0 },
+    { "google", "8.8.8.8", 443, ProbeKind::Tcp, 150.0 },
+};
+static LatencyMonitor g_latency;
+static EchoServer g_echo;   // --latency-echo: loopback targets for self-test without a tunnel
+static std::vector<LatencyStats> g_latencyStats;
+static std::vector<LatencyAlert> g_latencyAlerts;
+
+// Child process resources (openvpn.exe + scripts it spawns)
+static ProcessMonitor g_procmon;
+static ProcessLimits g_procLimits{ 1024.0, 10000, 0.0, 10 };
+static bool g_procAutoRestart = false;
+static std::vector<ProcessSeries> g_procSeries;
+static bool g_showProcess = true;   // View > Process; hidden = no snapshot copies
+
+static VerbosityControls g_verbUi;
+
+// Remotes of the active and candidate profiles, resolved in the background (--dns-server IP to use
+// one server, e.g. a local stub); the runner hands the child cached addresses
+static ResolverCache g_resolver;
+
+// --detached: the tunnel survives GUI exits and crashes; the journal lets the next run re-attach
+static TunnelJournal g_journal;
+static const char* g_journalPath = nullptr;   // --journal FILE, default tunnel.journal in the per-user directory
+static int64_t g_vpnStartedUnix = 0;
+
+// --control NAME: scripts drive the tunnel over the Unix domain socket NAME in the per-user
+// directory (see ControlServer.h); profiles they name must be --profiles entries
+static ControlServer g_control;
+static const char* g_controlName = nullptr;
+static ControlStatus g_controlStatus;
+static std::vector<ControlCommand> g_controlCmds;
+
+// --metrics-port N: Prometheus text on http://127.0.0.1:N/metrics. The runner registers the tunnel's
+// own metrics; the rest are updated once per frame.
+static MetricsRegistry g_metrics;
+static MetricsServer g_metricsServer;
+static int g_metricsPort = -1;   // -1 = off
+// label sets are literals: the registry keeps pointers to them
+static const struct { const char* name; const char* label; } kTunnelStates[] = {
+    { "CONNECTING", "state=\"CONNECTING\"" }, { "WAIT", "state=\"WAIT\"" }, { "AUTH", "state=\"AUTH\"" },
+    { "GET_CONFIG", "state=\"GET_CONFIG\"" }, { "ASSIGN_IP", "state=\"ASSIGN_IP\"" }, { "ADD_ROUTES", "state=\"ADD_ROUTES\"" },
+    { "CONNECTED", "state=\"CONNECTED\"" }, { "RECONNECTING", "state=\"RECONNECTING\"" }, { "EXITING", "state=\"EXITING\"" },
+};
+static constexpr size_t kFrameWindow = 600;   // frame-time percentiles over the last ~10 s
+static struct {
+    MetricsRegistry::Gauge up, uptime, state[std::size(kTunnelStates)];
+    MetricsRegistry::Counter logLines, logEvicted, logSampledOut, frames;
+    MetricsRegistry::Gauge frameQuantile[3];
+    MetricsRegistry::Histogram lineLatency;
+    HdrHistogram frameUs{ 10ull * 1000 * 1000 };
+    uint32_t window[kFrameWindow]{};
+} g_appMetrics;
+
+// Interface and route changes straight from the system (see NetWatcher.h), within a frame of
+// happening. When the uplink is lost under a CONNECTED tunnel and then comes back or moves to another
+// interface, or the tunnel adapter or its routes vanish while openvpn still says CONNECTED, openvpn
+// reconnects at once instead of waiting out its ping timeout on a dead connection. Only CONNECTED
+// counts: while it connects, reconnects or exits, openvpn removes and restores routes itself.
+static NetWatcher g_netWatch;
+static NetView g_netView;
+static std::vector<NetEvent> g_netEvents;
+static uint64_t g_netSeen = 0;        // NetWatcher::changes() g_netView reflects
+static uint32_t g_uplinkIndex = 0;    // interface of the last physical default route (kept while the tunnel replaces it)
+static bool g_uplinkLost = false;     // it went down while the tunnel was CONNECTED
+enum class NetTrigger { None, UplinkBack, TunnelDown, TunnelRoutes };
+static NetTrigger g_netTrigger = NetTrigger::None;
+static int64_t g_netTriggerNs = 0;    // last network event since the trigger was armed
+static size_t g_tunnelRoutes = 0;     // default-covering tunnel routes seen while CONNECTED
+static std::string g_netTriggerWhy;
+static constexpr int64_t kNetQuietNs = 1000000000;   // the network must settle this long before a reconnect
+
+// View > Speed test: goodput and latency under load through the tunnel (see SpeedTest.h).
+// --speed-server [HOST:]PORT runs the far end here, e.g. on the machine behind the tunnel.
+static SpeedTest g_speedTest;
+static SpeedTestResult g_speedResult;
+static SpeedTestControls g_speedUi;
+static bool g_showSpeed = false;
+static SpeedTestServer g_speedServer;
+static const char* g_speedServerAddr = nullptr;
+
+// --log-latency-probe pipe|pty: instead of openvpn, runs this exe as the child (--log-latency-child),
+// which prints a timestamped line every 20 ms the way a C program does (printf, no fflush); reports
+// child write -> line on screen percentiles once it exits. Compares plain pipes with --pty.
+static struct {
+    const char* mode{ nullptr };
+    bool started{ false };
+    int exitFrames{ 0 };              // frames since the child exited: lines still in flight get shown
+    HdrHistogram us{ 60ull * 1000 * 1000 };
+} g_probe;
+
+// --history DIR: one row per finished tunnel session (see ConnectionHistory.h), shown in View > History
+static ConnectionHistory g_history;
+static const char* g_historyDir = "history";
+static HistoryControls g_historyUi;
+static bool g_showHistory = false;
+static struct {
+    bool active{ false };             // a tunnel started or re-attached by this run is up
+    std::string profile, remote;      // as recorded
+} g_session;
+
+// Session record / replay: --record FILE, --replay FILE [--replay-speed X], --replay-bench FILE
+static SessionRecorder g_recorder;
+static const char* g_replayPath = nullptr;
+static double g_replaySpeed = 1.0;        // 0 = as fast as possible (threaded replay only)
+static bool g_replayBench = false;        // stepped replay, fixed 60 Hz recording time per frame
+static HdrHistogram g_benchFrameUs;
+
+static FrameArena g_frameArena;   // UI thread scratch, reset every frame
+static LogPaneCache g_logCache;   // log rows cached in a texture; View > Cached log pane toggles it
+static bool g_cacheLogs = true;
+// Distance-field font for the log pane: baked the first time it is turned on, then any zoom/DPI
+// without rebuilding glyphs
+static SdfFont g_sdfFont;
+static bool g_sdfLogs = false;
+static bool g_sdfFailed = false;   // the bake failed: the menu item stays disabled
+static const char* g_sdfFontPath = "C:\\Windows\\Fonts\\consola.ttf";   // --sdf-font PATH
+
+// Server map: --servers FILE (CSV) or --map-demo N; servers are probed while the window is open
+static std::vector<ServerEntry> g_servers;
+static ServerMap g_serverMap;
+static ServerProber g_prober;
+static std::vector<ProbeResult> g_probeResults;
+static std::vector<uint32_t> g_probeIndex;            // prober endpoint -> g_servers (TCP servers only)
+static bool g_probeOn = false;                        // prober started for the open map, even if it failed
+static ServerMapControls g_mapUi;
+static bool g_showMap = false;
+static const char* g_serversPath = nullptr;
+static size_t g_mapDemo = 0;                          // made-up servers and latencies, no probing
+static uint32_t g_mapRemote = ServerMap::kNone;       // server the next start connects to
+static uint32_t g_mapActive = ServerMap::kNone;       // server the running tunnel was started with
+
+// Profile finder (View > Find profile, Ctrl+P): .ovpn files from --profiles DIR, then every server
+static FuzzyIndex g_finder;
+static ProfileFinderControls g_finderUi;
+static bool g_showFinder = false;
+static const char* g_profilesDir = nullptr;
+static std::vector<std::wstring> g_profilePaths;   // finder entries [0, size) are profiles, the rest g_servers
+
+// Heap allocation profiler; --alloc-check fails the run if a warmed-up frame allocates
+static bool g_showAllocs = false;
+static int g_allocCheckFrames = 0;      // 0 = off
+static constexpr int kAllocWarmupFrames = 300;
+static int g_allocFailures = 0;
+
 // --------------- Helpers ----------------
 static void GlfwErrorCallback(int error, const char* desc) {
     std::fprintf(stderr, "GLFW Error %d: %s\n", error, desc);
@@ -68,6 +260,7 @@ static void InitGlad() {
 
 static void InitImGui() {
     IMGUI_CHECKVERSION();
+    AllocProfiler::installImGuiHooks();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
 
@@ -76,11 +269,596 @@ static void InitImGui() {
 
     ImGui_ImplGlfw_InitForOpenGL(g_Window, true);
     ImGui_ImplOpenGL3_Init("#version 330");
+
+    // follow the monitor's DPI (GLFW_SCALE_TO_MONITOR resizes the window, this scales the text)
+    ImGui::GetStyle().FontScaleDpi = ImGui_ImplGlfw_GetContentScaleForWindow(g_Window);
+    glfwSetWindowContentScaleCallback(g_Window, [](GLFWwindow*, float x, float) {
+        ImGui::GetStyle().FontScaleDpi = x;
+    });
+}
+
+// Only once SDF text is on (--sdf-font or the View menu): most runs never pay for the bake
+static void LoadSdfFont() {
+    if (!g_sdfLogs || g_sdfFont.ready() || g_sdfFailed) return;
+    std::string err;
+    for (const char* dir : { "shaders", "../shaders" })   // run from the repo or the project folder
+        if (g_sdfFont.load(g_sdfFontPath, dir, err)) return;
+    g_sdfLogs = false;
+    g_sdfFailed = true;
+    g_ingest.submit(g_frameArena.format("[sdf] %s", err.c_str()));
+}
+
+static void LoadServerMap() {
+    std::string err;
+    if (g_mapDemo) MakeDemoServers(g_mapDemo, 12345, g_servers);
+    else if (g_serversPath && !LoadServerList(g_serversPath, g_servers, err)) g_ingest.submit("[map] " + err);
+    if (g_servers.empty()) return;
+    bool ok = false;
+    for (const char* dir : { "shaders", "../shaders" })
+        if ((ok = g_serverMap.load(dir, err))) break;
+    if (!ok) g_ingest.submit(g_frameArena.format("[map] %s; drawing markers without instancing", err.c_str()));
+    g_serverMap.setServers(g_servers);
+    g_showMap = true;
+}
+
+// Applies probe results (or made-up ones for --map-demo) and the panel's requests
+static void PollServerMap() {
+    if (g_servers.empty()) return;
+    if (g_mapDemo) {
+        // a probe batch's worth per frame: latency grows with distance from central Europe
+        static uint32_t rng = 1;
+        for (int k = 0; k < (int)ServerProber::kMaxInFlight; ++k) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            const uint32_t i = rng % (uint32_t)g_servers.size();
+            const float dLat = g_servers[i].lat - 50.0f, dLon = g_servers[i].lon - 8.0f;
+            const float ms = (rng >> 24) < 8 ? -1.0f : 8.0f + 1.4f * std::sqrt(dLat * dLat + dLon * dLon) + ((rng >> 16) & 31);
+            g_serverMap.setLatency(i, ms);
+        }
+    }
+    else if (g_showMap && !g_probeOn) {
+        // once per opening: a failed start is not retried every frame
+        g_probeOn = true;
+        std::vector<ProbeEndpoint> eps;
+        g_probeIndex.clear();
+        for (size_t i = 0; i < g_servers.size(); ++i) {
+            if (!g_servers[i].tcp) continue;   // UDP servers do not answer a bare probe
+            eps.push_back({ g_servers[i].host, g_servers[i].port });
+            g_probeIndex.push_back((uint32_t)i);
+        }
+        if (!eps.empty() && !g_prober.start(std::move(eps))) g_ingest.submit("[map] Winsock unavailable; servers are not probed");
+    }
+    else if (!g_showMap && g_probeOn) {
+        g_prober.stop();
+        g_probeOn = false;
+    }
+    g_prober.poll(g_probeResults);
+    for (const ProbeResult& r : g_probeResults) g_serverMap.setLatency(g_probeIndex[r.index], r.ms);
+    g_mapUi.probing = g_prober.running();
+
+    if (g_mapUi.useSelected && g_serverMap.selected() != ServerMap::kNone) {
+        g_mapRemote = g_serverMap.selected();
+        const ServerEntry& e = g_servers[g_mapRemote];
+        g_cfg.remoteHost.assign(e.host.begin(), e.host.end());   // host names are ASCII
+        g_cfg.remotePort = e.port;
+        g_resolver.prefetch(e.host);
+        g_mapUi.remote = e.host + ":" + std::to_string(e.port);
+    }
+    if (g_mapUi.clearRemote) {
+        g_mapRemote = ServerMap::kNone;
+        g_cfg.remoteHost.clear();
+        g_mapUi.remote.clear();
+    }
+    g_mapUi.useSelected = g_mapUi.clearRemote = false;
+    g_serverMap.setConnected(g_vpn.running() ? g_mapActive : ServerMap::kNone);
+}
+
+static void LoadProfileFinder() {
+    std::vector<std::string> names;
+    if (g_profilesDir && !ListProfiles(std::filesystem::path(g_profilesDir).wstring(), g_profilePaths, names))
+        g_ingest.submit(g_frameArena.format("[profiles] no .ovpn files in %s", g_profilesDir));
+    size_t bytes = 0;
+    for (const std::string& n : names) bytes += n.size();
+    for (const ServerEntry& e : g_servers) bytes += e.name.size();
+    g_finder.clear();
+    g_finder.reserve(names.size() + g_servers.size(), bytes);
+    for (const std::string& n : names) g_finder.add(n);
+    for (const ServerEntry& e : g_servers) g_finder.add(e.name);
+    g_finder.search("");
+}
+
+static void PrefetchRemotes(const std::wstring& ovpn) {
+    std::vector<ProfileRemote> remotes;
+    ReadProfileRemotes(ovpn, remotes);
+    for (const ProfileRemote& r : remotes) g_resolver.prefetch(r.host);
+}
+
+static void StartResolver() {
+    g_resolver.start();
+    g_vpn.setResolver(&g_resolver);
+    g_prober.setResolver(&g_resolver);
+    PrefetchRemotes(g_cfg.ovpnFile);
+    for (const std::wstring& p : g_profilePaths) PrefetchRemotes(p);
+}
+
+// Ctrl+P opens the finder; a picked profile becomes the next start's config, a picked server its remote
+static void PollProfileFinder() {
+    if (g_finder.size() && ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_P)) g_showFinder = g_finderUi.focus = true;
+    const uint32_t i = g_finderUi.picked;
+    g_finderUi.picked = ~0u;
+    if (i == ~0u) return;
+    if (i < g_profilePaths.size()) {
+        g_cfg.ovpnFile = g_profilePaths[i];
+        PrefetchRemotes(g_cfg.ovpnFile);   // normally done at startup; refreshes a name that expired since
+        g_ingest.submit(g_frameArena.format("[profiles] next start uses %.*s", (int)g_finder.name(i).size(), g_finder.name(i).data()));
+    }
+    else {
+        g_serverMap.setSelected(i - (uint32_t)g_profilePaths.size());
+        g_mapUi.useSelected = g_showMap = true;   // PollServerMap sets the remote
+    }
+}
+
+static void StartLocalEcho() {
+    if (!g_echo.start()) { g_ingest.submit("[latency] local echo server failed to start"); return; }
+    g_latencyTargets.push_back({ "echo-tcp", "127.0.0.1", g_echo.port(), ProbeKind::Tcp, 5.0 });
+    g_latencyTargets.push_back({ "echo-udp", "127.0.0.1", g_echo.port(), ProbeKind::Udp, 5.0 });
+    g_latency.start(g_latencyTargets);
+}
+
+static void PollLatency() {
+    g_latency.snapshot(g_latencyStats);
+    g_latency.pollAlerts(g_latencyAlerts);
+    for (const auto& a : g_latencyAlerts)
+        g_ingest.submit(g_frameArena.format("[latency] %s: p95 %.1f ms %s SLO %.1f ms", a.name.c_str(), a.p95Ms,
+            a.breached ? "exceeds" : "back within", a.sloMs));
+}
+
+static void OnVpnLine(const std::string& line) {
+    g_control.log(line);
+    g_ingest.submit(line);
+}
+
+static void StartReplay() {
+    bool ok = g_replayBench ? g_vpn.openReplay(g_replayPath, OnVpnLine)
+                            : g_vpn.startReplay(g_replayPath, g_replaySpeed, OnVpnLine);
+    if (!ok) g_ingest.submit(g_frameArena.format("[replay] cannot open %s", g_replayPath));
+}
+
+// --replay-bench: prints frame-time percentiles once the recording is exhausted; true = done
+static bool StepReplayBench(int64_t frameUs) {
+    g_benchFrameUs.record((uint64_t)frameUs);
+    if (g_vpn.replaying() || !g_ingest.idle()) return false;
+    const IngestStats& in = g_ingest.stats();
+    std::fprintf(stderr, "[replay-bench] %llu frames, %llu lines: frame us p50 %llu p95 %llu p99 %llu max %llu; "
+        "ingest max %.0f us\n", (unsigned long long)g_benchFrameUs.count(), (unsigned long long)in.totalLines,
+        (unsigned long long)g_benchFrameUs.percentile(50), (unsigned long long)g_benchFrameUs.percentile(95),
+        (unsigned long long)g_benchFrameUs.percentile(99), (unsigned long long)g_benchFrameUs.max(), in.maxUs);
+    return true;
+}
+
+// --log-latency-child: 250 lines over ~5 s, block-buffered on a pipe, line-buffered on a console
+static int RunLatencyChild() {
+    for (int i = 0; i < 250; ++i) {
+        std::printf("latency-probe %lld %d\n", (long long)LogIngest::nowNs(), i);
+        Sleep(20);
+    }
+    return 0;
+}
+
+static void OnProbeLine(const std::string& line) {
+    long long ns;
+    if (std::sscanf(line.c_str(), "latency-probe %lld", &ns) == 1) g_ingest.submit(line, ns);   // timed from the child's write
+    else g_ingest.submit(line);
+}
+
+static void StartLatencyProbe() {
+    wchar_t self[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, self, MAX_PATH)) return;
+    OpenVpnConfig cfg;
+    cfg.openvpnExe = self;
+    cfg.extraArgs = { L"--log-latency-child" };
+    cfg.managementPort = 0;
+    cfg.pseudoConsole = std::strcmp(g_probe.mode, "pty") == 0;
+    g_vpn.start(cfg, OnProbeLine);
+    g_probe.started = g_vpn.running();
+    if (!g_probe.started) std::fprintf(stderr, "[log-latency] cannot start %ls\n", self);
+}
+
+// End of frame: the lines pumped this frame are on screen now
+static void PollLineLatency() {
+    const std::vector<int64_t>& times = g_ingest.pumpedTimes();
+    if (times.empty()) return;
+    const int64_t now = LogIngest::nowNs();
+    for (int64_t t : times) {
+        const int64_t ns = std::max<int64_t>(now - t, 0);
+        g_appMetrics.lineLatency.observe(ns / 1e9);
+        if (g_probe.mode) g_probe.us.record((uint64_t)(ns / 1000));
+    }
+}
+
+// --log-latency-probe: true = done
+static bool StepLatencyProbe() {
+    if (g_probe.started && g_vpn.running()) return false;
+    if (g_probe.started && ++g_probe.exitFrames < 30) return false;
+    const HdrHistogram& h = g_probe.us;
+    std::fprintf(stderr, "[log-latency] %s: %llu lines, write -> screen ms p50 %.1f p95 %.1f p99 %.1f max %.1f\n",
+        g_probe.mode, (unsigned long long)h.count(), h.percentile(50) / 1e3, h.percentile(95) / 1e3,
+        h.percentile(99) / 1e3, h.max() / 1e3);
+    g_vpn.stop();
+    return true;
+}
+
+// The session's history row keys: profile file name, and the --remote override or else the profile's first remote
+static void BeginSession() {
+    g_session.active = true;
+    g_session.profile = WideToUtf8(std::filesystem::path(g_cfg.ovpnFile).filename().wstring());
+    g_session.remote = WideToUtf8(g_cfg.remoteHost);
+    std::vector<ProfileRemote> remotes;
+    if (g_session.remote.empty() && ReadProfileRemotes(g_cfg.ovpnFile, remotes) && !remotes.empty()) g_session.remote = remotes[0].host;
+}
+
+static void EndSession(const char* reason) {
+    if (!g_session.active) return;
+    g_session.active = false;
+    HistorySession s;
+    s.startUnix = g_vpnStartedUnix;
+    s.stopUnix = (int64_t)std::time(nullptr);
+    s.connectMs = g_vpn.connectMs();
+    s.bytesIn = g_vpn.bytesIn();
+    s.bytesOut = g_vpn.bytesOut();
+    s.reconnects = g_vpn.sessionReconnects();
+    s.profile.swap(g_session.profile);
+    s.remote.swap(g_session.remote);
+    s.exitReason = reason;
+    if (g_history.isOpen() && !g_history.append(s)) g_ingest.submit("[history] cannot write the session");
+}
+
+static void StartLogShare() {
+    if (!g_logShareName) return;
+    std::string err;
+    if (!g_logShare.open(g_logShareName, 16384, err)) { g_ingest.submit("[log-share] " + err); return; }
+    g_ingest.setShare(&g_logShare);
+    g_ingest.submit(g_frameArena.format("[log-share] publishing to %s", g_logShareName));
+}
+
+static void OpenHistory() {
+    std::string err;
+    if (!g_history.open(g_historyDir, err)) g_ingest.submit("[history] " + err);
+}
+
+static void StartVpn() {
+    g_vpn.start(g_cfg, OnVpnLine);
+    g_mapActive = g_mapRemote;
+    g_latency.start(g_latencyTargets);
+    if (g_vpn.running()) g_procmon.start(g_vpn.pid());
+    g_vpnStartedUnix = (int64_t)std::time(nullptr);
+    if (g_vpn.running()) BeginSession();
+}
+
+// A detached tunnel from an earlier run: take it over instead of reconnecting
+static void ReattachVpn() {
+    std::string err;
+    std::wstring path;
+    if (g_journalPath) path = Utf8ToWide(g_journalPath);
+    else if (PrivateDir(path, err)) path += L"\\tunnel.journal";
+    if (path.empty() || !g_journal.open(path, err)) { g_ingest.submit("[journal] " + err); return; }
+    g_vpn.setJournal(&g_journal);
+    TunnelInfo t;
+    if (g_replayPath || !g_journal.read(t)) return;
+    if (!g_vpn.reattach(OnVpnLine)) {   // the runner reports the time to a working management connection
+        g_ingest.submit(g_frameArena.format("[OpenVPN] detached tunnel (pid %u) is gone", t.pid));
+        return;
+    }
+    g_cfg.ovpnFile = t.profile;   // Stop + Start reconnects the same tunnel
+    g_cfg.remoteHost = t.remoteHost;
+    g_cfg.remotePort = t.remotePort;
+    g_cfg.managementPort = t.managementPort;
+    g_cfg.detached = true;
+    g_vpnStartedUnix = t.startedUnix;
+    BeginSession();
+    g_latency.start(g_latencyTargets);
+    g_procmon.start(g_vpn.pid());
+    const long long up = (long long)std::time(nullptr) - t.startedUnix;
+    g_ingest.submit(g_frameArena.format("[OpenVPN] re-attaching to pid %u: %s, up %lldh%02lldm, %.1f MB in / %.1f MB out",
+        t.pid, t.state.empty() ? "state unknown" : t.state.c_str(), up / 3600, up / 60 % 60,
+        t.bytesIn / 1048576.0, t.bytesOut / 1048576.0));
+}
+
+static void StopVpn(const char* reason) {
+    EndSession(reason);
+    g_procmon.stop();
+    g_vpn.stop();
+    if (!g_echo.running()) g_latency.stop();
+}
+
+static void StartNetWatch() {
+    std::string err;
+    if (!g_netWatch.start(err)) { g_ingest.submit("[net] " + err); return; }
+    g_netWatch.snapshot(g_netView);
+    g_netSeen = g_netWatch.changes();
+    const NetInterface* u = g_netView.uplink();
+    g_uplinkIndex = u ? u->index : 0;
+}
+
+static void ArmNetTrigger(NetTrigger t, int64_t now, std::string why) {
+    if (g_netTrigger == NetTrigger::None) {
+        g_netTrigger = t;
+        g_netTriggerWhy = std::move(why);
+    }
+    g_netTriggerNs = now;
+}
+
+static void PollNetWatch() {
+    if (!g_netWatch.running()) return;
+    g_netWatch.poll(g_netEvents);
+    const int64_t now = LogIngest::nowNs();
+    const bool connected = g_vpn.running() && g_vpn.tunnelState() == "CONNECTED";
+    if (!connected) {   // openvpn is on it already, or there is no tunnel
+        g_uplinkLost = false;
+        g_netTrigger = NetTrigger::None;
+        g_tunnelRoutes = 0;
+    }
+    for (const NetEvent& e : g_netEvents) {
+        g_ingest.submit(g_frameArena.format("[net] %s (%.1f ms ago)", e.text.c_str(), (now - e.atNs) / 1e6));
+        if (!connected) continue;
+        if (g_netTrigger != NetTrigger::None) g_netTriggerNs = now;   // not settled yet
+        const bool down = e.kind == NetEvent::InterfaceDown || e.kind == NetEvent::InterfaceRemoved;
+        if (down && e.tunnel) ArmNetTrigger(NetTrigger::TunnelDown, now, "the tunnel adapter went down");
+        else if (e.kind == NetEvent::RouteRemoved && e.tunnel) ArmNetTrigger(NetTrigger::TunnelRoutes, now, "a tunnel route was removed");
+        else if (!e.tunnel && e.index == g_uplinkIndex) {
+            if (down) g_uplinkLost = true;
+            else if (e.kind == NetEvent::InterfaceUp && g_uplinkLost) {
+                g_uplinkLost = false;
+                ArmNetTrigger(NetTrigger::UplinkBack, now, "the uplink is back");
+            }
+        }
+    }
+    const uint64_t changes = g_netWatch.changes();
+    if (changes != g_netSeen) {
+        g_netSeen = changes;
+        g_netWatch.snapshot(g_netView);
+        const NetInterface* u = g_netView.uplink();
+        if (u && g_uplinkLost && connected) {   // its route is back, or another interface's took over
+            g_uplinkLost = false;
+            ArmNetTrigger(NetTrigger::UplinkBack, now, "uplink " + u->name + (u->index == g_uplinkIndex ? " is back" : " took over"));
+        }
+        if (u) g_uplinkIndex = u->index;
+        if (connected) g_tunnelRoutes = std::max(g_tunnelRoutes, g_netView.tunnelRoutes());
+    }
+    if (g_netTrigger == NetTrigger::None || now - g_netTriggerNs < kNetQuietNs) return;
+    // settled: the tunnel must still be CONNECTED and, for the tunnel triggers, still broken
+    const NetInterface* t = g_netView.tunnel();
+    const bool still = g_netTrigger == NetTrigger::UplinkBack || (g_netTrigger == NetTrigger::TunnelDown && (!t || !t->up)) ||
+        (g_netTrigger == NetTrigger::TunnelRoutes && g_netView.tunnelRoutes() < g_tunnelRoutes);
+    g_netTrigger = NetTrigger::None;
+    if (still && g_vpn.softRestart())
+        g_ingest.submit(g_frameArena.format("[net] %s: reconnecting the tunnel now", g_netTriggerWhy.c_str()));
+}
+
+static void StartSpeedServer() {
+    if (!g_speedServerAddr) return;
+    const char* colon = std::strrchr(g_speedServerAddr, ':');
+    const std::string host = colon ? std::string(g_speedServerAddr, colon) : "127.0.0.1";
+    std::string err;
+    if (!g_speedServer.start(host, (uint16_t)std::atoi(colon ? colon + 1 : g_speedServerAddr), 2, err))
+        g_ingest.submit("[speed] " + err);
+    else g_ingest.submit(g_frameArena.format("[speed] test server on %s:%u", host.c_str(), g_speedServer.port()));
+}
+
+static void PollSpeedTest() {
+    SpeedTestControls& c = g_speedUi;
+    if (c.start) {
+        SpeedTestOptions o;
+        o.host = c.host;
+        o.port = (uint16_t)c.port;
+        o.streams = c.streams;
+        o.seconds = c.seconds;
+        o.upload = c.direction == 1;
+        o.udp = c.udp;
+        o.udpMbps = c.udpMbps;
+        std::string err;
+        c.running = g_speedTest.start(o, err);
+        if (!c.running) g_ingest.submit("[speed] " + err);
+    }
+    if (c.stop) g_speedTest.stop();   // keeps what was measured so far
+    if (!c.running) return;
+    g_speedTest.snapshot(g_speedResult);
+    if (!g_speedTest.finished()) return;
+    g_speedTest.stop();   // joins the threads
+    c.running = false;
+    const SpeedTestResult& r = g_speedResult;
+    if (r.phase == SpeedTestResult::Failed) g_ingest.submit("[speed] failed: " + r.error);
+    else g_ingest.submit(g_frameArena.format("[speed] %d %s streams: %.1f Mbit/s over %.1f s; latency %.1f ms idle, %.1f ms loaded",
+        c.streams, c.direction ? "upload" : "download", r.mbps, r.seconds, r.idleP50Ms, r.loadedP50Ms));
+}
+
+static void StartControl() {
+    if (!g_controlName) return;
+    std::string err;
+    std::wstring dir;
+    if (std::strpbrk(g_controlName, "\\/:")) err = "--control takes a socket name, not a path";
+    else if (PrivateDir(dir, err) && g_control.start(WideToUtf8(dir) + "\\" + g_controlName, err)) return;
+    g_ingest.submit("[control] " + err);
+}
+
+// A control client may only pick one of the listed profiles (a file it wrote could carry scripts):
+// by the name the finder shows, or by its full path
+static bool FindListedProfile(const std::wstring& arg, std::wstring& path) {
+    for (const std::wstring& p : g_profilePaths) {
+        const std::wstring file = std::filesystem::path(p).filename().wstring();
+        if (_wcsicmp(p.c_str(), arg.c_str()) == 0 || _wcsicmp(file.c_str(), arg.c_str()) == 0 ||
+            (file.size() == arg.size() + 5 && _wcsnicmp(file.c_str(), arg.c_str(), arg.size()) == 0)) {
+            path = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Publishes the tunnel status to the control socket and runs the start/stop/profile requests it queued
+static void PollControl() {
+    if (!g_control.running()) return;
+    ControlStatus& st = g_controlStatus;
+    st.running = g_vpn.running();
+    st.detached = g_vpn.detached();
+    st.pid = st.running ? (uint32_t)g_vpn.pid() : 0;
+    st.state = g_vpn.tunnelState();
+    st.profile = g_cfg.ovpnFile;
+    st.bytesIn = g_vpn.bytesIn();
+    st.bytesOut = g_vpn.bytesOut();
+    st.startedUnix = g_vpnStartedUnix;
+    g_control.publish(st);
+
+    g_control.poll(g_controlCmds);
+    std::wstring profile;
+    for (const ControlCommand& c : g_controlCmds) {
+        if (c.kind == ControlCommand::Stop) {
+            if (!g_vpn.running()) { g_control.reply(c, false, "not running"); continue; }
+            StopVpn("stopped (control)");
+            g_ingest.submit("--- stopped (control) ---");
+            g_control.reply(c, true, "");
+            continue;
+        }
+        if (!c.path.empty() && !FindListedProfile(c.path, profile)) { g_control.reply(c, false, "not a --profiles entry"); continue; }
+        if (c.kind == ControlCommand::Start && g_vpn.running()) { g_control.reply(c, false, "already running"); continue; }
+        if (!c.path.empty()) {
+            g_cfg.ovpnFile = profile;
+            PrefetchRemotes(g_cfg.ovpnFile);
+        }
+        if (c.kind == ControlCommand::Profile && !g_vpn.running()) { g_control.reply(c, true, "used by the next start"); continue; }
+        if (g_vpn.running()) StopVpn("profile switch");   // on a live tunnel
+        StartVpn();
+        if (g_vpn.running()) g_control.reply(c, true, "pid " + std::to_string(g_vpn.pid()));
+        else g_control.reply(c, false, "start failed");
+    }
+}
+
+static void StartMetrics() {
+    if (g_metricsPort < 0) return;
+    MetricsRegistry& r = g_metrics;
+    auto& m = g_appMetrics;
+    g_vpn.setMetrics(r);
+    m.up = r.gauge("vpn_tunnel_up", "1 while the openvpn child runs");
+    m.uptime = r.gauge("vpn_tunnel_uptime_seconds", "Seconds since the running tunnel was started");
+    for (size_t i = 0; i < std::size(kTunnelStates); ++i)
+        m.state[i] = r.gauge("vpn_tunnel_state", "1 for the tunnel's current management state", kTunnelStates[i].label);
+    m.logLines = r.counter("vpn_log_lines_total", "Log lines ingested");
+    m.logEvicted = r.counter("vpn_log_lines_evicted_total", "Log lines dropped from the session store to stay in budget");
+    m.logSampledOut = r.counter("vpn_log_lines_sampled_out_total", "Log lines stored but left out of the live view");
+    m.frames = r.counter("vpn_gui_frames_total", "Frames rendered");
+    m.lineLatency = r.histogram("vpn_log_line_latency_seconds", "Time from a log line's arrival to the end of the frame that shows it",
+        { 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5 });
+    m.frameQuantile[0] = r.gauge("vpn_gui_frame_seconds", "Time between frame starts over the last 600 frames", "quantile=\"0.5\"");
+    m.frameQuantile[1] = r.gauge("vpn_gui_frame_seconds", "Time between frame starts over the last 600 frames", "quantile=\"0.95\"");
+    m.frameQuantile[2] = r.gauge("vpn_gui_frame_seconds", "Time between frame starts over the last 600 frames", "quantile=\"0.99\"");
+    std::string err;
+    if (!g_metricsServer.start(g_metrics, (uint16_t)g_metricsPort, err)) g_ingest.submit("[metrics] " + err);
+    else g_ingest.submit(g_frameArena.format("[metrics] http://127.0.0.1:%u/metrics", g_metricsServer.port()));
+}
+
+static void PollMetrics(int frame, int64_t frameUs) {
+    if (!g_metricsServer.running()) return;
+    auto& m = g_appMetrics;
+    const bool up = g_vpn.running();
+    m.up.set(up);
+    m.uptime.set(up && g_vpnStartedUnix ? (double)((int64_t)std::time(nullptr) - g_vpnStartedUnix) : 0.0);
+    const std::string state = up ? g_vpn.tunnelState() : std::string();
+    for (size_t i = 0; i < std::size(kTunnelStates); ++i) m.state[i].set(state == kTunnelStates[i].name);
+    const IngestStats& in = g_ingest.stats();
+    m.logLines.set(in.totalLines);
+    m.logSampledOut.set(in.hiddenLines);
+    m.logEvicted.set(g_logStore.begin());
+    m.frames.add();
+
+    uint32_t& slot = m.window[frame % kFrameWindow];
+    if (frame >= (int)kFrameWindow) m.frameUs.remove(slot);
+    slot = (uint32_t)std::min<int64_t>(frameUs, UINT32_MAX);
+    m.frameUs.record(slot);
+    if (frame % 60 == 0) {
+        m.frameQuantile[0].set(m.frameUs.percentile(50) / 1e6);
+        m.frameQuantile[1].set(m.frameUs.percentile(95) / 1e6);
+        m.frameQuantile[2].set(m.frameUs.percentile(99) / 1e6);
+    }
+}
+
+static void PollProcess() {
+    g_procmon.setLimits(g_procLimits);
+    if (g_showProcess) g_procmon.snapshot(g_procSeries);
+    std::string reason;
+    if (!g_procmon.takeRestartRequest(reason)) return;
+    g_ingest.submit(g_frameArena.format("[process] %s", reason.c_str()));
+    if (!g_procAutoRestart) return;
+    g_ingest.submit("[process] restarting tunnel");
+    StopVpn("restarted (process limits)");
+    StartVpn();
+}
+
+// openvpn exited on its own (fatal error, auth failure, killed): the session ends here
+static void PollHistory() {
+    if (g_session.active && !g_vpn.running()) EndSession("exited");
+}
+
+static void PollVerbosity() {
+    g_vpn.poll();
+    if (g_verbUi.applyVerb && !g_vpn.setVerb(g_verbUi.verb)) g_ingest.submit("[mgmt] verb change failed");
+    if (g_verbUi.applyMute && !g_vpn.setMute(g_verbUi.mute)) g_ingest.submit("[mgmt] mute change failed");
+    if (g_verbUi.startBurst) {
+        if (g_vpn.startDebugBurst(g_verbUi.burstVerb, std::chrono::seconds(g_verbUi.burstSeconds)))
+            g_ingest.submit(g_frameArena.format("[mgmt] debug burst: verb %d for %d s", g_verbUi.burstVerb,
+                g_verbUi.burstSeconds));
+        else g_ingest.submit("[mgmt] debug burst failed");
+    }
+    g_verbUi.applyVerb = g_verbUi.applyMute = g_verbUi.startBurst = false;
+    // while the slider is held, keep the user's value; otherwise mirror what openvpn runs with
+    g_verbUi.available = g_vpn.managementConnected();
+    if (!ImGui::IsAnyItemActive()) { g_verbUi.verb = g_vpn.verb(); g_verbUi.mute = g_vpn.mute(); }
+    g_verbUi.burstLeft = g_vpn.burstRemaining();
+}
+
+static void PollExport() {
+    // busy is checked first: snapshot() seals the store's open chunk
+    if (g_exportUi.start && g_exporter.running()) g_exportUi.status = "an export is already running";
+    else if (g_exportUi.start) g_exporter.start(g_logStore.snapshot(), g_exportUi.path, (ExportFormat)g_exportUi.format);
+    if (g_exportUi.cancel) g_exporter.cancel();
+    g_exportUi.start = g_exportUi.cancel = false;
+    g_exportUi.running = g_exporter.running();
+    g_exportUi.progress = g_exporter.progress();
+    if (g_exporter.takeResult(g_exportUi.status)) g_ingest.submit(g_frameArena.format("[export] %s", g_exportUi.status.c_str()));
+}
+
+static void CheckFrameAllocs(int frame) {
+    const AllocFrame& f = AllocProfiler::endFrame();
+    if (!g_allocCheckFrames || frame < kAllocWarmupFrames || !f.frameAllocs) return;
+    ++g_allocFailures;
+    std::fprintf(stderr, "[alloc-check] frame %d: %llu allocs, %llu bytes", frame,
+        (unsigned long long)f.frameAllocs, (unsigned long long)f.frameBytes);
+    for (size_t i = 1; i < AllocFrame::kTags; ++i)
+        if (f.allocs[i]) std::fprintf(stderr, "  %s=%llu", AllocProfiler::tagName((AllocTag)i), (unsigned long long)f.allocs[i]);
+    std::fprintf(stderr, "\n");
 }
 
 static void Cleanup() {
+    g_control.stop();
+    g_metricsServer.stop();
+    g_exporter.cancel();
+    g_procmon.stop();
+    g_latency.stop();
+    g_echo.stop();
+    g_netWatch.stop();
+    g_speedTest.stop();
+    g_speedServer.stop();
+    g_prober.stop();
+    g_resolver.stop();
+
     // ͣ VPN ̣ܣ
-    if (g_vpn.running()) g_vpn.stop();
+    if (g_vpn.detached()) g_vpn.detach();   // keeps running; the journal hands it to the next run
+    else if (g_vpn.running()) { EndSession("gui exit"); g_vpn.stop(); }
+    g_recorder.close();
+    g_history.close();
+    g_ingest.setShare(nullptr);
+    g_logShare.close();
+    g_logCache.release();   // GL objects, before the context goes away
+    g_sdfFont.release();
+    g_serverMap.release();
 
     // ImGui 
     ImGui_ImplOpenGL3_Shutdown();
@@ -105,6 +883,17 @@ static void DrawUI() {
             }
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("View")) {
+            ImGui::MenuItem("Allocations", nullptr, &g_showAllocs);
+            ImGui::MenuItem("Cached log pane", nullptr, &g_cacheLogs);
+            if (ImGui::MenuItem("SDF log text", nullptr, &g_sdfLogs, !g_sdfFailed)) LoadSdfFont();
+            ImGui::MenuItem("Server map", nullptr, &g_showMap, !g_servers.empty());
+            ImGui::MenuItem("History", nullptr, &g_showHistory);
+            ImGui::MenuItem("Process", nullptr, &g_showProcess);
+            ImGui::MenuItem("Speed test", nullptr, &g_showSpeed);
+            if (ImGui::MenuItem("Find profile", "Ctrl+P", &g_showFinder, g_finder.size() > 0)) g_finderUi.focus = g_showFinder;
+            ImGui::EndMenu();
+        }
         ImGui::EndMainMenuBar();
     }
 
@@ -113,14 +902,25 @@ static void DrawUI() {
         g_vpn.running(),
         []() { // onStart
             g_log.clear();
-            g_vpn.start(g_cfg, [](const std::string& line) { g_log.push(line); });
+            StartVpn();
         },
         []() { // onStop
-            g_vpn.stop();
-            g_log.push("--- stopped ---");
+            StopVpn("stopped");
+            g_ingest.submit("--- stopped ---");
         }
     );
-    UiPanels::DrawLogs(g_log);
+    UiPanels::DrawVerbosity(g_verbUi);
+    UiPanels::DrawLatency(g_latencyStats);
+    UiPanels::DrawLogExport(g_exportUi);
+    UiPanels::DrawNetwork(g_netView, g_netWatch.running());
+    UiPanels::DrawLogs(g_log, g_logStore, g_ingest.stats(), g_frameArena, g_cacheLogs ? &g_logCache : nullptr,
+        g_sdfLogs && g_sdfFont.ready() ? &g_sdfFont : nullptr);
+    if (g_showMap) UiPanels::DrawServerMap(g_serverMap, g_servers, g_mapUi, &g_showMap);
+    if (g_showFinder) UiPanels::DrawProfileFinder(g_finder, g_finderUi, &g_showFinder);
+    if (g_showHistory) UiPanels::DrawHistory(g_history, g_historyUi, &g_showHistory);
+    if (g_showSpeed) UiPanels::DrawSpeedTest(g_speedUi, g_speedResult, &g_showSpeed);
+    if (g_showProcess) UiPanels::DrawProcessMonitor(g_procSeries, g_procmon.lastSampleUs(), g_procLimits, g_procAutoRestart, &g_showProcess);
+    if (g_showAllocs) UiPanels::DrawAllocOverlay(&g_showAllocs, g_frameArena);
 
     // ѡһռλƬԺ Profiles/Settings ȣ
     ImGui::Begin("Tips");
@@ -130,14 +930,108 @@ static void DrawUI() {
 }
 
 // --------------- Main --------------------
-int main() {
+int main(int argc, char** argv) {
+    AllocScope uiThread(AllocTag::Ui);
+    // --ui-bench [--ui-bench-frames N] [--ui-bench-max LINES], --text-bench, --history-bench [--history-bench-rows N],
+    // --speed-bench [...] (see SpeedBench.h), --dns-bench [--dns-bench-names N] [--dns-bench-delay MS]:
+    // headless, run before any window exists
+    bool uiBench = false, textBench = false, historyBench = false, speedBench = false, dnsBench = false;
+    size_t historyRows = 2000000, dnsNames = 500;
+    int dnsDelayMs = 5;
+    UiBenchOptions bench;
+    SpeedTestOptions speed;
+    const char* speedTarget = nullptr;
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--ui-bench") == 0) uiBench = true;
+        else if (std::strcmp(argv[i], "--text-bench") == 0) textBench = true;
+        else if (std::strcmp(argv[i], "--history-bench") == 0) historyBench = true;
+        else if (std::strcmp(argv[i], "--history-bench-rows") == 0 && i + 1 < argc) historyRows = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--speed-bench") == 0) speedBench = true;
+        else if (std::strcmp(argv[i], "--speed-bench-streams") == 0 && i + 1 < argc) speed.streams = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--speed-bench-seconds") == 0 && i + 1 < argc) speed.seconds = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--speed-bench-upload") == 0) speed.upload = true;
+        else if (std::strcmp(argv[i], "--speed-bench-udp") == 0 && i + 1 < argc) { speed.udp = true; speed.udpMbps = std::atof(argv[++i]); }
+        else if (std::strcmp(argv[i], "--speed-bench-target") == 0 && i + 1 < argc) speedTarget = argv[++i];
+        else if (std::strcmp(argv[i], "--dns-bench") == 0) dnsBench = true;
+        else if (std::strcmp(argv[i], "--dns-bench-names") == 0 && i + 1 < argc) dnsNames = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--dns-bench-delay") == 0 && i + 1 < argc) dnsDelayMs = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ui-bench-frames") == 0 && i + 1 < argc) bench.frames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--ui-bench-max") == 0 && i + 1 < argc) {
+            uint64_t max = std::strtoull(argv[++i], nullptr, 10);
+            while (!bench.sizes.empty() && bench.sizes.back() > max) bench.sizes.pop_back();
+        }
+    if (uiBench) return UiBench::Run(bench);
+    if (textBench) return TextBench::Run();
+    if (historyBench) return HistoryBench::Run(historyRows);
+    if (speedBench) return SpeedBench::Run(speed, speedTarget);
+    if (dnsBench) return DnsBench::Run(dnsNames, dnsDelayMs);
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--log-latency-child") == 0) return RunLatencyChild();   // among openvpn-style arguments
+        else if (std::strcmp(argv[i], "--log-latency-probe") == 0 &&
+            (i + 1 == argc || (std::strcmp(argv[i + 1], "pipe") != 0 && std::strcmp(argv[i + 1], "pty") != 0))) {
+            std::fprintf(stderr, "[log-latency] --log-latency-probe takes pipe or pty\n");
+            return 1;
+        }
+
+    int exitCode = 0;
     try {
         InitGlfwAndWindow();
         InitGlad();
         InitImGui();
+        for (int i = 1; i < argc; ++i)
+            if (std::strcmp(argv[i], "--latency-echo") == 0) StartLocalEcho();
+            else if (std::strncmp(argv[i], "--alloc-check", 13) == 0) {
+                g_allocCheckFrames = argv[i][13] == '=' ? std::atoi(argv[i] + 14) : 600;
+                g_allocCheckFrames += kAllocWarmupFrames;
+                g_showAllocs = true;
+            }
+            else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+                if (g_recorder.open(argv[++i])) g_vpn.setRecorder(&g_recorder);
+                else g_ingest.submit(g_frameArena.format("[record] cannot create %s", argv[i]));
+            }
+            else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) g_replayPath = argv[++i];
+            else if (std::strcmp(argv[i], "--replay-bench") == 0 && i + 1 < argc) { g_replayPath = argv[++i]; g_replayBench = true; }
+            else if (std::strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) g_replaySpeed = std::atof(argv[++i]);
+            else if (std::strcmp(argv[i], "--sdf-font") == 0 && i + 1 < argc) { g_sdfFontPath = argv[++i]; g_sdfLogs = true; }
+            else if (std::strcmp(argv[i], "--servers") == 0 && i + 1 < argc) g_serversPath = argv[++i];
+            else if (std::strcmp(argv[i], "--map-demo") == 0 && i + 1 < argc) g_mapDemo = std::strtoul(argv[++i], nullptr, 10);
+            else if (std::strcmp(argv[i], "--profiles") == 0 && i + 1 < argc) g_profilesDir = argv[++i];
+            else if (std::strcmp(argv[i], "--detached") == 0) g_cfg.detached = true;
+            else if (std::strcmp(argv[i], "--pty") == 0) g_cfg.pseudoConsole = true;
+            else if (std::strcmp(argv[i], "--log-latency-probe") == 0 && i + 1 < argc) g_probe.mode = argv[++i];
+            else if (std::strcmp(argv[i], "--journal") == 0 && i + 1 < argc) g_journalPath = argv[++i];
+            else if (std::strcmp(argv[i], "--control") == 0 && i + 1 < argc) g_controlName = argv[++i];
+            else if (std::strcmp(argv[i], "--metrics-port") == 0 && i + 1 < argc) g_metricsPort = std::atoi(argv[++i]);
+            else if (std::strcmp(argv[i], "--history") == 0 && i + 1 < argc) g_historyDir = argv[++i];
+            else if (std::strcmp(argv[i], "--speed-server") == 0 && i + 1 < argc) g_speedServerAddr = argv[++i];
+            else if (std::strcmp(argv[i], "--log-share") == 0) { if (!g_logShareName) g_logShareName = LogShare::kDefaultName; }
+            else if (std::strcmp(argv[i], "--log-share-name") == 0 && i + 1 < argc) g_logShareName = argv[++i];
+            else if (std::strcmp(argv[i], "--dns-server") == 0 && i + 1 < argc) {
+                if (!g_resolver.setServer(argv[++i])) g_ingest.submit(g_frameArena.format("[dns] not an IPv4 address: %s", argv[i]));
+            }
+        LoadSdfFont();
+        LoadServerMap();
+        LoadProfileFinder();
+        StartResolver();
+        StartControl();
+        StartNetWatch();
+        StartMetrics();
+        OpenHistory();
+        StartLogShare();
+        StartSpeedServer();
+        if (g_replayBench) glfwSwapInterval(0);   // measure the frame, not the display
+        if (g_probe.mode) StartLatencyProbe();
+        else ReattachVpn();
+        if (g_replayPath) StartReplay();
 
         // ѭ
-        while (!glfwWindowShouldClose(g_Window)) {
+        auto lastFrameStart = std::chrono::steady_clock::now();
+        for (int frame = 0; !glfwWindowShouldClose(g_Window); ++frame) {
+            auto frameStart = std::chrono::steady_clock::now();
+            AllocProfiler::beginFrame();
+            g_frameArena.reset();
+            PollMetrics(frame, std::chrono::duration_cast<std::chrono::microseconds>(frameStart - lastFrameStart).count());
+            lastFrameStart = frameStart;
             glfwPollEvents();
             // Esc ˳
             if (glfwGetKey(g_Window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -149,6 +1043,11 @@ int main() {
             ImGui::NewFrame();
 
             // --- UI ---
+            if (g_replayBench) g_vpn.advanceReplay((int64_t)(16666667 * (g_replaySpeed > 0 ? g_replaySpeed : 1.0)));
+            { AllocScope s(AllocTag::Logs); g_ingest.pump(g_logStore, g_log); PollExport(); }
+            PollProfileFinder();
+            { AllocScope s(AllocTag::Net); PollLatency(); PollServerMap(); PollSpeedTest(); }
+            { AllocScope s(AllocTag::Vpn); PollProcess(); PollVerbosity(); PollControl(); PollHistory(); PollNetWatch(); }
             DrawUI();
 
             // Ⱦ
@@ -159,7 +1058,22 @@ int main() {
             glClearColor(0.08f, 0.10f, 0.12f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            if (g_replayBench) {
+                glFinish();   // include the GPU work in the measured frame
+                auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frameStart);
+                if (StepReplayBench(us.count())) break;
+            }
             glfwSwapBuffers(g_Window);
+            PollLineLatency();
+            if (g_probe.mode && StepLatencyProbe()) break;
+
+            CheckFrameAllocs(frame);
+            if (g_allocCheckFrames && frame + 1 >= g_allocCheckFrames) {
+                std::fprintf(stderr, "[alloc-check] %s: %d of %d steady-state frames allocated\n",
+                    g_allocFailures ? "FAIL" : "PASS", g_allocFailures, g_allocCheckFrames - kAllocWarmupFrames);
+                if (g_allocFailures) exitCode = 1;
+                break;
+            }
         }
     }
     catch (const std::exception& e) {
@@ -167,5 +1081,5 @@ int main() {
     }
 
     Cleanup();
-    return 0;
+    return exitCode;
 }
@@ -0,0 +1,330 @@
+#include "ControlServer.h"
+#include "../core/Utf8.h"
+#include <afunix.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+using namespace std::chrono;
+
+#ifndef IO_REPARSE_TAG_AF_UNIX   // older SDKs
+#define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+#endif
+
+static std::string trim(const std::string& s, size_t from, size_t to) {
+    while (from < to && (s[from] == ' ' || s[from] == '\t')) ++from;
+    while (to > from && (s[to - 1] == ' ' || s[to - 1] == '\t')) --to;
+    return s.substr(from, to - from);
+}
+
+// an AF_UNIX socket file: a reparse point with its own tag; anything else at the path is left alone
+static bool isSocketFile(const std::string& path) {
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(path.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    FindClose(h);
+    return (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && fd.dwReserved0 == IO_REPARSE_TAG_AF_UNIX;
+}
+
+ControlServer::~ControlServer() { stop(); }
+
+bool ControlServer::start(const std::string& path, std::string& err) {
+    stop();
+    sockaddr_un a{};
+    a.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(a.sun_path)) { err = "control socket path too long: " + path; return false; }
+    std::memcpy(a.sun_path, path.data(), path.size());
+    listen_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_ == INVALID_SOCKET) { err = "AF_UNIX sockets are not available (Windows 10 1803 or later)"; return false; }
+    if (isSocketFile(path)) DeleteFileA(path.c_str());   // left behind by a run that did not exit cleanly
+    if (bind(listen_, (sockaddr*)&a, sizeof(a)) != 0 || listen(listen_, SOMAXCONN) != 0) {
+        err = "cannot listen on " + path;
+        CloseSocketSafe(listen_);
+        return false;
+    }
+    SetNonBlocking(listen_, true);
+    if (!loop_.start()) {
+        err = "cannot start the control event loop";
+        CloseSocketSafe(listen_);
+        if (isSocketFile(path)) DeleteFileA(path.c_str());
+        return false;
+    }
+    path_ = path;
+    loop_.post([this] {
+        loop_.add(listen_, POLLRDNORM, [this](short) { acceptClients(); });
+        lastRate_ = steady_clock::now();
+        timer_ = loop_.every(milliseconds(50), [this] { tick(); });
+    });
+    return true;
+}
+
+void ControlServer::stop() {
+    loop_.stop();
+    for (Client& c : clients_) CloseSocketSafe(c.s);
+    clients_.clear();
+    CloseSocketSafe(listen_);
+    if (!path_.empty() && isSocketFile(path_)) DeleteFileA(path_.c_str());
+    path_.clear();
+    std::lock_guard<std::mutex> lk(cmdMu_);
+    commands_.clear();
+}
+
+void ControlServer::publish(const ControlStatus& s) {
+    std::lock_guard<std::mutex> lk(statusMu_);
+    if (s.profile != status_.profile) profileUtf8_ = WideToUtf8(s.profile);
+    status_ = s;   // reuses the strings' storage
+}
+
+void ControlServer::log(const std::string& line) {
+    if (!running()) return;
+    std::lock_guard<std::mutex> lk(logMu_);
+    logRing_[logSeq_ % kLogLines].assign(line);
+    ++logSeq_;
+}
+
+void ControlServer::poll(std::vector<ControlCommand>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lk(cmdMu_);
+    out.swap(commands_);
+}
+
+void ControlServer::reply(const ControlCommand& cmd, bool ok, const std::string& text) {
+    if (!running()) return;
+    std::string r = ok ? "OK" : "ERR";
+    if (!text.empty()) r += " " + text;
+    loop_.post([this, client = cmd.client, seq = cmd.seq, r = std::move(r)]() mutable {
+        if (Client* c = find(client)) complete(*c, seq, std::move(r));
+    });
+}
+
+ControlServer::Client* ControlServer::find(uint32_t id) {
+    for (Client& c : clients_)
+        if (c.id == id && c.s != INVALID_SOCKET) return &c;
+    return nullptr;
+}
+
+void ControlServer::acceptClients() {
+    for (;;) {
+        SOCKET s = accept(listen_, nullptr, nullptr);
+        if (s == INVALID_SOCKET) return;
+        clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [](const Client& c) { return c.s == INVALID_SOCKET; }),
+            clients_.end());
+        if (clients_.size() >= kMaxClients) {
+            static const char busy[] = "* ERR too many clients\n";
+            send(s, busy, sizeof(busy) - 1, 0);
+            CloseSocketSafe(s);
+            continue;
+        }
+        SetNonBlocking(s, true);
+        Client c;
+        c.id = nextClient_++;
+        c.s = s;
+        clients_.push_back(std::move(c));
+        loop_.add(s, POLLRDNORM, [this, id = clients_.back().id](short revents) { onClient(id, revents); });
+    }
+}
+
+void ControlServer::drop(Client& c) {
+    loop_.remove(c.s);
+    CloseSocketSafe(c.s);   // erased by the next accept or tick
+}
+
+void ControlServer::onClient(uint32_t id, short revents) {
+    Client* c = find(id);
+    if (!c) return;
+    if (revents & (POLLRDNORM | POLLHUP | POLLERR)) {
+        char buf[4096];
+        for (;;) {
+            const int n = recv(c->s, buf, sizeof(buf), 0);
+            if (n == 0 || (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK)) { drop(*c); return; }
+            if (n < 0) break;
+            c->in.append(buf, n);
+        }
+        // every complete line of this read is answered before anything is sent: one write per batch
+        size_t from = 0;
+        for (size_t nl; (nl = c->in.find('\n', from)) != std::string::npos; from = nl + 1) {
+            line_.assign(c->in, from, nl - from);
+            if (!line_.empty() && line_.back() == '\r') line_.pop_back();
+            if (!line_.empty()) request(*c, line_);
+        }
+        c->in.erase(0, from);
+        if (c->in.size() > kMaxLine) { drop(*c); return; }
+    }
+    flush(*c);
+}
+
+// "<id> cmd args; cmd args; ..." -> one reply per command, all under the same id
+void ControlServer::request(Client& c, const std::string& line) {
+    const size_t sp = std::min(line.find(' '), line.size());
+    const std::string id = line.substr(0, sp);
+    if (id.empty() || id[0] == '*' || id[0] == '|') {   // would read as a push or a log row
+        c.replies.push_back({ c.nextSeq++, true, "? ERR bad request id\n" });
+        return;
+    }
+    size_t from = sp;
+    for (;;) {
+        const size_t semi = std::min(line.find(';', from), line.size());
+        const std::string part = trim(line, from, semi);
+        const size_t ws = std::min(part.find(' '), part.size());
+        command(c, id, part.substr(0, ws), trim(part, ws, part.size()));
+        if (semi == line.size()) break;
+        from = semi + 1;
+    }
+}
+
+void ControlServer::command(Client& c, const std::string& id, const std::string& cmd, const std::string& args) {
+    c.replies.push_back({ c.nextSeq++, false, id + " " });
+    Reply& r = c.replies.back();
+    char buf[256];
+    if (cmd == "start" || cmd == "stop" || cmd == "profile") {   // the UI thread owns the tunnel
+        ControlCommand m;
+        m.kind = cmd == "start" ? ControlCommand::Start : cmd == "stop" ? ControlCommand::Stop : ControlCommand::Profile;
+        if (m.kind == ControlCommand::Profile && args.empty()) { r.text += "ERR profile needs a path\n"; r.done = true; return; }
+        m.path = Utf8ToWide(args);
+        m.client = c.id;
+        m.seq = r.seq;
+        std::lock_guard<std::mutex> lk(cmdMu_);
+        commands_.push_back(std::move(m));
+        return;
+    }
+    r.done = true;
+    if (cmd == "ping") r.text += "OK pong\n";
+    else if (cmd == "status") {
+        std::lock_guard<std::mutex> lk(statusMu_);
+        const long long up = status_.running && status_.startedUnix ? (long long)std::time(nullptr) - status_.startedUnix : 0;
+        std::snprintf(buf, sizeof(buf), "OK running=%d detached=%d pid=%u state=%s up=%lld profile=", status_.running ? 1 : 0,
+            status_.detached ? 1 : 0, status_.pid, status_.state.empty() ? "-" : status_.state.c_str(), up);
+        r.text += buf;
+        r.text += profileUtf8_;   // last: it may contain spaces
+        r.text += '\n';
+    }
+    else if (cmd == "stats") {
+        std::lock_guard<std::mutex> lk(statusMu_);
+        std::snprintf(buf, sizeof(buf), "OK in=%llu out=%llu inBps=%llu outBps=%llu\n", (unsigned long long)status_.bytesIn,
+            (unsigned long long)status_.bytesOut, (unsigned long long)rateIn_, (unsigned long long)rateOut_);
+        r.text += buf;
+    }
+    else if (cmd == "log") {
+        const size_t want = args.empty() ? 20 : std::min<size_t>(std::strtoul(args.c_str(), nullptr, 10), kLogLines);
+        std::lock_guard<std::mutex> lk(logMu_);
+        const uint64_t n = std::min<uint64_t>(want, std::min<uint64_t>(logSeq_, kLogLines));
+        r.text += "OK " + std::to_string(n) + "\n";
+        for (uint64_t s = logSeq_ - n; s < logSeq_; ++s) {
+            r.text += "| ";
+            r.text += logRing_[s % kLogLines];
+            r.text += '\n';
+        }
+    }
+    else if (cmd == "sub") {
+        const size_t ws = std::min(args.find(' '), args.size());
+        const std::string what = args.substr(0, ws);
+        if (what == "state") {
+            c.subState = true;
+            c.lastState = "\n";   // never a state name: the current state is pushed on the next tick
+        }
+        else if (what == "stats") {
+            const long ms = ws < args.size() ? std::strtol(args.c_str() + ws, nullptr, 10) : 1000;
+            c.subStats = true;
+            c.statsEvery = milliseconds(std::clamp<long>(ms, 100, 60000));
+            c.statsDue = steady_clock::now();
+        }
+        else if (what == "log") {
+            c.subLog = true;
+            std::lock_guard<std::mutex> lk(logMu_);
+            c.logNext = logSeq_;
+        }
+        else { r.text += "ERR sub state|stats [ms]|log\n"; return; }
+        r.text += "OK\n";
+    }
+    else if (cmd == "unsub") {
+        if (args.empty() || args == "state") c.subState = false;
+        if (args.empty() || args == "stats") c.subStats = false;
+        if (args.empty() || args == "log") c.subLog = false;
+        r.text += "OK\n";
+    }
+    else r.text += cmd.empty() ? "ERR empty request\n" : "ERR unknown command " + cmd + "\n";
+}
+
+void ControlServer::complete(Client& c, uint32_t seq, std::string text) {
+    for (Reply& r : c.replies)
+        if (r.seq == seq && !r.done) {
+            r.text += text;
+            r.text += '\n';
+            r.done = true;
+            break;
+        }
+    flush(c);
+}
+
+// moves finished replies (in order) to the output and writes as much as the socket takes
+void ControlServer::flush(Client& c) {
+    if (c.s == INVALID_SOCKET) return;
+    while (!c.replies.empty() && c.replies.front().done) {
+        c.out += c.replies.front().text;
+        c.replies.pop_front();
+    }
+    while (c.outOff < c.out.size()) {
+        const int n = send(c.s, c.out.data() + c.outOff, (int)std::min<size_t>(c.out.size() - c.outOff, 1 << 16), 0);
+        if (n < 0 && WSAGetLastError() == WSAEWOULDBLOCK) break;
+        if (n <= 0) { drop(c); return; }
+        c.outOff += n;
+    }
+    if (c.outOff == c.out.size()) {
+        c.out.clear();
+        c.outOff = 0;
+    }
+    else if (c.out.size() - c.outOff > kMaxOutput) { drop(c); return; }
+    loop_.setEvents(c.s, c.out.empty() ? POLLRDNORM : POLLRDNORM | POLLWRNORM);
+}
+
+// subscriptions, and the throughput rate the stats replies use
+void ControlServer::tick() {
+    const auto now = steady_clock::now();
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [](const Client& c) { return c.s == INVALID_SOCKET; }),
+        clients_.end());
+    uint64_t in, out;
+    {
+        std::lock_guard<std::mutex> lk(statusMu_);
+        scratch_.assign(status_.state);
+        in = status_.bytesIn;
+        out = status_.bytesOut;
+    }
+    const auto elapsed = duration_cast<milliseconds>(now - lastRate_).count();
+    if (elapsed >= 1000) {
+        rateIn_ = in >= lastIn_ ? (in - lastIn_) * 1000 / elapsed : 0;   // counters restart with the tunnel
+        rateOut_ = out >= lastOut_ ? (out - lastOut_) * 1000 / elapsed : 0;
+        lastIn_ = in;
+        lastOut_ = out;
+        lastRate_ = now;
+    }
+    if (clients_.empty()) return;
+
+    std::lock_guard<std::mutex> lk(logMu_);
+    char buf[160];
+    for (Client& c : clients_) {
+        const size_t before = c.out.size();
+        if (c.subState && c.lastState != scratch_) {
+            c.lastState = scratch_;
+            c.out += "* state ";
+            c.out += scratch_.empty() ? "-" : scratch_;
+            c.out += '\n';
+        }
+        if (c.subStats && now >= c.statsDue) {
+            c.statsDue = now + c.statsEvery;
+            std::snprintf(buf, sizeof(buf), "* stats %llu %llu %llu %llu\n", (unsigned long long)in, (unsigned long long)out,
+                (unsigned long long)rateIn_, (unsigned long long)rateOut_);
+            c.out += buf;
+        }
+        if (c.subLog) {
+            for (uint64_t s = std::max(c.logNext, logSeq_ - std::min<uint64_t>(logSeq_, kLogLines)); s < logSeq_; ++s) {
+                c.out += "* log ";
+                c.out += logRing_[s % kLogLines];
+                c.out += '\n';
+            }
+            c.logNext = logSeq_;
+        }
+        if (c.out.size() != before) flush(c);
+    }
+}
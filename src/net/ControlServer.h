@@ -0,0 +1,116 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "EventLoop.h"
+
+// --------- local control API ----------
+// Scripts and tray helpers drive the app through a Unix domain socket (AF_UNIX, Windows 10 1803+).
+// The socket carries no authentication of its own: it belongs in a directory only its user can
+// open (PrivateDir.h), and the file's ACL is inherited from there.
+// Everything runs on one EventLoop thread, never on the render thread: queries are answered there
+// from the status the UI thread publishes once per frame, and only start/stop/profile are handed
+// to the UI thread, which answers them through reply().
+//
+// Protocol, one request per line:   <id> <command> [args] [; <command> [args] ...]
+//   ping | status | stats | log [n] | start [profile] | stop | profile <name|path>
+//   sub state | sub stats [ms] | sub log | unsub [state|stats|log]
+// Every command gets one reply, "<id> OK ..." or "<id> ERR ...", in request order, so clients can
+// pipeline requests and batch several commands on one line. "log" replies "<id> OK n" and n lines
+// of "| <line>". Subscriptions push "* state NAME", "* stats in out inBps outBps" and "* log <line>"
+// between replies. A profile must be one of the app's --profiles entries, by name or full path.
+struct ControlStatus {
+    bool running{ false }, detached{ false };
+    uint32_t pid{ 0 };
+    std::string state;                 // management state name, e.g. CONNECTED
+    std::wstring profile;
+    uint64_t bytesIn{ 0 }, bytesOut{ 0 };
+    int64_t startedUnix{ 0 };          // 0 = unknown
+};
+
+struct ControlCommand {
+    enum Kind { Start, Stop, Profile };
+    Kind kind{ Start };
+    std::wstring path;                 // Start: optional profile, Profile: the new profile
+    uint32_t client{ 0 }, seq{ 0 };    // where reply() goes
+};
+
+class ControlServer {
+public:
+    static constexpr size_t kLogLines = 256;                  // log ring for "log" and "sub log"
+    static constexpr size_t kMaxClients = 16;
+    static constexpr size_t kMaxLine = 4096;                  // longer requests drop the client
+    static constexpr size_t kMaxOutput = 1 << 20;             // unread replies; a client that stops reading is dropped
+
+    ControlServer() = default;
+    ~ControlServer();
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool start(const std::string& path, std::string& err);   // replaces a stale socket, never any other file
+    void stop();
+    bool running() const { return loop_.running(); }
+
+    void publish(const ControlStatus& s);                     // UI thread, once per frame
+    void log(const std::string& line);                        // any thread
+    // UI thread: start/stop/profile requests since the last call (swaps storage with out); answer
+    // each one with reply()
+    void poll(std::vector<ControlCommand>& out);
+    void reply(const ControlCommand& cmd, bool ok, const std::string& text);
+
+private:
+    struct Reply {
+        uint32_t seq{ 0 };
+        bool done{ false };
+        std::string text;              // complete reply lines
+    };
+    struct Client {
+        uint32_t id{ 0 };
+        SOCKET s{ INVALID_SOCKET };
+        std::string in, out;           // bytes after the last newline; unsent output from outOff
+        size_t outOff{ 0 };
+        std::deque<Reply> replies;     // in request order; sent once done
+        uint32_t nextSeq{ 0 };
+        bool subState{ false }, subStats{ false }, subLog{ false };
+        std::string lastState;
+        std::chrono::milliseconds statsEvery{ 1000 };
+        std::chrono::steady_clock::time_point statsDue{};
+        uint64_t logNext{ 0 };         // next log sequence number to push
+    };
+
+    void acceptClients();
+    void onClient(uint32_t id, short revents);
+    void request(Client& c, const std::string& line);
+    void command(Client& c, const std::string& id, const std::string& cmd, const std::string& args);
+    void complete(Client& c, uint32_t seq, std::string text);
+    void flush(Client& c);
+    void drop(Client& c);
+    void tick();
+    Client* find(uint32_t id);
+
+    EventLoop loop_;
+    std::string path_;
+    SOCKET listen_{ INVALID_SOCKET };
+    uint32_t timer_{ 0 };
+
+    // loop thread only
+    std::vector<Client> clients_;
+    uint32_t nextClient_{ 1 };
+    std::string line_, scratch_;
+    uint64_t rateIn_{ 0 }, rateOut_{ 0 };                     // bytes/s over the last second
+    uint64_t lastIn_{ 0 }, lastOut_{ 0 };
+    std::chrono::steady_clock::time_point lastRate_{};
+
+    mutable std::mutex statusMu_;      // guards status_, profileUtf8_
+    ControlStatus status_;
+    std::string profileUtf8_;
+
+    std::mutex logMu_;                 // guards the log ring
+    std::vector<std::string> logRing_ = std::vector<std::string>(kLogLines);
+    uint64_t logSeq_{ 0 };             // lines ever logged; ring slot = seq % kLogLines
+
+    std::mutex cmdMu_;                 // guards commands_
+    std::vector<ControlCommand> commands_;
+};
@@ -0,0 +1,105 @@
+#include "DnsBench.h"
+#include "ResolverCache.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+std::atomic<int> g_delayMs{ 0 };
+std::atomic<uint64_t> g_calls{ 0 };
+
+double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+// The DnsQuery_A test double: A queries for "*.test" get an address derived from the name, AAAA and
+// every other name fail the way an NXDOMAIN answer does
+DNS_STATUS WINAPI FakeDnsQuery(PCSTR name, WORD type, DWORD, PVOID, PDNS_RECORD* results, PVOID*) {
+    ++g_calls;
+    if (const int ms = g_delayMs.load()) Sleep(ms);
+    *results = nullptr;
+    const size_t len = std::strlen(name);
+    if (type != DNS_TYPE_A || len < 5 || std::strcmp(name + len - 5, ".test") != 0) return DNS_ERROR_RCODE_NAME_ERROR;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) h = (h ^ (uint8_t)name[i]) * 16777619u;
+    PDNS_RECORD r = new DNS_RECORD{};
+    r->wType = DNS_TYPE_A;
+    r->Flags.S.Section = DnsSectionAnswer;
+    r->dwTtl = 60;
+    r->Data.A.IpAddress = htonl(0x0A000000u | (h & 0xFFFFFFu));
+    *results = r;
+    return 0;
+}
+
+void FakeDnsFree(PDNS_RECORD list) {
+    while (list) {
+        PDNS_RECORD next = list->pNext;
+        delete list;
+        list = next;
+    }
+}
+
+void waitIdle(const ResolverCache& cache) {
+    while (cache.stats().pending) Sleep(1);
+}
+} // namespace
+
+int DnsBench::Run(size_t names, int delayMs) {
+    names = std::max<size_t>(names, 1);
+    g_delayMs = delayMs;
+    ResolverCache cache;
+    cache.setDnsApi(&FakeDnsQuery, &FakeDnsFree);
+    cache.start();
+    if (!cache.running()) { std::printf("[dns-bench] Winsock unavailable\n"); return 1; }
+    std::vector<std::string> hosts(names);
+    char buf[32];
+    for (size_t i = 0; i < names; ++i) {
+        std::snprintf(buf, sizeof(buf), "server-%05zu.test", i);
+        hosts[i] = buf;
+    }
+    bool ok = true;
+
+    // cold: every name prefetched at once, the way StartResolver queues the profiles' remotes
+    auto t0 = Clock::now();
+    for (const std::string& h : hosts) cache.prefetch(h);
+    waitIdle(cache);
+    const double coldMs = msSince(t0);
+    ResolverCache::Stats s = cache.stats();
+    std::printf("cold     %zu names, %d ms per query: %.0f ms on %d workers, %zu resolved, %llu queries\n",
+        names, delayMs, coldMs, ResolverCache::kDefaultWorkers, s.resolved, (unsigned long long)g_calls.load());
+    ok &= s.resolved == names;
+
+    // warm: lookups only, as pinRemotes does on every connect; none may reach the double
+    const uint64_t callsBefore = g_calls;
+    const size_t lookups = names * 200;
+    std::vector<std::string> ips;
+    size_t hits = 0;
+    t0 = Clock::now();
+    for (size_t i = 0; i < lookups; ++i) hits += cache.lookup(hosts[i % names], ips, 2);
+    const double warmMs = msSince(t0);
+    std::printf("warm     %zu lookups: %.0f ns each, %zu hits, %llu queries\n", lookups, warmMs * 1e6 / lookups,
+        hits, (unsigned long long)(g_calls - callsBefore));
+    ok &= hits == lookups && g_calls == callsBefore;
+
+    // negative: a failing name is asked once (A and AAAA), then stays failed for kNegativeTtl
+    const uint64_t failBefore = g_calls;
+    size_t failedHits = 0;
+    for (int round = 0; round < 100; ++round) {
+        failedHits += cache.lookup("gone.invalid", ips);
+        waitIdle(cache);
+    }
+    const uint64_t failQueries = g_calls - failBefore;
+    std::printf("negative 100 lookups of a failing name: %zu hits, %llu queries\n", failedHits,
+        (unsigned long long)failQueries);
+    ok &= failedHits == 0 && failQueries == 2;
+
+    cache.stop();
+    if (!ok) std::printf("[dns-bench] FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+
+// --------- resolver cache benchmark (--dns-bench [--dns-bench-names N] [--dns-bench-delay MS]) ----------
+// Headless and offline: ResolverCache runs against an in-process DnsQuery_A double that answers
+// "<name>.test" with one A record (10.x.y.z, TTL 60 s) after delayMs and fails everything else as
+// NXDOMAIN. Prints the cold fill time of N names, the cost of a warm lookup, and how often a failing
+// name reaches the double. Fails if a warm lookup misses or queries, or a failure is not cached.
+class DnsBench {
+public:
+    static int Run(size_t names, int delayMs);   // prints one row per case to stdout; returns exit code
+};
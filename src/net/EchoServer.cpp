@@ -0,0 +1,64 @@
+#include "EchoServer.h"
+#include <algorithm>
+
+EchoServer::~EchoServer() { stop(); }
+
+bool EchoServer::start(uint16_t port) {
+    stop();
+    if (!wsa_.ok()) return false;
+    sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); addr.sin_port = htons(port);
+
+    tcp_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (tcp_ == INVALID_SOCKET || bind(tcp_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(tcp_, SOMAXCONN) != 0) {
+        CloseSocketSafe(tcp_); return false;
+    }
+    int len = sizeof(addr);
+    getsockname(tcp_, (sockaddr*)&addr, &len);   // resolve ephemeral port, UDP shares it
+    port_ = ntohs(addr.sin_port);
+
+    udp_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp_ == INVALID_SOCKET || bind(udp_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        CloseSocketSafe(udp_); CloseSocketSafe(tcp_); return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&EchoServer::loop, this);
+    return true;
+}
+
+void EchoServer::stop() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    for (auto& c : clients_) CloseSocketSafe(c);
+    clients_.clear();
+    CloseSocketSafe(tcp_);
+    CloseSocketSafe(udp_);
+}
+
+void EchoServer::loop() {
+    std::vector<WSAPOLLFD> fds;
+    char buf[2048];
+    while (running_) {
+        fds.clear();
+        fds.push_back({ tcp_, POLLRDNORM, 0 });
+        fds.push_back({ udp_, POLLRDNORM, 0 });
+        for (SOCKET c : clients_) fds.push_back({ c, POLLRDNORM, 0 });
+        if (WSAPoll(fds.data(), (ULONG)fds.size(), 100) <= 0) continue;
+
+        if (fds[0].revents & POLLRDNORM) {
+            SOCKET c = accept(tcp_, nullptr, nullptr);
+            if (c != INVALID_SOCKET) clients_.push_back(c);
+        }
+        if (fds[1].revents & POLLRDNORM) {
+            sockaddr_storage from{}; int fromLen = sizeof(from);
+            int n = recvfrom(udp_, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+            if (n > 0) sendto(udp_, buf, n, 0, (sockaddr*)&from, fromLen);
+        }
+        for (size_t i = 2; i < fds.size(); ++i) {
+            if (!fds[i].revents) continue;
+            SOCKET& c = clients_[i - 2];
+            int n = recv(c, buf, sizeof(buf), 0);
+            if (n <= 0 || send(c, buf, n, 0) != n) CloseSocketSafe(c);
+        }
+        clients_.erase(std::remove(clients_.begin(), clients_.end(), INVALID_SOCKET), clients_.end());
+    }
+}
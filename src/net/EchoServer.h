@@ -0,0 +1,31 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "Net.h"
+
+// --------- loopback TCP/UDP echo server ----------
+// Tiny reflector used as a local probe target (latency monitor self-test, CI runs without a tunnel).
+// Binds 127.0.0.1; port 0 picks an ephemeral port, read it back with port().
+class EchoServer {
+public:
+    EchoServer() = default;
+    ~EchoServer();
+
+    bool start(uint16_t port = 0);
+    void stop();
+    bool running() const { return running_.load(); }
+    uint16_t port() const { return port_; }
+
+private:
+    void loop();
+
+    WsaSession wsa_;
+    SOCKET tcp_{ INVALID_SOCKET };
+    SOCKET udp_{ INVALID_SOCKET };
+    std::vector<SOCKET> clients_;
+    uint16_t port_{ 0 };
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+};
@@ -0,0 +1,142 @@
+#include "EventLoop.h"
+#include <algorithm>
+
+using namespace std::chrono;
+
+EventLoop::~EventLoop() { stop(); }
+
+bool EventLoop::start() {
+    stop();
+    if (!wsa_.ok()) return false;
+    // wake socket: UDP on loopback, connected to its own address
+    wake_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int len = sizeof(a);
+    if (wake_ == INVALID_SOCKET || bind(wake_, (sockaddr*)&a, sizeof(a)) != 0 ||
+        getsockname(wake_, (sockaddr*)&a, &len) != 0 || connect(wake_, (sockaddr*)&a, sizeof(a)) != 0) {
+        CloseSocketSafe(wake_);
+        return false;
+    }
+    SetNonBlocking(wake_, true);
+    running_ = true;
+    thread_ = std::thread(&EventLoop::loop, this);
+    return true;
+}
+
+void EventLoop::stop() {
+    if (running_.exchange(false)) {
+        char b = 0;
+        send(wake_, &b, 1, 0);
+    }
+    if (thread_.joinable()) thread_.join();
+    CloseSocketSafe(wake_);
+    watches_.clear();
+    added_.clear();
+    timers_.clear();
+    std::lock_guard<std::mutex> lk(mu_);
+    posted_.clear();
+}
+
+void EventLoop::add(SOCKET s, short events, IoHandler h) {
+    (dispatching_ ? added_ : watches_).push_back({ s, events, std::move(h), false });
+}
+
+void EventLoop::setEvents(SOCKET s, short events) {
+    for (auto* v : { &watches_, &added_ })
+        for (Watch& w : *v)
+            if (w.s == s && !w.dead) w.events = events;
+}
+
+void EventLoop::remove(SOCKET s) {
+    for (auto* v : { &watches_, &added_ })
+        for (Watch& w : *v)
+            if (w.s == s) w.dead = true;   // swept after dispatch: handlers may still be on the stack
+}
+
+uint32_t EventLoop::every(milliseconds period, Task t) {
+    Timer tm;
+    tm.id = nextTimer_++;
+    tm.period = std::max<steady_clock::duration>(period, milliseconds(1));
+    tm.due = steady_clock::now() + tm.period;
+    tm.t = std::move(t);
+    timers_.push_back(std::move(tm));
+    return timers_.back().id;
+}
+
+void EventLoop::cancel(uint32_t timer) {
+    for (Timer& t : timers_)
+        if (t.id == timer) t.id = 0;   // swept by runTimers()
+}
+
+void EventLoop::post(Task t) {
+    bool first;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        first = posted_.empty();
+        posted_.push_back(std::move(t));
+    }
+    if (first) {   // later posts find the wake byte already pending
+        char b = 0;
+        send(wake_, &b, 1, 0);
+    }
+}
+
+void EventLoop::runPosted() {
+    char buf[64];
+    while (recv(wake_, buf, sizeof(buf), 0) > 0) {}
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        runningTasks_.swap(posted_);
+    }
+    for (Task& t : runningTasks_) t();
+    runningTasks_.clear();
+}
+
+int EventLoop::runTimers() {
+    timers_.erase(std::remove_if(timers_.begin(), timers_.end(), [](const Timer& t) { return t.id == 0; }), timers_.end());
+    const auto now = steady_clock::now();
+    for (size_t i = 0; i < timers_.size(); ++i) {   // by index: a timer may add another
+        if (timers_[i].id == 0 || timers_[i].due > now) continue;
+        timers_[i].due += timers_[i].period;
+        if (timers_[i].due <= now) timers_[i].due = now + timers_[i].period;   // fell behind: skip, don't burst
+        Task t = timers_[i].t;
+        t();
+    }
+    auto next = steady_clock::time_point::max();
+    for (const Timer& t : timers_)
+        if (t.id) next = std::min(next, t.due);
+    if (next == steady_clock::time_point::max()) return -1;
+    return (int)std::max<int64_t>(0, duration_cast<milliseconds>(next - steady_clock::now() + microseconds(999)).count());
+}
+
+void EventLoop::loop() {
+    while (running_) {
+        const int timeout = runTimers();
+        fds_.resize(watches_.size() + 1);
+        fds_[0] = WSAPOLLFD{};
+        fds_[0].fd = wake_;
+        fds_[0].events = POLLRDNORM;
+        for (size_t i = 0; i < watches_.size(); ++i) {
+            fds_[i + 1] = WSAPOLLFD{};
+            fds_[i + 1].fd = watches_[i].s;
+            fds_[i + 1].events = watches_[i].events;
+        }
+        const int n = WSAPoll(fds_.data(), (ULONG)fds_.size(), timeout);
+        if (!running_) break;
+        if (n > 0) {
+            dispatching_ = true;
+            for (size_t i = 0; i < watches_.size(); ++i) {
+                const short re = fds_[i + 1].revents;
+                if (re && !watches_[i].dead) watches_[i].h(re);
+            }
+            dispatching_ = false;
+            if (fds_[0].revents) runPosted();
+        }
+        watches_.erase(std::remove_if(watches_.begin(), watches_.end(), [](const Watch& w) { return w.dead; }), watches_.end());
+        for (Watch& w : added_)
+            if (!w.dead) watches_.push_back(std::move(w));
+        added_.clear();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Net.h"
+
+// --------- single-threaded socket event loop ----------
+// One thread, one WSAPoll over every watched socket. Handlers, timers and posted tasks all run on
+// that thread, so the code they share needs no locks; other threads hand work over with post().
+// post() wakes the poll through a loopback UDP socket connected to itself.
+class EventLoop {
+public:
+    using IoHandler = std::function<void(short revents)>;
+    using Task = std::function<void()>;
+
+    EventLoop() = default;
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool start();
+    void stop();                         // joins (not from the loop thread); watched sockets stay open
+    bool running() const { return running_.load(); }
+    bool inLoop() const { return std::this_thread::get_id() == thread_.get_id(); }
+
+    // loop thread only (handlers, timers, posted tasks); removing from inside a handler is fine
+    void add(SOCKET s, short events, IoHandler h);
+    void setEvents(SOCKET s, short events);
+    void remove(SOCKET s);
+    uint32_t every(std::chrono::milliseconds period, Task t);   // first run one period from now
+    void cancel(uint32_t timer);
+
+    void post(Task t);                   // any thread; runs on the loop thread, in post order
+
+private:
+    struct Watch {
+        SOCKET s{ INVALID_SOCKET };
+        short events{ 0 };
+        IoHandler h;
+        bool dead{ false };
+    };
+    struct Timer {
+        uint32_t id{ 0 };
+        std::chrono::steady_clock::duration period{};
+        std::chrono::steady_clock::time_point due{};
+        Task t;
+    };
+
+    void loop();
+    int runTimers();                     // runs due timers; ms until the next one (-1 = none)
+    void runPosted();
+
+    WsaSession wsa_;
+    SOCKET wake_{ INVALID_SOCKET };
+    std::vector<Watch> watches_, added_; // added_: registered while handlers run, merged afterwards
+    std::vector<WSAPOLLFD> fds_;
+    std::vector<Timer> timers_;
+    uint32_t nextTimer_{ 1 };
+    bool dispatching_{ false };
+
+    std::mutex mu_;                      // guards posted_
+    std::vector<Task> posted_, runningTasks_;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+};
@@ -0,0 +1,155 @@
+#include "LatencyMonitor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace std::chrono;
+
+static constexpr uint64_t kMinSamples = 10;      // don't judge the SLO on a handful of probes
+static constexpr double kSloClearRatio = 0.9;    // hysteresis: recover only once p95 < 90% of the SLO
+
+LatencyMonitor::~LatencyMonitor() { stop(); }
+
+void LatencyMonitor::start(std::vector<LatencyTarget> targets, milliseconds interval, size_t window) {
+    stop();
+    interval_ = interval;
+    window_ = std::max<size_t>(window, 1);
+    probes_.clear();
+    probes_.resize(targets.size());
+    for (size_t i = 0; i < targets.size(); ++i) {
+        probes_[i].cfg = std::move(targets[i]);
+        probes_[i].stats.name = probes_[i].cfg.name;
+        probes_[i].ring.reserve(window_);
+    }
+    alerts_.clear();
+    if (!wsa_.ok() || probes_.empty()) return;
+    running_ = true;
+    thread_ = std::thread(&LatencyMonitor::loop, this);
+}
+
+void LatencyMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    for (auto& p : probes_) CloseSocketSafe(p.udp);
+}
+
+void LatencyMonitor::snapshot(std::vector<LatencyStats>& out) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    out.resize(probes_.size());
+    for (size_t i = 0; i < probes_.size(); ++i) out[i] = probes_[i].stats;
+}
+
+void LatencyMonitor::pollAlerts(std::vector<LatencyAlert>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lk(mu_);
+    std::swap(out, alerts_);
+}
+
+void LatencyMonitor::loop() {
+    const int timeoutMs = (int)std::min<long long>(interval_.count(), 2000);
+    auto next = steady_clock::now();
+    while (running_) {
+        for (auto& p : probes_) {
+            if (!running_) break;
+            uint32_t rttUs = 0;
+            bool ok = measure(p, timeoutMs, rttUs);
+            record(p, ok, rttUs);
+        }
+        next += interval_;
+        auto now = steady_clock::now();
+        if (now > next + interval_) next = now;   // fell behind (slow probes): skip instead of bursting
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait_until(lk, next, [this] { return !running_; });
+    }
+}
+
+bool LatencyMonitor::measure(Probe& p, int timeoutMs, uint32_t& rttUs) {
+    if (!p.resolved) {
+        int type = p.cfg.kind == ProbeKind::Tcp ? SOCK_STREAM : SOCK_DGRAM;
+        if (!ResolveHost(p.cfg.host, p.cfg.port, type, p.addr)) return false;
+        p.resolved = true;
+        CloseSocketSafe(p.udp);
+    }
+    bool ok = p.cfg.kind == ProbeKind::Tcp ? probeTcp(p, timeoutMs, rttUs) : probeUdp(p, timeoutMs, rttUs);
+    if (!ok) p.resolved = false;   // remote may have moved (or the tunnel re-routed): re-resolve next round
+    return ok;
+}
+
+bool LatencyMonitor::probeTcp(Probe& p, int timeoutMs, uint32_t& rttUs) {
+    SOCKET s = socket(p.addr.family(), SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET) return false;
+    SetNonBlocking(s, true);
+    auto t0 = steady_clock::now();
+    bool ok = connect(s, p.addr.get(), p.addr.len) == 0
+        || (WSAGetLastError() == WSAEWOULDBLOCK && WaitSocket(s, true, timeoutMs));
+    auto t1 = steady_clock::now();
+    if (ok) {
+        int err = 0; int len = sizeof(err);
+        ok = getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &len) == 0 && err == 0;
+    }
+    CloseSocketSafe(s);
+    rttUs = (uint32_t)duration_cast<microseconds>(t1 - t0).count();
+    return ok;
+}
+
+bool LatencyMonitor::probeUdp(Probe& p, int timeoutMs, uint32_t& rttUs) {
+    if (p.udp == INVALID_SOCKET) {
+        p.udp = socket(p.addr.family(), SOCK_DGRAM, IPPROTO_UDP);
+        if (p.udp == INVALID_SOCKET) return false;
+        if (connect(p.udp, p.addr.get(), p.addr.len) != 0) { CloseSocketSafe(p.udp); return false; }
+    }
+    char pkt[16] = { 'L', 'A', 'T', 'P' };
+    uint32_t seq = ++p.seq;
+    memcpy(pkt + 4, &seq, sizeof(seq));
+
+    auto t0 = steady_clock::now();
+    auto deadline = t0 + milliseconds(timeoutMs);
+    if (send(p.udp, pkt, sizeof(pkt), 0) != (int)sizeof(pkt)) return false;
+    char reply[64];
+    for (;;) {
+        int left = (int)duration_cast<milliseconds>(deadline - steady_clock::now()).count();
+        if (left <= 0 || !WaitSocket(p.udp, false, left)) return false;
+        int n = recv(p.udp, reply, sizeof(reply), 0);
+        if (n < 0) return false;    // WSAECONNRESET = ICMP port unreachable
+        uint32_t got = 0;
+        if (n >= 8 && memcmp(reply, pkt, 4) == 0) memcpy(&got, reply + 4, sizeof(got));
+        if (got == seq) break;      // otherwise a late reply to an earlier probe: keep waiting
+    }
+    rttUs = (uint32_t)duration_cast<microseconds>(steady_clock::now() - t0).count();
+    return true;
+}
+
+void LatencyMonitor::record(Probe& p, bool ok, uint32_t rttUs) {
+    std::lock_guard<std::mutex> lk(mu_);
+    LatencyStats& st = p.stats;
+    ++st.sent;
+    st.lastOk = ok;
+    if (!ok) { ++st.lost; return; }
+
+    if (p.ring.size() < window_) p.ring.push_back(rttUs);
+    else {
+        p.hist.remove(p.ring[p.ringPos]);
+        p.ring[p.ringPos] = rttUs;
+        p.ringPos = (p.ringPos + 1) % window_;
+    }
+    p.hist.record(rttUs);
+
+    double ms = rttUs / 1000.0;
+    if (p.prevMs >= 0) st.jitterMs += (std::fabs(ms - p.prevMs) - st.jitterMs) / 16.0;   // RFC 3550 estimator
+    p.prevMs = ms;
+    st.lastMs = ms;
+    st.p50Ms = p.hist.percentile(50) / 1000.0;
+    st.p95Ms = p.hist.percentile(95) / 1000.0;
+    st.p99Ms = p.hist.percentile(99) / 1000.0;
+
+    if (p.hist.count() < kMinSamples) return;
+    bool breach = st.sloBreached ? st.p95Ms > p.cfg.sloMs * kSloClearRatio : st.p95Ms > p.cfg.sloMs;
+    if (breach != st.sloBreached) {
+        st.sloBreached = breach;
+        alerts_.push_back({ st.name, breach, st.p95Ms, p.cfg.sloMs });
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Net.h"
+#include "../core/HdrHistogram.h"
+
+// --------- in-tunnel latency / jitter monitor ----------
+enum class ProbeKind { Tcp, Udp };   // Tcp: time a connect() handshake; Udp: round trip through an echo service
+
+struct LatencyTarget {
+    std::string name;
+    std::string host;
+    uint16_t port{ 0 };
+    ProbeKind kind{ ProbeKind::Tcp };
+    double sloMs{ 200.0 };            // alert when the rolling p95 exceeds this
+};
+
+struct LatencyStats {
+    std::string name;
+    bool lastOk{ false };
+    uint64_t sent{ 0 }, lost{ 0 };
+    double lastMs{ 0 }, p50Ms{ 0 }, p95Ms{ 0 }, p99Ms{ 0 }, jitterMs{ 0 };
+    bool sloBreached{ false };
+};
+
+struct LatencyAlert {
+    std::string name;
+    bool breached{ false };          // false = recovered
+    double p95Ms{ 0 }, sloMs{ 0 };
+};
+
+class LatencyMonitor {
+public:
+    LatencyMonitor() = default;
+    ~LatencyMonitor();
+
+    // window = number of most recent probes kept in each target's histogram
+    void start(std::vector<LatencyTarget> targets,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(1000), size_t window = 300);
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // UI thread: copies into caller-owned vectors so steady-state polling reuses their storage
+    void snapshot(std::vector<LatencyStats>& out) const;
+    void pollAlerts(std::vector<LatencyAlert>& out);
+
+private:
+    struct Probe {
+        LatencyTarget cfg;
+        SockAddr addr;
+        bool resolved{ false };
+        SOCKET udp{ INVALID_SOCKET };
+        uint32_t seq{ 0 };
+        HdrHistogram hist;
+        std::vector<uint32_t> ring;   // last `window` RTTs (us), evicted values are removed from hist
+        size_t ringPos{ 0 };
+        double prevMs{ -1 };
+        LatencyStats stats;
+    };
+
+    void loop();
+    bool measure(Probe& p, int timeoutMs, uint32_t& rttUs);
+    bool probeTcp(Probe& p, int timeoutMs, uint32_t& rttUs);
+    bool probeUdp(Probe& p, int timeoutMs, uint32_t& rttUs);
+    void record(Probe& p, bool ok, uint32_t rttUs);
+
+    WsaSession wsa_;
+    std::vector<Probe> probes_;
+    std::chrono::milliseconds interval_{ 1000 };
+    size_t window_{ 300 };
+
+    mutable std::mutex mu_;          // guards probes_[i].stats and alerts_
+    std::vector<LatencyAlert> alerts_;
+    std::condition_variable cv_;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+};
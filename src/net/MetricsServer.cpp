@@ -0,0 +1,140 @@
+#include "MetricsServer.h"
+#include "../core/Metrics.h"
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+MetricsServer::~MetricsServer() { stop(); }
+
+bool MetricsServer::start(const MetricsRegistry& registry, uint16_t port, std::string& err) {
+    stop();
+    sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); addr.sin_port = htons(port);
+    listen_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_ == INVALID_SOCKET || bind(listen_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_, SOMAXCONN) != 0) {
+        err = "cannot listen on 127.0.0.1:" + std::to_string(port);
+        CloseSocketSafe(listen_);
+        return false;
+    }
+    int len = sizeof(addr);
+    getsockname(listen_, (sockaddr*)&addr, &len);
+    port_ = ntohs(addr.sin_port);
+    SetNonBlocking(listen_, true);
+    registry_ = &registry;
+    clients_.assign(kMaxClients, Client{});   // fixed slots: handlers refer to them by index
+    if (!loop_.start()) {
+        err = "cannot start the metrics event loop";
+        CloseSocketSafe(listen_);
+        return false;
+    }
+    loop_.post([this] { loop_.add(listen_, POLLRDNORM, [this](short) { acceptClients(); }); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    loop_.stop();
+    for (Client& c : clients_) CloseSocketSafe(c.s);
+    CloseSocketSafe(listen_);
+}
+
+void MetricsServer::acceptClients() {
+    for (;;) {
+        SOCKET s = accept(listen_, nullptr, nullptr);
+        if (s == INVALID_SOCKET) return;
+        size_t slot = 0;
+        while (slot < clients_.size() && clients_[slot].s != INVALID_SOCKET) ++slot;
+        if (slot == clients_.size()) { CloseSocketSafe(s); continue; }   // scrapers are few; refuse the rest
+        SetNonBlocking(s, true);
+        Client& c = clients_[slot];
+        c.s = s;
+        c.in.clear();
+        c.out.clear();
+        c.outOff = 0;
+        c.closeAfter = false;
+        loop_.add(s, POLLRDNORM, [this, slot](short revents) { onClient(slot, revents); });
+    }
+}
+
+void MetricsServer::drop(Client& c) {
+    loop_.remove(c.s);
+    CloseSocketSafe(c.s);
+}
+
+void MetricsServer::onClient(size_t slot, short revents) {
+    Client& c = clients_[slot];
+    if (c.s == INVALID_SOCKET) return;
+    if (revents & (POLLRDNORM | POLLHUP | POLLERR)) {
+        char buf[2048];
+        for (;;) {
+            const int n = recv(c.s, buf, sizeof(buf), 0);
+            if (n == 0 || (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK)) { drop(c); return; }
+            if (n < 0) break;
+            c.in.append(buf, n);
+        }
+        for (size_t end; !c.closeAfter && (end = c.in.find("\r\n\r\n")) != std::string::npos;) {   // pipelined requests
+            if (!respond(c, end)) { drop(c); return; }
+            c.in.erase(0, end + 4);
+        }
+        if (c.in.size() > kMaxRequest) { drop(c); return; }
+    }
+    flush(c);
+}
+
+static bool startsWithNoCase(const char* p, const char* prefix) {
+    for (; *prefix; ++p, ++prefix)
+        if (std::tolower((unsigned char)*p) != *prefix) return false;
+    return true;
+}
+
+bool MetricsServer::respond(Client& c, size_t headerEnd) {
+    c.in[headerEnd] = '\0';   // the headers become one C string; the terminator is erased with them
+    const char* req = c.in.c_str();
+    const bool head = std::strncmp(req, "HEAD ", 5) == 0;
+    if (!head && std::strncmp(req, "GET ", 4) != 0) {
+        c.out += "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, HEAD\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        c.closeAfter = true;
+        return true;
+    }
+    const char* target = req + (head ? 5 : 4);
+    const char* sp = std::strchr(target, ' ');
+    const char* eol = std::strstr(req, "\r\n");
+    if (!sp || (eol && sp > eol)) return false;
+    c.closeAfter = std::strncmp(sp + 1, "HTTP/1.0", 8) == 0;
+    for (const char* h = eol; h;) {
+        const char* line = h + 2;
+        h = std::strstr(line, "\r\n");
+        if (!startsWithNoCase(line, "connection:")) continue;
+        const std::string_view value(line + 11, h ? h - line - 11 : std::strlen(line + 11));
+        if (value.find("close") != std::string_view::npos) c.closeAfter = true;
+    }
+
+    const size_t pathLen = std::strcspn(target, " ?");   // a query string is ignored
+    char header[256];
+    if (pathLen != 8 || std::strncmp(target, "/metrics", 8) != 0) {
+        std::snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nContent-Length: 10\r\n%s\r\n%s",
+            c.closeAfter ? "Connection: close\r\n" : "", head ? "" : "not found\n");
+        c.out += header;
+        return true;
+    }
+    registry_->render(body_);
+    std::snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: %zu\r\n%s\r\n", body_.size(), c.closeAfter ? "Connection: close\r\n" : "");
+    c.out += header;
+    if (!head) c.out += body_;
+    return true;
+}
+
+void MetricsServer::flush(Client& c) {
+    while (c.outOff < c.out.size()) {
+        const int n = send(c.s, c.out.data() + c.outOff, (int)(c.out.size() - c.outOff), 0);
+        if (n < 0 && WSAGetLastError() == WSAEWOULDBLOCK) break;
+        if (n <= 0) { drop(c); return; }
+        c.outOff += n;
+    }
+    if (c.outOff == c.out.size()) {
+        c.out.clear();
+        c.outOff = 0;
+        if (c.closeAfter) { drop(c); return; }
+    }
+    loop_.setEvents(c.s, c.out.empty() ? POLLRDNORM : POLLRDNORM | POLLWRNORM);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "EventLoop.h"
+
+class MetricsRegistry;
+
+// --------- Prometheus /metrics endpoint ----------
+// Minimal HTTP/1.1 server on 127.0.0.1: GET (or HEAD) /metrics renders the registry, anything else
+// is a 404. Keep-alive is honoured, so a scraper reuses its connection. It runs on its own
+// EventLoop thread. The exposition goes into one reused buffer and connection slots (with their
+// buffers) are recycled, so a steady scrape does not allocate.
+class MetricsServer {
+public:
+    static constexpr size_t kMaxClients = 8;
+    static constexpr size_t kMaxRequest = 8192;   // request line + headers
+
+    MetricsServer() = default;
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(const MetricsRegistry& registry, uint16_t port, std::string& err);   // port 0 = ephemeral
+    void stop();
+    bool running() const { return loop_.running(); }
+    uint16_t port() const { return port_; }
+
+private:
+    struct Client {
+        SOCKET s{ INVALID_SOCKET };
+        std::string in, out;       // request bytes; unsent response from outOff
+        size_t outOff{ 0 };
+        bool closeAfter{ false };  // Connection: close / HTTP/1.0
+    };
+
+    void acceptClients();
+    void onClient(size_t slot, short revents);
+    bool respond(Client& c, size_t headerEnd);   // false: malformed, drop the connection
+    void flush(Client& c);
+    void drop(Client& c);
+
+    EventLoop loop_;
+    const MetricsRegistry* registry_{ nullptr };
+    SOCKET listen_{ INVALID_SOCKET };
+    uint16_t port_{ 0 };
+    std::vector<Client> clients_;  // loop thread only; a closed slot is reused by the next accept
+    std::string body_;             // loop thread: the last rendered exposition
+};
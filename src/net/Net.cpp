@@ -0,0 +1,42 @@
+#include "Net.h"
+#include <cstring>
+#pragma comment(lib, "ws2_32.lib")
+
+WsaSession::WsaSession() {
+    WSADATA wsa{};
+    ok_ = WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+}
+WsaSession::~WsaSession() { if (ok_) WSACleanup(); }
+
+bool ResolveHost(const std::string& host, uint16_t port, int sockType, SockAddr& out) {
+    addrinfo hints{}; hints.ai_family = AF_UNSPEC; hints.ai_socktype = sockType;
+    addrinfo* res = nullptr;
+    std::string svc = std::to_string(port);
+    if (getaddrinfo(host.c_str(), svc.c_str(), &hints, &res) != 0 || !res) return false;
+    out.len = (int)res->ai_addrlen;
+    memcpy(&out.ss, res->ai_addr, res->ai_addrlen);
+    freeaddrinfo(res);
+    return true;
+}
+
+std::string FormatAddr(const SockAddr& a) {
+    char host[INET6_ADDRSTRLEN]{}; char port[8]{};
+    if (getnameinfo(a.get(), a.len, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+        return "?";
+    return a.family() == AF_INET6 ? "[" + std::string(host) + "]:" + port : std::string(host) + ":" + port;
+}
+
+bool SetNonBlocking(SOCKET s, bool on) {
+    u_long mode = on ? 1 : 0;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+
+bool WaitSocket(SOCKET s, bool write, int timeoutMs) {
+    WSAPOLLFD pfd{}; pfd.fd = s; pfd.events = write ? POLLWRNORM : POLLRDNORM;
+    int n = WSAPoll(&pfd, 1, timeoutMs);
+    if (n <= 0) return false;
+    if (write && (pfd.revents & (POLLERR | POLLHUP))) return false;
+    return (pfd.revents & (write ? POLLWRNORM : (POLLRDNORM | POLLHUP))) != 0;
+}
+
+void CloseSocketSafe(SOCKET& s) { if (s != INVALID_SOCKET) { closesocket(s); s = INVALID_SOCKET; } }
@@ -0,0 +1,35 @@
+#pragma once
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <cstdint>
+#include <string>
+
+// --------- Winsock helpers ----------
+// WSAStartup/WSACleanup are ref-counted by Windows, so each net component just owns a WsaSession.
+class WsaSession {
+public:
+    WsaSession();
+    ~WsaSession();
+    WsaSession(const WsaSession&) = delete;
+    WsaSession& operator=(const WsaSession&) = delete;
+    bool ok() const { return ok_; }
+
+private:
+    bool ok_{ false };
+};
+
+struct SockAddr {
+    sockaddr_storage ss{};
+    int len{ 0 };
+    const sockaddr* get() const { return reinterpret_cast<const sockaddr*>(&ss); }
+    int family() const { return ss.ss_family; }
+};
+
+// getaddrinfo wrapper: first result for host:port with the given SOCK_STREAM/SOCK_DGRAM type
+bool ResolveHost(const std::string& host, uint16_t port, int sockType, SockAddr& out);
+std::string FormatAddr(const SockAddr& a);
+
+bool SetNonBlocking(SOCKET s, bool on);
+// waits for readable (write=false) or writable (write=true); returns false on timeout/error
+bool WaitSocket(SOCKET s, bool write, int timeoutMs);
+void CloseSocketSafe(SOCKET& s);
@@ -0,0 +1,231 @@
+#include "NetWatcher.h"
+#include <iphlpapi.h>
+#include <netioapi.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string_view>
+#include "../core/Utf8.h"
+#pragma comment(lib, "iphlpapi.lib")
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// TAP-Windows6 ("TAP-Windows Adapter V9"), Wintun ("Wintun Userspace Tunnel") and ovpn-dco
+// ("OpenVPN Data Channel Offload") adapters
+static bool isTunnel(const MIB_IF_ROW2& row) {
+    const std::wstring_view d(row.Description);
+    for (const wchar_t* k : { L"TAP-Windows", L"Wintun", L"OpenVPN" })
+        if (d.find(k) != std::wstring_view::npos) return true;
+    return false;
+}
+
+// false: not worth watching (loopback, the filter-driver rows every adapter has)
+static bool toInterface(const MIB_IF_ROW2& row, NetInterface& out) {
+    if (row.Type == IF_TYPE_SOFTWARE_LOOPBACK || row.InterfaceAndOperStatusFlags.FilterInterface) return false;
+    out.index = row.InterfaceIndex;
+    out.luid = row.InterfaceLuid.Value;
+    out.name = WideToUtf8(row.Alias);
+    out.up = row.OperStatus == IfOperStatusUp;
+    out.tunnel = isTunnel(row);
+    return true;
+}
+
+static void copyAddr(const SOCKADDR_INET& a, uint8_t* out) {
+    if (a.si_family == AF_INET) std::memcpy(out, &a.Ipv4.sin_addr, 4);
+    else std::memcpy(out, &a.Ipv6.sin6_addr, 16);
+}
+
+// false: not a route that covers the default
+static bool toRoute(const MIB_IPFORWARD_ROW2& row, NetRoute& out) {
+    const SOCKADDR_INET& dest = row.DestinationPrefix.Prefix;
+    const unsigned prefix = row.DestinationPrefix.PrefixLength;
+    if (!(dest.si_family == AF_INET && prefix <= 1) && !(dest.si_family == AF_INET6 && prefix <= 4)) return false;
+    out.luid = row.InterfaceLuid.Value;
+    out.index = row.InterfaceIndex;
+    out.v6 = dest.si_family == AF_INET6;
+    out.prefix = (uint8_t)prefix;
+    out.metric = row.Metric;
+    copyAddr(dest, out.dest);
+    copyAddr(row.NextHop, out.nextHop);
+    char text[INET6_ADDRSTRLEN];
+    if (!inet_ntop(dest.si_family, out.dest, text, sizeof(text))) std::strcpy(text, "?");
+    out.text = std::string(text) + "/" + std::to_string(prefix);
+    return true;
+}
+
+static bool sameRoute(const NetRoute& a, const NetRoute& b) {
+    return a.luid == b.luid && a.v6 == b.v6 && a.prefix == b.prefix && std::memcmp(a.dest, b.dest, sizeof(a.dest)) == 0 &&
+        std::memcmp(a.nextHop, b.nextHop, sizeof(a.nextHop)) == 0;
+}
+
+// --- NetView ---
+
+const NetInterface* NetView::find(uint32_t index) const {
+    for (const NetInterface& i : interfaces)
+        if (i.index == index) return &i;
+    return nullptr;
+}
+
+const NetInterface* NetView::tunnel() const {
+    const NetInterface* best = nullptr;
+    for (const NetInterface& i : interfaces)
+        if (i.tunnel && (!best || (i.up && !best->up))) best = &i;
+    return best;
+}
+
+size_t NetView::tunnelRoutes() const {
+    return (size_t)std::count_if(routes.begin(), routes.end(), [this](const NetRoute& r) {
+        const NetInterface* i = find(r.index);
+        return i && i->tunnel;
+    });
+}
+
+const NetInterface* NetView::uplink() const {
+    const NetInterface* best = nullptr;
+    uint32_t metric = 0;
+    for (const NetRoute& r : routes) {
+        const NetInterface* i = r.prefix == 0 ? find(r.index) : nullptr;
+        if (!i || !i->up || i->tunnel || (best && r.metric >= metric)) continue;
+        best = i;
+        metric = r.metric;
+    }
+    return best;
+}
+
+// --- NetWatcher ---
+
+// Thread-pool threads, which may run two notifications for one interface at once. Its state is read
+// under the lock, so whichever applies last applies the newest state.
+struct NetWatcher::Callbacks {
+    static void NETIOAPI_API_ onInterface(PVOID ctx, PMIB_IPINTERFACE_ROW row, MIB_NOTIFICATION_TYPE) {
+        if (!row) return;
+        NetWatcher* w = static_cast<NetWatcher*>(ctx);
+        const int64_t at = nowNs();
+        {
+            std::lock_guard<std::mutex> lk(w->mu_);
+            MIB_IF_ROW2 ifRow{};
+            ifRow.InterfaceLuid = row->InterfaceLuid;
+            NetInterface n;
+            const bool present = GetIfEntry2(&ifRow) == NO_ERROR && toInterface(ifRow, n);   // gone once both families are
+            w->applyInterface(row->InterfaceLuid.Value, present ? &n : nullptr, at);
+        }
+        w->changes_.fetch_add(1, std::memory_order_release);
+    }
+
+    static void NETIOAPI_API_ onRoute(PVOID ctx, PMIB_IPFORWARD_ROW2 row, MIB_NOTIFICATION_TYPE type) {
+        NetRoute r;
+        if (!row || !toRoute(*row, r)) return;
+        NetWatcher* w = static_cast<NetWatcher*>(ctx);
+        const int64_t at = nowNs();
+        {
+            std::lock_guard<std::mutex> lk(w->mu_);
+            w->applyRoute(r, type == MibDeleteInstance, at);
+        }
+        w->changes_.fetch_add(1, std::memory_order_release);
+    }
+};
+
+NetWatcher::~NetWatcher() { stop(); }
+
+bool NetWatcher::start(std::string& err) {
+    stop();
+    // Subscribe first, then read the tables under the lock: a notification that arrives meanwhile waits
+    // and is applied on top of the tables, never overwritten by them.
+    std::unique_lock<std::mutex> lk(mu_);
+    if (NotifyIpInterfaceChange(AF_UNSPEC, &Callbacks::onInterface, this, FALSE, &ifNotify_) != NO_ERROR ||
+        NotifyRouteChange2(AF_UNSPEC, &Callbacks::onRoute, this, FALSE, &routeNotify_) != NO_ERROR) {
+        err = "cannot subscribe to interface and route changes";
+        lk.unlock();   // stop() waits for callbacks, which may be waiting for the lock
+        stop();
+        return false;
+    }
+    readTables();
+    changes_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void NetWatcher::readTables() {
+    NetView view;
+    MIB_IF_TABLE2* ifs = nullptr;
+    if (GetIfTable2(&ifs) == NO_ERROR) {
+        for (ULONG i = 0; i < ifs->NumEntries; ++i) {
+            NetInterface n;
+            if (toInterface(ifs->Table[i], n)) view.interfaces.push_back(std::move(n));
+        }
+        FreeMibTable(ifs);
+    }
+    MIB_IPFORWARD_TABLE2* routes = nullptr;
+    if (GetIpForwardTable2(AF_UNSPEC, &routes) == NO_ERROR) {
+        for (ULONG i = 0; i < routes->NumEntries; ++i) {
+            NetRoute r;
+            if (toRoute(routes->Table[i], r)) view.routes.push_back(std::move(r));
+        }
+        FreeMibTable(routes);
+    }
+    view_ = std::move(view);
+    events_.clear();
+}
+
+void NetWatcher::stop() {
+    if (ifNotify_) CancelMibChangeNotify2(ifNotify_);   // returns once no callback runs
+    if (routeNotify_) CancelMibChangeNotify2(routeNotify_);
+    ifNotify_ = routeNotify_ = nullptr;
+    std::lock_guard<std::mutex> lk(mu_);
+    view_ = NetView{};
+    events_.clear();
+}
+
+void NetWatcher::poll(std::vector<NetEvent>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lk(mu_);
+    std::swap(out, events_);
+}
+
+void NetWatcher::snapshot(NetView& out) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    out.interfaces = view_.interfaces;
+    out.routes = view_.routes;
+}
+
+void NetWatcher::emit(NetEvent::Kind kind, bool tunnel, uint32_t index, int64_t atNs, std::string text) {
+    events_.push_back({ kind, tunnel, index, atNs, std::move(text) });
+}
+
+void NetWatcher::applyInterface(uint64_t luid, const NetInterface* now, int64_t atNs) {
+    auto& v = view_.interfaces;
+    auto it = std::find_if(v.begin(), v.end(), [luid](const NetInterface& i) { return i.luid == luid; });
+    if (!now) {
+        if (it == v.end()) return;
+        emit(NetEvent::InterfaceRemoved, it->tunnel, it->index, atNs, (it->tunnel ? "tunnel adapter " : "interface ") + it->name + " removed");
+        v.erase(it);
+        return;
+    }
+    const char* kind = now->tunnel ? "tunnel adapter " : "interface ";
+    if (it == v.end()) {
+        emit(NetEvent::InterfaceAdded, now->tunnel, now->index, atNs, kind + now->name + (now->up ? " added, up" : " added, down"));
+        v.push_back(*now);
+        return;
+    }
+    if (it->up != now->up)
+        emit(now->up ? NetEvent::InterfaceUp : NetEvent::InterfaceDown, now->tunnel, now->index, atNs, kind + now->name + (now->up ? " up" : " down"));
+    *it = *now;
+}
+
+void NetWatcher::applyRoute(NetRoute& r, bool removed, int64_t atNs) {
+    auto& v = view_.routes;
+    auto it = std::find_if(v.begin(), v.end(), [&r](const NetRoute& x) { return sameRoute(x, r); });
+    const NetInterface* via = view_.find(r.index);
+    const bool tunnel = via && via->tunnel;
+    const std::string name = via ? via->name : "interface " + std::to_string(r.index);
+    if (removed) {
+        if (it == v.end()) return;
+        emit(NetEvent::RouteRemoved, tunnel, r.index, atNs, "route " + r.text + " via " + name + " removed");
+        v.erase(it);
+        return;
+    }
+    if (it != v.end()) { it->metric = r.metric; return; }
+    emit(NetEvent::RouteAdded, tunnel, r.index, atNs, "route " + r.text + " via " + name + " added");
+    v.push_back(std::move(r));
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Net.h"
+
+// --------- link and route watcher ----------
+// The system's own view of the tunnel: whether the TAP/Wintun/DCO adapter is up and which default
+// routes point at it, kept current from IP Helper change notifications (NotifyIpInterfaceChange,
+// NotifyRouteChange2) instead of scraping the openvpn log. The tables are read once at start();
+// after that every notification is applied to the view where it arrives, on a system thread-pool
+// thread, and queued as a NetEvent that the UI thread drains each frame.
+// Only routes that cover the default are kept: /0 and openvpn's def1 halves (/1) for IPv4, and up
+// to /4 for IPv6 (::/0, 2000::/4, 3000::/4).
+struct NetInterface {
+    uint32_t index{ 0 };
+    uint64_t luid{ 0 };
+    std::string name;                 // alias, e.g. "Wi-Fi", "OpenVPN Wintun"
+    bool up{ false };                 // operational status
+    bool tunnel{ false };             // TAP-Windows, Wintun or ovpn-dco adapter
+};
+
+struct NetRoute {
+    uint64_t luid{ 0 };               // interface
+    uint32_t index{ 0 };
+    bool v6{ false };
+    uint8_t prefix{ 0 };
+    uint8_t dest[16]{};
+    uint8_t nextHop[16]{};
+    uint32_t metric{ 0 };
+    std::string text;                 // "0.0.0.0/1"
+};
+
+struct NetView {
+    std::vector<NetInterface> interfaces;
+    std::vector<NetRoute> routes;     // default-covering routes only
+
+    const NetInterface* find(uint32_t index) const;
+    const NetInterface* tunnel() const;     // the first tunnel adapter, up ones first; nullptr = none
+    size_t tunnelRoutes() const;            // default-covering routes through a tunnel adapter
+    const NetInterface* uplink() const;     // the interface of the best /0 route that is up and no tunnel
+};
+
+struct NetEvent {
+    enum Kind { InterfaceAdded, InterfaceRemoved, InterfaceUp, InterfaceDown, RouteAdded, RouteRemoved };
+    Kind kind{ InterfaceAdded };
+    bool tunnel{ false };             // concerns a tunnel adapter
+    uint32_t index{ 0 };              // the interface
+    int64_t atNs{ 0 };                // when the notification arrived, LogIngest::nowNs() time base
+    std::string text;                 // e.g. "route 0.0.0.0/1 via OpenVPN Wintun added"
+};
+
+class NetWatcher {
+public:
+    NetWatcher() = default;
+    ~NetWatcher();
+    NetWatcher(const NetWatcher&) = delete;
+    NetWatcher& operator=(const NetWatcher&) = delete;
+
+    bool start(std::string& err);
+    void stop();                      // waits for callbacks in progress
+    bool running() const { return ifNotify_ != nullptr; }
+
+    // UI thread: events since the last poll, swapped into out (its storage is reused)
+    void poll(std::vector<NetEvent>& out);
+    // copies the view; changes() tells whether there is anything new to copy
+    void snapshot(NetView& out) const;
+    uint64_t changes() const { return changes_.load(std::memory_order_acquire); }
+
+private:
+    struct Callbacks;                 // the IP Helper callbacks, typed in the .cpp
+    friend struct Callbacks;
+
+    void applyInterface(uint64_t luid, const NetInterface* now, int64_t atNs);   // under mu_; now null = gone
+    void applyRoute(NetRoute& r, bool removed, int64_t atNs);                    // under mu_
+    void readTables();                                                           // under mu_
+    void emit(NetEvent::Kind kind, bool tunnel, uint32_t index, int64_t atNs, std::string text);   // under mu_
+
+    mutable std::mutex mu_;           // guards view_ and events_
+    NetView view_;
+    std::vector<NetEvent> events_;
+    std::atomic<uint64_t> changes_{ 0 };
+    HANDLE ifNotify_{ nullptr }, routeNotify_{ nullptr };
+};
@@ -0,0 +1,231 @@
+#include "ResolverCache.h"
+#include <algorithm>
+#include <cstring>
+#pragma comment(lib, "dnsapi.lib")
+
+using namespace std::chrono;
+
+ResolverCache::~ResolverCache() { stop(); }
+
+int64_t ResolverCache::nowNs() { return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count(); }
+
+uint32_t ResolverCache::hashOf(std::string_view s) {   // FNV-1a
+    uint32_t h = 2166136261u;
+    for (char c : s) h = (h ^ (uint8_t)c) * 16777619u;
+    return h;
+}
+
+bool ResolverCache::setServer(const std::string& ipv4) {
+    in_addr a{};
+    if (inet_pton(AF_INET, ipv4.c_str(), &a) != 1) return false;
+    std::memcpy(&server_, &a, sizeof(server_));
+    return true;
+}
+
+void ResolverCache::start(int workers) {
+    stop();
+    if (!wsa_.ok()) return;
+    running_ = true;
+    for (int i = 0; i < std::max(workers, 1); ++i) workers_.emplace_back(&ResolverCache::worker, this);
+}
+
+void ResolverCache::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();   // a worker inside DnsQuery finishes that query first
+    workers_.clear();
+}
+
+uint32_t ResolverCache::find(std::string_view host, uint32_t h) const {
+    if (index_.empty()) return kNone;
+    const size_t mask = index_.size() - 1;
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        const uint32_t slot = index_[i];
+        if (!slot) return kNone;
+        const Entry& e = entries_[slot - 1];
+        if (e.hash == h && nameOf(e) == host) return slot - 1;
+    }
+}
+
+uint32_t ResolverCache::insert(std::string_view host, uint32_t h) {
+    if ((entries_.size() + 1) * 2 > index_.size()) {   // keep the load under one half
+        index_.assign(std::max<size_t>(64, index_.size() * 2), 0);
+        for (uint32_t k = 0; k < entries_.size(); ++k) {
+            size_t i = entries_[k].hash & (index_.size() - 1);
+            while (index_[i]) i = (i + 1) & (index_.size() - 1);
+            index_[i] = k + 1;
+        }
+    }
+    Entry e;
+    e.hash = h;
+    e.nameOff = (uint32_t)names_.size();
+    e.nameLen = (uint16_t)host.size();
+    names_.insert(names_.end(), host.begin(), host.end());
+    entries_.push_back(e);
+    addrs_.resize(entries_.size() * kMaxAddrs);
+    size_t i = h & (index_.size() - 1);
+    while (index_[i]) i = (i + 1) & (index_.size() - 1);
+    index_[i] = (uint32_t)entries_.size();
+    return (uint32_t)entries_.size() - 1;
+}
+
+void ResolverCache::enqueue(uint32_t e) {
+    if (entries_[e].state == kQueued) return;
+    entries_[e].state = kQueued;
+    queue_.push_back(e);
+    ++stats_.pending;
+    cv_.notify_one();
+}
+
+static bool isNumeric(const std::string& host) {
+    in6_addr a6{};
+    in_addr a4{};
+    return inet_pton(AF_INET, host.c_str(), &a4) == 1 || inet_pton(AF_INET6, host.c_str(), &a6) == 1;
+}
+
+void ResolverCache::prefetch(std::string_view host) {
+    if (host.empty() || host.size() > 253 || isNumeric(std::string(host))) return;
+    const uint32_t h = hashOf(host);
+    std::lock_guard<std::mutex> lk(mu_);
+    uint32_t e = find(host, h);
+    if (e == kNone) e = insert(host, h);
+    Entry& en = entries_[e];
+    const int64_t now = nowNs();
+    en.wanted = now;
+    if (en.state == kNew || ((en.state == kOk || en.state == kFailed) && now >= en.refresh)) enqueue(e);
+}
+
+bool ResolverCache::lookup(std::string_view host, std::vector<std::string>& ips, size_t max) {
+    ips.clear();
+    const std::string h(host);
+    if (isNumeric(h)) { ips.push_back(h); return true; }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        const uint32_t e = find(host, hashOf(host));
+        if (e != kNone && entries_[e].addrCount && nowNs() < entries_[e].expires) {   // also while a refresh is queued
+            const Entry& en = entries_[e];
+            for (size_t k = 0; k < en.addrCount && k < max; ++k) {
+                const Addr& a = addrs_[e * kMaxAddrs + k];
+                char buf[INET6_ADDRSTRLEN]{};
+                if (inet_ntop(a.v6 ? AF_INET6 : AF_INET, a.b, buf, sizeof(buf))) ips.push_back(buf);
+            }
+            ++stats_.hits;
+            return !ips.empty();
+        }
+        ++stats_.misses;
+    }
+    prefetch(host);
+    return false;
+}
+
+ResolverCache::Stats ResolverCache::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    Stats s = stats_;
+    s.names = entries_.size();
+    s.resolved = s.failed = 0;
+    for (const Entry& e : entries_) {
+        s.resolved += e.addrCount > 0;
+        s.failed += e.state == kFailed;
+    }
+    return s;
+}
+
+// A and AAAA answers with the smallest TTL among them; without answers (e.g. a name DnsQuery does
+// not handle) getaddrinfo has the last word, at kDefaultTtl
+bool ResolverCache::query(const std::string& host, Answer& out) const {
+    out.count = 0;
+    out.ttl = UINT32_MAX;
+    IP4_ARRAY servers{};
+    servers.AddrCount = 1;
+    servers.AddrArray[0] = server_;
+    const QueryFn query = query_ ? query_ : &DnsQuery_A;
+    for (WORD type : { (WORD)DNS_TYPE_A, (WORD)DNS_TYPE_AAAA }) {
+        PDNS_RECORD list = nullptr;
+        if (query(host.c_str(), type, DNS_QUERY_STANDARD, server_ ? &servers : nullptr, &list, nullptr) != 0) continue;
+        for (PDNS_RECORD r = list; r && out.count < kMaxAddrs; r = r->pNext) {
+            if (r->Flags.S.Section != DnsSectionAnswer || r->wType != type) continue;   // skips the CNAME chain
+            Addr& a = out.addrs[out.count++];
+            a.v6 = type == DNS_TYPE_AAAA;
+            if (a.v6) std::memcpy(a.b, r->Data.AAAA.Ip6Address.IP6Byte, 16);
+            else std::memcpy(a.b, &r->Data.A.IpAddress, 4);
+            out.ttl = std::min<uint32_t>(out.ttl, r->dwTtl);
+        }
+        if (free_) free_(list);
+        else DnsRecordListFree(list, DnsFreeRecordList);
+    }
+    if (out.count || server_ || query_) return out.count > 0;
+
+    addrinfo hints{}; hints.ai_family = AF_UNSPEC; hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0) return false;
+    for (addrinfo* r = res; r && out.count < kMaxAddrs; r = r->ai_next) {
+        Addr& a = out.addrs[out.count];
+        a = Addr{};
+        if (r->ai_family == AF_INET) std::memcpy(a.b, &reinterpret_cast<sockaddr_in*>(r->ai_addr)->sin_addr, 4);
+        else if (r->ai_family == AF_INET6) { a.v6 = 1; std::memcpy(a.b, &reinterpret_cast<sockaddr_in6*>(r->ai_addr)->sin6_addr, 16); }
+        else continue;
+        ++out.count;
+    }
+    freeaddrinfo(res);
+    out.ttl = (uint32_t)kDefaultTtl.count();
+    return out.count > 0;
+}
+
+void ResolverCache::worker() {
+    std::unique_lock<std::mutex> lk(mu_);
+    Answer ans;
+    std::string host;
+    while (running_) {
+        if (queue_.empty()) {
+            // nothing queued: wake for the earliest refresh of a name someone still wants
+            const int64_t now = nowNs();
+            const int64_t forget = now - duration_cast<nanoseconds>(kForgetAfter).count();
+            int64_t next = INT64_MAX;
+            for (uint32_t e = 0; e < entries_.size(); ++e) {
+                const Entry& en = entries_[e];
+                if ((en.state != kOk && en.state != kFailed) || en.wanted < forget) continue;
+                if (en.refresh <= now) enqueue(e);
+                else next = std::min(next, en.refresh);
+            }
+            if (!queue_.empty()) continue;
+            if (next == INT64_MAX) cv_.wait(lk);
+            else cv_.wait_for(lk, nanoseconds(next - now));
+            continue;
+        }
+        const uint32_t e = queue_.front();
+        queue_.pop_front();
+        host.assign(nameOf(entries_[e]));
+        lk.unlock();
+        const auto t0 = steady_clock::now();
+        const bool ok = query(host, ans);
+        const double ms = duration<double, std::milli>(steady_clock::now() - t0).count();
+        lk.lock();
+
+        Entry& en = entries_[e];   // looked up again: entries_ may have grown while unlocked
+        const int64_t now = nowNs();
+        --stats_.pending;
+        ++stats_.queries;
+        stats_.lastQueryMs = ms;
+        stats_.maxQueryMs = std::max(stats_.maxQueryMs, ms);
+        if (ok) {
+            const seconds ttl = std::clamp(seconds(ans.ttl), kMinTtl, kMaxTtl);
+            en.state = kOk;
+            en.addrCount = (uint8_t)ans.count;
+            std::copy(ans.addrs, ans.addrs + ans.count, addrs_.begin() + (size_t)e * kMaxAddrs);
+            en.expires = now + duration_cast<nanoseconds>(ttl).count();
+            en.refresh = now + duration_cast<nanoseconds>(ttl).count() * 4 / 5;   // re-resolve before it expires
+        }
+        else if (!en.addrCount || now >= en.expires) {
+            en.state = kFailed;
+            en.addrCount = 0;
+            en.expires = en.refresh = now + duration_cast<nanoseconds>(kNegativeTtl).count();
+        }
+        else {   // a failed refresh keeps the answer until it expires, retrying meanwhile
+            en.state = kOk;
+            en.refresh = std::min(en.expires, now + duration_cast<nanoseconds>(kNegativeTtl).count());
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Net.h"
+#include <windns.h>
+
+// --------- remote host resolver cache ----------
+// OpenVPN resolves a profile's remotes itself, one after another, when it connects. A slow
+// resolver adds seconds to every connect and reconnect. ResolverCache resolves the remotes of the
+// active and candidate profiles ahead of time on a few worker threads. It keeps each answer for
+// its DNS TTL and re-resolves it shortly before it expires, so OpenVpnRunner can hand the child
+// addresses it already knows. Queries go through DnsQuery, which includes the hosts file and the
+// system DNS cache; setServer() points them at one server instead (e.g. a local stub resolver).
+// A failed name is cached for kNegativeTtl, so it is not retried on every connect.
+//
+// Table layout: entries_ in insertion order, names back to back in names_, kMaxAddrs address
+// slots per entry in addrs_, and an open-addressing hash index of entry numbers.
+class ResolverCache {
+public:
+    static constexpr int kDefaultWorkers = 4;
+    static constexpr size_t kMaxAddrs = 8;                  // per name
+    static constexpr std::chrono::seconds kMinTtl{ 10 }, kMaxTtl{ 3600 }, kNegativeTtl{ 30 };
+    static constexpr std::chrono::seconds kDefaultTtl{ 300 };   // getaddrinfo fallback carries no TTL
+
+    struct Stats {
+        size_t names{ 0 }, resolved{ 0 }, failed{ 0 }, pending{ 0 };
+        uint64_t queries{ 0 }, hits{ 0 }, misses{ 0 };
+        double lastQueryMs{ 0 }, maxQueryMs{ 0 };
+    };
+
+    // DnsQuery_A and the matching list free; DnsBench swaps in a test double
+    using QueryFn = DNS_STATUS(WINAPI*)(PCSTR name, WORD type, DWORD options, PVOID extra, PDNS_RECORD* results, PVOID* reserved);
+    using FreeFn = void (*)(PDNS_RECORD list);
+
+    ResolverCache() = default;
+    ~ResolverCache();
+    ResolverCache(const ResolverCache&) = delete;
+    ResolverCache& operator=(const ResolverCache&) = delete;
+
+    void start(int workers = kDefaultWorkers);
+    void stop();
+    bool running() const { return running_.load(); }
+    bool setServer(const std::string& ipv4);   // before start(); DnsQuery only, port 53
+    // before start(): queries go to query instead of DnsQuery_A, with no getaddrinfo fallback
+    void setDnsApi(QueryFn query, FreeFn free) { query_ = query; free_ = free; }
+
+    // Queues host unless it is cached and fresh (or already queued); any thread, never blocks on DNS.
+    // Numeric addresses are skipped. A prefetched name is kept fresh until nobody has asked for it
+    // for kForgetAfter.
+    void prefetch(std::string_view host);
+    // The cached addresses of host as numeric strings (at most max), when fresh. Unknown, pending
+    // and failed names return false and are prefetched. A numeric host returns itself.
+    bool lookup(std::string_view host, std::vector<std::string>& ips, size_t max = kMaxAddrs);
+    Stats stats() const;
+
+private:
+    static constexpr std::chrono::hours kForgetAfter{ 1 };
+    enum : uint8_t { kNew, kQueued, kOk, kFailed };
+    struct Addr {
+        uint8_t v6{ 0 };
+        uint8_t b[16]{};
+    };
+    struct Entry {
+        uint32_t hash{ 0 };
+        uint32_t nameOff{ 0 };
+        uint16_t nameLen{ 0 };
+        uint8_t state{ kNew };
+        uint8_t addrCount{ 0 };
+        int64_t expires{ 0 }, refresh{ 0 }, wanted{ 0 };   // steady_clock ns
+    };
+    struct Answer {
+        Addr addrs[kMaxAddrs];
+        size_t count{ 0 };
+        uint32_t ttl{ 0 };   // seconds
+    };
+
+    static uint32_t hashOf(std::string_view s);
+    static int64_t nowNs();
+    std::string_view nameOf(const Entry& e) const { return std::string_view(names_.data() + e.nameOff, e.nameLen); }
+    uint32_t find(std::string_view host, uint32_t h) const;   // kNone if absent; mu_ held
+    uint32_t insert(std::string_view host, uint32_t h);       // mu_ held
+    void enqueue(uint32_t e);                                  // mu_ held
+    bool query(const std::string& host, Answer& out) const;   // worker, without the lock
+    void worker();
+
+    static constexpr uint32_t kNone = ~0u;
+
+    WsaSession wsa_;
+    uint32_t server_{ 0 };                  // IPv4 in network order, 0 = system resolvers
+    QueryFn query_{ nullptr };              // nullptr = DnsQuery_A
+    FreeFn free_{ nullptr };
+
+    mutable std::mutex mu_;                 // guards everything below
+    std::vector<Entry> entries_;
+    std::vector<char> names_;
+    std::vector<Addr> addrs_;               // kMaxAddrs slots per entry
+    std::vector<uint32_t> index_;           // entry + 1, 0 = empty slot; size is a power of two
+    std::deque<uint32_t> queue_;            // entries waiting for a worker
+    Stats stats_;
+    std::condition_variable cv_;
+    std::atomic<bool> running_{ false };
+    std::vector<std::thread> workers_;
+};
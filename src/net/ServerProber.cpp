@@ -0,0 +1,152 @@
+#include "ServerProber.h"
+#include <algorithm>
+#include "ResolverCache.h"
+
+using namespace std::chrono;
+
+ServerProber::~ServerProber() { stop(); }
+
+bool ServerProber::start(std::vector<ProbeEndpoint> endpoints, milliseconds interval, int timeoutMs) {
+    stop();
+    interval_ = interval;
+    timeoutMs_ = std::max(timeoutMs, 1);
+    targets_.clear();
+    targets_.resize(endpoints.size());
+    for (size_t i = 0; i < endpoints.size(); ++i) targets_[i].ep = std::move(endpoints[i]);
+    inflight_.reserve(kMaxInFlight);
+    fds_.reserve(kMaxInFlight);
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        results_.clear();
+    }
+    waiting_.clear();
+    if (!wsa_.ok() || targets_.empty()) return false;
+    running_ = true;
+    thread_ = std::thread(&ServerProber::loop, this);
+    return true;
+}
+
+void ServerProber::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    for (auto& f : inflight_) CloseSocketSafe(f.s);
+    inflight_.clear();
+}
+
+void ServerProber::poll(std::vector<ProbeResult>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lk(mu_);
+    std::swap(out, results_);
+}
+
+void ServerProber::loop() {
+    size_t cursor = 0;
+    auto sweepStart = steady_clock::now();
+    while (running_) {
+        if (cursor == 0 && !resolver_) {
+            // no cache: resolve the whole sweep up front, before any connect is being timed
+            for (size_t i = 0; i < targets_.size() && running_; ++i) {
+                Target& t = targets_[i];
+                if (!t.resolved) t.resolved = ResolveHost(t.ep.host, t.ep.port, SOCK_STREAM, t.addr);
+            }
+        }
+        // names that were still resolving get another look; past kResolveWait they count as unresolved
+        const bool late = steady_clock::now() - sweepStart > kResolveWait;
+        for (size_t i = waiting_.size(); i-- > 0 && inflight_.size() < kMaxInFlight;) {
+            const uint32_t index = waiting_[i];
+            const Resolve r = resolve(targets_[index]);
+            if (r == Resolve::Pending && !late) continue;
+            waiting_[i] = waiting_.back();
+            waiting_.pop_back();
+            if (r == Resolve::Ready) launch(index);
+            else batch_.push_back({ index, -1.0f });
+        }
+        while (inflight_.size() < kMaxInFlight && cursor < targets_.size() && running_) {
+            const uint32_t index = (uint32_t)cursor++;
+            const Resolve r = resolve(targets_[index]);
+            if (r == Resolve::Ready) launch(index);
+            else if (r == Resolve::Pending) waiting_.push_back(index);
+            else batch_.push_back({ index, -1.0f });
+        }
+        if (inflight_.empty()) {
+            publish();
+            if (!waiting_.empty()) {
+                // only unresolved names left: give the resolver a moment
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait_for(lk, milliseconds(50), [this] { return !running_; });
+                continue;
+            }
+            // sweep done: sleep out the rest of the interval
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait_until(lk, sweepStart + interval_, [this] { return !running_; });
+            cursor = 0;
+            sweepStart = steady_clock::now();
+            continue;
+        }
+
+        fds_.resize(inflight_.size());
+        for (size_t i = 0; i < inflight_.size(); ++i) {
+            fds_[i] = WSAPOLLFD{};
+            fds_[i].fd = inflight_[i].s;
+            fds_[i].events = POLLWRNORM;
+        }
+        // short waits keep stop() responsive and let publish() run while slow connects are pending
+        int n = WSAPoll(fds_.data(), (ULONG)fds_.size(), 50);
+        const auto now = steady_clock::now();
+        for (size_t i = inflight_.size(); i-- > 0;) {
+            const short re = n > 0 ? fds_[i].revents : 0;
+            if (re & (POLLERR | POLLHUP)) finish(i, false);
+            else if (re & POLLWRNORM) {
+                int err = 0; int len = sizeof(err);
+                finish(i, getsockopt(inflight_[i].s, SOL_SOCKET, SO_ERROR, (char*)&err, &len) == 0 && err == 0);
+            }
+            // older WSAPoll versions never report a refused connect: the timeout covers those too
+            else if (now - inflight_[i].t0 > milliseconds(timeoutMs_)) finish(i, false);
+        }
+        publish();
+    }
+    publish();
+}
+
+// Never blocks on DNS when a resolver is set: a name it has not answered yet is Pending
+ServerProber::Resolve ServerProber::resolve(Target& t) {
+    if (t.resolved) return Resolve::Ready;
+    if (!resolver_) return Resolve::Failed;   // the sweep's up-front pass already tried
+    if (!resolver_->lookup(t.ep.host, ips_, 1)) return Resolve::Pending;
+    t.resolved = ResolveHost(ips_[0], t.ep.port, SOCK_STREAM, t.addr);   // numeric: no query
+    return t.resolved ? Resolve::Ready : Resolve::Failed;
+}
+
+void ServerProber::launch(uint32_t index) {
+    const Target& t = targets_[index];
+    InFlight f;
+    f.index = index;
+    f.s = socket(t.addr.family(), SOCK_STREAM, IPPROTO_TCP);
+    if (f.s == INVALID_SOCKET) { batch_.push_back({ index, -1.0f }); return; }
+    SetNonBlocking(f.s, true);
+    f.t0 = steady_clock::now();
+    inflight_.push_back(f);
+    if (connect(f.s, t.addr.get(), t.addr.len) == 0) finish(inflight_.size() - 1, true);
+    else if (WSAGetLastError() != WSAEWOULDBLOCK) finish(inflight_.size() - 1, false);
+}
+
+void ServerProber::finish(size_t slot, bool ok) {
+    InFlight& f = inflight_[slot];
+    const float ms = duration<float, std::milli>(steady_clock::now() - f.t0).count();
+    batch_.push_back({ f.index, ok ? ms : -1.0f });
+    if (!ok) targets_[f.index].resolved = false;   // the server may have moved: re-resolve next sweep
+    CloseSocketSafe(f.s);
+    inflight_[slot] = inflight_.back();
+    inflight_.pop_back();
+}
+
+void ServerProber::publish() {
+    if (batch_.empty()) return;
+    std::lock_guard<std::mutex> lk(mu_);
+    results_.insert(results_.end(), batch_.begin(), batch_.end());
+    batch_.clear();
+}
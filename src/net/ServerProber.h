@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Net.h"
+
+class ResolverCache;
+
+// --------- bulk endpoint prober (server map) ----------
+// Times a TCP connect() to every endpoint of a large server list, many at once: up to
+// kMaxInFlight non-blocking connects are outstanding and one WSAPoll waits on all of them, so a
+// sweep over thousands of servers takes about (count / kMaxInFlight) round trips instead of count.
+// Unlike LatencyMonitor there are no histograms: the UI only needs the latest figure per server.
+// Names come from the ResolverCache when one is set, so DNS never runs inside a timed connect:
+// an endpoint whose name is still being resolved waits (up to kResolveWait) and is launched later.
+struct ProbeEndpoint {
+    std::string host;
+    uint16_t port{ 0 };
+};
+
+struct ProbeResult {
+    uint32_t index{ 0 };   // into the endpoint list given to start()
+    float ms{ -1 };        // connect time; < 0 = unreachable / unresolved / timed out
+};
+
+class ServerProber {
+public:
+    static constexpr size_t kMaxInFlight = 64;
+    static constexpr std::chrono::seconds kResolveWait{ 5 };   // per sweep, for names not cached yet
+
+    ServerProber() = default;
+    ~ServerProber();
+
+    void setResolver(ResolverCache* resolver) { resolver_ = resolver; }   // before start()
+    // each endpoint is probed once per `interval` (a sweep that overruns starts the next one at once);
+    // false if Winsock is unavailable or there is nothing to probe
+    bool start(std::vector<ProbeEndpoint> endpoints,
+        std::chrono::milliseconds interval = std::chrono::milliseconds(30000), int timeoutMs = 2000);
+    void stop();
+    bool running() const { return running_.load(); }
+
+    // UI thread: results since the last call, in completion order (swaps storage with out)
+    void poll(std::vector<ProbeResult>& out);
+
+private:
+    struct Target {
+        ProbeEndpoint ep;
+        SockAddr addr;
+        bool resolved{ false };
+    };
+    enum class Resolve { Ready, Pending, Failed };
+    struct InFlight {
+        SOCKET s{ INVALID_SOCKET };
+        uint32_t index{ 0 };
+        std::chrono::steady_clock::time_point t0;
+    };
+
+    void loop();
+    Resolve resolve(Target& t);
+    void launch(uint32_t index);
+    void finish(size_t slot, bool ok);
+    void publish();
+
+    WsaSession wsa_;
+    ResolverCache* resolver_{ nullptr };
+    std::vector<Target> targets_;
+    std::chrono::milliseconds interval_{ 30000 };
+    int timeoutMs_{ 2000 };
+    std::vector<InFlight> inflight_;     // worker only
+    std::vector<WSAPOLLFD> fds_;
+    std::vector<uint32_t> waiting_;      // worker only: names still resolving this sweep
+    std::vector<std::string> ips_;       // worker only: lookup scratch
+    std::vector<ProbeResult> batch_;     // worker only: completed since the last publish()
+
+    std::mutex mu_;                      // guards results_
+    std::vector<ProbeResult> results_;
+    std::condition_variable cv_;
+    std::atomic<bool> running_{ false };
+    std::thread thread_;
+};
@@ -0,0 +1,58 @@
+#include "SpeedBench.h"
+#include "SpeedTestServer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+int SpeedBench::Run(SpeedTestOptions opt, const char* target) {
+    SpeedTestServer server;
+    std::string err;
+    if (target) {
+        const char* colon = std::strrchr(target, ':');
+        opt.host = colon ? std::string(target, colon) : std::string(target);
+        if (colon) opt.port = (uint16_t)std::atoi(colon + 1);
+    }
+    else {
+        if (!server.start("127.0.0.1", 0, 2, err)) { std::printf("[speed-bench] %s\n", err.c_str()); return 1; }
+        opt.host = "127.0.0.1";
+        opt.port = server.port();
+    }
+    SpeedTest test;
+    if (!test.start(opt, err)) { std::printf("[speed-bench] %s\n", err.c_str()); return 1; }
+    std::printf("[speed-bench] %s:%u, %d %s stream%s%s, %d s\n", opt.host.c_str(), (unsigned)opt.port, opt.streams,
+        opt.upload ? "upload" : "download", opt.streams == 1 ? "" : "s", opt.udp ? " + UDP" : "", opt.seconds);
+
+    SpeedTestResult r;
+    double prevSeconds = 0;
+    uint64_t prevBytes = 0;
+    for (int tick = 1; !test.finished(); ++tick) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (tick % 10) continue;
+        test.snapshot(r);
+        if (r.phase != SpeedTestResult::Load || r.seconds - prevSeconds < 0.5) continue;
+        std::printf("  %5.1f s  %9.1f Mbit/s over the last %.1f s, ping p50 %.2f ms\n", r.seconds,
+            (r.bytes - prevBytes) * 8 / ((r.seconds - prevSeconds) * 1e6), r.seconds - prevSeconds, r.loadedP50Ms);
+        std::fflush(stdout);
+        prevSeconds = r.seconds;
+        prevBytes = r.bytes;
+    }
+    test.stop();
+    test.snapshot(r);
+    if (r.phase == SpeedTestResult::Failed) { std::printf("[speed-bench] failed: %s\n", r.error.c_str()); return 1; }
+
+    std::printf("%-8s %12s %12s %12s  %s\n", "stream", "MB", "Mbit/s", "connect ms", "");
+    for (size_t i = 0; i < r.streams.size(); ++i) {
+        const SpeedStreamStats& s = r.streams[i];
+        char name[16];
+        std::snprintf(name, sizeof(name), s.udp ? "udp" : "tcp %zu", i + 1);
+        std::printf("%-8s %12.1f %12.1f %12.2f  ", name, s.bytes / 1e6, s.mbps, s.connectMs);
+        if (s.udp) std::printf("%llu sent, %.2f%% lost, rtt p50 %.2f ms p95 %.2f ms", (unsigned long long)s.sent,
+            s.sent ? 100.0 * s.lost / s.sent : 0.0, s.rttP50Ms, s.rttP95Ms);
+        std::printf("%s\n", s.error.c_str());
+    }
+    std::printf("total    %12.1f %12.1f over %.1f s; ping p50 idle %.2f ms, loaded %.2f ms (p95 %.2f ms)\n",
+        r.bytes / 1e6, r.mbps, r.seconds, r.idleP50Ms, r.loadedP50Ms, r.loadedP95Ms);
+    return r.bytes ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "SpeedTest.h"
+
+// --------- speed test, headless (--speed-bench) ----------
+// [--speed-bench-streams N] [--speed-bench-seconds S] [--speed-bench-upload] [--speed-bench-udp MBPS]
+// [--speed-bench-target HOST:PORT]
+// Without a target it starts a SpeedTestServer on loopback first, so CI can run it with no tunnel
+// and no remote. Prints the aggregate every second, then one row per stream; exit code 1 when the
+// test failed or moved nothing.
+class SpeedBench {
+public:
+    static int Run(SpeedTestOptions opt, const char* target);
+};
@@ -0,0 +1,397 @@
+#include "SpeedTest.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <thread>
+
+using namespace SpeedTestProto;
+
+static constexpr int kMaxIoPerWakeup = 8;          // 2 MB per stream before the next one gets a turn
+static constexpr size_t kDatagramBytes = 1200;     // fits the tunnel MTU without fragments
+static constexpr int kPaceMs = 10;
+static constexpr int kMaxBurstMs = 100;            // UDP credit after a stalled timer
+static constexpr int64_t kGraceNs = 1000000000;    // after the load, at most: replies in flight, the final report
+static constexpr int kSendBuffer = 1 << 20;        // uploads: room for a fast link's bandwidth-delay product
+
+static int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int socketError(SOCKET s) {
+    int e = 0;
+    int len = sizeof(e);
+    if (getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&e, &len) != 0) return WSAGetLastError();
+    return e;
+}
+
+SpeedTest::~SpeedTest() { stop(); }
+
+bool SpeedTest::start(const SpeedTestOptions& opt, std::string& err) {
+    stop();
+    opt_ = opt;
+    opt_.streams = std::clamp(opt_.streams, 1, (int)kMaxStreams);
+    opt_.seconds = std::clamp(opt_.seconds, 1, 300);
+    int threads = opt_.threads > 0 ? opt_.threads : std::min({ opt_.streams, (int)std::thread::hardware_concurrency(), 4 });
+    threads = std::clamp(threads, 1, opt_.streams);
+    Pattern();
+
+    workers_.clear();
+    for (int i = 0; i <= threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->rx.resize(kBufferBytes);
+    }
+    streams_.clear();
+    for (int i = 0; i < opt_.streams + (opt_.udp ? 1 : 0); ++i) {
+        streams_.push_back(std::make_unique<Stream>());
+        Stream& st = *streams_.back();
+        st.udp = i == opt_.streams;
+        st.index = (uint8_t)(st.udp ? 0 : i);
+        st.worker = st.udp ? 0 : 1 + (size_t)i % (size_t)threads;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        idleUs_.reset();
+        loadedUs_.reset();
+        error_.clear();
+    }
+    loadStartNs_ = loadEndNs_ = 0;
+    pingGot_ = 0;
+    pingSeq_ = 0;
+    drainUntilNs_ = 0;
+    reportDone_ = false;
+    session_ = std::random_device{}();
+    phase_ = SpeedTestResult::Baseline;
+    for (auto& w : workers_) {
+        if (!w->loop.start()) { err = "cannot start the speed test event loops"; stop(); phase_ = SpeedTestResult::Idle; return false; }
+    }
+    worker(0).loop.post([this] {
+        if (!ResolveHost(opt_.host, opt_.port, SOCK_STREAM, addr_)) {   // DNS can take seconds: never on the caller's thread
+            std::lock_guard<std::mutex> lk(mu_);
+            error_ = "cannot resolve " + opt_.host;
+            phase_ = SpeedTestResult::Failed;
+            return;
+        }
+        startNs_ = nowNs();
+        openPing();
+        worker(0).loop.every(std::chrono::milliseconds(kPingMs), [this] { tick(); });
+    });
+    return true;
+}
+
+void SpeedTest::stop() {
+    for (auto& w : workers_) w->loop.stop();
+    for (auto& st : streams_) CloseSocketSafe(st->s);
+    CloseSocketSafe(ping_);
+    pingOpen_ = false;
+    workers_.clear();
+    const int phase = phase_.load();
+    if (phase == SpeedTestResult::Load) {   // cut short: what ran so far is still a result
+        if (!loadEndNs_.load()) loadEndNs_ = nowNs();
+        phase_ = SpeedTestResult::Done;
+    }
+    else if (phase == SpeedTestResult::Baseline) {
+        std::lock_guard<std::mutex> lk(mu_);
+        error_ = "stopped";
+        phase_ = SpeedTestResult::Failed;
+    }
+}
+
+bool SpeedTest::finished() const {
+    const int phase = phase_.load();
+    return phase == SpeedTestResult::Done || phase == SpeedTestResult::Failed;
+}
+
+void SpeedTest::snapshot(SpeedTestResult& out) const {
+    out.phase = (SpeedTestResult::Phase)phase_.load();
+    const int64_t start = loadStartNs_.load(), end = loadEndNs_.load();
+    out.seconds = start ? ((end ? end : nowNs()) - start) / 1e9 : 0.0;
+    const double bitsPerUs = out.seconds > 0 ? 8.0 / (out.seconds * 1e6) : 0.0;   // bytes -> Mbit/s
+    out.bytes = 0;
+    out.streams.resize(streams_.size());
+    std::lock_guard<std::mutex> lk(mu_);
+    out.error = error_;
+    for (size_t i = 0; i < streams_.size(); ++i) {
+        const Stream& st = *streams_[i];
+        SpeedStreamStats& o = out.streams[i];
+        o.udp = st.udp;
+        const int64_t received = st.received.load(std::memory_order_relaxed);   // no report: the ping connection failed
+        o.bytes = !st.udp && opt_.upload && received >= 0 ? (uint64_t)received : st.bytes.load(std::memory_order_relaxed);
+        o.mbps = o.bytes * bitsPerUs;
+        const int64_t us = st.connectUs.load(std::memory_order_relaxed);
+        o.connectMs = us < 0 ? -1.0 : us / 1e3;
+        const int e = st.error.load(std::memory_order_relaxed);
+        if (!e) o.error.clear();
+        else if (e < 0) o.error = "closed by the server";
+        else o.error = "socket error " + std::to_string(e);
+        if (st.udp) {
+            o.sent = st.sent.load(std::memory_order_relaxed);
+            o.lost = o.sent - std::min(o.sent, st.acked.load(std::memory_order_relaxed));
+            o.rttP50Ms = st.rttUs.percentile(50) / 1e3;
+            o.rttP95Ms = st.rttUs.percentile(95) / 1e3;
+        }
+        else out.bytes += o.bytes;
+    }
+    out.mbps = out.bytes * bitsPerUs;
+    out.idleP50Ms = idleUs_.percentile(50) / 1e3;
+    out.loadedP50Ms = loadedUs_.percentile(50) / 1e3;
+    out.loadedP95Ms = loadedUs_.percentile(95) / 1e3;
+}
+
+// --- control thread (worker 0) ---
+
+void SpeedTest::hello(char* out, char mode, uint8_t stream) const {
+    std::memcpy(out, kMagic, sizeof(kMagic));
+    out[4] = mode;
+    out[5] = (char)stream;
+    std::memcpy(out + 6, &session_, sizeof(session_));
+}
+
+void SpeedTest::openPing() {
+    ping_ = socket(addr_.family(), SOCK_STREAM, IPPROTO_TCP);
+    if (ping_ == INVALID_SOCKET) return;
+    SetNonBlocking(ping_, true);
+    const int one = 1;
+    setsockopt(ping_, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+    if (connect(ping_, addr_.get(), addr_.len) != 0 && WSAGetLastError() != WSAEWOULDBLOCK) { CloseSocketSafe(ping_); return; }
+    worker(0).loop.add(ping_, POLLWRNORM, [this](short revents) { onPing(revents); });
+}
+
+void SpeedTest::closePing() {
+    if (ping_ == INVALID_SOCKET) return;
+    worker(0).loop.remove(ping_);
+    CloseSocketSafe(ping_);
+    pingOpen_ = false;
+}
+
+void SpeedTest::onPing(short revents) {
+    if (!pingOpen_) {
+        const int e = (revents & (POLLERR | POLLHUP)) ? std::max(socketError(ping_), 1) : socketError(ping_);
+        char buf[kHelloBytes];
+        hello(buf, kPing, 0);
+        if (e || send(ping_, buf, (int)sizeof(buf), 0) != (int)sizeof(buf)) {
+            std::lock_guard<std::mutex> lk(mu_);
+            error_ = "cannot reach " + FormatAddr(addr_);
+            phase_ = SpeedTestResult::Failed;
+            loadEndNs_ = nowNs();
+            closePing();
+            return;
+        }
+        pingOpen_ = true;
+        worker(0).loop.setEvents(ping_, POLLRDNORM);
+        return;
+    }
+    for (;;) {
+        const int n = recv(ping_, pingIn_ + pingGot_, (int)(sizeof(pingIn_) - pingGot_), 0);
+        if (n == 0 || (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK)) { closePing(); return; }   // the test goes on without latency
+        if (n < 0) return;
+        pingGot_ += (size_t)n;
+        if (pingGot_ < sizeof(pingIn_)) continue;
+        pingGot_ = 0;
+        Probe p;
+        std::memcpy(&p, pingIn_, sizeof(p));
+        if (p.magic == kReportMagic) {   // the server's upload counts
+            if (p.seq == kReportEnd) reportDone_ |= loadEndNs_.load() && p.sentNs >= loadEndNs_.load();
+            else if (p.seq < (uint32_t)opt_.streams) streams_[p.seq]->received.store(p.sentNs, std::memory_order_relaxed);
+            continue;
+        }
+        const int64_t now = nowNs();
+        const int64_t loadStart = loadStartNs_.load();
+        const uint64_t us = (uint64_t)std::max<int64_t>(now - p.sentNs, 0) / 1000;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (!loadStart || p.sentNs < loadStart) idleUs_.record(us);
+        else if (!loadEndNs_.load() || p.sentNs < loadEndNs_.load()) loadedUs_.record(us);
+    }
+}
+
+void SpeedTest::tick() {
+    const int64_t now = nowNs();
+    const int phase = phase_.load();
+    const bool loading = phase == SpeedTestResult::Load && !loadEndNs_.load();
+    if (pingOpen_ && (phase == SpeedTestResult::Baseline || loading)) {
+        const Probe p[2] = { { kProbeMagic, pingSeq_++, now }, { kReportMagic, 0, now } };
+        const int n = (loading && opt_.upload ? 2 : 1) * (int)sizeof(Probe);   // uploads: the server's count each tick
+        if (send(ping_, (const char*)p, n, 0) != n) closePing();
+    }
+    if (phase == SpeedTestResult::Baseline && now - startNs_ >= kBaselineMs * 1000000ll) {
+        loadStartNs_ = now;
+        phase_ = SpeedTestResult::Load;
+        for (size_t w = 0; w < workers_.size(); ++w) {
+            if (w == 0) connectStreams(0);
+            else worker(w).loop.post([this, w] { connectStreams(w); });
+        }
+    }
+    else if (loading) {
+        bool anyTcp = false;
+        for (const auto& st : streams_) anyTcp |= !st->udp && !st->error.load();
+        if (!anyTcp) {
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                error_ = "every stream failed";
+            }
+            loadEndNs_ = now;
+            finish(SpeedTestResult::Failed);
+        }
+        else if (now - loadStartNs_.load() >= opt_.seconds * 1000000000ll) beginDrain(now);
+    }
+    else if (phase == SpeedTestResult::Load &&
+        (now >= drainUntilNs_ || (!opt_.udp && (reportDone_ || !opt_.upload || !pingOpen_)))) {
+        finish(SpeedTestResult::Done);
+    }
+}
+
+// The load is over. TCP streams close; the UDP stream stops sending but keeps reading for twice its
+// p95 round trip, so datagrams still in flight are not counted as lost; an upload asks the server
+// for its final count. Both are bounded by kGraceNs.
+void SpeedTest::beginDrain(int64_t now) {
+    loadEndNs_ = now;
+    for (size_t w = 1; w < workers_.size(); ++w) worker(w).loop.post([this, w] { closeStreams(w); });
+    int64_t graceNs = kGraceNs;
+    for (auto& p : streams_) {
+        Stream& st = *p;
+        if (!st.udp) continue;
+        if (st.timer) worker(0).loop.cancel(st.timer);
+        st.timer = 0;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (st.rttUs.count()) graceNs = std::min<int64_t>(graceNs, 2 * (int64_t)st.rttUs.percentile(95) * 1000);
+    }
+    drainUntilNs_ = now + graceNs;
+    if (pingOpen_ && opt_.upload) {
+        const Probe r{ kReportMagic, 0, now };
+        if (send(ping_, (const char*)&r, (int)sizeof(r), 0) != (int)sizeof(r)) closePing();
+    }
+}
+
+void SpeedTest::finish(SpeedTestResult::Phase phase) {
+    for (size_t w = 1; w < workers_.size(); ++w) worker(w).loop.post([this, w] { closeStreams(w); });
+    closeStreams(0);
+    closePing();
+    phase_ = phase;
+}
+
+// --- streams ---
+
+void SpeedTest::connectStreams(size_t w) {
+    for (auto& p : streams_) {
+        Stream& st = *p;
+        if (st.worker != w) continue;
+        st.startNs = nowNs();
+        st.s = socket(addr_.family(), st.udp ? SOCK_DGRAM : SOCK_STREAM, st.udp ? IPPROTO_UDP : IPPROTO_TCP);
+        if (st.s == INVALID_SOCKET) { st.error = WSAGetLastError(); continue; }
+        SetNonBlocking(st.s, true);
+        if (st.udp) {   // connected: send/recv, and only the server's answers arrive
+            if (connect(st.s, addr_.get(), addr_.len) != 0) { fail(st, WSAGetLastError()); continue; }
+            st.open = true;
+            st.connectUs = 0;
+            worker(w).loop.add(st.s, POLLRDNORM, [this, &st](short) { readUdp(st); });
+            st.timer = worker(w).loop.every(std::chrono::milliseconds(kPaceMs), [this, &st] { sendUdp(st, nowNs()); });
+            continue;
+        }
+        if (opt_.upload) setsockopt(st.s, SOL_SOCKET, SO_SNDBUF, (const char*)&kSendBuffer, sizeof(kSendBuffer));
+        // receive buffers are left to the stack's autotuning, which a fixed SO_RCVBUF would turn off
+        if (connect(st.s, addr_.get(), addr_.len) != 0 && WSAGetLastError() != WSAEWOULDBLOCK) { fail(st, WSAGetLastError()); continue; }
+        worker(w).loop.add(st.s, POLLWRNORM, [this, &st](short revents) { onStream(st, revents); });
+    }
+}
+
+void SpeedTest::closeStreams(size_t w) {
+    for (auto& p : streams_) {
+        Stream& st = *p;
+        if (st.worker != w || st.s == INVALID_SOCKET) continue;
+        if (st.timer) worker(w).loop.cancel(st.timer);
+        st.timer = 0;
+        worker(w).loop.remove(st.s);
+        CloseSocketSafe(st.s);
+    }
+}
+
+void SpeedTest::fail(Stream& st, int error) {
+    st.error = error ? error : -1;
+    if (st.timer) worker(st.worker).loop.cancel(st.timer);
+    st.timer = 0;
+    if (st.s != INVALID_SOCKET) worker(st.worker).loop.remove(st.s);
+    CloseSocketSafe(st.s);
+}
+
+void SpeedTest::onStream(Stream& st, short revents) {
+    Worker& w = worker(st.worker);
+    if (!st.open) {
+        const int e = (revents & (POLLERR | POLLHUP)) ? std::max(socketError(st.s), 1) : socketError(st.s);
+        if (e) { fail(st, e); return; }
+        char buf[kHelloBytes];
+        hello(buf, opt_.upload ? kUpload : kDownload, st.index);
+        if (send(st.s, buf, (int)sizeof(buf), 0) != (int)sizeof(buf)) { fail(st, WSAGetLastError()); return; }
+        st.open = true;
+        st.connectUs = (nowNs() - st.startNs) / 1000;
+        w.loop.setEvents(st.s, opt_.upload ? POLLRDNORM | POLLWRNORM : POLLRDNORM);
+        return;
+    }
+    if (revents & (POLLRDNORM | POLLHUP | POLLERR)) {   // downloads; on uploads only the server closing
+        for (int i = 0; i < kMaxIoPerWakeup; ++i) {
+            const int n = recv(st.s, w.rx.data(), (int)w.rx.size(), 0);
+            if (n == 0) { fail(st, -1); return; }
+            if (n < 0) {
+                if (WSAGetLastError() != WSAEWOULDBLOCK) { fail(st, WSAGetLastError()); return; }
+                break;
+            }
+            st.bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            if ((size_t)n < w.rx.size()) break;   // drained
+        }
+    }
+    if ((revents & POLLWRNORM) && opt_.upload) {
+        const std::vector<char>& pattern = Pattern();
+        for (int i = 0; i < kMaxIoPerWakeup; ++i) {
+            const int n = send(st.s, pattern.data() + st.txAt, (int)(pattern.size() - st.txAt), 0);
+            if (n < 0) {
+                if (WSAGetLastError() != WSAEWOULDBLOCK) fail(st, WSAGetLastError());
+                break;
+            }
+            st.bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);   // handed to TCP; the server's report replaces it
+            st.txAt = (st.txAt + (size_t)n) % pattern.size();
+        }
+    }
+}
+
+// Paced at udpMbps: the datagrams owed for the time since the last tick, carrying the fraction over.
+// The timer is only nominally kPaceMs: it follows WSAPoll's ~15.6 ms timeout granularity and skips
+// missed periods, so a fixed amount per tick would send well under the rate.
+void SpeedTest::sendUdp(Stream& st, int64_t now) {
+    const int64_t elapsedNs = st.lastNs ? std::min<int64_t>(now - st.lastNs, kMaxBurstMs * 1000000ll) : kPaceMs * 1000000ll;
+    st.lastNs = now;
+    st.credit += opt_.udpMbps * 1e6 / 8 * (elapsedNs / 1e9) / kDatagramBytes;
+    char buf[kDatagramBytes];
+    std::memcpy(buf, Pattern().data(), sizeof(buf));
+    for (; st.credit >= 1; st.credit -= 1) {
+        const Probe p{ kProbeMagic, st.seq++, now };
+        std::memcpy(buf, &p, sizeof(p));
+        if (send(st.s, buf, (int)sizeof(buf), 0) != (int)sizeof(buf)) {
+            if (WSAGetLastError() == WSAEWOULDBLOCK) { st.credit = 0; break; }   // the socket is full: that is loss too
+            fail(st, WSAGetLastError());
+            return;
+        }
+        st.sent.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void SpeedTest::readUdp(Stream& st) {
+    Worker& w = worker(st.worker);
+    for (;;) {
+        const int n = recv(st.s, w.rx.data(), (int)w.rx.size(), 0);
+        if (n < 0) {
+            const int e = WSAGetLastError();
+            if (e == WSAEWOULDBLOCK) return;
+            if (e == WSAECONNRESET) continue;   // ICMP unreachable for an earlier datagram: it counts as lost
+            fail(st, e);
+            return;
+        }
+        Probe p;
+        if ((size_t)n < sizeof(p)) continue;
+        std::memcpy(&p, w.rx.data(), sizeof(p));
+        if (p.magic != kProbeMagic) continue;
+        st.acked.fetch_add(1, std::memory_order_relaxed);
+        st.bytes.fetch_add(kDatagramBytes, std::memory_order_relaxed);
+        const uint64_t us = (uint64_t)std::max<int64_t>(nowNs() - p.sentNs, 0) / 1000;
+        std::lock_guard<std::mutex> lk(mu_);
+        st.rttUs.record(us);
+    }
+}
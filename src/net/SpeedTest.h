@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "EventLoop.h"
+#include "SpeedTestServer.h"
+#include "../core/HdrHistogram.h"
+
+// --------- tunnel throughput test ----------
+// N parallel TCP streams to a SpeedTestServer (see SpeedTestServer.h for the wire format), plus
+// optionally one paced UDP stream for loss and round trips, while a ping connection measures
+// latency: for one second before the load (idle) and then under it, which shows how much the
+// tunnel's queues add when it is full.
+// TCP streams are spread over a few EventLoop threads; one more thread carries the ping, the UDP
+// stream and the phase timer, so latency samples never queue behind bulk reads. Uploads are sent
+// straight from the shared pattern and downloads land in one scratch buffer per thread, so moving a
+// byte costs the socket call and nothing else. Goodput counts payload bytes over the load phase:
+// downloads as they arrive, uploads as the server reports receiving them on the ping connection
+// (what send() accepted may still sit in the socket buffer). When the load ends, sending stops and
+// the UDP stream stays open for a grace period, so replies still in flight do not count as lost.
+struct SpeedTestOptions {
+    std::string host{ "127.0.0.1" };
+    uint16_t port{ SpeedTestProto::kDefaultPort };
+    int streams{ 4 };
+    bool upload{ false };             // false: the server sends
+    bool udp{ false };                // plus one UDP stream paced at udpMbps
+    double udpMbps{ 20 };
+    int seconds{ 10 };                // load phase
+    int threads{ 0 };                 // event loops for the TCP streams, 0 = min(streams, cores, 4)
+};
+
+struct SpeedStreamStats {
+    bool udp{ false };
+    std::string error;                // empty = fine
+    uint64_t bytes{ 0 };              // payload delivered
+    double mbps{ 0 };
+    double connectMs{ -1 };           // TCP handshake under load, -1 = not connected
+    uint64_t sent{ 0 }, lost{ 0 };    // UDP datagrams; lost = not answered (yet)
+    double rttP50Ms{ 0 }, rttP95Ms{ 0 };   // UDP
+};
+
+struct SpeedTestResult {
+    enum Phase { Idle, Baseline, Load, Done, Failed };
+    Phase phase{ Idle };
+    std::string error;
+    double seconds{ 0 };              // load time so far
+    uint64_t bytes{ 0 };
+    double mbps{ 0 };                 // all TCP streams
+    double idleP50Ms{ 0 };            // ping before the load
+    double loadedP50Ms{ 0 }, loadedP95Ms{ 0 };
+    std::vector<SpeedStreamStats> streams;
+};
+
+class SpeedTest {
+public:
+    static constexpr int kBaselineMs = 1000;
+    static constexpr int kPingMs = 50;
+
+    SpeedTest() = default;
+    ~SpeedTest();
+    SpeedTest(const SpeedTest&) = delete;
+    SpeedTest& operator=(const SpeedTest&) = delete;
+
+    bool start(const SpeedTestOptions& opt, std::string& err);   // returns at once: resolving happens on worker 0
+    void stop();                                                 // also after Done: joins the threads
+    bool finished() const;                                       // Done or Failed
+    // the thread that calls start/stop, while the test runs or after; reuses out's vectors
+    void snapshot(SpeedTestResult& out) const;
+
+private:
+    struct Stream {
+        SOCKET s{ INVALID_SOCKET };
+        size_t worker{ 0 };
+        bool udp{ false };
+        uint8_t index{ 0 };               // TCP: the stream number in the hello
+        bool open{ false };               // loop thread: handshake done
+        size_t txAt{ 0 };                 // upload: offset into the pattern
+        uint32_t seq{ 0 };                // UDP: next datagram
+        double credit{ 0 };               // UDP: datagrams owed by the pacing timer
+        int64_t lastNs{ 0 };              // UDP: the last pacing tick
+        uint32_t timer{ 0 };              // UDP: pacing timer
+        int64_t startNs{ 0 };
+        std::atomic<uint64_t> bytes{ 0 }, sent{ 0 }, acked{ 0 };
+        std::atomic<int64_t> received{ -1 };   // upload: the server's count, -1 = no report yet
+        std::atomic<int64_t> connectUs{ -1 };
+        std::atomic<int> error{ 0 };      // socket error, 0 = none
+        HdrHistogram rttUs{ 10ull * 1000 * 1000 };   // UDP, guarded by mu_
+    };
+    struct Worker {
+        EventLoop loop;
+        std::vector<char> rx;             // receive scratch, loop thread only
+    };
+
+    void connectStreams(size_t worker);   // that worker's thread
+    void onStream(Stream& st, short revents);
+    void sendUdp(Stream& st, int64_t nowNs);
+    void readUdp(Stream& st);
+    void closeStreams(size_t worker);
+    void fail(Stream& st, int error);
+    void tick();                          // worker 0: phases and pings
+    void beginDrain(int64_t now);
+    void finish(SpeedTestResult::Phase phase);
+    void hello(char* out, char mode, uint8_t stream) const;
+    void openPing();
+    void onPing(short revents);
+    void closePing();
+    Worker& worker(size_t i) { return *workers_[i]; }
+
+    SpeedTestOptions opt_;
+    SockAddr addr_;
+    std::vector<std::unique_ptr<Worker>> workers_;   // 0: control, 1..: TCP streams
+    std::vector<std::unique_ptr<Stream>> streams_;   // fixed once started
+
+    // worker 0 only
+    SOCKET ping_{ INVALID_SOCKET };
+    bool pingOpen_{ false };
+    char pingIn_[sizeof(SpeedTestProto::Probe)]{};
+    size_t pingGot_{ 0 };
+    uint32_t pingSeq_{ 0 };
+    int64_t startNs_{ 0 };
+    int64_t drainUntilNs_{ 0 };           // after the load: when the UDP grace period ends
+    bool reportDone_{ false };            // the report requested at the end of the load has arrived
+    uint32_t session_{ 0 };               // tells the server which connections are one test
+
+    std::atomic<int> phase_{ SpeedTestResult::Idle };
+    std::atomic<int64_t> loadStartNs_{ 0 }, loadEndNs_{ 0 };
+    mutable std::mutex mu_;               // guards the histograms and error_
+    HdrHistogram idleUs_{ 10ull * 1000 * 1000 }, loadedUs_{ 10ull * 1000 * 1000 };
+    std::string error_;
+};
@@ -0,0 +1,221 @@
+#include "SpeedTestServer.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace SpeedTestProto;
+
+static constexpr int kMaxIoPerWakeup = 8;        // 2 MB per stream before the next one gets a turn
+static constexpr int kMaxDatagramsPerWakeup = 64;
+
+const std::vector<char>& SpeedTestProto::Pattern() {
+    static const std::vector<char> bytes = [] {
+        std::vector<char> b(kBufferBytes);
+        uint64_t x = 0x9E3779B97F4A7C15ull;
+        for (size_t i = 0; i < b.size(); i += 8) {   // xorshift64: cheap and incompressible enough
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            std::memcpy(&b[i], &x, 8);
+        }
+        return b;
+    }();
+    return bytes;
+}
+
+SpeedTestServer::~SpeedTestServer() { stop(); }
+
+bool SpeedTestServer::start(const std::string& host, uint16_t port, int threads, std::string& err) {
+    stop();
+    const std::string where = host + ":" + std::to_string(port);
+    sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) { err = "not an IPv4 address: " + host; return false; }
+    Pattern();   // built here rather than on the first download
+    workers_.resize((size_t)std::clamp(threads, 1, 16));
+    for (auto& w : workers_) {
+        w = std::make_unique<Worker>();
+        w->rx.resize(kBufferBytes);
+    }
+
+    listen_ = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_ == INVALID_SOCKET || bind(listen_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_, SOMAXCONN) != 0) {
+        err = "cannot listen on " + where;
+        stop();
+        return false;
+    }
+    int len = sizeof(addr);
+    getsockname(listen_, (sockaddr*)&addr, &len);   // resolve an ephemeral port, UDP shares it
+    port_ = ntohs(addr.sin_port);
+    udp_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (udp_ == INVALID_SOCKET || bind(udp_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        err = "cannot bind UDP " + where;
+        stop();
+        return false;
+    }
+    SetNonBlocking(listen_, true);
+    SetNonBlocking(udp_, true);
+    for (auto& w : workers_) {
+        if (!w->loop.start()) { err = "cannot start the speed test event loops"; stop(); return false; }
+    }
+    Worker& first = *workers_[0];
+    first.loop.post([this, &first] {
+        first.loop.add(listen_, POLLRDNORM, [this](short) { acceptConns(); });
+        first.loop.add(udp_, POLLRDNORM, [this](short) { onDatagram(); });
+    });
+    return true;
+}
+
+void SpeedTestServer::stop() {
+    for (auto& w : workers_) w->loop.stop();
+    for (auto& w : workers_) {
+        for (auto& c : w->conns) CloseSocketSafe(c->s);
+        std::lock_guard<std::mutex> lk(w->mu);
+        for (SOCKET& s : w->incoming) CloseSocketSafe(s);
+    }
+    workers_.clear();
+    CloseSocketSafe(listen_);
+    CloseSocketSafe(udp_);
+    nextWorker_ = 0;
+}
+
+// Worker 0's thread. A connection belongs to one worker for its lifetime.
+void SpeedTestServer::acceptConns() {
+    for (;;) {
+        SOCKET s = accept(listen_, nullptr, nullptr);
+        if (s == INVALID_SOCKET) return;
+        SetNonBlocking(s, true);
+        const int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));   // ping echoes go out at once
+        Worker& w = *workers_[nextWorker_++ % workers_.size()];
+        bool first;
+        {
+            std::lock_guard<std::mutex> lk(w.mu);
+            first = w.incoming.empty();
+            w.incoming.push_back(s);
+        }
+        if (first) w.loop.post([this, &w] { adopt(w); });
+    }
+}
+
+void SpeedTestServer::adopt(Worker& w) {
+    {
+        std::lock_guard<std::mutex> lk(w.mu);
+        w.adopting.swap(w.incoming);
+    }
+    for (SOCKET s : w.adopting) {
+        w.conns.push_back(std::make_unique<Conn>());
+        Conn* c = w.conns.back().get();
+        c->s = s;
+        w.loop.add(s, POLLRDNORM, [this, &w, c](short revents) { onConn(w, c, revents); });
+    }
+    w.adopting.clear();
+}
+
+// the session a hello names, created by its first connection
+std::shared_ptr<SpeedTestServer::Session> SpeedTestServer::session(uint32_t id) {
+    std::lock_guard<std::mutex> lk(sessionsMu_);
+    for (auto it = sessions_.begin(); it != sessions_.end();) it = it->second.expired() ? sessions_.erase(it) : std::next(it);
+    std::weak_ptr<Session>& slot = sessions_[id];
+    std::shared_ptr<Session> s = slot.lock();
+    if (!s) {
+        s = std::make_shared<Session>();
+        slot = s;
+    }
+    return s;
+}
+
+void SpeedTestServer::drop(Worker& w, Conn* c) {
+    w.loop.remove(c->s);
+    CloseSocketSafe(c->s);
+    // the handler is swept after this dispatch, so the Conn can go now
+    w.conns.erase(std::find_if(w.conns.begin(), w.conns.end(), [c](const auto& p) { return p.get() == c; }));
+}
+
+void SpeedTestServer::onConn(Worker& w, Conn* c, short revents) {
+    if (revents & (POLLRDNORM | POLLHUP | POLLERR)) {
+        for (int i = 0; i < kMaxIoPerWakeup; ++i) {
+            const int n = recv(c->s, w.rx.data(), (int)w.rx.size(), 0);
+            if (n == 0 || (n < 0 && WSAGetLastError() != WSAEWOULDBLOCK)) { drop(w, c); return; }
+            if (n < 0) break;
+            received_.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            const char* p = w.rx.data();
+            size_t len = (size_t)n;
+            if (c->got < kHelloBytes) {
+                const size_t take = std::min(len, kHelloBytes - c->got);
+                std::memcpy(c->hello + c->got, p, take);
+                c->got += take;
+                p += take;
+                len -= take;
+                if (c->got < kHelloBytes) continue;
+                c->mode = c->hello[4];
+                c->stream = (uint8_t)c->hello[5];
+                if (std::memcmp(c->hello, kMagic, sizeof(kMagic)) != 0 || c->stream >= kMaxStreams ||
+                    (c->mode != kDownload && c->mode != kUpload && c->mode != kPing)) { drop(w, c); return; }
+                uint32_t id;
+                std::memcpy(&id, c->hello + 6, sizeof(id));
+                c->session = session(id);
+                if (c->mode == kUpload) {
+                    std::atomic<uint32_t>& n = c->session->streams;
+                    for (uint32_t cur = n.load(); cur < c->stream + 1u && !n.compare_exchange_weak(cur, c->stream + 1u);) {}
+                }
+                if (c->mode == kDownload) w.loop.setEvents(c->s, POLLRDNORM | POLLWRNORM);
+            }
+            if (c->mode == kUpload && len) c->session->bytes[c->stream].fetch_add(len, std::memory_order_relaxed);
+            if (c->mode == kPing && len) onPing(w, c, p, len);
+            if ((size_t)n < w.rx.size()) break;   // drained
+        }
+    }
+    if ((revents & POLLWRNORM) && c->mode == kDownload) {
+        const std::vector<char>& pattern = Pattern();
+        for (int i = 0; i < kMaxIoPerWakeup; ++i) {
+            const int n = send(c->s, pattern.data() + c->txAt, (int)(pattern.size() - c->txAt), 0);
+            if (n < 0) {
+                if (WSAGetLastError() == WSAEWOULDBLOCK) break;
+                drop(w, c);
+                return;
+            }
+            sent_.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            c->txAt = (c->txAt + (size_t)n) % pattern.size();
+        }
+    }
+}
+
+// Echoes probe frames; a report request gets the session's upload counters instead
+void SpeedTestServer::onPing(Worker& w, Conn* c, const char* p, size_t len) {
+    w.reply.clear();
+    while (len) {
+        const size_t take = std::min(len, sizeof(c->frame) - c->frameGot);
+        std::memcpy(c->frame + c->frameGot, p, take);
+        c->frameGot += take;
+        p += take;
+        len -= take;
+        if (c->frameGot < sizeof(c->frame)) break;
+        c->frameGot = 0;
+        Probe f;
+        std::memcpy(&f, c->frame, sizeof(f));
+        if (f.magic != kReportMagic) { w.reply.append(c->frame, sizeof(f)); continue; }
+        const uint32_t n = c->session->streams.load();
+        for (uint32_t i = 0; i < n; ++i) {
+            const Probe r{ kReportMagic, i, (int64_t)c->session->bytes[i].load(std::memory_order_relaxed) };
+            w.reply.append((const char*)&r, sizeof(r));
+        }
+        const Probe end{ kReportMagic, kReportEnd, f.sentNs };
+        w.reply.append((const char*)&end, sizeof(end));
+    }
+    if (!w.reply.empty()) send(c->s, w.reply.data(), (int)w.reply.size(), 0);   // about 1 KB at most: never blocks
+}
+
+// Worker 0's thread: answer each probe datagram with its header
+void SpeedTestServer::onDatagram() {
+    Worker& w = *workers_[0];
+    for (int i = 0; i < kMaxDatagramsPerWakeup; ++i) {
+        sockaddr_storage from{};
+        int fromLen = sizeof(from);
+        const int n = recvfrom(udp_, w.rx.data(), (int)w.rx.size(), 0, (sockaddr*)&from, &fromLen);
+        if (n < 0) return;
+        received_.fetch_add((uint64_t)n, std::memory_order_relaxed);
+        Probe p;
+        if ((size_t)n < sizeof(p)) continue;
+        std::memcpy(&p, w.rx.data(), sizeof(p));
+        if (p.magic != kProbeMagic) continue;
+        if (sendto(udp_, (const char*)&p, (int)sizeof(p), 0, (sockaddr*)&from, fromLen) > 0)
+            sent_.fetch_add(sizeof(p), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "EventLoop.h"
+
+// --------- speed test wire format ----------
+// A TCP connection opens with a 10-byte hello: "VST2", a mode byte, the stream's index and a 32-bit
+// session id the client picks for the whole test.
+//   kDownload  the server sends until the client closes
+//   kUpload    the server reads, counts and discards
+//   kPing      16-byte Probe frames, echoed. A kReportMagic frame is answered instead with one
+//              {kReportMagic, stream, bytes} frame per upload stream of the session (payload bytes
+//              the server received so far), then {kReportMagic, kReportEnd, the request's sentNs}.
+// UDP datagrams to the same port start with a Probe; the server answers with just that header, so
+// the client sees which datagrams arrived and their round trip without echoing the payload.
+namespace SpeedTestProto {
+constexpr char kMagic[4] = { 'V', 'S', 'T', '2' };
+constexpr size_t kHelloBytes = 10;
+enum Mode : char { kDownload = 'D', kUpload = 'U', kPing = 'P' };
+constexpr uint16_t kDefaultPort = 5209;
+constexpr size_t kBufferBytes = 256 * 1024;   // send pattern and per-thread receive scratch
+constexpr uint32_t kProbeMagic = 0x50545356;  // "VSTP"
+constexpr uint32_t kReportMagic = 0x52545356; // "VSTR"
+constexpr uint32_t kReportEnd = 0xFFFFFFFFu;
+constexpr size_t kMaxStreams = 64;
+
+struct Probe {
+    uint32_t magic;
+    uint32_t seq;
+    int64_t sentNs;                           // sender's steady clock, echoed untouched
+};
+static_assert(sizeof(Probe) == 16, "Probe is part of the wire format");
+
+// The payload both sides send: one read-only buffer of random bytes (a compressing tunnel must not
+// make the test look faster), shared by every stream, so sending copies nothing on our side
+const std::vector<char>& Pattern();
+}
+
+// --------- speed test server ----------
+// The far end of SpeedTest: --speed-server [HOST:]PORT in the GUI, or on loopback in --speed-bench.
+// Connections are spread round-robin over a few EventLoop threads. Each thread receives into one
+// scratch buffer and every download is sent straight from the shared pattern, so the server does
+// no per-connection buffering. Reads and writes are capped per wakeup so one fast stream cannot
+// starve the others on its thread.
+class SpeedTestServer {
+public:
+    SpeedTestServer() = default;
+    ~SpeedTestServer();
+    SpeedTestServer(const SpeedTestServer&) = delete;
+    SpeedTestServer& operator=(const SpeedTestServer&) = delete;
+
+    // host: IPv4 address to bind ("0.0.0.0" to serve through the tunnel); port 0 = ephemeral
+    bool start(const std::string& host, uint16_t port, int threads, std::string& err);
+    void stop();
+    bool running() const { return !workers_.empty() && workers_[0]->loop.running(); }
+    uint16_t port() const { return port_; }
+    uint64_t bytesSent() const { return sent_.load(std::memory_order_relaxed); }
+    uint64_t bytesReceived() const { return received_.load(std::memory_order_relaxed); }
+
+private:
+    struct Session {                      // one client's test: its upload streams' received bytes
+        std::atomic<uint64_t> bytes[SpeedTestProto::kMaxStreams]{};
+        std::atomic<uint32_t> streams{ 0 };   // highest upload stream index + 1
+    };
+    struct Conn {
+        SOCKET s{ INVALID_SOCKET };
+        char hello[SpeedTestProto::kHelloBytes]{};
+        size_t got{ 0 };                  // hello bytes so far
+        char mode{ 0 };
+        uint8_t stream{ 0 };
+        std::shared_ptr<Session> session;
+        size_t txAt{ 0 };                 // download: offset into the pattern
+        char frame[sizeof(SpeedTestProto::Probe)]{};   // ping: a frame cut off by the last read
+        size_t frameGot{ 0 };
+    };
+    struct Worker {
+        EventLoop loop;
+        std::vector<char> rx;             // receive scratch, loop thread only
+        std::string reply;                // ping echoes and reports, loop thread only
+        std::vector<std::unique_ptr<Conn>> conns;   // loop thread only
+        std::mutex mu;                    // guards incoming
+        std::vector<SOCKET> incoming;     // accepted on worker 0, not adopted yet (stop() closes them)
+        std::vector<SOCKET> adopting;     // loop thread: incoming swapped out
+    };
+
+    void acceptConns();
+    void adopt(Worker& w);
+    void onConn(Worker& w, Conn* c, short revents);
+    void onDatagram();
+    void onPing(Worker& w, Conn* c, const char* p, size_t len);
+    void drop(Worker& w, Conn* c);
+    std::shared_ptr<Session> session(uint32_t id);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    SOCKET listen_{ INVALID_SOCKET };
+    SOCKET udp_{ INVALID_SOCKET };
+    uint16_t port_{ 0 };
+    size_t nextWorker_{ 0 };              // worker 0's thread (the acceptor) only
+    std::mutex sessionsMu_;               // guards sessions_; an entry lives as long as its connections
+    std::unordered_map<uint32_t, std::weak_ptr<Session>> sessions_;
+    std::atomic<uint64_t> sent_{ 0 }, received_{ 0 };
+};
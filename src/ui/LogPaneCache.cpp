@@ -0,0 +1,251 @@
+#include "LogPaneCache.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+// Same pipeline as the ImGui GL3 backend, but with our own program/VAO/buffers: the callback runs
+// while the backend is in the middle of a draw list, so its vertex buffer must not be touched.
+static const char* kVertexShader = R"(#version 330 core
+uniform mat4 ProjMtx;
+layout (location = 0) in vec2 Position;
+layout (location = 1) in vec2 UV;
+layout (location = 2) in vec4 Color;
+out vec2 Frag_UV;
+out vec4 Frag_Color;
+void main() {
+    Frag_UV = UV;
+    Frag_Color = Color;
+    gl_Position = ProjMtx * vec4(Position.xy, 0, 1);
+}
+)";
+
+static const char* kFragmentShader = R"(#version 330 core
+uniform sampler2D Texture;
+in vec2 Frag_UV;
+in vec4 Frag_Color;
+layout (location = 0) out vec4 Out_Color;
+void main() {
+    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);
+}
+)";
+
+static GLuint compile(GLenum type, const char* src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    GLint ok = 0;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (!ok) { glDeleteShader(s); return 0; }
+    return s;
+}
+
+bool LogPaneCache::ensureProgram() {
+    if (program_ || failed_) return program_ != 0;
+    GLuint vs = compile(GL_VERTEX_SHADER, kVertexShader), fs = compile(GL_FRAGMENT_SHADER, kFragmentShader);
+    if (vs && fs) {
+        GLuint p = glCreateProgram();
+        glAttachShader(p, vs);
+        glAttachShader(p, fs);
+        glLinkProgram(p);
+        GLint ok = 0;
+        glGetProgramiv(p, GL_LINK_STATUS, &ok);
+        if (ok) program_ = p; else glDeleteProgram(p);
+    }
+    if (vs) glDeleteShader(vs);
+    if (fs) glDeleteShader(fs);
+    if (!program_) { failed_ = true; return false; }
+    locProj_ = glGetUniformLocation(program_, "ProjMtx");
+    locTex_ = glGetUniformLocation(program_, "Texture");
+
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glGenBuffers(1, &ebo_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, pos));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, uv));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, col));
+    glBindVertexArray(0);
+
+    list_ = IM_NEW(ImDrawList)(ImGui::GetDrawListSharedData());
+    return true;
+}
+
+void LogPaneCache::ensureTarget(int w, int h) {
+    if (tex_ && w == pxW_ && h == pxH_) return;
+    GLint lastTex = 0, lastFbo = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTex);
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &lastFbo);
+    if (!tex_) glGenTextures(1, &tex_);
+    if (!fbo_) glGenFramebuffers(1, &fbo_);
+    glBindTexture(GL_TEXTURE_2D, tex_);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);   // the slot ring wraps vertically
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex_, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)lastFbo);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)lastTex);
+    pxW_ = w; pxH_ = h;
+    invalidate();
+}
+
+void LogPaneCache::invalidate() {
+    std::fill(slotId_.begin(), slotId_.end(), ~0ull);
+}
+
+bool LogPaneCache::draw(size_t count, float rowH, uint64_t firstId, uint64_t epoch,
+                        FunctionRef<RowKey(size_t)> key, FunctionRef<void(size_t, ImDrawList&, ImVec2)> drawRow) {
+    if (!ensureProgram()) return false;
+    redrawn_ = 0;
+    const ImVec2 avail = ImGui::GetContentRegionAvail();     // visible area of the child
+    const ImVec2 origin = ImGui::GetCursorScreenPos();       // top of row 0, moves with the scroll
+    const float scrollY = ImGui::GetScrollY();
+    ImGui::Dummy(ImVec2(avail.x, rowH * (float)count));      // scroll extent
+    if (count == 0 || avail.x < 1 || avail.y < 1) return true;
+
+    // one slot per visible row plus a partially visible one at each edge
+    const size_t slots = (size_t)std::ceil(avail.y / rowH) + 2;
+    const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+    if (slots != slotId_.size()) {
+        slotId_.assign(slots, ~0ull);
+        slotKey_.assign(slots, RowKey{});
+        dirty_.reserve(slots);
+    }
+    texW_ = avail.x;
+    texH_ = rowH * (float)slots;
+    ensureTarget((int)std::ceil(texW_ * scale.x), (int)std::ceil(texH_ * scale.y));
+    // a queued rasterization that never ran (frame skipped) leaves the slots stale
+    if (pending_ || epoch != epoch_ || ImGui::GetFont() != font_ || ImGui::GetFontSize() != fontSize_ || rowH != rowH_)
+        invalidate();
+    epoch_ = epoch; font_ = ImGui::GetFont(); fontSize_ = ImGui::GetFontSize(); rowH_ = rowH;
+
+    list_->_ResetForNewFrame();
+    list_->Flags |= ImDrawListFlags_AllowVtxOffset;
+    list_->PushClipRect(ImVec2(0, 0), ImVec2(texW_, texH_));
+    list_->PushTexture(ImGui::GetIO().Fonts->TexRef);
+    dirty_.clear();
+
+    const size_t first = (size_t)(scrollY / rowH);
+    const size_t last = std::min(count, (size_t)std::ceil((scrollY + avail.y) / rowH));
+    for (size_t i = first; i < last; ++i) {
+        const uint64_t id = firstId + i;
+        const size_t slot = (size_t)(id % slots);
+        const RowKey k = key(i);
+        if (slotId_[slot] == id && slotKey_[slot] == k) continue;
+        slotId_[slot] = id; slotKey_[slot] = k;
+        dirty_.push_back(slot);
+        drawRow(i, *list_, ImVec2(0, rowH * (float)slot));
+    }
+    redrawn_ = dirty_.size();
+
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    if (redrawn_) {
+        dl->AddCallback(&LogPaneCache::renderCallback, this);
+        dl->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+        pending_ = true;
+    }
+    // content y maps to texture y = (firstId * rowH + y) mod texH; GL_REPEAT does the wrap.
+    // The FBO is bottom-up, so v runs from 1 at the top of the ring downwards.
+    // Slots below the last row may hold stale rows, so the quad stops at the end of the content.
+    const float h = std::min(avail.y, rowH * (float)count - scrollY);
+    if (h <= 0) return true;
+    const double ring = std::fmod((double)firstId * rowH + scrollY, (double)texH_);
+    const float v0 = 1.0f - (float)(ring / texH_), v1 = v0 - h / texH_;
+    // The texture holds premultiplied rows over transparent slots, so it blends onto the window
+    // background exactly like immediate-mode text would.
+    const ImVec2 p0(origin.x, origin.y + scrollY);
+    dl->AddCallback(&LogPaneCache::premultipliedCallback, nullptr);
+    dl->AddImage((ImTextureID)(intptr_t)tex_, p0, ImVec2(p0.x + avail.x, p0.y + h),
+                 ImVec2(0, v0), ImVec2(avail.x / texW_, v1));
+    dl->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    return true;
+}
+
+void LogPaneCache::renderCallback(const ImDrawList*, const ImDrawCmd* cmd) {
+    static_cast<LogPaneCache*>(cmd->UserCallbackData)->flush();
+}
+
+void LogPaneCache::premultipliedCallback(const ImDrawList*, const ImDrawCmd*) {
+    glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void LogPaneCache::flush() {
+    pending_ = false;
+    if (!list_ || dirty_.empty()) return;
+    GLint lastFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &lastFbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glViewport(0, 0, pxW_, pxH_);
+
+    // clear the redrawn slots to transparent; rows are bottom-up in the FBO
+    const float pxPerRow = (float)pxH_ / texH_ * rowH_;
+    glEnable(GL_SCISSOR_TEST);
+    glClearColor(0, 0, 0, 0);
+    for (size_t slot : dirty_) {
+        int top = (int)std::lround(pxPerRow * (float)slot), bottom = (int)std::lround(pxPerRow * (float)(slot + 1));
+        glScissor(0, pxH_ - bottom, pxW_, bottom - top);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    if (list_->VtxBuffer.Size == 0) { glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)lastFbo); return; }
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+    setupRenderState();
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)list_->VtxBuffer.Size * sizeof(ImDrawVert), list_->VtxBuffer.Data, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)list_->IdxBuffer.Size * sizeof(ImDrawIdx), list_->IdxBuffer.Data, GL_STREAM_DRAW);
+    glActiveTexture(GL_TEXTURE0);
+    for (const ImDrawCmd& c : list_->CmdBuffer) {
+        if (c.UserCallback) {
+            if (c.UserCallback == ImDrawCallback_ResetRenderState) setupRenderState();
+            else c.UserCallback(list_, &c);
+            continue;
+        }
+        if (c.ElemCount == 0) continue;
+        glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)c.GetTexID());
+        glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)c.ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                                 (void*)(intptr_t)(c.IdxOffset * sizeof(ImDrawIdx)), (GLint)c.VtxOffset);
+    }
+    glBindVertexArray(0);
+    // the ResetRenderState callback queued after us restores the backend's program, buffers and viewport
+    glBindFramebuffer(GL_FRAMEBUFFER, (GLuint)lastFbo);
+}
+
+void LogPaneCache::setupRenderState() {
+    const float L = 0, R = texW_, T = 0, B = texH_;
+    const float ortho[4][4] = {
+        { 2.0f / (R - L), 0.0f, 0.0f, 0.0f },
+        { 0.0f, 2.0f / (T - B), 0.0f, 0.0f },
+        { 0.0f, 0.0f, -1.0f, 0.0f },
+        { (R + L) / (L - R), (T + B) / (B - T), 0.0f, 1.0f },
+    };
+    glUseProgram(program_);
+    glUniformMatrix4fv(locProj_, 1, GL_FALSE, &ortho[0][0]);
+    glUniform1i(locTex_, 0);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+}
+
+void LogPaneCache::release() {
+    if (list_) { IM_DELETE(list_); list_ = nullptr; }
+    if (tex_) glDeleteTextures(1, &tex_);
+    if (fbo_) glDeleteFramebuffers(1, &fbo_);
+    if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (ebo_) glDeleteBuffers(1, &ebo_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (program_) glDeleteProgram(program_);
+    tex_ = fbo_ = vbo_ = ebo_ = vao_ = program_ = 0;
+    pxW_ = pxH_ = 0;
+    slotId_.clear();
+    slotKey_.clear();
+    dirty_.clear();
+    pending_ = false;
+}
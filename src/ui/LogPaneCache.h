@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "imgui.h"
+#include "../core/FunctionRef.h"
+
+// --------- cached log pane (offscreen texture of rasterized rows) ----------
+// The visible rows of the log child window live in a texture used as a ring of row slots:
+// row id r is kept in slot r % slots. Each frame only rows whose id or key changed are
+// rasterized, into an offscreen ImDrawList that is executed from a draw callback inside the
+// window's own draw list (after the renderer has uploaded the font atlas). Scrolling or new lines
+// at the bottom only expose a few new rows; the rest of the pane is reused by shifting the texture
+// coordinates, so on the fast path the whole log window is one textured quad.
+// All GL work happens on the UI thread with the context current; release() before the context goes.
+class LogPaneCache {
+public:
+    // Identity of a row's content: rows with equal keys (and equal epoch) draw the same pixels
+    struct RowKey {
+        uint64_t a{ 0 }, b{ 0 };
+        bool operator==(const RowKey& o) const { return a == o.a && b == o.b; }
+    };
+
+    LogPaneCache() = default;
+    LogPaneCache(const LogPaneCache&) = delete;
+    LogPaneCache& operator=(const LogPaneCache&) = delete;
+    ~LogPaneCache() { release(); }
+
+    // Lays out `count` rows of height rowH in the current (child) window. Row i has the id
+    // firstId + i, which must stay attached to the same row while it is on screen; changing epoch
+    // redraws everything. drawRow paints row i at pos into the offscreen list (draw callbacks such
+    // as SdfFont's run during the offscreen pass). Returns false when the cache cannot be used (no
+    // GL program) and nothing was submitted; the caller then draws the rows itself.
+    bool draw(size_t count, float rowH, uint64_t firstId, uint64_t epoch,
+              FunctionRef<RowKey(size_t)> key, FunctionRef<void(size_t, ImDrawList&, ImVec2)> drawRow);
+    void release();
+
+    size_t rowsRedrawn() const { return redrawn_; }   // last frame; 0 = one textured quad
+
+private:
+    static void renderCallback(const ImDrawList* parent, const ImDrawCmd* cmd);
+    static void premultipliedCallback(const ImDrawList* parent, const ImDrawCmd* cmd);
+    bool ensureProgram();
+    void ensureTarget(int w, int h);
+    void invalidate();
+    void flush();   // GL: rasterize list_ into the texture
+    void setupRenderState();
+
+    ImDrawList* list_{ nullptr };            // offscreen rows, built on the UI thread
+    std::vector<uint64_t> slotId_;           // row id held by each slot (~0 = empty)
+    std::vector<RowKey> slotKey_;
+    std::vector<size_t> dirty_;              // slots rasterized this frame
+    size_t redrawn_{ 0 };
+    uint64_t epoch_{ ~0ull };
+    const ImFont* font_{ nullptr };
+    float fontSize_{ 0 }, rowH_{ 0 }, texW_{ 0 }, texH_{ 0 };   // texture extent in UI units
+    int pxW_{ 0 }, pxH_{ 0 };
+    bool pending_{ false };                  // callback queued but not run yet
+    bool failed_{ false };
+
+    unsigned tex_{ 0 }, fbo_{ 0 }, program_{ 0 }, vao_{ 0 }, vbo_{ 0 }, ebo_{ 0 };
+    int locProj_{ -1 }, locTex_{ -1 };
+};
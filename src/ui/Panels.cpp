@@ -1,5 +1,27 @@
 #include "Panels.h"
 #include "imgui.h"
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string_view>
+#include "../core/AllocProfiler.h"
+#include "../core/FrameArena.h"
+#include "../core/FuzzyIndex.h"
+#include "../log/LogIngest.h"
+#include "../log/LogStore.h"
+#include "LogPaneCache.h"
+#include "SdfFont.h"
+#include "ServerMap.h"
+#include "../net/LatencyMonitor.h"
+#include "../net/NetWatcher.h"
+#include "../net/SpeedTest.h"
+#include "../vpn/ConnectionHistory.h"
+#include "../vpn/ProcessMonitor.h"
+#include "../vpn/ServerList.h"
 
 // ---------- class methods ----------
 void UiPanels::DrawUI() {
@@ -8,7 +30,7 @@ void UiPanels::DrawUI() {
     ImGui::End();
 }
 
-void UiPanels::DrawVpnControls(bool connected, std::function<void()> onStart, std::function<void()> onStop) {
+void UiPanels::DrawVpnControls(bool connected, FunctionRef<void()> onStart, FunctionRef<void()> onStop) {
     ImGui::Begin("Controls");
     if (!connected) {
         if (ImGui::Button("Start VPN") && onStart) onStart();
@@ -19,23 +41,593 @@ void UiPanels::DrawVpnControls(bool connected, std::function<void()> onStart, st
     ImGui::End();
 }
 
-void UiPanels::DrawLogs(LogBuffer& log) {
+void UiPanels::DrawVerbosity(VerbosityControls& v) {
+    ImGui::Begin("Controls");
+    ImGui::SeparatorText("Verbosity");
+    if (!v.available) { ImGui::TextDisabled("management interface not connected"); ImGui::End(); return; }
+    ImGui::SetNextItemWidth(120);
+    ImGui::SliderInt("verb", &v.verb, 0, 11);
+    v.applyVerb = ImGui::IsItemDeactivatedAfterEdit();
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    ImGui::InputInt("mute", &v.mute, 1, 10);   // EnterReturnsTrue isn't allowed on scalar inputs (asserts)
+    v.applyMute = ImGui::IsItemDeactivatedAfterEdit();
+    if (v.burstLeft > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "debug burst: verb %d, %.0f s left", v.verb, v.burstLeft);
+    }
+    else {
+        ImGui::SetNextItemWidth(120);
+        ImGui::SliderInt("burst verb", &v.burstVerb, 4, 11);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120);
+        ImGui::SliderInt("seconds", &v.burstSeconds, 5, 600);
+        ImGui::SameLine();
+        v.startBurst = ImGui::Button("Debug burst");
+    }
+    ImGui::End();
+}
+
+// What the system says about the tunnel, not the log: is its adapter up, does it carry the default
+// routes, and which interface carries the tunnel itself
+void UiPanels::DrawNetwork(const NetView& view, bool watching) {
+    ImGui::Begin("Controls");
+    ImGui::SeparatorText("Network");
+    if (!watching) { ImGui::TextDisabled("not watching interface changes"); ImGui::End(); return; }
+    const ImVec4 bad(1.0f, 0.35f, 0.3f, 1.0f);
+    if (const NetInterface* t = view.tunnel()) {
+        const size_t routes = view.tunnelRoutes();
+        if (t->up) ImGui::Text("Tunnel adapter %s: up, %zu default route%s", t->name.c_str(), routes, routes == 1 ? "" : "s");
+        else ImGui::TextColored(bad, "Tunnel adapter %s: down", t->name.c_str());
+    }
+    else ImGui::TextDisabled("no tunnel adapter");
+    if (const NetInterface* u = view.uplink()) ImGui::Text("Uplink: %s", u->name.c_str());
+    else ImGui::TextColored(bad, "Uplink: no default route");
+    ImGui::End();
+}
+
+void UiPanels::DrawLatency(const std::vector<LatencyStats>& stats) {
+    ImGui::Begin("Controls");
+    ImGui::SeparatorText("Latency");
+    if (stats.empty()) { ImGui::TextDisabled("no probe targets"); ImGui::End(); return; }
+    if (ImGui::BeginTable("latency", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Target");
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("Jitter");
+        ImGui::TableSetupColumn("Loss");
+        ImGui::TableHeadersRow();
+        for (const auto& s : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (s.sloBreached) ImGui::TextColored(ImVec4(1.0f, 0.35f, 0.3f, 1.0f), "%s (SLO)", s.name.c_str());
+            else ImGui::TextUnformatted(s.name.c_str());
+            ImGui::TableNextColumn();
+            if (s.lastOk) ImGui::Text("%.1f ms", s.lastMs); else ImGui::TextDisabled("timeout");
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", s.p50Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", s.p95Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", s.p99Ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", s.jitterMs);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f%%", s.sent ? 100.0 * s.lost / s.sent : 0.0);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void UiPanels::DrawLogExport(ExportControls& e) {
+    ImGui::Begin("Controls");
+    ImGui::SeparatorText("Export logs");
+    static const char* formats[] = { "Text", "JSON Lines", "Text (gzip)" };
+    static const char* extensions[] = { ".txt", ".jsonl", ".txt.gz" };
+    ImGui::BeginDisabled(e.running);
+    ImGui::SetNextItemWidth(300);
+    ImGui::InputText("file", e.path, sizeof(e.path));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120);
+    int prev = e.format;
+    if (ImGui::Combo("format", &e.format, formats, IM_ARRAYSIZE(formats)) && prev != e.format) {
+        // swap a known extension so the file name keeps matching the format
+        size_t len = strlen(e.path), ext = strlen(extensions[prev]);
+        if (len > ext && strcmp(e.path + len - ext, extensions[prev]) == 0)
+            snprintf(e.path + len - ext, sizeof(e.path) - (len - ext), "%s", extensions[e.format]);
+    }
+    ImGui::EndDisabled();
+    if (!e.running) e.start = ImGui::Button("Export");
+    else {
+        ImGui::ProgressBar(e.progress, ImVec2(300, 0));
+        ImGui::SameLine();
+        e.cancel = ImGui::Button("Cancel");
+    }
+    if (!e.status.empty()) ImGui::TextWrapped("%s", e.status.c_str());
+    ImGui::End();
+}
+
+void UiPanels::DrawLogs(LogBuffer& log, const LogStore& store, const IngestStats& ingest, FrameArena& arena,
+                        LogPaneCache* cache, const SdfFont* sdf) {
     ImGui::Begin("Logs");
-    for (const auto& s : log.lines) ImGui::TextUnformatted(s.c_str());
+    ImGui::Text("ingest %.0f us (avg %.0f, max %.0f)  %u lines/frame, %u shown, budget %u  hidden %llu / %llu",
+        ingest.lastUs, ingest.avgUs, ingest.maxUs, ingest.lastLines, ingest.lastShown, ingest.budget,
+        (unsigned long long)ingest.hiddenLines, (unsigned long long)ingest.totalLines);
+    if (ingest.backlog) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.3f, 1.0f), "backlog %u", ingest.backlog);
+    }
+    uint64_t stored = store.end() - store.begin();
+    ImGui::Text("store %llu lines, %.1f MB (%.1f MB as text), %zu templates",
+        (unsigned long long)stored, store.bytes() / 1048576.0, store.rawBytes() / 1048576.0, store.templates().size());
+
+    // search runs over the whole store (or the time window); new lines are scanned incrementally
+    static char query[128] = "";
+    static std::string active;
+    static std::vector<uint64_t> hits;
+    static uint64_t searched = 0, searchLo = 0;   // searchLo: window start the hits were collected from
+    // time window in seconds since the first line; "to" <= "from" leaves it open-ended (jump to time)
+    static bool showTimes = false, windowOn = false;
+    static double fromS = 0, toS = 0;
+    ImGui::Checkbox("times", &showTimes);
+    ImGui::SameLine(); ImGui::Checkbox("window", &windowOn);
+    ImGui::SameLine(); ImGui::SetNextItemWidth(100); ImGui::InputDouble("from s", &fromS, 0, 0, "%.3f");
+    ImGui::SameLine(); ImGui::SetNextItemWidth(100); ImGui::InputDouble("to s", &toS, 0, 0, "%.3f");
+    // SDF text scales without baking glyphs, so the log pane gets its own zoom
+    static float zoom = 1.0f;
+    if (sdf) { ImGui::SameLine(); ImGui::SetNextItemWidth(100); ImGui::SliderFloat("zoom", &zoom, 0.5f, 4.0f, "%.2fx"); }
+    if (cache) { ImGui::SameLine(); ImGui::TextDisabled("(%zu rows redrawn)", cache->rowsRedrawn()); }
+    const int64_t origin = store.originNs();
+    const bool windowed = windowOn && origin >= 0;
+    uint64_t lo = store.begin(), hi = store.end();
+    if (windowed) {
+        int64_t t1 = origin + (int64_t)(fromS * 1e9);
+        if (toS > fromS) store.timeRange(t1, origin + (int64_t)(toS * 1e9), lo, hi);
+        else lo = store.lowerBoundTime(t1);
+    }
+    ImGui::InputTextWithHint("##find", "search all lines", query, sizeof(query));
+    const uint64_t windowLo = windowed ? lo : 0;   // eviction moving begin() must not restart the search
+    if (active != query || windowLo != searchLo || hi < searched) {
+        active = query; hits.clear(); searched = lo; searchLo = windowLo;
+    }
+    if (!active.empty()) {
+        store.search(active, searched, hi, hits, arena);
+        searched = std::max(searched, hi);
+        ImGui::SameLine(); ImGui::Text("%zu matches", hits.size());
+    }
+    else if (windowed) { ImGui::SameLine(); ImGui::Text("%llu lines in window", (unsigned long long)(hi - lo)); }
+    ImGui::Separator();
+
+    auto drawTime = [&](uint64_t index) {
+        if (!showTimes) return;
+        int64_t t = store.timeOf(index);
+        if (t >= 0) ImGui::TextDisabled("%12.6f", (t - origin) / 1e9); else ImGui::TextDisabled("%12s", "-");
+        ImGui::SameLine();
+    };
+
+    static std::string text;
+    ImGui::BeginChild("lines");
+    bool follow = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+    const bool filtered = !active.empty() || windowed;
+    const size_t count = !active.empty() ? hits.size() : windowed ? (size_t)(hi - lo) : log.size();
+
+    // Rows painted with ImDrawList calls (cached pane, SDF text) mirror the widget layout below.
+    // Cache ids: hit position, line index in the window, or the live row id.
+    auto rowKey = [&](size_t i) -> LogPaneCache::RowKey {
+        if (filtered) return { !active.empty() ? hits[i] : lo + i, 0 };
+        const LogRow& r = log[i];
+        const bool burst = r.tid == LogRow::kBurst, evicted = !burst && r.line < store.begin();
+        return { r.line, (uint64_t)r.repeat << 32 | (uint64_t)burst << 1 | (uint64_t)evicted };
+    };
+    ImFont* font = ImGui::GetFont();
+    const float size = ImGui::GetFontSize() * (sdf ? zoom : 1.0f), gap = ImGui::GetStyle().ItemSpacing.x;
+    const float rowH = sdf ? sdf->lineHeight(size) + ImGui::GetStyle().ItemSpacing.y : ImGui::GetTextLineHeightWithSpacing();
+    const ImU32 normal = ImGui::GetColorU32(ImGuiCol_Text), dim = ImGui::GetColorU32(ImGuiCol_TextDisabled);
+    auto paintText = [&](size_t i, ImDrawList& dl, ImVec2 pos) {   // SDF rows: inside begin()/end()
+        auto put = [&](ImU32 col, std::string_view s) {
+            if (sdf) { pos.x += sdf->addText(dl, pos, size, col, s) + gap; return; }
+            dl.AddText(font, size, pos, col, s.data(), s.data() + s.size());
+            pos.x += font->CalcTextSizeA(size, FLT_MAX, 0.0f, s.data(), s.data() + s.size()).x + gap;
+        };
+        auto putTime = [&](uint64_t index) {
+            if (!showTimes) return;
+            int64_t t = store.timeOf(index);
+            put(dim, t >= 0 ? arena.format("%12.6f", (t - origin) / 1e9) : arena.format("%12s", "-"));
+        };
+        if (filtered) {
+            uint64_t index = !active.empty() ? hits[i] : lo + i;
+            putTime(index);
+            store.line(index, text);
+            put(normal, text);
+            return;
+        }
+        const LogRow& r = log[i];
+        if (r.tid == LogRow::kBurst) {
+            put(dim, arena.format("[log] burst of %llu lines: %u hidden from view (kept in store)",
+                (unsigned long long)r.line, r.repeat));
+            return;
+        }
+        putTime(r.line);
+        if (!store.line(r.line, text)) text = "(evicted)";
+        put(normal, text);
+        if (r.repeat > 1) put(dim, arena.format("x%u", r.repeat));
+    };
+    auto paintRow = [&](size_t i, ImDrawList& dl, ImVec2 pos) {
+        if (sdf) sdf->begin(dl);
+        paintText(i, dl, pos);
+        if (sdf) sdf->end(dl);
+    };
+    const uint64_t firstId = !active.empty() ? 0 : windowed ? lo : log.firstId();
+    const uint64_t epoch = (showTimes ? 1 : 0) | (sdf ? 2 : 0);
+    const bool cached = cache && cache->draw(count, rowH, firstId, epoch, rowKey, paintRow);
+
+    if (!cached && sdf) {
+        ImDrawList& dl = *ImGui::GetWindowDrawList();
+        ImGuiListClipper clip;
+        clip.Begin((int)count, rowH);
+        sdf->begin(dl);
+        while (clip.Step()) {
+            for (int i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                paintText((size_t)i, dl, ImGui::GetCursorScreenPos());
+                ImGui::Dummy(ImVec2(1.0f, rowH - ImGui::GetStyle().ItemSpacing.y));
+            }
+        }
+        sdf->end(dl);
+    }
+    else if (!cached) {
+        ImGuiListClipper clip;
+        clip.Begin((int)count);
+        while (clip.Step()) {
+            for (int i = clip.DisplayStart; i < clip.DisplayEnd; ++i) {
+                if (filtered) {
+                    uint64_t index = !active.empty() ? hits[i] : lo + i;
+                    drawTime(index);
+                    store.line(index, text);
+                    ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                    continue;
+                }
+                const LogRow& r = log[i];
+                if (r.tid == LogRow::kBurst) {
+                    ImGui::TextDisabled("[log] burst of %llu lines: %u hidden from view (kept in store)",
+                        (unsigned long long)r.line, r.repeat);
+                    continue;
+                }
+                drawTime(r.line);
+                if (!store.line(r.line, text)) text = "(evicted)";
+                ImGui::TextUnformatted(text.data(), text.data() + text.size());
+                if (r.repeat > 1) { ImGui::SameLine(); ImGui::TextDisabled("x%u", r.repeat); }
+            }
+        }
+    }
+    if (follow) ImGui::SetScrollHereY(1.0f);
+    ImGui::EndChild();
+    ImGui::End();
+}
+
+void UiPanels::DrawServerMap(ServerMap& map, const std::vector<ServerEntry>& servers, ServerMapControls& c, bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(900, 520), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Server map", open)) { ImGui::End(); return; }
+    ImGui::Text("%zu servers, %zu probed, %zu reachable%s", map.size(), map.probed(), map.reachable(),
+        c.probing ? " (probing)" : "");
+    ImGui::SameLine();
+    ImGui::TextDisabled("  %zu bytes uploaded last frame%s", map.bytesUploaded(), map.ready() ? "" : ", no map shaders");
+
+    const uint32_t sel = map.selected();
+    if (sel != ServerMap::kNone && sel < servers.size()) {
+        const ServerEntry& e = servers[sel];
+        ImGui::Text("%s  %s:%u", e.name.c_str(), e.host.c_str(), (unsigned)e.port);
+        ImGui::SameLine();
+        c.useSelected = ImGui::SmallButton("Use for next connection");
+    }
+    else ImGui::TextDisabled("click a server to select it; drag to pan, wheel to zoom");
+    if (!c.remote.empty()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("  next start: %s", c.remote.c_str());
+        ImGui::SameLine();
+        c.clearRemote = ImGui::SmallButton("Use profile");
+    }
+
+    map.draw(ImGui::GetContentRegionAvail());
+    const uint32_t hov = map.hovered();
+    if (hov != ServerMap::kNone && hov < servers.size()) {
+        const ServerEntry& e = servers[hov];
+        const float ms = map.latency(hov);
+        if (std::isnan(ms)) ImGui::SetTooltip("%s\n%s:%u\n%s", e.name.c_str(), e.host.c_str(), (unsigned)e.port,
+            e.tcp ? "not probed yet" : "UDP: not probed");
+        else if (ms < 0) ImGui::SetTooltip("%s\n%s:%u\nunreachable", e.name.c_str(), e.host.c_str(), (unsigned)e.port);
+        else ImGui::SetTooltip("%s\n%s:%u\n%.1f ms", e.name.c_str(), e.host.c_str(), (unsigned)e.port, ms);
+    }
+    ImGui::End();
+}
+
+// Type-ahead over every profile and server name. The scan is budgeted (FuzzyIndex::search/resume),
+// so a broad query over a large list fills in over a few frames instead of stalling one.
+void UiPanels::DrawProfileFinder(FuzzyIndex& index, ProfileFinderControls& f, bool* open) {
+    static std::vector<FuzzyIndex::Range> ranges;   // reused across rows and frames
+    f.picked = ~0u;
+    ImGui::SetNextWindowSize(ImVec2(520, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Find profile", open)) { ImGui::End(); return; }
+    if (f.focus) { ImGui::SetKeyboardFocusHere(); f.focus = false; }
+    ImGui::SetNextItemWidth(-FLT_MIN);
+    const bool changed = ImGui::InputTextWithHint("##query", "type to filter, e.g. jp tok tcp", f.query, sizeof(f.query));
+    const bool enter = ImGui::IsItemDeactivated() && ImGui::IsKeyPressed(ImGuiKey_Enter);
+
+    const auto t0 = std::chrono::steady_clock::now();
+    if (changed) { index.search(f.query); f.cursor = 0; }
+    else if (index.pending()) index.resume();
+    f.searchUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    const std::vector<FuzzyIndex::Hit>& hits = index.results();
+    const int rows = (int)hits.size();
+    if (ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows)) {
+        if (ImGui::IsKeyPressed(ImGuiKey_DownArrow)) f.cursor = std::min(f.cursor + 1, rows - 1);
+        if (ImGui::IsKeyPressed(ImGuiKey_UpArrow)) f.cursor = std::max(f.cursor - 1, 0);
+    }
+    f.cursor = std::max(0, std::min(f.cursor, rows - 1));
+    if (enter && rows) f.picked = hits[f.cursor].index;
+
+    ImGui::TextDisabled("%zu of %zu match%s  (%.0f us)", index.matchCount(), index.size(),
+        index.pending() ? ", searching..." : "", f.searchUs);
+    if (index.matchCount() > hits.size()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled(" best %d shown", rows);
+    }
+
+    ImGui::BeginChild("##hits", ImVec2(0, 0), ImGuiChildFlags_Borders);
+    const ImU32 normal = ImGui::GetColorU32(ImGuiCol_Text);
+    const ImU32 match = IM_COL32(255, 200, 80, 255);
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    ImGuiListClipper clip;
+    clip.Begin(rows);
+    if (f.cursor < rows) clip.IncludeItemByIndex(f.cursor);
+    while (clip.Step()) {
+        for (int r = clip.DisplayStart; r < clip.DisplayEnd; ++r) {
+            const uint32_t i = hits[r].index;
+            ImGui::PushID(r);
+            const ImVec2 pos = ImGui::GetCursorScreenPos();
+            if (ImGui::Selectable("##hit", r == f.cursor)) { f.cursor = r; f.picked = i; }
+            if (r == f.cursor && (changed || ImGui::IsKeyPressed(ImGuiKey_DownArrow) || ImGui::IsKeyPressed(ImGuiKey_UpArrow)))
+                ImGui::SetScrollHereY();
+            ImGui::PopID();
+            // the name in segments: matched bytes in the highlight colour
+            const std::string_view name = index.name(i);
+            index.highlights(i, ranges);
+            const char* s = name.data();
+            ImVec2 p = pos;
+            size_t at = 0;
+            for (const FuzzyIndex::Range& g : ranges) {
+                if (g.start > at) {
+                    dl->AddText(p, normal, s + at, s + g.start);
+                    p.x += ImGui::CalcTextSize(s + at, s + g.start).x;
+                }
+                dl->AddText(p, match, s + g.start, s + g.start + g.len);
+                p.x += ImGui::CalcTextSize(s + g.start, s + g.start + g.len).x;
+                at = g.start + g.len;
+            }
+            if (at < name.size()) dl->AddText(p, normal, s + at, s + name.size());
+        }
+    }
+    ImGui::EndChild();
     ImGui::End();
 }
 
-// ---------- free-function wrappers ( main.cpp ֱӵ) ----------
-static UiPanels g_ui_singleton;
+void UiPanels::DrawHistory(const ConnectionHistory& history, HistoryControls& h, bool* open) {
+    static std::vector<HistoryGroup> groups;   // the last query's result
+    static HistorySession s;                   // reused for the visible rows
+    static const char* ranges[] = { "Last 24 hours", "Last 7 days", "Last 30 days", "Last 90 days", "All time" };
+    static const int rangeDays[] = { 1, 7, 30, 90, 0 };
+    static const char* keys[] = { "Server", "Profile", "Exit reason" };
+    ImGui::SetNextWindowSize(ImVec2(760, 480), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("History", open)) { ImGui::End(); return; }
+    if (!history.isOpen()) { ImGui::TextDisabled("history is not recorded (see --history)"); ImGui::End(); return; }
+    ImGui::SetNextItemWidth(160);
+    bool changed = ImGui::Combo("##range", &h.range, ranges, IM_ARRAYSIZE(ranges));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160);
+    changed |= ImGui::Combo("Group by", &h.groupBy, keys, IM_ARRAYSIZE(keys));
+    if (changed || h.rows != history.size()) {
+        const int days = rangeDays[h.range];
+        const auto t0 = std::chrono::steady_clock::now();
+        history.aggregate(days ? (int64_t)std::time(nullptr) - days * 86400ll : 0, (HistoryKey)h.groupBy, groups);
+        h.queryUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        h.rows = history.size();
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("%zu sessions recorded, query %.0f us", history.size(), h.queryUs);
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit |
+        ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("groups", 8, flags, ImVec2(0, ImGui::GetContentRegionAvail().y * 0.5f))) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn(keys[h.groupBy], ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Sessions");
+        ImGui::TableSetupColumn("Failed");
+        ImGui::TableSetupColumn("Connect p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("Reconnects");
+        ImGui::TableSetupColumn("Hours");
+        ImGui::TableSetupColumn("GB in / out");
+        ImGui::TableHeadersRow();
+        ImGuiListClipper clip;
+        clip.Begin((int)groups.size());
+        while (clip.Step()) {
+            for (int r = clip.DisplayStart; r < clip.DisplayEnd; ++r) {
+                const HistoryGroup& g = groups[r];
+                const std::string_view name = history.name(g.key);
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(name.data(), name.data() + name.size());
+                ImGui::TableNextColumn(); ImGui::Text("%u", g.sessions);
+                ImGui::TableNextColumn(); ImGui::Text("%u", g.sessions - g.connected);
+                ImGui::TableNextColumn();
+                if (g.connected) ImGui::Text("%.1f s", g.p50Ms / 1000); else ImGui::TextDisabled("-");
+                ImGui::TableNextColumn();
+                if (g.connected) ImGui::Text("%.1f s", g.p95Ms / 1000); else ImGui::TextDisabled("-");
+                ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)g.reconnects);
+                ImGui::TableNextColumn(); ImGui::Text("%.1f", g.seconds / 3600.0);
+                ImGui::TableNextColumn(); ImGui::Text("%.2f / %.2f", g.bytesIn / 1e9, g.bytesOut / 1e9);
+            }
+        }
+        ImGui::EndTable();
+    }
 
-void DrawUI() {
-    g_ui_singleton.DrawUI();
+    ImGui::SeparatorText("Sessions, newest first");
+    if (ImGui::BeginTable("sessions", 8, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Started");
+        ImGui::TableSetupColumn("Duration");
+        ImGui::TableSetupColumn("Profile", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Server", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("Connect");
+        ImGui::TableSetupColumn("MB in / out");
+        ImGui::TableSetupColumn("Reconnects");
+        ImGui::TableSetupColumn("Exit");
+        ImGui::TableHeadersRow();
+        ImGuiListClipper clip;
+        clip.Begin((int)history.size());
+        while (clip.Step()) {
+            for (int r = clip.DisplayStart; r < clip.DisplayEnd; ++r) {
+                history.session(history.size() - 1 - r, s);
+                char started[32];
+                const std::time_t t = (std::time_t)s.startUnix;
+                const std::tm* tm = std::localtime(&t);
+                if (!tm || !std::strftime(started, sizeof(started), "%Y-%m-%d %H:%M", tm)) std::strcpy(started, "?");
+                const long long up = s.stopUnix - s.startUnix;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(started);
+                ImGui::TableNextColumn(); ImGui::Text("%lldh%02lldm", up / 3600, up / 60 % 60);
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(s.profile.c_str());
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(s.remote.c_str());
+                ImGui::TableNextColumn();
+                if (s.connectMs >= 0) ImGui::Text("%.1f s", s.connectMs / 1000.0); else ImGui::TextDisabled("-");
+                ImGui::TableNextColumn(); ImGui::Text("%.1f / %.1f", s.bytesIn / 1048576.0, s.bytesOut / 1048576.0);
+                ImGui::TableNextColumn(); ImGui::Text("%u", s.reconnects);
+                ImGui::TableNextColumn(); ImGui::TextUnformatted(s.exitReason.c_str());
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
 }
 
-void DrawVpnControls(bool connected, std::function<void()> onStart, std::function<void()> onStop) {
-    g_ui_singleton.DrawVpnControls(connected, onStart, onStop);
+// Goodput through the tunnel per stream and in total, and the ping's latency idle and under load:
+// the difference is what the tunnel's queues add when it is full
+void UiPanels::DrawSpeedTest(SpeedTestControls& c, const SpeedTestResult& r, bool* open) {
+    static const char* phases[] = { "", "measuring idle latency...", "running...", "done", "failed" };
+    c.start = c.stop = false;
+    ImGui::SetNextWindowSize(ImVec2(640, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Speed test", open)) { ImGui::End(); return; }
+    ImGui::BeginDisabled(c.running);
+    ImGui::SetNextItemWidth(220);
+    ImGui::InputText("Server", c.host, sizeof(c.host));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    if (ImGui::InputInt("Port", &c.port, 0)) c.port = std::clamp(c.port, 1, 65535);
+    ImGui::SetNextItemWidth(220);
+    ImGui::SliderInt("Streams", &c.streams, 1, 32);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(80);
+    if (ImGui::InputInt("Seconds", &c.seconds, 0)) c.seconds = std::clamp(c.seconds, 1, 300);
+    ImGui::RadioButton("Download", &c.direction, 0);
+    ImGui::SameLine();
+    ImGui::RadioButton("Upload", &c.direction, 1);
+    ImGui::SameLine();
+    ImGui::Checkbox("UDP at", &c.udp);
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(60);
+    if (ImGui::InputFloat("Mbit/s", &c.udpMbps, 0, 0, "%.0f")) c.udpMbps = std::clamp(c.udpMbps, 0.1f, 10000.0f);
+    ImGui::EndDisabled();
+    if (c.running) c.stop = ImGui::Button("Stop");
+    else c.start = ImGui::Button("Start");
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", phases[r.phase]);
+    if (r.phase == SpeedTestResult::Failed) {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "%s", r.error.c_str());
+    }
+    if (r.phase == SpeedTestResult::Idle || r.phase == SpeedTestResult::Failed) { ImGui::End(); return; }
+
+    ImGui::SeparatorText("Total");
+    ImGui::Text("%.1f Mbit/s   %.1f MB in %.1f s", r.mbps, r.bytes / 1e6, r.seconds);
+    ImGui::Text("Latency p50 %.1f ms idle, %.1f ms loaded (p95 %.1f ms)", r.idleP50Ms, r.loadedP50Ms, r.loadedP95Ms);
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit |
+        ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("streams", 5, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Stream");
+        ImGui::TableSetupColumn("Mbit/s");
+        ImGui::TableSetupColumn("MB");
+        ImGui::TableSetupColumn("Connect");
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < r.streams.size(); ++i) {
+            const SpeedStreamStats& s = r.streams[i];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if (s.udp) ImGui::TextUnformatted("UDP"); else ImGui::Text("TCP %zu", i + 1);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", s.mbps);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", s.bytes / 1e6);
+            ImGui::TableNextColumn();
+            if (s.connectMs >= 0 && !s.udp) ImGui::Text("%.1f ms", s.connectMs); else ImGui::TextDisabled("-");
+            ImGui::TableNextColumn();
+            if (!s.error.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "%s", s.error.c_str());
+            else if (s.udp) ImGui::Text("%.2f%% lost, rtt p50 %.1f ms p95 %.1f ms", s.sent ? 100.0 * s.lost / s.sent : 0.0,
+                s.rttP50Ms, s.rttP95Ms);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void UiPanels::DrawProcessMonitor(const std::vector<ProcessSeries>& procs, double sampleUs, ProcessLimits& limits, bool& autoRestart, bool* open) {
+    if (!ImGui::Begin("Process", open)) { ImGui::End(); return; }
+    if (procs.empty()) ImGui::TextDisabled("VPN process not running");
+    else ImGui::TextDisabled("last sample took %.0f us", sampleUs);
+    for (const auto& p : procs) {
+        ImGui::PushID((int)p.pid);
+        ImGui::SeparatorText(p.name.c_str());
+        if (!p.alive) ImGui::TextDisabled("pid %u (exited)", p.pid);
+        else ImGui::Text("pid %u  CPU %.1f%%  RSS %.1f MB  private %.1f MB  handles %u  threads %u  csw %.0f/s",
+            p.pid, p.cpuPct, p.rssMb, p.privateMb, p.handles, p.threads, p.cswPerSec);
+        int n = (int)p.count, off = (int)p.head;
+        ImVec2 size(0, 40);
+        ImGui::PlotLines("RSS MB", p.rss.data(), n, off, nullptr, FLT_MAX, FLT_MAX, size);
+        ImGui::PlotLines("CPU %", p.cpu.data(), n, off, nullptr, 0.0f, FLT_MAX, size);
+        ImGui::PlotLines("Handles", p.hnd.data(), n, off, nullptr, FLT_MAX, FLT_MAX, size);
+        ImGui::PlotLines("Ctx sw/s", p.csw.data(), n, off, nullptr, 0.0f, FLT_MAX, size);
+        ImGui::PopID();
+    }
+    ImGui::SeparatorText("Restart thresholds (0 = off)");
+    float rss = (float)limits.maxRssMb, cpu = (float)limits.maxCpuPct;
+    int handles = (int)limits.maxHandles;
+    if (ImGui::InputFloat("Max RSS MB", &rss, 0, 0, "%.0f")) limits.maxRssMb = rss > 0 ? rss : 0;
+    if (ImGui::InputInt("Max handles", &handles)) limits.maxHandles = handles > 0 ? (uint32_t)handles : 0;
+    if (ImGui::InputFloat("Max CPU %", &cpu, 0, 0, "%.0f")) limits.maxCpuPct = cpu > 0 ? cpu : 0;
+    ImGui::InputInt("Sustain (samples)", &limits.sustainSamples);
+    ImGui::Checkbox("Restart tunnel on breach", &autoRestart);
+    ImGui::End();
 }
 
-void DrawLogs(LogBuffer& log) {
-    g_ui_singleton.DrawLogs(log);
+void UiPanels::DrawAllocOverlay(bool* open, const FrameArena& arena) {
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Allocations", open, ImGuiWindowFlags_AlwaysAutoResize)) { ImGui::End(); return; }
+    const AllocFrame& f = AllocProfiler::last();
+    ImGui::Text("UI thread: %llu allocs, %llu bytes last frame", (unsigned long long)f.frameAllocs,
+        (unsigned long long)f.frameBytes);
+    ImGui::PlotHistogram("##allocs", AllocProfiler::history(), (int)AllocProfiler::kHistory,
+        (int)AllocProfiler::historyHead(), nullptr, 0.0f, FLT_MAX, ImVec2(300, 50));
+    if (ImGui::BeginTable("tags", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+        ImGui::TableSetupColumn("Tag");
+        ImGui::TableSetupColumn("Allocs");
+        ImGui::TableSetupColumn("Bytes");
+        ImGui::TableSetupColumn("Frees");
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < AllocFrame::kTags; ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(AllocProfiler::tagName((AllocTag)i));
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)f.allocs[i]);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)f.bytes[i]);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)f.frees[i]);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("frame arena: %zu KB peak of %zu KB", arena.highWater() >> 10, arena.capacity() >> 10);
+    ImGui::TextDisabled("\"other\" = background threads, not counted against the frame");
+    ImGui::End();
 }
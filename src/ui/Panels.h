@@ -1,26 +1,139 @@
 #pragma once
-#include <functional>
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "../core/FunctionRef.h"
+#include "../log/LogTemplates.h"
 
 // --------- simple ring log ----------
+// Live view rows point into the LogStore instead of owning text. Consecutive lines that share a
+// template collapse into one row showing the newest line and a repeat count (raw lines never do:
+// they share template 0 without having anything else in common). The rows live in a
+// fixed ring allocated once, so a steady stream of lines never touches the heap.
+struct LogRow {
+    static constexpr uint32_t kBurst = 0xFFFFFFFFu;   // summary row: line = burst size, repeat = hidden
+    uint64_t line{ 0 };
+    uint32_t tid{ 0 };
+    uint32_t repeat{ 1 };
+};
+
 struct LogBuffer {
-    std::vector<std::string> lines;
-    void add(const std::string& s) { lines.push_back(s); if (lines.size() > 2000) lines.erase(lines.begin()); }
+    static constexpr size_t kMaxLines = 2000;
+    LogBuffer() : ring_(kMaxLines) {}
+    size_t size() const { return count_; }
+    const LogRow& operator[](size_t i) const { return ring_[(head_ + i) % kMaxLines]; }   // 0 = oldest
+    uint64_t firstId() const { return dropped_; }   // row i has the stable id firstId() + i
+    void add(const LogRow& r) {
+        if (count_ && r.tid != LogRow::kBurst && r.tid != LogTemplates::kRaw && back().tid == r.tid) {
+            back().line = r.line;
+            back().repeat += r.repeat;
+            return;
+        }
+        if (count_ < kMaxLines) { ring_[(head_ + count_++) % kMaxLines] = r; return; }
+        ring_[head_] = r;   // full: overwrite the oldest
+        head_ = (head_ + 1) % kMaxLines;
+        ++dropped_;
+    }
     // ݾ÷
-    void clear() { lines.clear(); }
-    void push(const std::string& s) { add(s); }
+    void clear() { dropped_ += count_; head_ = count_ = 0; }
+    void push(uint64_t line, uint32_t tid) { add({ line, tid, 1 }); }
+
+private:
+    LogRow& back() { return ring_[(head_ + count_ - 1) % kMaxLines]; }
+    std::vector<LogRow> ring_;
+    size_t head_{ 0 }, count_{ 0 };
+    uint64_t dropped_{ 0 };
+};
+
+class ConnectionHistory;
+class FrameArena;
+class FuzzyIndex;
+class LogPaneCache;
+class SdfFont;
+class ServerMap;
+struct ServerEntry;
+class LogStore;
+struct LatencyStats;
+struct IngestStats;
+struct ProcessSeries;
+struct ProcessLimits;
+struct SpeedTestResult;
+struct NetView;
+
+// Runtime verbosity: main fills in the current state, the panel sets apply*/startBurst for main to act on
+struct VerbosityControls {
+    bool available{ false };          // management interface connected
+    int verb{ 3 }, mute{ 0 };
+    int burstVerb{ 7 }, burstSeconds{ 60 };
+    double burstLeft{ 0 };            // > 0 while a debug burst is running
+    bool applyVerb{ false }, applyMute{ false }, startBurst{ false };
+};
+
+// Log export: the panel edits path/format and sets start/cancel for main to act on
+struct ExportControls {
+    char path[260] = "openvpn-log.txt";
+    int format{ 0 };                  // ExportFormat: text, JSON Lines, gzip
+    bool running{ false };
+    float progress{ 0 };
+    std::string status;               // last result or error
+    bool start{ false }, cancel{ false };
+};
+
+// Server map: main reports the remote the next start will use, the panel sets useSelected/clearRemote
+struct ServerMapControls {
+    bool probing{ false };            // ServerProber running
+    std::string remote;               // "host:port" given to the next start, empty = the profile's remotes
+    bool useSelected{ false }, clearRemote{ false };
+};
+
+// Profile finder: the panel runs the search as the query changes and sets picked for main to act on
+struct ProfileFinderControls {
+    char query[128] = "";
+    bool focus{ false };              // main sets it (Ctrl+P) to put the cursor in the query box
+    int cursor{ 0 };                  // highlighted row, moved with the arrow keys
+    double searchUs{ 0 };             // search work done this frame
+    uint32_t picked{ ~0u };           // FuzzyIndex entry chosen this frame, ~0u = none
+};
+
+// Connection history: the panel picks the range and grouping and reruns the query when they change
+// or a session is added
+struct HistoryControls {
+    int range{ 3 };                   // 1 day, 7, 30, 90 days, all
+    int groupBy{ 0 };                 // HistoryKey: server, profile, exit reason
+    size_t rows{ ~size_t(0) };        // history size the groups were computed for
+    double queryUs{ 0 };
+};
+
+// Speed test: the panel edits the options and sets start/stop for main to act on; main refreshes
+// the result every frame while the test runs
+struct SpeedTestControls {
+    char host[128] = "127.0.0.1";
+    int port{ 5209 };                 // SpeedTestProto::kDefaultPort
+    int streams{ 4 }, seconds{ 10 };
+    int direction{ 0 };               // download, upload
+    bool udp{ false };
+    float udpMbps{ 20 };
+    bool running{ false };
+    bool start{ false }, stop{ false };
 };
 
 // --------- class API (ڲʵ) ----------
 class UiPanels {
 public:
-    void DrawUI();
-    void DrawVpnControls(bool connected, std::function<void()> onStart, std::function<void()> onStop);
-    void DrawLogs(LogBuffer& log);
+    static void DrawUI();
+    static void DrawVpnControls(bool connected, FunctionRef<void()> onStart, FunctionRef<void()> onStop);
+    static void DrawVerbosity(VerbosityControls& v);                   // appended to the "Controls" window
+    static void DrawLatency(const std::vector<LatencyStats>& stats);   // appended to the "Controls" window
+    static void DrawLogExport(ExportControls& e);                      // appended to the "Controls" window
+    static void DrawNetwork(const NetView& view, bool watching);       // appended to the "Controls" window
+    // cache: optional GL row cache (nullptr = immediate mode, e.g. the headless bench)
+    // sdf: optional distance-field font for the log text (nullptr = ImGui font, no zoom)
+    static void DrawLogs(LogBuffer& log, const LogStore& store, const IngestStats& ingest, FrameArena& arena,
+                         LogPaneCache* cache = nullptr, const SdfFont* sdf = nullptr);
+    static void DrawServerMap(ServerMap& map, const std::vector<ServerEntry>& servers, ServerMapControls& c, bool* open);
+    static void DrawProfileFinder(FuzzyIndex& index, ProfileFinderControls& f, bool* open);
+    static void DrawHistory(const ConnectionHistory& history, HistoryControls& h, bool* open);
+    static void DrawSpeedTest(SpeedTestControls& c, const SpeedTestResult& r, bool* open);
+    static void DrawProcessMonitor(const std::vector<ProcessSeries>& procs, double sampleUs, ProcessLimits& limits, bool& autoRestart, bool* open);
+    static void DrawAllocOverlay(bool* open, const FrameArena& arena); // per-frame heap allocations (AllocProfiler)
 };
-
-// --------- free functions (main.cpp ڵõȫֺ) ----------
-void DrawUI();
-void DrawVpnControls(bool connected, std::function<void()> onStart, std::function<void()> onStop);
-void DrawLogs(LogBuffer& log);
@@ -0,0 +1,226 @@
+#include "SdfFont.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+// Bake parameters: distances are stored out to kPadding base pixels on either side of the edge,
+// which is enough to keep edges clean from about a quarter of the base size to several times it.
+static constexpr float kBaseSize = 40.0f;
+static constexpr int kPadding = 5;
+static constexpr unsigned char kOnEdge = 128;
+static constexpr int kAtlasWidth = 512;
+
+static bool readFile(const std::string& path, std::vector<unsigned char>& out) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    long n = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    out.resize(n > 0 ? (size_t)n : 0);
+    bool ok = n > 0 && std::fread(out.data(), 1, out.size(), f) == out.size();
+    std::fclose(f);
+    return ok;
+}
+
+static GLuint compile(GLenum type, const std::vector<unsigned char>& src, std::string& err) {
+    GLuint s = glCreateShader(type);
+    const char* p = (const char*)src.data();
+    GLint len = (GLint)src.size();
+    glShaderSource(s, 1, &p, &len);
+    glCompileShader(s);
+    GLint ok = 0;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (ok) return s;
+    char log[512] = "";
+    glGetShaderInfoLog(s, sizeof(log), nullptr, log);
+    err = std::string("SDF shader: ") + log;
+    glDeleteShader(s);
+    return 0;
+}
+
+// One code point from UTF-8; malformed bytes come back as '?' and advance by one
+static uint32_t decodeUtf8(std::string_view s, size_t& i) {
+    const unsigned char c = (unsigned char)s[i];
+    if (c < 0x80) { ++i; return c; }
+    int n = (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : -1;
+    if (n < 0 || i + n >= s.size()) { ++i; return '?'; }
+    uint32_t cp = c & (0x3F >> n);
+    for (int k = 1; k <= n; ++k) {
+        const unsigned char cc = (unsigned char)s[i + k];
+        if ((cc & 0xC0) != 0x80) { ++i; return '?'; }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    i += n + 1;
+    return cp;
+}
+
+bool SdfFont::load(const char* ttfPath, const char* shaderDir, std::string& err) {
+    release();
+    std::vector<unsigned char> ttf, vsSrc, fsSrc;
+    if (!readFile(ttfPath, ttf)) { err = std::string("cannot read font ") + ttfPath; return false; }
+    const std::string dir = shaderDir;
+    if (!readFile(dir + "/sdf_vertex.glsl", vsSrc) || !readFile(dir + "/sdf_fragment.glsl", fsSrc)) {
+        err = "cannot read SDF shaders from " + dir;
+        return false;
+    }
+    stbtt_fontinfo info;
+    if (!stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0))) {
+        err = std::string("not a TrueType font: ") + ttfPath;
+        return false;
+    }
+
+    // bake every glyph once, shelf-packed into a single-channel atlas
+    const float scale = stbtt_ScaleForPixelHeight(&info, kBaseSize);
+    int asc = 0, desc = 0, gap = 0;
+    stbtt_GetFontVMetrics(&info, &asc, &desc, &gap);
+    baseSize_ = kBaseSize;
+    ascent_ = asc * scale;
+    struct Baked { unsigned char* bits; int w, h, x, y; };
+    std::vector<Baked> baked(kLast - kFirst + 1, Baked{ nullptr, 0, 0, 0, 0 });
+    glyphs_.assign(baked.size(), Glyph{});
+    int penX = 0, penY = 0, shelf = 0;
+    for (uint32_t cp = kFirst; cp <= kLast; ++cp) {
+        Baked& b = baked[cp - kFirst];
+        Glyph& g = glyphs_[cp - kFirst];
+        if (!stbtt_FindGlyphIndex(&info, (int)cp)) { g.advance = -1; continue; }   // filled from '?' below
+        int adv = 0, lsb = 0, xoff = 0, yoff = 0;
+        stbtt_GetCodepointHMetrics(&info, (int)cp, &adv, &lsb);
+        g.advance = adv * scale;
+        b.bits = stbtt_GetCodepointSDF(&info, scale, (int)cp, kPadding, kOnEdge, (float)kOnEdge / kPadding,
+                                       &b.w, &b.h, &xoff, &yoff);
+        if (!b.bits) continue;   // blank glyph (space)
+        if (penX + b.w > kAtlasWidth) { penX = 0; penY += shelf + 1; shelf = 0; }
+        b.x = penX; b.y = penY;
+        penX += b.w + 1;
+        shelf = std::max(shelf, b.h);
+        g.x0 = (float)xoff; g.y0 = (float)yoff;
+        g.x1 = (float)(xoff + b.w); g.y1 = (float)(yoff + b.h);
+    }
+    atlasW_ = kAtlasWidth;
+    atlasH_ = penY + shelf;
+    std::vector<unsigned char> pixels((size_t)atlasW_ * atlasH_, 0);
+    for (size_t i = 0; i < baked.size(); ++i) {
+        Baked& b = baked[i];
+        if (!b.bits) continue;
+        for (int y = 0; y < b.h; ++y)
+            std::copy(b.bits + (size_t)y * b.w, b.bits + (size_t)(y + 1) * b.w, pixels.data() + (size_t)(b.y + y) * atlasW_ + b.x);
+        stbtt_FreeSDF(b.bits, nullptr);
+        Glyph& g = glyphs_[i];
+        g.u0 = (float)b.x / atlasW_; g.v0 = (float)b.y / atlasH_;
+        g.u1 = (float)(b.x + b.w) / atlasW_; g.v1 = (float)(b.y + b.h) / atlasH_;
+    }
+    for (Glyph& g : glyphs_) if (g.advance < 0) g = glyphs_['?' - kFirst];
+
+    GLuint vs = compile(GL_VERTEX_SHADER, vsSrc, err), fs = vs ? compile(GL_FRAGMENT_SHADER, fsSrc, err) : 0;
+    GLuint prog = 0;
+    if (vs && fs) {
+        prog = glCreateProgram();
+        glAttachShader(prog, vs);
+        glAttachShader(prog, fs);
+        glLinkProgram(prog);
+        GLint ok = 0;
+        glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+        if (!ok) { glDeleteProgram(prog); prog = 0; err = "SDF shader: link failed"; }
+    }
+    if (vs) glDeleteShader(vs);
+    if (fs) glDeleteShader(fs);
+    if (!prog) { glyphs_.clear(); return false; }
+    program_ = prog;
+    locProj_ = glGetUniformLocation(program_, "ProjMtx");
+    locTex_ = glGetUniformLocation(program_, "Texture");
+    locDist_ = glGetUniformLocation(program_, "DistPerTexel");
+
+    GLint lastTex = 0, lastAlign = 4;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTex);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &lastAlign);
+    glGenTextures(1, &tex_);
+    glBindTexture(GL_TEXTURE_2D, tex_);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasW_, atlasH_, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);   // SDF edges need bilinear samples
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, lastAlign);
+    glBindTexture(GL_TEXTURE_2D, (GLuint)lastTex);
+
+    // the VAO gets whatever vertex/index buffers are bound when the callback runs
+    glGenVertexArrays(1, &vao_);
+    glBindVertexArray(vao_);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    return true;
+}
+
+void SdfFont::release() {
+    if (tex_) glDeleteTextures(1, &tex_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (program_) glDeleteProgram(program_);
+    tex_ = vao_ = program_ = 0;
+    glyphs_.clear();
+}
+
+float SdfFont::measure(float size, std::string_view s) const {
+    const float k = size / baseSize_;
+    float w = 0;
+    for (size_t i = 0; i < s.size();) w += glyph(decodeUtf8(s, i)).advance;
+    return w * k;
+}
+
+void SdfFont::begin(ImDrawList& dl) const {
+    dl.AddCallback(&SdfFont::beginCallback, const_cast<SdfFont*>(this));
+    dl.PushTexture((ImTextureID)(intptr_t)tex_);
+}
+
+void SdfFont::end(ImDrawList& dl) const {
+    dl.PopTexture();
+    dl.AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+float SdfFont::addText(ImDrawList& dl, ImVec2 pos, float size, ImU32 col, std::string_view s) const {
+    const float k = size / baseSize_;
+    const float baseline = std::floor(pos.y + ascent_ * k + 0.5f);
+    const float clipRight = dl.GetClipRectMax().x;
+    float x = pos.x;
+    for (size_t i = 0; i < s.size();) {
+        const Glyph& g = glyph(decodeUtf8(s, i));
+        if (g.x1 > g.x0 && x < clipRight) {
+            dl.PrimReserve(6, 4);
+            dl.PrimRectUV(ImVec2(x + g.x0 * k, baseline + g.y0 * k), ImVec2(x + g.x1 * k, baseline + g.y1 * k),
+                          ImVec2(g.u0, g.v0), ImVec2(g.u1, g.v1), col);
+        }
+        x += g.advance * k;
+    }
+    return x - pos.x;
+}
+
+void SdfFont::beginCallback(const ImDrawList*, const ImDrawCmd* cmd) {
+    const SdfFont* f = static_cast<const SdfFont*>(cmd->UserCallbackData);
+    // Borrow the current program's projection and the current vertex/index buffers, so the same
+    // callback works inside the ImGui backend and inside LogPaneCache's offscreen pass.
+    GLint prog = 0, vbo = 0, ebo = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prog);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &vbo);
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &ebo);
+    float proj[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    const GLint loc = prog ? glGetUniformLocation((GLuint)prog, "ProjMtx") : -1;
+    if (loc >= 0) glGetUniformfv((GLuint)prog, loc, proj);
+
+    glUseProgram(f->program_);
+    glUniformMatrix4fv(f->locProj_, 1, GL_FALSE, proj);
+    glUniform1i(f->locTex_, 0);
+    glUniform1f(f->locDist_, (float)kOnEdge / kPadding / 255.0f);
+    glBindVertexArray(f->vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, (GLuint)ebo);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, pos));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, uv));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (void*)offsetof(ImDrawVert, col));
+}
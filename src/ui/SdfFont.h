@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "imgui.h"
+
+// --------- signed-distance-field font ----------
+// One single-channel atlas of distance fields, baked once from a TTF at a fixed base size, draws
+// text at any size: scaling only changes quad sizes, the edge is reconstructed per pixel by
+// shaders/sdf_fragment.glsl. DPI changes and zoom never rebuild or grow the atlas.
+// Text goes into an ordinary ImDrawList between begin() and end(): begin() queues a callback that
+// switches the renderer to the SDF program (reusing the bound vertex buffers and projection),
+// end() queues ImDrawCallback_ResetRenderState. Covers U+0020..U+00FF; controls draw as spaces and
+// anything else as '?'.
+// All GL work happens on the UI thread with the context current; release() before the context goes.
+class SdfFont {
+public:
+    SdfFont() = default;
+    SdfFont(const SdfFont&) = delete;
+    SdfFont& operator=(const SdfFont&) = delete;
+    ~SdfFont() { release(); }
+
+    // shaderDir holds sdf_vertex.glsl / sdf_fragment.glsl; returns false with err set on failure
+    bool load(const char* ttfPath, const char* shaderDir, std::string& err);
+    void release();
+    bool ready() const { return program_ != 0; }
+
+    float lineHeight(float size) const { return size; }   // size = ascent - descent in pixels
+    float measure(float size, std::string_view s) const;
+    size_t textureBytes() const { return (size_t)atlasW_ * atlasH_; }
+
+    void begin(ImDrawList& dl) const;
+    void end(ImDrawList& dl) const;
+    // pos = top-left of the line; returns the advance. Only valid between begin() and end().
+    float addText(ImDrawList& dl, ImVec2 pos, float size, ImU32 col, std::string_view s) const;
+
+private:
+    struct Glyph {
+        float x0{ 0 }, y0{ 0 }, x1{ 0 }, y1{ 0 };   // quad relative to pen/baseline, base-size pixels
+        float u0{ 0 }, v0{ 0 }, u1{ 0 }, v1{ 0 };
+        float advance{ 0 };
+    };
+    static constexpr uint32_t kFirst = 0x20, kLast = 0xFF;
+    static void beginCallback(const ImDrawList* parent, const ImDrawCmd* cmd);
+    const Glyph& glyph(uint32_t cp) const { return glyphs_[(cp < kFirst ? ' ' : cp <= kLast ? cp : '?') - kFirst]; }
+
+    std::vector<Glyph> glyphs_;
+    float baseSize_{ 0 }, ascent_{ 0 };   // base-size pixels
+    int atlasW_{ 0 }, atlasH_{ 0 };
+    unsigned tex_{ 0 }, program_{ 0 }, vao_{ 0 };
+    int locProj_{ -1 }, locTex_{ -1 }, locDist_{ -1 };
+};
@@ -0,0 +1,333 @@
+#include "ServerMap.h"
+#include "../vpn/ServerList.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+// dirty instances closer than this are sent as one glBufferSubData run (16 bytes each)
+static constexpr uint32_t kMergeGap = 32;
+
+static bool readFile(const std::string& path, std::string& out) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    std::fseek(f, 0, SEEK_END);
+    long n = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    out.resize(n > 0 ? (size_t)n : 0);
+    bool ok = n > 0 && std::fread(&out[0], 1, out.size(), f) == out.size();
+    std::fclose(f);
+    return ok;
+}
+
+static GLuint compile(GLenum type, const std::string& src, std::string& err) {
+    GLuint s = glCreateShader(type);
+    const char* p = src.c_str();
+    GLint len = (GLint)src.size();
+    glShaderSource(s, 1, &p, &len);
+    glCompileShader(s);
+    GLint ok = 0;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (ok) return s;
+    char log[512] = "";
+    glGetShaderInfoLog(s, sizeof(log), nullptr, log);
+    err = std::string("map shader: ") + log;
+    glDeleteShader(s);
+    return 0;
+}
+
+bool ServerMap::load(const char* shaderDir, std::string& err) {
+    release();
+    std::string vsSrc, fsSrc;
+    const std::string dir = shaderDir;
+    if (!readFile(dir + "/map_vertex.glsl", vsSrc) || !readFile(dir + "/map_fragment.glsl", fsSrc)) {
+        err = "cannot read map shaders from " + dir;
+        return false;
+    }
+    GLuint vs = compile(GL_VERTEX_SHADER, vsSrc, err), fs = vs ? compile(GL_FRAGMENT_SHADER, fsSrc, err) : 0;
+    GLuint prog = 0;
+    if (vs && fs) {
+        prog = glCreateProgram();
+        glAttachShader(prog, vs);
+        glAttachShader(prog, fs);
+        glLinkProgram(prog);
+        GLint ok = 0;
+        glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+        if (!ok) { glDeleteProgram(prog); prog = 0; err = "map shader: link failed"; }
+    }
+    if (vs) glDeleteShader(vs);
+    if (fs) glDeleteShader(fs);
+    if (!prog) return false;
+    program_ = prog;
+    locProj_ = glGetUniformLocation(program_, "ProjMtx");
+    locOrigin_ = glGetUniformLocation(program_, "Origin");
+    locScale_ = glGetUniformLocation(program_, "Scale");
+    locRadius_ = glGetUniformLocation(program_, "Radius");
+
+    // every attribute advances once per instance; the quad corners come from gl_VertexID
+    GLint lastVbo = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &lastVbo);
+    glGenVertexArrays(1, &vao_);
+    glGenBuffers(1, &vbo_);
+    glBindVertexArray(vao_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, x));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance), (void*)offsetof(Instance, color));
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(Instance), (void*)offsetof(Instance, flags));
+    glVertexAttribDivisor(0, 1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)lastVbo);
+    capacity_ = 0;
+    fullUpload_ = true;
+    return true;
+}
+
+void ServerMap::release() {
+    if (vbo_) glDeleteBuffers(1, &vbo_);
+    if (vao_) glDeleteVertexArrays(1, &vao_);
+    if (program_) glDeleteProgram(program_);
+    vbo_ = vao_ = program_ = 0;
+    capacity_ = 0;
+}
+
+void ServerMap::setServers(const std::vector<ServerEntry>& servers) {
+    const size_t n = servers.size();
+    inst_.assign(n, Instance{});
+    latency_.assign(n, std::numeric_limits<float>::quiet_NaN());
+    for (size_t i = 0; i < n; ++i) {
+        inst_[i].x = (servers[i].lon + 180.0f) / 180.0f;
+        inst_[i].y = (90.0f - servers[i].lat) / 180.0f;
+        inst_[i].color = latencyColor(latency_[i]);
+    }
+    dirty_.clear();
+    isDirty_.assign(n, 0);
+    fullUpload_ = true;
+    probed_ = reachable_ = 0;
+    selected_ = connected_ = hovered_ = kNone;
+
+    // bucket the markers into the grid (counting sort by cell)
+    auto cellOf = [](const Instance& in) {
+        int cx = std::min(std::max((int)(in.x * kGridH), 0), kGridW - 1);
+        int cy = std::min(std::max((int)(in.y * kGridH), 0), kGridH - 1);
+        return (size_t)cy * kGridW + cx;
+    };
+    cellStart_.assign((size_t)kGridW * kGridH + 1, 0);
+    for (const Instance& in : inst_) ++cellStart_[cellOf(in) + 1];
+    for (size_t c = 1; c < cellStart_.size(); ++c) cellStart_[c] += cellStart_[c - 1];
+    cellItems_.resize(n);
+    std::vector<uint32_t> fill(cellStart_.begin(), cellStart_.end() - 1);
+    for (size_t i = 0; i < n; ++i) cellItems_[fill[cellOf(inst_[i])]++] = (uint32_t)i;
+}
+
+void ServerMap::setLatency(uint32_t i, float ms) {
+    if (i >= inst_.size()) return;
+    const float prev = latency_[i];
+    if (prev == ms) return;
+    if (std::isnan(prev)) ++probed_;
+    else if (prev >= 0) --reachable_;
+    if (ms >= 0) ++reachable_;
+    latency_[i] = ms;
+    const ImU32 col = latencyColor(ms);
+    if (inst_[i].color == col) return;   // same colour band: nothing to upload
+    inst_[i].color = col;
+    markDirty(i);
+}
+
+void ServerMap::setSelected(uint32_t i) {
+    if (i >= inst_.size()) i = kNone;
+    if (selected_ != kNone) setFlag(selected_, 1, false);
+    selected_ = i;
+    if (i != kNone) setFlag(i, 1, true);
+}
+
+void ServerMap::setConnected(uint32_t i) {
+    if (i >= inst_.size()) i = kNone;
+    if (connected_ == i) return;
+    if (connected_ != kNone) setFlag(connected_, 2, false);
+    connected_ = i;
+    if (i != kNone) setFlag(i, 2, true);
+}
+
+void ServerMap::setFlag(uint32_t i, uint32_t flag, bool on) {
+    const uint32_t f = on ? inst_[i].flags | flag : inst_[i].flags & ~flag;
+    if (f == inst_[i].flags) return;
+    inst_[i].flags = f;
+    markDirty(i);
+}
+
+void ServerMap::markDirty(uint32_t i) {
+    if (fullUpload_ || isDirty_[i]) return;
+    isDirty_[i] = 1;
+    dirty_.push_back(i);
+}
+
+ImU32 ServerMap::latencyColor(float ms) {
+    if (std::isnan(ms)) return IM_COL32(130, 136, 145, 200);   // not probed yet
+    if (ms < 0) return IM_COL32(120, 40, 45, 220);              // unreachable
+    // 8 bands from green (< 40 ms) through yellow to red (> 300 ms); banding keeps small jitter
+    // from re-uploading an instance whose colour would not visibly change
+    static const ImU32 kBands[] = {
+        IM_COL32(60, 200, 100, 255), IM_COL32(110, 210, 90, 255), IM_COL32(170, 215, 80, 255), IM_COL32(225, 210, 70, 255),
+        IM_COL32(240, 170, 60, 255), IM_COL32(240, 130, 55, 255), IM_COL32(235, 90, 55, 255), IM_COL32(220, 55, 55, 255),
+    };
+    static const float kLimits[] = { 40, 70, 100, 150, 200, 250, 300 };
+    int b = 0;
+    while (b < 7 && ms >= kLimits[b]) ++b;
+    return kBands[b];
+}
+
+uint32_t ServerMap::pick(ImVec2 p, float r) const {
+    if (inst_.empty()) return kNone;
+    const float cell = 1.0f / kGridH;
+    const int cx0 = std::max((int)std::floor((p.x - r) / cell), 0), cx1 = std::min((int)std::floor((p.x + r) / cell), kGridW - 1);
+    const int cy0 = std::max((int)std::floor((p.y - r) / cell), 0), cy1 = std::min((int)std::floor((p.y + r) / cell), kGridH - 1);
+    uint32_t best = kNone;
+    float bestD = r * r;
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const size_t c = (size_t)cy * kGridW + cx;
+            for (uint32_t k = cellStart_[c]; k < cellStart_[c + 1]; ++k) {
+                const Instance& in = inst_[cellItems_[k]];
+                const float dx = in.x - p.x, dy = in.y - p.y, d = dx * dx + dy * dy;
+                if (d <= bestD) { bestD = d; best = cellItems_[k]; }
+            }
+        }
+    return best;
+}
+
+bool ServerMap::draw(ImVec2 size) {
+    ImGuiIO& io = ImGui::GetIO();
+    size.x = std::max(size.x, 64.0f);
+    size.y = std::max(size.y, 32.0f);
+    const ImVec2 p0 = ImGui::GetCursorScreenPos(), p1(p0.x + size.x, p0.y + size.y);
+    const ImVec2 mid(p0.x + size.x * 0.5f, p0.y + size.y * 0.5f);
+    ImGui::InvisibleButton("##servermap", size);
+    const bool hot = ImGui::IsItemHovered();
+    const float fit = std::min(size.x * 0.5f, size.y);   // the map is 2 x 1 units
+
+    if (ImGui::IsItemActive() && ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+        center_.x -= io.MouseDelta.x / (fit * zoom_);
+        center_.y -= io.MouseDelta.y / (fit * zoom_);
+    }
+    if (hot && io.MouseWheel != 0) {   // keep the point under the mouse in place
+        const float s = fit * zoom_;
+        const ImVec2 m(center_.x + (io.MousePos.x - mid.x) / s, center_.y + (io.MousePos.y - mid.y) / s);
+        zoom_ = std::min(std::max(zoom_ * std::pow(1.25f, io.MouseWheel), 1.0f), 256.0f);
+        const float s2 = fit * zoom_;
+        center_ = ImVec2(m.x - (io.MousePos.x - mid.x) / s2, m.y - (io.MousePos.y - mid.y) / s2);
+    }
+    scale_ = fit * zoom_;
+    const float halfW = size.x * 0.5f / scale_, halfH = size.y * 0.5f / scale_;
+    center_.x = halfW >= 1.0f ? 1.0f : std::min(std::max(center_.x, halfW), 2.0f - halfW);
+    center_.y = halfH >= 0.5f ? 0.5f : std::min(std::max(center_.y, halfH), 1.0f - halfH);
+    origin_ = ImVec2(mid.x - center_.x * scale_, mid.y - center_.y * scale_);
+    radius_ = std::min(3.0f + std::log2(zoom_), 8.0f);
+
+    hovered_ = kNone;
+    if (hot) hovered_ = pick(ImVec2((io.MousePos.x - origin_.x) / scale_, (io.MousePos.y - origin_.y) / scale_),
+                             (radius_ + 2.0f) / scale_);
+    bool changed = false;
+    const float slop = io.MouseDragThreshold;
+    if (hot && ImGui::IsMouseReleased(ImGuiMouseButton_Left) && io.MouseDragMaxDistanceSqr[0] < slop * slop
+        && hovered_ != selected_) {
+        setSelected(hovered_);
+        changed = true;
+    }
+
+    // background: ocean and a 30 degree graticule, equator and prime meridian brighter
+    ImDrawList* dl = ImGui::GetWindowDrawList();
+    dl->PushClipRect(p0, p1, true);
+    const ImVec2 m0 = origin_, m1(origin_.x + 2.0f * scale_, origin_.y + scale_);
+    dl->AddRectFilled(p0, p1, IM_COL32(12, 15, 20, 255));
+    dl->AddRectFilled(m0, m1, IM_COL32(18, 32, 50, 255));
+    for (int lon = -150; lon <= 150; lon += 30) {
+        const float x = origin_.x + (lon + 180) / 180.0f * scale_;
+        dl->AddLine(ImVec2(x, m0.y), ImVec2(x, m1.y), lon ? IM_COL32(50, 70, 95, 255) : IM_COL32(80, 105, 135, 255));
+    }
+    for (int lat = -60; lat <= 60; lat += 30) {
+        const float y = origin_.y + (90 - lat) / 180.0f * scale_;
+        dl->AddLine(ImVec2(m0.x, y), ImVec2(m1.x, y), lat ? IM_COL32(50, 70, 95, 255) : IM_COL32(80, 105, 135, 255));
+    }
+
+    if (!inst_.empty() && ready()) {
+        dl->AddCallback(&ServerMap::renderCallback, this);
+        dl->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+    }
+    else {   // no shaders: one circle per visible marker
+        for (const Instance& in : inst_) {
+            const ImVec2 c(origin_.x + in.x * scale_, origin_.y + in.y * scale_);
+            if (c.x < p0.x - 8 || c.x > p1.x + 8 || c.y < p0.y - 8 || c.y > p1.y + 8) continue;
+            dl->AddCircleFilled(c, radius_, in.color, 8);
+            if (in.flags & 2) dl->AddCircle(c, radius_ * 1.25f, IM_COL32(77, 255, 115, 255), 12, radius_ * 0.3f);
+            if (in.flags & 1) dl->AddCircle(c, radius_ * 1.6f, IM_COL32_WHITE, 12, radius_ * 0.3f);
+        }
+    }
+    if (hovered_ != kNone) {
+        const Instance& in = inst_[hovered_];
+        dl->AddCircle(ImVec2(origin_.x + in.x * scale_, origin_.y + in.y * scale_), radius_ * 2.0f + 2.0f,
+                      IM_COL32(255, 255, 255, 160), 16, 1.5f);
+    }
+    dl->PopClipRect();
+    return changed;
+}
+
+void ServerMap::upload() {
+    uploaded_ = 0;
+    const size_t n = inst_.size();
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    if (capacity_ < n) {
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(n * sizeof(Instance)), inst_.data(), GL_DYNAMIC_DRAW);
+        capacity_ = n;
+        uploaded_ = n * sizeof(Instance);
+    }
+    else if (fullUpload_ || dirty_.size() * 4 > n) {   // mostly dirty anyway: one contiguous copy
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)(n * sizeof(Instance)), inst_.data());
+        uploaded_ = n * sizeof(Instance);
+    }
+    else if (!dirty_.empty()) {
+        std::sort(dirty_.begin(), dirty_.end());
+        for (size_t k = 0; k < dirty_.size();) {
+            uint32_t lo = dirty_[k], hi = lo + 1;
+            while (++k < dirty_.size() && dirty_[k] <= hi + kMergeGap) hi = dirty_[k] + 1;
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(lo * sizeof(Instance)), (GLsizeiptr)((hi - lo) * sizeof(Instance)),
+                            inst_.data() + lo);
+            uploaded_ += (hi - lo) * sizeof(Instance);
+        }
+    }
+    for (uint32_t i : dirty_) isDirty_[i] = 0;
+    dirty_.clear();
+    fullUpload_ = false;
+}
+
+void ServerMap::renderCallback(const ImDrawList*, const ImDrawCmd* cmd) {
+    ServerMap* m = static_cast<ServerMap*>(cmd->UserCallbackData);
+    // the backend does not set a scissor for callbacks: clip to the canvas ourselves
+    const ImDrawData* dd = ImGui::GetDrawData();
+    const ImVec2 fs = dd->FramebufferScale;
+    const float fbH = dd->DisplaySize.y * fs.y;
+    const float x0 = (cmd->ClipRect.x - dd->DisplayPos.x) * fs.x, y0 = (cmd->ClipRect.y - dd->DisplayPos.y) * fs.y;
+    const float x1 = (cmd->ClipRect.z - dd->DisplayPos.x) * fs.x, y1 = (cmd->ClipRect.w - dd->DisplayPos.y) * fs.y;
+    if (x1 <= x0 || y1 <= y0) return;
+    glScissor((GLint)x0, (GLint)(fbH - y1), (GLsizei)(x1 - x0), (GLsizei)(y1 - y0));
+
+    GLint prog = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prog);
+    float proj[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+    const GLint loc = prog ? glGetUniformLocation((GLuint)prog, "ProjMtx") : -1;
+    if (loc >= 0) glGetUniformfv((GLuint)prog, loc, proj);
+
+    m->upload();
+    glUseProgram(m->program_);
+    glUniformMatrix4fv(m->locProj_, 1, GL_FALSE, proj);
+    glUniform2f(m->locOrigin_, m->origin_.x, m->origin_.y);
+    glUniform1f(m->locScale_, m->scale_);
+    glUniform1f(m->locRadius_, m->radius_);
+    glBindVertexArray(m->vao_);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m->inst_.size());
+}
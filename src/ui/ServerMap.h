@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "imgui.h"
+
+struct ServerEntry;
+
+// --------- server map (instanced markers) ----------
+// Thousands of endpoints on an equirectangular world map. Every marker is one instance of a
+// 4-vertex strip in a single glDrawArraysInstanced, issued from a draw callback inside the map
+// window; shaders/map_vertex.glsl expands the quad, shaders/map_fragment.glsl draws the dot and the
+// selected/connected rings. The per-instance buffer (position, latency colour, flags) is uploaded
+// once by setServers(); later changes mark single instances dirty and only the touched runs are
+// re-sent with glBufferSubData when the frame renders.
+// Hover picking goes through a uniform grid over the map, so it checks a few cells instead of
+// every server. All GL work happens on the UI thread with the context current.
+class ServerMap {
+public:
+    static constexpr uint32_t kNone = ~0u;
+
+    ServerMap() = default;
+    ServerMap(const ServerMap&) = delete;
+    ServerMap& operator=(const ServerMap&) = delete;
+    ~ServerMap() { release(); }
+
+    // shaderDir holds map_vertex.glsl / map_fragment.glsl; without them markers are drawn as
+    // ImDrawList circles (same picking, one draw per marker)
+    bool load(const char* shaderDir, std::string& err);
+    void release();
+    bool ready() const { return program_ != 0; }
+
+    void setServers(const std::vector<ServerEntry>& servers);   // resets latency and selection
+    void setLatency(uint32_t i, float ms);                       // ms < 0 = unreachable
+    void setSelected(uint32_t i);                                // kNone clears
+    void setConnected(uint32_t i);
+    uint32_t selected() const { return selected_; }
+    uint32_t connected() const { return connected_; }
+    uint32_t hovered() const { return hovered_; }                // last draw(), kNone = none
+    float latency(uint32_t i) const { return latency_[i]; }      // NaN until the first probe
+    size_t size() const { return inst_.size(); }
+    size_t probed() const { return probed_; }
+    size_t reachable() const { return reachable_; }
+    size_t bytesUploaded() const { return uploaded_; }           // by the last rendered frame
+
+    // Canvas of `size` at the cursor: drag pans, the wheel zooms at the mouse, a click selects
+    // the marker under it (or clears the selection). Returns true when a click changed the selection.
+    bool draw(ImVec2 size);
+
+private:
+    struct Instance {            // matches the attribute layout in load()
+        float x{ 0 }, y{ 0 };    // map units: x 0..2 west to east, y 0..1 north to south
+        uint32_t color{ 0 };     // ImU32 (RGBA bytes)
+        uint32_t flags{ 0 };     // 1 = selected, 2 = connected
+    };
+    static constexpr int kGridW = 128, kGridH = 64;   // square cells of 1/64 map unit
+
+    static void renderCallback(const ImDrawList* parent, const ImDrawCmd* cmd);
+    static ImU32 latencyColor(float ms);
+    uint32_t pick(ImVec2 p, float r) const;   // nearest marker within r map units of p
+    void setFlag(uint32_t i, uint32_t flag, bool on);
+    void markDirty(uint32_t i);
+    void upload();
+
+    std::vector<Instance> inst_;
+    std::vector<float> latency_;
+    std::vector<uint32_t> cellStart_, cellItems_;   // grid as CSR: items of cell c = [start[c], start[c+1])
+    std::vector<uint32_t> dirty_;                   // instances changed since the last upload
+    std::vector<uint8_t> isDirty_;
+    bool fullUpload_{ true };
+    size_t probed_{ 0 }, reachable_{ 0 }, uploaded_{ 0 };
+    uint32_t selected_{ kNone }, connected_{ kNone }, hovered_{ kNone };
+
+    ImVec2 center_{ 1.0f, 0.5f };   // view centre in map units
+    float zoom_{ 1.0f };            // 1 = whole map fits the canvas
+    ImVec2 origin_{ 0, 0 };         // this frame: screen position of map (0,0), read by the callback
+    float scale_{ 1 }, radius_{ 4 };
+
+    unsigned program_{ 0 }, vao_{ 0 }, vbo_{ 0 };
+    size_t capacity_{ 0 };          // instances the GL buffer holds
+    int locProj_{ -1 }, locOrigin_{ -1 }, locScale_{ -1 }, locRadius_{ -1 };
+};
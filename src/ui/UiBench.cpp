@@ -0,0 +1,161 @@
+#include "UiBench.h"
+#include "Panels.h"
+#include "imgui.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "../core/AllocProfiler.h"
+#include "../core/FrameArena.h"
+#include "../core/HdrHistogram.h"
+#include "../log/LogIngest.h"
+#include "../log/LogStore.h"
+#include "../net/LatencyMonitor.h"
+#include "../vpn/ProcessMonitor.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+int64_t nsSince(Clock::time_point t0) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count();
+}
+
+// Stands in for the renderer backend: every texture request succeeds without touching a GPU
+void acceptTextures(ImDrawData* dd) {
+    if (!dd->Textures) return;
+    for (ImTextureData* tex : *dd->Textures) {
+        switch (tex->Status) {
+        case ImTextureStatus_WantCreate: tex->SetTexID((ImTextureID)1); tex->SetStatus(ImTextureStatus_OK); break;
+        case ImTextureStatus_WantUpdates: tex->SetStatus(ImTextureStatus_OK); break;
+        case ImTextureStatus_WantDestroy: tex->SetTexID(ImTextureID_Invalid); tex->SetStatus(ImTextureStatus_Destroyed); break;
+        default: break;
+        }
+    }
+}
+
+// OpenVPN-looking lines: a handful of templates with changing numbers, like a busy tunnel at verb 4
+void fillLogs(uint64_t n, LogStore& store, LogBuffer& view) {
+    static const char* fmt[] = {
+        "%llu us=%u TLS: soft reset sec=3600/3600 bytes=%u/-1 pkts=%u/0",
+        "%llu us=%u Data Channel: cipher 'AES-256-GCM', peer-id: %u",
+        "%llu us=%u UDPv4 read [%u] from [AF_INET]185.%u.7.3:1194: P_DATA_V2",
+        "%llu us=%u MANAGEMENT: >BYTECOUNT:%u,%u",
+        "%llu us=%u PUSH: Received control message: 'PUSH_REPLY,route-gateway 10.8.%u.1,ping 10,ping-restart %u'",
+    };
+    char line[256];
+    int64_t t = LogIngest::nowNs();
+    uint32_t x = 12345;
+    for (uint64_t i = 0; i < n; ++i) {
+        x = x * 1664525u + 1013904223u;
+        std::snprintf(line, sizeof(line), fmt[(x >> 24) % 5], (unsigned long long)(1700000000 + i / 50),
+            x % 1000000, x >> 8 & 0xFFFF, x >> 4 & 0xFF);
+        t += 20000 + (x & 0xFFFF);
+        uint32_t tid = 0;
+        uint64_t idx = store.append(line, t, &tid);
+        view.push(idx, tid);
+    }
+}
+
+void fillStats(std::vector<LatencyStats>& lat, std::vector<ProcessSeries>& procs, IngestStats& ingest) {
+    static const char* names[] = { "cloudflare", "google", "gateway", "dns-1", "dns-2", "echo-tcp", "echo-udp", "peer" };
+    lat.clear();
+    for (int i = 0; i < 8; ++i) {
+        LatencyStats s;
+        s.name = names[i];
+        s.lastOk = i != 3;
+        s.sent = 1000 + i; s.lost = i;
+        s.lastMs = 10.0 + i; s.p50Ms = 9.0 + i; s.p95Ms = 20.0 + i; s.p99Ms = 40.0 + i; s.jitterMs = 0.5 * i;
+        s.sloBreached = i == 2;
+        lat.push_back(s);
+    }
+    procs.assign(3, ProcessSeries{});
+    for (size_t p = 0; p < procs.size(); ++p) {
+        ProcessSeries& s = procs[p];
+        s.pid = 4000 + (uint32_t)p; s.parentPid = p ? 4000 : 1; s.alive = true;
+        s.name = p ? "netsh.exe" : "openvpn.exe";
+        s.cpuPct = 3.5; s.rssMb = 24.0; s.privateMb = 18.0; s.cswPerSec = 400; s.handles = 220; s.threads = 6;
+        for (size_t k = 0; k < ProcessSeries::kHistory; ++k) {
+            s.cpu[k] = (float)(k % 17); s.rss[k] = 20.0f + (float)(k % 5); s.hnd[k] = 200.0f + (float)(k % 9); s.csw[k] = (float)(k * 3 % 500);
+        }
+        s.count = ProcessSeries::kHistory;
+    }
+    ingest.lastUs = 120; ingest.avgUs = 100; ingest.maxUs = 900; ingest.lastLines = 40; ingest.lastShown = 40;
+    ingest.budget = 200;
+}
+} // namespace
+
+int UiBench::Run(const UiBenchOptions& opt) {
+    IMGUI_CHECKVERSION();
+    AllocProfiler::installImGuiHooks();
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1600, 900);
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    io.BackendRendererName = "ui-bench (no GPU)";
+    ImGui::StyleColorsDark();
+
+    std::vector<LatencyStats> lat;
+    std::vector<ProcessSeries> procs;
+    IngestStats ingest;
+    fillStats(lat, procs, ingest);
+    VerbosityControls verb;
+    verb.available = true;
+    ExportControls exportUi;
+    ProcessLimits limits;
+    bool autoRestart = false;
+    FrameArena arena;
+
+    std::printf("%10s %8s %9s %9s %9s %9s %9s %9s %8s %8s %7s %8s\n", "lines", "fill_s", "p50_us", "p95_us", "max_us",
+        "new_us", "draw_us", "rend_us", "vtx", "idx", "allocs", "store_MB");
+    for (uint64_t n : opt.sizes) {
+        LogStore store((size_t)4 << 30);   // no eviction: the point is to see the cost of a big store
+        LogBuffer view;
+        auto t0 = Clock::now();
+        fillLogs(n, store, view);
+        double fillS = nsSince(t0) / 1e9;
+
+        HdrHistogram frameUs(10ull * 1000 * 1000);
+        int64_t newNs = 0, drawNs = 0, renderNs = 0;
+        uint64_t allocs = 0;
+        int vtx = 0, idx = 0;
+        for (int f = 0; f < opt.warmupFrames + opt.frames; ++f) {
+            const bool measured = f >= opt.warmupFrames;
+            io.DeltaTime = 1.0f / 60.0f;
+            arena.reset();
+            AllocProfiler::beginFrame();
+            auto a = Clock::now();
+            ImGui::NewFrame();
+            auto b = Clock::now();
+            UiPanels::DrawUI();
+            UiPanels::DrawVpnControls(true, [] {}, [] {});
+            UiPanels::DrawVerbosity(verb);
+            UiPanels::DrawLatency(lat);
+            UiPanels::DrawLogExport(exportUi);
+            ImGui::SetNextWindowPos(ImVec2(420, 20), ImGuiCond_Always);
+            ImGui::SetNextWindowSize(ImVec2(1150, 860), ImGuiCond_Always);
+            UiPanels::DrawLogs(view, store, ingest, arena);
+            UiPanels::DrawProcessMonitor(procs, 0, limits, autoRestart);
+            auto c = Clock::now();
+            ImGui::Render();
+            auto d = Clock::now();
+            acceptTextures(ImGui::GetDrawData());
+            const AllocFrame& af = AllocProfiler::endFrame();
+            if (!measured) continue;
+            newNs += std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+            drawNs += std::chrono::duration_cast<std::chrono::nanoseconds>(c - b).count();
+            renderNs += std::chrono::duration_cast<std::chrono::nanoseconds>(d - c).count();
+            frameUs.record((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(d - a).count());
+            allocs += af.frameAllocs;
+            vtx = ImGui::GetDrawData()->TotalVtxCount;
+            idx = ImGui::GetDrawData()->TotalIdxCount;
+        }
+        const double frames = opt.frames > 0 ? opt.frames : 1;
+        std::printf("%10llu %8.2f %9llu %9llu %9llu %9.1f %9.1f %9.1f %8d %8d %7.1f %8.1f\n", (unsigned long long)n, fillS,
+            (unsigned long long)frameUs.percentile(50), (unsigned long long)frameUs.percentile(95),
+            (unsigned long long)frameUs.max(), newNs / frames / 1e3, drawNs / frames / 1e3, renderNs / frames / 1e3, vtx, idx,
+            allocs / frames, store.bytes() / 1048576.0);
+        std::fflush(stdout);
+    }
+    ImGui::DestroyContext();
+    return 0;
+}
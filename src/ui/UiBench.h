@@ -0,0 +1,19 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// --------- headless UI benchmark (--ui-bench) ----------
+// Runs the real panels in an ImGui context with no GLFW/OpenGL backend: a dummy renderer accepts the
+// font atlas texture requests, so it works on CI machines without a GPU or display. For each data
+// size the store and view are filled with synthetic lines, then NewFrame -> Draw* -> Render is timed
+// and the generated vertex/index counts and heap allocations per frame are reported.
+struct UiBenchOptions {
+    std::vector<uint64_t> sizes{ 1000, 10000, 100000, 1000000, 10000000 };   // log lines
+    int warmupFrames{ 30 };
+    int frames{ 300 };
+};
+
+class UiBench {
+public:
+    static int Run(const UiBenchOptions& opt);   // prints one row per size to stdout; returns exit code
+};
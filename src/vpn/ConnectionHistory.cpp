@@ -0,0 +1,241 @@
+#include "ConnectionHistory.h"
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HISTORY_SSE2 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const char* const kColumnFiles[] = {
+    "start.u32", "stop.u32", "connect.u32", "in.u64", "out.u64", "reconnects.u32", "profile.u32", "remote.u32", "exit.u32",
+};
+static constexpr uint32_t kNone = 0xFFFFFFFFu;
+static constexpr uint64_t kMaxConnectMs = 10ull * 60 * 1000;   // histogram range; slower connects count as 10 min
+
+static inline int lowestBit(uint32_t v) {
+#if defined(_MSC_VER)
+    unsigned long idx = 0; _BitScanForward(&idx, v); return (int)idx;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+static uint32_t stored(int64_t unix) {
+    return (uint32_t)std::clamp<int64_t>(unix - ConnectionHistory::kEpoch, 0, 0xFFFFFFFFll);
+}
+
+template <typename T>
+static void readColumn(const fs::path& path, std::vector<T>& v) {
+    v.clear();
+    std::FILE* f = std::fopen(path.string().c_str(), "rb");
+    if (!f) return;
+    std::error_code ec;
+    const uintmax_t bytes = fs::file_size(path, ec);
+    if (!ec) {
+        v.resize((size_t)(bytes / sizeof(T)));
+        v.resize(std::fread(v.data(), sizeof(T), v.size(), f));
+    }
+    std::fclose(f);
+}
+
+template <typename F>
+void ConnectionHistory::forEachColumn(F&& f) {
+    f(kStart, start_); f(kStop, stop_); f(kConnect, connect_); f(kIn, in_); f(kOut, out_);
+    f(kReconnects, reconnects_); f(kProfile, profile_); f(kRemote, remote_); f(kExit, exit_);
+}
+
+bool ConnectionHistory::open(const std::string& dir, std::string& err) {
+    close();
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+    if (ec) { err = "cannot create " + dir + ": " + ec.message(); return false; }
+    const fs::path root(dir);
+
+    // dictionary: a line cut off by a crash was never referred to
+    const fs::path dictPath = root / "strings.dict";
+    std::string text;
+    if (std::FILE* f = std::fopen(dictPath.string().c_str(), "rb")) {
+        char buf[65536];
+        for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0;) text.append(buf, n);
+        std::fclose(f);
+    }
+    size_t at = 0;
+    for (size_t eol; (eol = text.find('\n', at)) != std::string::npos; at = eol + 1) {
+        ids_.emplace(text.substr(at, eol - at), (uint32_t)names_.size());
+        names_.push_back(text.substr(at, eol - at));
+    }
+    if (at < text.size()) fs::resize_file(dictPath, at, ec);
+    dictBytes_ = at;
+
+    // columns: keep the rows all of them have. The byte size decides, not the element count: a torn
+    // last element would otherwise stay and put every later append at the wrong offset.
+    size_t rows = SIZE_MAX;
+    forEachColumn([&](Column c, auto& v) { readColumn(root / kColumnFiles[c], v); rows = std::min(rows, v.size()); });
+    forEachColumn([&](Column c, auto& v) {
+        v.resize(rows);
+        const fs::path path = root / kColumnFiles[c];
+        const uintmax_t bytes = fs::file_size(path, ec);
+        if (!ec && bytes != rows * sizeof(v[0])) fs::resize_file(path, rows * sizeof(v[0]), ec);
+    });
+
+    dir_ = dir;
+    if (!openFiles()) { err = "cannot write to " + dir; close(); return false; }
+    return true;
+}
+
+bool ConnectionHistory::openFiles() {
+    const fs::path root(dir_);
+    dict_ = std::fopen((root / "strings.dict").string().c_str(), "ab");
+    for (int c = 0; c < kColumns && dict_; ++c) {
+        files_[c] = std::fopen((root / kColumnFiles[c]).string().c_str(), "ab");
+        if (!files_[c]) return false;
+    }
+    return dict_ != nullptr;
+}
+
+// Drops the rows from `rows` on and the strings from `names` on, in memory and on disk. The handles are
+// closed first, so nothing still buffered from the failed write can land after the cut.
+void ConnectionHistory::rollback(size_t rows, size_t names, uint64_t dictBytes) {
+    for (std::FILE*& f : files_)
+        if (f) { std::fclose(f); f = nullptr; }
+    std::fclose(dict_);
+    dict_ = nullptr;
+    std::error_code ec;
+    const fs::path root(dir_);
+    forEachColumn([&](Column c, auto& v) {
+        v.resize(rows);
+        fs::resize_file(root / kColumnFiles[c], rows * sizeof(v[0]), ec);
+    });
+    fs::resize_file(root / "strings.dict", dictBytes, ec);
+    for (size_t i = names; i < names_.size(); ++i) ids_.erase(names_[i]);
+    names_.resize(names);
+    dictBytes_ = dictBytes;
+    if (!openFiles()) close();
+}
+
+void ConnectionHistory::close() {
+    for (std::FILE*& f : files_)
+        if (f) { std::fclose(f); f = nullptr; }
+    if (dict_) { std::fclose(dict_); dict_ = nullptr; }
+    names_.clear();
+    ids_.clear();
+    dictBytes_ = 0;
+    forEachColumn([](Column, auto& v) { v.clear(); });
+}
+
+uint32_t ConnectionHistory::intern(const std::string& s) {
+    std::string line = s;
+    std::replace(line.begin(), line.end(), '\n', ' ');   // one string per line
+    std::replace(line.begin(), line.end(), '\r', ' ');
+    auto it = ids_.find(line);
+    if (it != ids_.end()) return it->second;
+    const uint32_t id = (uint32_t)names_.size();
+    line += '\n';
+    std::fwrite(line.data(), 1, line.size(), dict_);
+    dictBytes_ += line.size();
+    line.pop_back();
+    ids_.emplace(line, id);
+    names_.push_back(std::move(line));
+    return id;
+}
+
+bool ConnectionHistory::append(const HistorySession* sessions, size_t count) {
+    if (!isOpen()) return false;
+    const size_t first = size(), names = names_.size();
+    const uint64_t dictBytes = dictBytes_;
+    for (size_t i = 0; i < count; ++i) {
+        const HistorySession& s = sessions[i];
+        start_.push_back(stored(s.startUnix));
+        stop_.push_back(stored(s.stopUnix));
+        connect_.push_back(s.connectMs < 0 ? kNoConnect : (uint32_t)std::min<int64_t>(s.connectMs, kNoConnect - 1));
+        in_.push_back(s.bytesIn);
+        out_.push_back(s.bytesOut);
+        reconnects_.push_back(s.reconnects);
+        profile_.push_back(intern(s.profile));
+        remote_.push_back(intern(s.remote));
+        exit_.push_back(intern(s.exitReason));
+    }
+    bool ok = std::fflush(dict_) == 0;   // the strings land before the rows that use them
+    forEachColumn([&](Column c, auto& v) {
+        ok &= std::fwrite(v.data() + first, sizeof(v[0]), count, files_[c]) == count && std::fflush(files_[c]) == 0;
+    });
+    if (!ok) rollback(first, names, dictBytes);
+    return ok;
+}
+
+void ConnectionHistory::session(size_t row, HistorySession& out) const {
+    out.startUnix = kEpoch + start_[row];
+    out.stopUnix = kEpoch + stop_[row];
+    out.connectMs = connect_[row] == kNoConnect ? -1 : (int64_t)connect_[row];
+    out.bytesIn = in_[row];
+    out.bytesOut = out_[row];
+    out.reconnects = reconnects_[row];
+    out.profile = name(profile_[row]);
+    out.remote = name(remote_[row]);
+    out.exitReason = name(exit_[row]);
+}
+
+template <typename F>
+void ConnectionHistory::forEachSince(uint32_t since, F&& f) const {
+    const uint32_t* t = start_.data();
+    const size_t n = start_.size();
+    size_t i = 0;
+#ifdef HISTORY_SSE2
+    // SSE2 only compares signed lanes: flipping the sign bit of both sides orders them as unsigned
+    const __m128i bias = _mm_set1_epi32((int)0x80000000u);
+    const __m128i limit = _mm_xor_si128(_mm_set1_epi32((int)since), bias);
+    auto before = [&](size_t at) {
+        const __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(t + at)), bias);
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(v, limit)));
+    };
+    for (; i + 16 <= n; i += 16) {   // older sessions, one branch per 16 rows
+        if ((before(i) & before(i + 4) & before(i + 8) & before(i + 12)) != 0xF) break;
+    }
+    for (; i + 4 <= n; i += 4) {
+        for (uint32_t m = ~(uint32_t)before(i) & 0xF; m; m &= m - 1) f(i + lowestBit(m));
+    }
+#endif
+    for (; i < n; ++i)
+        if (t[i] >= since) f(i);
+}
+
+void ConnectionHistory::aggregate(int64_t sinceUnix, HistoryKey by, std::vector<HistoryGroup>& out) const {
+    out.clear();
+    const std::vector<uint32_t>& keys = by == HistoryKey::Remote ? remote_ : by == HistoryKey::Profile ? profile_ : exit_;
+    const uint32_t unknown = (uint32_t)names_.size();   // ids past the dictionary share one group
+    groupOf_.assign(names_.size() + 1, kNone);
+    forEachSince(stored(sinceUnix), [&](size_t i) {
+        const uint32_t key = std::min(keys[i], unknown);
+        uint32_t& g = groupOf_[key];
+        if (g == kNone) {
+            g = (uint32_t)out.size();
+            out.emplace_back();
+            out.back().key = key;
+            if (connectMs_.size() < out.size()) connectMs_.emplace_back(kMaxConnectMs);
+            else connectMs_[g].reset();
+        }
+        HistoryGroup& h = out[g];
+        ++h.sessions;
+        h.reconnects += reconnects_[i];
+        h.seconds += stop_[i] > start_[i] ? stop_[i] - start_[i] : 0;
+        h.bytesIn += in_[i];
+        h.bytesOut += out_[i];
+        if (connect_[i] != kNoConnect) {
+            ++h.connected;
+            connectMs_[g].record(connect_[i]);
+        }
+    });
+    for (size_t g = 0; g < out.size(); ++g) {
+        out[g].p50Ms = (double)connectMs_[g].percentile(50);
+        out[g].p95Ms = (double)connectMs_[g].percentile(95);
+    }
+    std::sort(out.begin(), out.end(), [](const HistoryGroup& a, const HistoryGroup& b) {
+        return a.sessions != b.sessions ? a.sessions > b.sessions : a.key < b.key;
+    });
+}
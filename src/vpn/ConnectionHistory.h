@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "../core/HdrHistogram.h"
+
+// --------- connection history ----------
+// One row per finished tunnel session, stored column by column in a directory of append-only files,
+// so a query reads only the columns it needs and scans them as flat arrays:
+//   start.u32, stop.u32     seconds since 2020-01-01 UTC (unsigned: good until 2156)
+//   connect.u32             ms from start to the first CONNECTED, kNoConnect = never connected / unknown
+//   in.u64, out.u64         bytes through the tunnel
+//   reconnects.u32
+//   profile.u32, remote.u32, exit.u32   ids into strings.dict: one UTF-8 string per line, id = line number
+// The dictionary is written before the rows that refer to it. A crash between column writes leaves
+// columns of different lengths, or a torn last element; open() keeps the rows every column has and
+// cuts every file back to exactly that. A failed append is rolled back the same way.
+struct HistorySession {
+    int64_t startUnix{ 0 }, stopUnix{ 0 };
+    int64_t connectMs{ -1 };          // -1 = never connected, or unknown (re-attached tunnel)
+    uint64_t bytesIn{ 0 }, bytesOut{ 0 };
+    uint32_t reconnects{ 0 };
+    std::string profile, remote, exitReason;
+};
+
+enum class HistoryKey { Remote, Profile, ExitReason };
+
+// Aggregate over the sessions that share one key
+struct HistoryGroup {
+    uint32_t key{ 0 };                // dictionary id, see ConnectionHistory::name()
+    uint32_t sessions{ 0 }, connected{ 0 };
+    uint64_t reconnects{ 0 };
+    uint64_t seconds{ 0 };            // total session time
+    uint64_t bytesIn{ 0 }, bytesOut{ 0 };
+    double p50Ms{ 0 }, p95Ms{ 0 };    // connect time of the connected sessions, ~1% precision
+};
+
+class ConnectionHistory {
+public:
+    static constexpr uint32_t kNoConnect = 0xFFFFFFFFu;
+    static constexpr int64_t kEpoch = 1577836800;   // 2020-01-01 00:00:00 UTC
+
+    ConnectionHistory() = default;
+    ConnectionHistory(const ConnectionHistory&) = delete;
+    ConnectionHistory& operator=(const ConnectionHistory&) = delete;
+    ~ConnectionHistory() { close(); }
+
+    bool open(const std::string& dir, std::string& err);   // creates the directory; loads every column
+    void close();
+    bool isOpen() const { return dict_ != nullptr; }
+
+    // UI thread. One write (and flush) per column for the whole batch.
+    bool append(const HistorySession* sessions, size_t count);
+    bool append(const HistorySession& s) { return append(&s, 1); }
+
+    size_t size() const { return start_.size(); }
+    void session(size_t row, HistorySession& out) const;   // row 0 = oldest
+    std::string_view name(uint32_t id) const { return id < names_.size() ? std::string_view(names_[id]) : "?"; }
+
+    // Sessions started at or after sinceUnix, grouped by `by`, most sessions first. The start column
+    // is filtered four rows per SSE2 compare; the matching rows feed per-group counters and
+    // connect-time histograms, which are reused across queries.
+    void aggregate(int64_t sinceUnix, HistoryKey by, std::vector<HistoryGroup>& out) const;
+
+private:
+    enum Column { kStart, kStop, kConnect, kIn, kOut, kReconnects, kProfile, kRemote, kExit, kColumns };
+
+    uint32_t intern(const std::string& s);   // appends new strings to strings.dict
+    bool openFiles();                        // append handles for the dictionary and every column
+    void rollback(size_t rows, size_t names, uint64_t dictBytes);
+    template <typename F> void forEachColumn(F&& f);   // f(Column, std::vector<T>&) for every column
+    template <typename F> void forEachSince(uint32_t since, F&& f) const;
+
+    std::string dir_;
+    std::FILE* dict_{ nullptr };
+    uint64_t dictBytes_{ 0 };
+    std::FILE* files_[kColumns]{};
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, uint32_t> ids_;
+
+    std::vector<uint32_t> start_, stop_, connect_, reconnects_, profile_, remote_, exit_;
+    std::vector<uint64_t> in_, out_;
+
+    mutable std::vector<uint32_t> groupOf_;        // key id -> index into the query's groups
+    mutable std::vector<HdrHistogram> connectMs_;  // per group
+};
@@ -0,0 +1,87 @@
+#include "HistoryBench.h"
+#include "ConnectionHistory.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+} // namespace
+
+int HistoryBench::Run(size_t rows) {
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / "vpn-history-bench";
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+    std::string err;
+    ConnectionHistory h;
+    if (!h.open(dir.string(), err)) { std::printf("%s\n", err.c_str()); return 1; }
+
+    // sessions back to back over the last two years; some servers are slow, some never connect
+    const int64_t now = (int64_t)std::time(nullptr);
+    const int64_t span = 2 * 365 * 86400ll;
+    std::vector<HistorySession> batch(65536);
+    char name[64];
+    uint32_t x = 12345;
+    auto t0 = Clock::now();
+    for (size_t done = 0; done < rows;) {
+        const size_t n = std::min(batch.size(), rows - done);
+        for (size_t i = 0; i < n; ++i) {
+            HistorySession& s = batch[i];
+            x = x * 1664525u + 1013904223u;
+            const uint32_t server = (x >> 8) % 300, profile = (x >> 16) % 40;
+            s.startUnix = now - span + (int64_t)((done + i) * (double)span / rows);
+            s.stopUnix = s.startUnix + 60 + (x >> 4 & 0x3FFF);
+            s.connectMs = x % 97 == 0 ? -1 : 800 + (int64_t)(x % 4000) * (1 + server % 4);
+            s.bytesIn = x >> 2;
+            s.bytesOut = x >> 5;
+            s.reconnects = x % 13 == 0 ? x >> 28 : 0;
+            std::snprintf(name, sizeof(name), "vpn-%03u.example.net", server);
+            s.remote = name;
+            std::snprintf(name, sizeof(name), "profile-%02u.ovpn", profile);
+            s.profile = name;
+            s.exitReason = x % 97 == 0 ? "exited" : x % 11 == 0 ? "restarted (process limits)" : "stopped";
+        }
+        if (!h.append(batch.data(), n)) { std::printf("append failed\n"); return 1; }
+        done += n;
+    }
+    std::printf("append %zu sessions: %.0f ms\n", rows, msSince(t0));
+    h.close();
+    t0 = Clock::now();
+    if (!h.open(dir.string(), err) || h.size() != rows) { std::printf("reopen failed: %s\n", err.c_str()); return 1; }
+    std::printf("open (load every column): %.1f ms\n\n", msSince(t0));
+
+    std::printf("%-12s %-12s %8s %10s %9s\n", "range", "group by", "groups", "sessions", "best_ms");
+    static const char* const kKeys[] = { "server", "profile", "exit reason" };
+    std::vector<HistoryGroup> groups;
+    for (int days : { 1, 30, 90, 0 }) {
+        for (int key = 0; key < 3; ++key) {
+            double best = 1e9;
+            for (int k = 0; k < 5; ++k) {
+                t0 = Clock::now();
+                h.aggregate(days ? now - days * 86400ll : 0, (HistoryKey)key, groups);
+                best = std::min(best, msSince(t0));
+            }
+            uint64_t sessions = 0;
+            for (const HistoryGroup& g : groups) sessions += g.sessions;
+            char range[32];
+            std::snprintf(range, sizeof(range), days ? "%d days" : "all", days);
+            std::printf("%-12s %-12s %8zu %10llu %9.2f\n", range, kKeys[key], groups.size(), (unsigned long long)sessions, best);
+        }
+    }
+    h.aggregate(now - 90 * 86400ll, HistoryKey::Remote, groups);
+    if (!groups.empty()) {
+        std::printf("\nbusiest server, 90 days: %.*s  %u sessions, p50 %.0f ms, p95 %.0f ms\n", (int)h.name(groups[0].key).size(),
+            h.name(groups[0].key).data(), groups[0].sessions, groups[0].p50Ms, groups[0].p95Ms);
+    }
+    h.close();
+    std::filesystem::remove_all(dir, ec);
+    return 0;
+}
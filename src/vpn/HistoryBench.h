@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+
+// --------- connection history benchmark (--history-bench [--history-bench-rows N]) ----------
+// Headless: writes N synthetic sessions (two years, 300 servers, 40 profiles) into a scratch
+// ConnectionHistory directory, reopens it, and times the panel's queries, e.g. p95 connect time per
+// server over the last 90 days. The directory is removed afterwards.
+class HistoryBench {
+public:
+    static int Run(size_t rows);   // prints one row per query to stdout; returns exit code
+};
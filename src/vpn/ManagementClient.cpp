@@ -0,0 +1,100 @@
+#include "ManagementClient.h"
+#include <cstring>
+
+ManagementClient::~ManagementClient() { disconnect(); }
+
+void ManagementClient::connect(const std::string& host, uint16_t port, LineHandler onLine, std::string onConnect,
+    std::string password) {
+    disconnect();
+    if (!wsa_.ok() || !port) return;
+    host_ = host;
+    port_ = port;
+    onLine_ = std::move(onLine);
+    onConnect_ = std::move(onConnect);
+    password_ = std::move(password);
+    running_ = true;
+    thread_ = std::thread(&ManagementClient::loop, this);
+}
+
+void ManagementClient::disconnect() {
+    running_ = false;
+    {
+        std::lock_guard<std::mutex> lk(sendMu_);
+        if (sock_ != INVALID_SOCKET) shutdown(sock_, SD_BOTH);   // wakes the blocked recv()
+    }
+    if (thread_.joinable()) thread_.join();
+    connected_ = false;
+}
+
+bool ManagementClient::send(std::string_view command) {
+    std::lock_guard<std::mutex> lk(sendMu_);
+    if (!connected_ || sock_ == INVALID_SOCKET) return false;
+    std::string buf(command);
+    buf += '\n';
+    return ::send(sock_, buf.data(), (int)buf.size(), 0) == (int)buf.size();
+}
+
+void ManagementClient::loop() {
+    std::string partial;
+    while (running_) {
+        SockAddr addr;
+        SOCKET s = INVALID_SOCKET;
+        if (ResolveHost(host_, port_, SOCK_STREAM, addr)) {
+            s = socket(addr.family(), SOCK_STREAM, IPPROTO_TCP);
+            if (s != INVALID_SOCKET && ::connect(s, addr.get(), addr.len) != 0) CloseSocketSafe(s);
+        }
+        if (s == INVALID_SOCKET) {   // openvpn opens the port a moment after it starts
+            for (int i = 0; i < 5 && running_; ++i) Sleep(40);
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lk(sendMu_);
+            sock_ = s;
+            connected_ = password_.empty();
+        }
+        if (!password_.empty()) {   // openvpn reads the reply to its prompt as one line
+            const std::string reply = password_ + '\n';
+            ::send(s, reply.data(), (int)reply.size(), 0);
+        }
+        else if (!onConnect_.empty()) send(onConnect_);
+        partial.clear();
+        while (running_ && readLines(partial)) {}
+        std::lock_guard<std::mutex> lk(sendMu_);
+        connected_ = false;
+        CloseSocketSafe(sock_);
+    }
+}
+
+bool ManagementClient::readLines(std::string& partial) {
+    char buf[4096];
+    int n = recv(sock_, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    partial.append(buf, n);
+    size_t start = 0;
+    for (size_t nl; (nl = partial.find('\n', start)) != std::string::npos; start = nl + 1) {
+        size_t end = (nl > start && partial[nl - 1] == '\r') ? nl - 1 : nl;
+        if (!connected_) {
+            if (!authenticate(std::string_view(partial).substr(start, end - start))) return false;
+        }
+        else if (onLine_) onLine_(partial.substr(start, end - start));
+    }
+    partial.erase(0, start);
+    return true;
+}
+
+// Before openvpn accepts the password. The prompt has no newline, so it heads the reply line:
+// "ENTER PASSWORD:SUCCESS: password is correct". False drops the connection.
+bool ManagementClient::authenticate(std::string_view line) {
+    if (line.find("SUCCESS: password is correct") != std::string_view::npos) {
+        {
+            std::lock_guard<std::mutex> lk(sendMu_);
+            connected_ = true;
+        }
+        if (!onConnect_.empty()) send(onConnect_);
+        return true;
+    }
+    if (line.find("ERROR: bad password") == std::string_view::npos) return true;
+    running_ = false;   // retrying with the same password cannot help
+    if (onLine_) onLine_("ERROR: management password rejected");
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "../net/Net.h"
+
+// --------- OpenVPN management interface client ----------
+// Connects to the --management TCP port, retrying while openvpn is still starting up, and delivers
+// every received line (command replies and >REALTIME notifications) to onLine on its own thread.
+// Reconnects if the socket drops while the client is still wanted; onConnect (newline-separated
+// commands, e.g. "log on all") is sent on every connect, so a re-attached GUI gets its backfill.
+// With a password (openvpn's --management pw-file) the client answers the "ENTER PASSWORD:" prompt
+// first; nothing is delivered or sent until openvpn accepts it, and a rejected password ends the retries.
+class ManagementClient {
+public:
+    using LineHandler = std::function<void(const std::string&)>;
+
+    ManagementClient() = default;
+    ~ManagementClient();
+
+    void connect(const std::string& host, uint16_t port, LineHandler onLine, std::string onConnect = {},
+        std::string password = {});
+    void disconnect();
+    bool connected() const { return connected_.load(); }   // and authenticated
+
+    bool send(std::string_view command);   // any thread; newline appended; false if not connected
+
+private:
+    void loop();
+    bool readLines(std::string& partial);
+    bool authenticate(std::string_view line);
+
+    WsaSession wsa_;
+    std::string host_;
+    uint16_t port_{ 0 };
+    LineHandler onLine_;
+    std::string onConnect_;
+    std::string password_;
+
+    std::mutex sendMu_;
+    SOCKET sock_{ INVALID_SOCKET };
+    std::atomic<bool> running_{ false }, connected_{ false };
+    std::thread thread_;
+};
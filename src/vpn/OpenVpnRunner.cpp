@@ -1,12 +1,33 @@
 #include "OpenVpnRunner.h"
-#include <codecvt>
-#include <locale>
+#include "ServerList.h"
+#include "../core/PrivateDir.h"
+#include "../core/Utf8.h"
+#include "../net/ResolverCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
 
-static std::wstring widen(const std::string& s) {
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> cv; return cv.from_bytes(s);
+// sent on every management connect: state and counters; a detached tunnel adds log history + live log
+static const char kLiveCommands[] = "state on\nbytecount 1";
+static const char kDetachedCommands[] = "log on all\nstate on\nbytecount 1";
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+OpenVpnRunner::~OpenVpnRunner() {
+    if (reaper_.joinable()) reaper_.join();
 }
-static std::string narrow(const std::wstring& w) {
-    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> cv; return cv.to_bytes(w);
+
+void OpenVpnRunner::setMetrics(MetricsRegistry& registry) {
+    connectSeconds_ = registry.histogram("vpn_connect_seconds", "Time from start or reconnect to CONNECTED",
+        { 0.5, 1, 2, 3, 5, 8, 13, 20, 30, 60, 120 });
+    reconnects_ = registry.counter("vpn_reconnects_total", "Tunnel reconnects reported by openvpn (RECONNECTING)");
+    bytesInTotal_ = registry.counter("vpn_received_bytes_total", "Bytes received through the tunnel this session");
+    bytesOutTotal_ = registry.counter("vpn_sent_bytes_total", "Bytes sent through the tunnel this session");
 }
 
 bool OpenVpnRunner::start(const OpenVpnConfig& cfg,
@@ -14,17 +35,436 @@ bool OpenVpnRunner::start(const OpenVpnConfig& cfg,
     std::function<void(const std::string&)> /*onError*/) {
     ProcessOptions opt;
     opt.exe = cfg.openvpnExe;
-    opt.args = { L"--config", cfg.ovpnFile, L"--verb", L"3" };
+    opt.args = { L"--config", cfg.ovpnFile, L"--verb", std::to_wstring(cfg.verb) };
+    // options apply in order, so remotes ahead of --config head the connection list
+    std::vector<std::wstring> remotes;
+    size_t pinned = 0, missed = 0;
+    if (resolver_) pinRemotes(cfg, remotes, pinned, missed);
+    else if (!cfg.remoteHost.empty()) remotes = { L"--remote", cfg.remoteHost, std::to_wstring(cfg.remotePort) };
+    opt.args.insert(opt.args.begin(), remotes.begin(), remotes.end());
+    const bool detached = cfg.detached && cfg.managementPort;
+    if (detached) opt.args.insert(opt.args.end(), { L"--management-log-cache", L"1000" });   // backfill for re-attach
     for (auto& a : cfg.extraArgs) opt.args.push_back(a);
     opt.hidden = true;
+    opt.captureOutput = !detached;   // a pipe would break when the GUI exits
+    opt.pseudoConsole = cfg.pseudoConsole;   // its escape sequences go through the sanitizer like any other
+    opt.detached = detached;
 
+    stop();   // joins the previous reader before its callback is replaced
+    if (reaper_.joinable()) reaper_.join();   // the previous detached child still holds the port
+    onLine_ = onOutput;
+    if (cfg.managementPort) {   // without the password any local process could drive the tunnel
+        if (!writePassword(cfg.managementPort)) return false;
+        opt.args.insert(opt.args.end(), { L"--management", L"127.0.0.1", std::to_wstring(cfg.managementPort), pwFile_ });
+    }
+    ProcessRunner::OutputHandler onChunk;
+    if (!detached) onChunk = [this](const char* data, size_t len) { onOutputChunk(data, len); };
     std::wstring err;
-    bool ok = runner_.start(opt, &err);
-    if (!ok && onOutput) { onOutput(narrow(L"[OpenVPN] start failed: " + err)); }
-    else if (ok && onOutput) { onOutput("[OpenVPN] started"); }
+    bool ok = runner_.start(opt, &err, std::move(onChunk));
+    if (!ok) removePassword();
+    emitState(!ok ? WideToUtf8(L"[OpenVPN] start failed: " + err)
+        : detached ? "[OpenVPN] started detached, pid " + std::to_string(runner_.pid()) : runner_.pseudoConsole() ? "[OpenVPN] started, output through a pseudo console" : std::string("[OpenVPN] started"));
+    if (ok && resolver_) {
+        emitState("[OpenVPN] " + std::to_string(pinned) + " pre-resolved remote addresses, " + std::to_string(missed) +
+            " names not cached yet");
+    }
+    verb_ = cfg.verb;
+    mute_ = 0;
+    burstRestore_ = -1;
+    detached_ = ok && detached;
+    lastLogTime_ = 0;
+    lastLogCount_ = historySame_ = 0;
+    attachNs_ = 0;
+    bytesIn_ = bytesOut_ = 0;
+    {
+        std::lock_guard<std::mutex> lk(stateMu_);
+        state_.clear();
+    }
+    connectStartNs_ = startNs_ = ok ? steadyNs() : 0;
+    connectMs_ = -1;
+    sessionReconnects_ = 0;
+    if (detached_ && journal_) {
+        TunnelInfo t;
+        t.pid = runner_.pid();
+        t.createdAt = runner_.createdAt();
+        t.managementPort = cfg.managementPort;
+        t.verb = cfg.verb;
+        t.startedUnix = (int64_t)std::time(nullptr);
+        t.profile = cfg.ovpnFile;
+        t.remoteHost = cfg.remoteHost;
+        t.remotePort = cfg.remotePort;
+        journal_->begin(t);
+    }
+    if (ok && cfg.managementPort) {
+        mgmt_.connect("127.0.0.1", cfg.managementPort, [this](const std::string& line) { onManagementLine(line); },
+            detached_ ? kDetachedCommands : kLiveCommands, password_);
+    }
     return ok;
 }
 
+// --remote <ip> for every remote the cache knows: the --remote override first, then the profile's.
+// The override's name follows its addresses as a fallback; the profile's names stay in the profile.
+void OpenVpnRunner::pinRemotes(const OpenVpnConfig& cfg, std::vector<std::wstring>& args, size_t& pinned, size_t& missed) {
+    constexpr size_t kPerRemote = 2;   // openvpn tries each in turn; more only slows a dead server's failover
+    std::vector<ProfileRemote> remotes;
+    if (!cfg.remoteHost.empty()) remotes.push_back({ WideToUtf8(cfg.remoteHost), cfg.remotePort, {} });
+    const size_t overrides = remotes.size();
+    ReadProfileRemotes(cfg.ovpnFile, remotes);
+    std::vector<std::string> ips;
+    for (size_t i = 0; i < remotes.size(); ++i) {
+        const ProfileRemote& r = remotes[i];
+        if (!resolver_->lookup(r.host, ips, kPerRemote)) ++missed;   // lookup() queued it for next time
+        else if (ips[0] != r.host) {                                   // numeric remotes need no help
+            for (const std::string& ip : ips) {
+                args.insert(args.end(), { L"--remote", Utf8ToWide(ip), std::to_wstring(r.port) });
+                if (!r.proto.empty()) args.push_back(Utf8ToWide(r.proto));
+                ++pinned;
+            }
+        }
+        if (i < overrides) args.insert(args.end(), { L"--remote", cfg.remoteHost, std::to_wstring(cfg.remotePort) });
+    }
+}
+
+bool OpenVpnRunner::reattach(std::function<void(const std::string&)> onOutput) {
+    TunnelInfo t;
+    if (!journal_ || !journal_->read(t)) return false;
+    const int64_t t0 = steadyNs();
+    stop();
+    if (!runner_.attach(t.pid, t.createdAt)) {   // it exited (or the pid belongs to someone else now)
+        journal_->end();
+        return false;
+    }
+    onLine_ = std::move(onOutput);
+    verb_ = t.verb;
+    mute_ = 0;
+    burstRestore_ = -1;
+    detached_ = true;
+    lastLogTime_ = 0;
+    lastLogCount_ = historySame_ = 0;
+    attachNs_ = t0;   // the first management line stops the clock
+    bytesIn_ = t.bytesIn;   // until the first >BYTECOUNT
+    bytesOut_ = t.bytesOut;
+    connectStartNs_ = startNs_ = 0;   // connected long ago, or still trying since an unknown time
+    connectMs_ = -1;
+    sessionReconnects_ = 0;
+    {
+        std::lock_guard<std::mutex> lk(stateMu_);
+        state_ = t.state;
+    }
+    if (!readPassword(t.managementPort)) {
+        emitState("[OpenVPN] the detached tunnel's management password is gone: no log or state from it");
+        return true;
+    }
+    mgmt_.connect("127.0.0.1", t.managementPort, [this](const std::string& line) { onManagementLine(line); },
+        kDetachedCommands, password_);
+    return true;
+}
+
+// ---------- management password ----------
+// A fresh random password per session, in a pw-file for --management. The file lives in the per-user
+// directory and stays while a detached child runs, so the next GUI run can re-attach with it.
+bool OpenVpnRunner::writePassword(uint16_t port) {
+    std::string err;
+    std::wstring dir;
+    password_ = RandomHex(16);
+    if (password_.empty()) err = "no random source";
+    else if (PrivateDir(dir, err)) {
+        pwFile_ = dir + L"\\management-" + std::to_wstring(port) + L".pw";
+        HANDLE f = CreateFileW(pwFile_.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        const std::string line = password_ + '\n';
+        DWORD n = 0;
+        const bool ok = f != INVALID_HANDLE_VALUE && WriteFile(f, line.data(), (DWORD)line.size(), &n, nullptr) && n == line.size();
+        if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+        if (ok) return true;
+        err = "cannot write " + WideToUtf8(pwFile_);
+    }
+    removePassword();
+    emitState("[OpenVPN] start failed: management password: " + err);
+    return false;
+}
+
+bool OpenVpnRunner::readPassword(uint16_t port) {
+    std::string err;
+    std::wstring dir;
+    if (!PrivateDir(dir, err)) return false;
+    pwFile_ = dir + L"\\management-" + std::to_wstring(port) + L".pw";
+    HANDLE f = CreateFileW(pwFile_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    char buf[128];
+    DWORD n = 0;
+    const bool ok = f != INVALID_HANDLE_VALUE && ReadFile(f, buf, sizeof(buf), &n, nullptr);
+    if (f != INVALID_HANDLE_VALUE) CloseHandle(f);
+    password_.assign(buf, ok ? n : 0);
+    while (!password_.empty() && (password_.back() == '\n' || password_.back() == '\r')) password_.pop_back();
+    if (password_.empty()) pwFile_.clear();
+    return !password_.empty();
+}
+
+void OpenVpnRunner::removePassword() {
+    if (!pwFile_.empty()) DeleteFileW(pwFile_.c_str());
+    pwFile_.clear();
+    password_.clear();
+}
+
+void OpenVpnRunner::detach() {
+    if (!detached_) return;
+    mgmt_.disconnect();
+    runner_.release();   // the journal keeps the tunnel for the next run
+    pwFile_.clear();     // and the password file, for the next run's management connect
+    password_.clear();
+    detached_ = false;
+}
+
+void OpenVpnRunner::clearDetached() {
+    if (!detached_) return;
+    if (journal_) journal_->end();
+    detached_ = false;
+}
+
+// "time,flags,message" (history) or ">LOG:time,flags,message" (live); false for anything else
+static bool parseLogLine(const std::string& line, int64_t& time, std::string& message) {
+    size_t p = line.rfind(">LOG:", 0) == 0 ? 5 : 0;
+    if (p == line.size() || line[p] < '0' || line[p] > '9') return false;
+    char* end = nullptr;
+    time = std::strtoll(line.c_str() + p, &end, 10);
+    if (*end != ',') return false;
+    const size_t flags = end - line.c_str() + 1;
+    const size_t comma = line.find(',', flags);
+    if (comma == std::string::npos) return false;
+    for (size_t i = flags; i < comma; ++i)
+        if (line[i] < 'A' || line[i] > 'Z') return false;
+    message.assign(line, comma + 1, std::string::npos);
+    return true;
+}
+
+void OpenVpnRunner::onOutputChunk(const char* data, size_t len) {
+    if (!len) { emitState("[OpenVPN] output closed"); return; }   // EOF: the child exited
+    if (recorder_) recorder_->record(SessionEvent::Output, data, len);   // raw: a replay cleans it again
+    ingestOutput(data, len);
+}
+
+// the whole read is cleaned at once; a clean chunk (nearly all of them) is split in place
+void OpenVpnRunner::ingestOutput(const char* data, size_t len) {
+    const std::string_view text = sanitizer_.feed(data, len, clean_);
+    splitLines(text.data(), text.size());
+}
+
+void OpenVpnRunner::onManagementLine(const std::string& line) {
+    if (recorder_) recorder_->record(SessionEvent::Management, line.data(), line.size());
+    if (attachNs_) {   // connected and authenticated: the re-attach is complete
+        char msg[96];
+        std::snprintf(msg, sizeof(msg), "[OpenVPN] re-attached in %.2f ms (management interface up)", (steadyNs() - attachNs_) / 1e6);
+        attachNs_ = 0;
+        emitState(msg);
+    }
+    // a detached child's log: history lines the previous connection already delivered are skipped.
+    // Log times are whole seconds, so lines sharing the newest second are told apart by count.
+    int64_t time = 0;
+    std::string message;
+    if ((line.rfind(">LOG:", 0) == 0 || detached_) && parseLogLine(line, time, message)) {
+        const bool live = line[0] == '>';
+        if (!live && (time < lastLogTime_ || (time == lastLogTime_ && historySame_++ < lastLogCount_))) return;
+        if (time == lastLogTime_) ++lastLogCount_;
+        else {
+            lastLogTime_ = time;
+            lastLogCount_ = 1;
+            historySame_ = live ? 0 : 1;
+        }
+        if (TextSanitizer::clean(message, mgmtClean_)) message.swap(mgmtClean_);
+        if (onLine_) onLine_(message);
+        return;
+    }
+    if (line == "END") { historySame_ = 0; return; }   // the history dump is over
+    if (line.rfind(">BYTECOUNT:", 0) == 0) {   // >BYTECOUNT:in,out
+        char* end = nullptr;
+        const uint64_t in = std::strtoull(line.c_str() + 11, &end, 10);
+        if (*end != ',') return;
+        const uint64_t out = std::strtoull(end + 1, nullptr, 10);
+        bytesIn_.store(in, std::memory_order_relaxed);
+        bytesOut_.store(out, std::memory_order_relaxed);
+        bytesInTotal_.set(in);
+        bytesOutTotal_.set(out);
+        if (journal_ && detached_) journal_->setCounters(in, out);
+        return;
+    }
+    if (line.rfind(">STATE:", 0) == 0) {   // >STATE:time,NAME,...
+        const size_t a = line.find(',');
+        const size_t b = a == std::string::npos ? a : line.find(',', a + 1);
+        if (b == std::string::npos) return;
+        const std::string_view name = std::string_view(line).substr(a + 1, b - a - 1);
+        {
+            std::lock_guard<std::mutex> lk(stateMu_);
+            state_.assign(name);
+        }
+        if (journal_ && detached_) journal_->setState(name);
+        if (name == "RECONNECTING") {
+            reconnects_.add();
+            sessionReconnects_.fetch_add(1, std::memory_order_relaxed);
+            connectStartNs_ = steadyNs();
+        }
+        else if (name == "CONNECTED" && connectStartNs_) {
+            const int64_t now = steadyNs();
+            connectSeconds_.observe((now - connectStartNs_) / 1e9);
+            connectStartNs_ = 0;
+            if (startNs_ && connectMs_.load(std::memory_order_relaxed) < 0)
+                connectMs_.store((now - startNs_) / 1000000, std::memory_order_relaxed);
+        }
+        return;
+    }
+    // command replies go to the log; realtime notifications are handled by their consumers
+    if (onLine_ && (line.rfind("SUCCESS:", 0) == 0 || line.rfind("ERROR:", 0) == 0))
+        onLine_("[mgmt] " + line);
+}
+
+std::string OpenVpnRunner::tunnelState() const {
+    std::lock_guard<std::mutex> lk(stateMu_);
+    return state_;
+}
+
+void OpenVpnRunner::emitState(const std::string& message) {
+    if (recorder_) recorder_->record(SessionEvent::State, message.data(), message.size());
+    if (onLine_) onLine_(message);
+}
+
 void OpenVpnRunner::stop() {
+    stopReplay();
+    if (detached_ && mgmt_.send("signal SIGTERM")) {   // lets it tear the tunnel down cleanly, off the UI thread
+        if (reaper_.joinable()) reaper_.join();
+        if (HANDLE h = runner_.takeProcess()) {
+            reaper_ = std::thread([h] {
+                if (WaitForSingleObject(h, 3000) != WAIT_OBJECT_0) TerminateProcess(h, 0);
+                CloseHandle(h);
+            });
+        }
+    }
+    mgmt_.disconnect();
     runner_.stop();
+    clearDetached();
+    removePassword();
+    partial_.append(sanitizer_.finish(clean_));   // a sequence cut off by the end of the output
+    if (!partial_.empty() && onLine_) onLine_(partial_);   // unterminated last line
+    partial_.clear();
+}
+
+void OpenVpnRunner::splitLines(const char* data, size_t len) {
+    const char* end = data + len;
+    while (data < end) {
+        const char* nl = static_cast<const char*>(memchr(data, '\n', end - data));
+        if (!nl) { partial_.append(data, end); return; }
+        size_t n = nl - data;
+        if (partial_.empty()) line_.assign(data, n);
+        else { partial_.append(data, n); line_.swap(partial_); partial_.clear(); }
+        if (!line_.empty() && line_.back() == '\r') line_.pop_back();
+        if (onLine_) onLine_(line_);
+        data = nl + 1;
+    }
+}
+
+bool OpenVpnRunner::setVerb(int level) {
+    if (level < 0 || level > 11 || !mgmt_.send("verb " + std::to_string(level))) return false;
+    verb_ = level;
+    if (journal_ && detached_) journal_->setVerb(level);
+    burstRestore_ = -1;   // an explicit level wins over a running burst
+    return true;
+}
+
+bool OpenVpnRunner::setMute(int lines) {
+    if (lines < 0 || !mgmt_.send("mute " + std::to_string(lines))) return false;
+    mute_ = lines;
+    return true;
+}
+
+bool OpenVpnRunner::startDebugBurst(int level, std::chrono::seconds duration) {
+    int restore = burstRestore_ >= 0 ? burstRestore_ : verb_;
+    if (!setVerb(level)) return false;
+    burstRestore_ = restore;
+    burstEnd_ = std::chrono::steady_clock::now() + duration;
+    return true;
+}
+
+double OpenVpnRunner::burstRemaining() const {
+    if (burstRestore_ < 0) return 0;
+    double left = std::chrono::duration<double>(burstEnd_ - std::chrono::steady_clock::now()).count();
+    return left > 0 ? left : 0;
+}
+
+void OpenVpnRunner::poll() {
+    if (detached_ && !runner_.running()) {   // no output pipe to report the exit
+        mgmt_.disconnect();
+        runner_.release();
+        clearDetached();
+        removePassword();
+        emitState("[OpenVPN] detached tunnel exited");
+    }
+    if (burstRestore_ < 0 || std::chrono::steady_clock::now() < burstEnd_) return;
+    int restore = burstRestore_;
+    if (setVerb(restore) && onLine_) onLine_("[mgmt] debug burst over, verb back to " + std::to_string(restore));
+    else if (!mgmt_.connected()) burstRestore_ = -1;   // tunnel gone; the next start uses cfg.verb anyway
+}
+
+// ---------- replay ----------
+void OpenVpnRunner::deliver(const SessionReader::Event& ev) {
+    switch (ev.kind) {
+    case SessionEvent::Output: ingestOutput(ev.data.data(), ev.data.size()); break;
+    case SessionEvent::Management: onManagementLine(ev.data); break;
+    case SessionEvent::State: if (onLine_) onLine_(ev.data); break;
+    }
+}
+
+bool OpenVpnRunner::openReplay(const std::string& path, std::function<void(const std::string&)> onOutput) {
+    stop();
+    if (!replay_.open(path)) return false;
+    onLine_ = std::move(onOutput);
+    liveRecorder_ = recorder_;   // back once the replay ends or is stopped
+    recorder_ = nullptr;         // never record a replay into itself
+    replayPending_ = false;
+    replayClock_ = 0;
+    replaying_ = true;
+    return true;
+}
+
+bool OpenVpnRunner::advanceReplay(int64_t ns) {
+    if (!replaying_) return false;
+    replayClock_ += ns;
+    while (replaying_) {   // stopReplay() may clear it from the UI thread mid-catch-up
+        if (!replayPending_ && !replay_.next(replayEv_)) {
+            partial_.append(sanitizer_.finish(clean_));
+            if (!partial_.empty() && onLine_) onLine_(partial_);
+            partial_.clear();
+            replay_.close();
+            recorder_ = liveRecorder_;
+            replaying_ = false;
+            return false;
+        }
+        replayPending_ = replayEv_.ns > replayClock_;
+        if (replayPending_) return true;
+        deliver(replayEv_);
+    }
+    return false;
+}
+
+bool OpenVpnRunner::startReplay(const std::string& path, double speed, std::function<void(const std::string&)> onOutput) {
+    if (!openReplay(path, std::move(onOutput))) return false;
+    replayThread_ = std::thread(&OpenVpnRunner::replayLoop, this, speed);
+    return true;
+}
+
+void OpenVpnRunner::replayLoop(double speed) {
+    // sleep until the next event is due (scaled), then deliver everything that is due
+    auto t0 = std::chrono::steady_clock::now();
+    while (replaying_) {
+        if (speed <= 0) { advanceReplay(INT64_MAX / 2); break; }
+        int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+        int64_t target = (int64_t)(elapsed * speed);
+        if (!advanceReplay(target - replayClock_)) break;
+        int64_t waitNs = (int64_t)((replayEv_.ns - replayClock_) / speed);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(std::min<int64_t>(waitNs, 50 * 1000 * 1000)));
+    }
+}
+
+void OpenVpnRunner::stopReplay() {
+    bool wasReplaying = replaying_.exchange(false);
+    if (replayThread_.joinable()) replayThread_.join();
+    if (!wasReplaying) return;
+    replay_.close();
+    recorder_ = liveRecorder_;
 }
@@ -1,23 +1,153 @@
 #pragma once
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
+#include "../core/Metrics.h"
+#include "../core/Utf8.h"
+#include "ManagementClient.h"
 #include "ProcessRunner.h"
+#include "SessionRecorder.h"
+#include "TunnelJournal.h"
+
+class ResolverCache;
 
 struct OpenVpnConfig {
     std::wstring openvpnExe;     // openvpn.exe ·
     std::wstring ovpnFile;       // ļ·
     std::vector<std::wstring> extraArgs; // 
+    uint16_t managementPort{ 7505 };     // 127.0.0.1 --management port, 0 = off; a fresh password guards it
+    int verb{ 3 };                       // --verb at startup, changeable at runtime via management
+    std::wstring remoteHost{};           // non-empty: tried before the profile's own remotes
+    uint16_t remotePort{ 0 };
+    bool detached{ false };              // tunnel outlives the GUI (needs managementPort), see TunnelJournal
+    bool pseudoConsole{ false };         // capture output through a ConPTY: line-buffered child, see ProcessOptions
 };
 
 class OpenVpnRunner {
 public:
+    ~OpenVpnRunner();
+
+    // onOutput gets one call per output line, on the process reader thread
     bool start(const OpenVpnConfig& cfg,
         std::function<void(const std::string&)> onOutput = {},
         std::function<void(const std::string&)> onError = {});
-    void stop();
-    bool running() const { return runner_.running(); }
+    void stop();                     // a detached child gets SIGTERM and up to 3 s in the background
+    bool running() const { return runner_.running() || replaying_.load(); }
+    DWORD pid() const { return runner_.pid(); }
+
+    // runtime log level through the management interface, no reconnect needed
+    bool managementConnected() const { return mgmt_.connected(); }
+    bool setVerb(int level);
+    bool setMute(int lines);
+    int verb() const { return verb_; }
+    int mute() const { return mute_; }
+    // raise verbosity for `duration`, then poll() restores the previous level
+    bool startDebugBurst(int level, std::chrono::seconds duration);
+    double burstRemaining() const;   // seconds, 0 when no burst is active
+    // reconnect in place ("signal SIGUSR1"): drops the connection without ending the process, e.g.
+    // once the network under a stale connection has changed; false without the management interface
+    bool softRestart() { return mgmt_.send("signal SIGUSR1"); }
+    void poll();                     // UI thread, once per frame
+
+    // live tunnel status from the management interface (state and bytecount notifications);
+    // any thread. Counters are the child's totals for this session.
+    uint64_t bytesIn() const { return bytesIn_.load(std::memory_order_relaxed); }
+    uint64_t bytesOut() const { return bytesOut_.load(std::memory_order_relaxed); }
+    std::string tunnelState() const;   // e.g. "CONNECTED", empty before the first >STATE
+    // this session: ms from start() to the first CONNECTED (-1 = not yet, or re-attached), RECONNECTINGs
+    int64_t connectMs() const { return connectMs_.load(std::memory_order_relaxed); }
+    uint32_t sessionReconnects() const { return sessionReconnects_.load(std::memory_order_relaxed); }
+    // Optional: registers the tunnel's metrics (connect time, reconnects, traffic), which the
+    // management thread then updates as notifications arrive. Call once, while stopped.
+    void setMetrics(MetricsRegistry& registry);
+
+    // Optional: remotes the cache has already resolved go to the child as "--remote <ip>" ahead of
+    // the profile, so connecting needs no DNS; names it does not know yet are prefetched.
+    void setResolver(ResolverCache* resolver) { resolver_ = resolver; }
+
+    // ---------- detached tunnels ----------
+    // A detached child is not tied to the GUI. Its log comes through the management interface
+    // ("log on all" also sends the recent history) and the journal records it, so the next run
+    // re-attaches instead of reconnecting. Set the journal while stopped.
+    void setJournal(TunnelJournal* journal) { journal_ = journal; }
+    bool reattach(std::function<void(const std::string&)> onOutput);   // false: no live tunnel in the journal
+    void detach();                   // GUI exit: drop the management connection, leave the tunnel up
+    bool detached() const { return detached_; }
+
+    // ---------- session record / replay ----------
+    // The recorder sees every output chunk, management line and state message of live sessions.
+    void setRecorder(SessionRecorder* rec) { recorder_ = rec; }   // nullptr = off; set while stopped
+    // Replays a recording through the same paths a live child uses (line splitting, management
+    // handling, state messages). speed scales the recorded timing; 0 = as fast as possible.
+    bool startReplay(const std::string& path, double speed, std::function<void(const std::string&)> onOutput);
+    // Stepped replay for deterministic tests: no thread, advanceReplay() delivers every event due
+    // within the next `ns` of recording time on the caller's thread. False once the recording is done.
+    bool openReplay(const std::string& path, std::function<void(const std::string&)> onOutput);
+    bool advanceReplay(int64_t ns);
+    bool replaying() const { return replaying_.load(); }
 
 private:
+    void splitLines(const char* data, size_t len);
+    void onOutputChunk(const char* data, size_t len);   // reader thread
+    void ingestOutput(const char* data, size_t len);    // sanitize + split
+    void onManagementLine(const std::string& line);     // management thread
+    void emitState(const std::string& message);
+    void deliver(const SessionReader::Event& ev);
+    void replayLoop(double speed);
+    void stopReplay();
+
+    void clearDetached();
+    bool writePassword(uint16_t port);
+    bool readPassword(uint16_t port);
+    void removePassword();
+    void pinRemotes(const OpenVpnConfig& cfg, std::vector<std::wstring>& args, size_t& pinned, size_t& missed);
+
     ProcessRunner runner_;
+    ManagementClient mgmt_;
+    std::string password_;   // this session's management password, kept in pwFile_ for openvpn
+    std::wstring pwFile_;
+    int verb_{ 3 }, mute_{ 0 };
+    int burstRestore_{ -1 };
+    std::chrono::steady_clock::time_point burstEnd_{};
+    std::function<void(const std::string&)> onLine_;
+    std::string partial_;   // reader thread only: bytes after the last newline
+    std::string line_;
+    TextSanitizer sanitizer_;   // reader thread: child output, validated per read
+    std::string clean_;
+    std::string mgmtClean_;     // management thread
+
+    ResolverCache* resolver_{ nullptr };
+    TunnelJournal* journal_{ nullptr };
+    bool detached_{ false };
+    // management thread: newest log time seen and how many lines carried it; "log on all" repeats
+    // the history on every connect, and only what lies past these is new
+    int64_t lastLogTime_{ 0 };
+    uint32_t lastLogCount_{ 0 };
+    uint32_t historySame_{ 0 };  // this history dump's lines at lastLogTime_ so far
+    int64_t attachNs_{ 0 };      // reattach() until the first authenticated management line
+    std::thread reaper_;         // a stopped detached child's teardown
+
+    std::atomic<uint64_t> bytesIn_{ 0 }, bytesOut_{ 0 };
+    mutable std::mutex stateMu_;   // guards state_
+    std::string state_;
+
+    MetricsRegistry::Histogram connectSeconds_;
+    MetricsRegistry::Counter reconnects_, bytesInTotal_, bytesOutTotal_;
+    int64_t connectStartNs_{ 0 };   // start() / last RECONNECTING, 0 = not connecting or unknown
+    int64_t startNs_{ 0 };          // start(), 0 = re-attached
+    std::atomic<int64_t> connectMs_{ -1 };
+    std::atomic<uint32_t> sessionReconnects_{ 0 };
+
+    SessionRecorder* recorder_{ nullptr };
+    SessionRecorder* liveRecorder_{ nullptr };   // recorder_ while a replay has it switched off
+    SessionReader replay_;
+    SessionReader::Event replayEv_;
+    bool replayPending_{ false };   // replayEv_ is read but not yet due
+    int64_t replayClock_{ 0 };
+    std::thread replayThread_;
+    std::atomic<bool> replaying_{ false };
 };
@@ -0,0 +1,286 @@
+#include "ProcessMonitor.h"
+#include <psapi.h>
+#include <algorithm>
+#include <cstdio>
+
+using namespace std::chrono;
+
+// SYSTEM_PROCESS_INFORMATION / SYSTEM_THREAD_INFORMATION as returned by NtQuerySystemInformation(5).
+// winternl.h hides most of these fields behind Reserved[], so spell out the long-stable layout here.
+namespace {
+struct SysUnicodeString { USHORT Length, MaximumLength; PWSTR Buffer; };
+
+struct SysThreadInfo {
+    LARGE_INTEGER KernelTime, UserTime, CreateTime;
+    ULONG WaitTime;
+    PVOID StartAddress;
+    HANDLE UniqueProcess, UniqueThread;
+    LONG Priority, BasePriority;
+    ULONG ContextSwitches;
+    ULONG ThreadState, WaitReason;
+};
+
+struct SysProcInfo {
+    ULONG NextEntryOffset;
+    ULONG NumberOfThreads;
+    LARGE_INTEGER WorkingSetPrivateSize;
+    ULONG HardFaultCount, NumberOfThreadsHighWatermark;
+    ULONGLONG CycleTime;
+    LARGE_INTEGER CreateTime, UserTime, KernelTime;
+    SysUnicodeString ImageName;
+    LONG BasePriority;
+    HANDLE UniqueProcessId, InheritedFromUniqueProcessId;
+    ULONG HandleCount, SessionId;
+    ULONG_PTR UniqueProcessKey;
+    SIZE_T PeakVirtualSize, VirtualSize;
+    ULONG PageFaultCount;
+    SIZE_T PeakWorkingSetSize, WorkingSetSize;
+    SIZE_T QuotaPeakPagedPoolUsage, QuotaPagedPoolUsage, QuotaPeakNonPagedPoolUsage, QuotaNonPagedPoolUsage;
+    SIZE_T PagefileUsage, PeakPagefileUsage, PrivatePageCount;
+    LARGE_INTEGER ReadOperationCount, WriteOperationCount, OtherOperationCount;
+    LARGE_INTEGER ReadTransferCount, WriteTransferCount, OtherTransferCount;
+    // SysThreadInfo[NumberOfThreads] follows
+};
+
+using NtQuerySystemInformationFn = LONG(WINAPI*)(ULONG, PVOID, ULONG, PULONG);
+constexpr ULONG kSystemProcessInformation = 5;
+constexpr LONG kStatusInfoLengthMismatch = (LONG)0xC0000004;
+
+NtQuerySystemInformationFn ntQuery() {
+    static auto fn = (NtQuerySystemInformationFn)GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQuerySystemInformation");
+    return fn;
+}
+
+uint32_t pidOf(HANDLE h) { return (uint32_t)(ULONG_PTR)h; }
+
+int64_t fileTime(const FILETIME& ft) { return (int64_t)(((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime); }
+
+std::string narrowName(const SysUnicodeString& u) {
+    if (!u.Buffer || !u.Length) return "System";
+    int wlen = u.Length / (int)sizeof(wchar_t);
+    int n = WideCharToMultiByte(CP_UTF8, 0, u.Buffer, wlen, nullptr, 0, nullptr, nullptr);
+    std::string s(n, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, u.Buffer, wlen, s.data(), n, nullptr, nullptr);
+    return s;
+}
+
+} // namespace
+
+ProcessMonitor::~ProcessMonitor() { stop(); }
+
+void ProcessMonitor::start(DWORD rootPid, milliseconds interval) {
+    stop();
+    root_ = rootPid;
+    interval_ = interval;
+    procs_.clear();
+    breachRun_ = 0;
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        series_.clear();
+        restartPending_ = false;
+    }
+    if (!root_ || !ntQuery()) return;
+    running_ = true;
+    thread_ = std::thread(&ProcessMonitor::loop, this);
+}
+
+void ProcessMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) thread_.join();
+    closeHandles();   // the sampler is gone: procs_ is ours
+}
+
+void ProcessMonitor::closeHandles() {
+    for (auto& t : procs_) {
+        if (t.h) CloseHandle(t.h);
+        t.h = nullptr;
+    }
+}
+
+void ProcessMonitor::setLimits(const ProcessLimits& l) {
+    std::lock_guard<std::mutex> lk(mu_);
+    limits_ = l;
+}
+
+void ProcessMonitor::snapshot(std::vector<ProcessSeries>& out) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    out.resize(series_.size());
+    std::copy(series_.begin(), series_.end(), out.begin());
+}
+
+bool ProcessMonitor::takeRestartRequest(std::string& reason) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!restartPending_) return false;
+    restartPending_ = false;
+    reason = restartReason_;
+    return true;
+}
+
+void ProcessMonitor::loop() {
+    auto prev = steady_clock::now(), prevDiscover = prev;
+    for (int tick = 0; running_; ++tick) {
+        auto now = steady_clock::now();
+        if (tick % kDiscoverTicks == 0) {
+            discover(duration<double>(now - prevDiscover).count());
+            prevDiscover = now;
+        }
+        sample(duration<double>(now - prev).count());
+        ProcessLimits limits;
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            limits = limits_;
+        }
+        check(limits);
+        publish();
+        prev = now;
+        lastSampleUs_ = duration<double, std::micro>(steady_clock::now() - now).count();
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait_for(lk, interval_, [this] { return !running_; });
+    }
+}
+
+ProcessMonitor::Tracked* ProcessMonitor::find(uint32_t pid, int64_t createTime) {
+    for (auto& t : procs_) if (t.s.pid == pid && t.createTime == createTime) return &t;
+    return nullptr;
+}
+
+void ProcessMonitor::discover(double dtSec) {
+    if (buf_.empty()) buf_.resize(256 * 1024);
+    ULONG need = 0;
+    LONG st;
+    while ((st = ntQuery()(kSystemProcessInformation, buf_.data(), (ULONG)buf_.size(), &need)) == kStatusInfoLengthMismatch)
+        buf_.resize(std::max<size_t>(buf_.size() * 2, need + 64 * 1024));
+    if (st < 0) return;
+
+    auto forEach = [this](auto&& fn) {
+        for (size_t off = 0;;) {
+            auto* p = reinterpret_cast<const SysProcInfo*>(buf_.data() + off);
+            fn(*p);
+            if (!p->NextEntryOffset) break;
+            off += p->NextEntryOffset;
+        }
+    };
+
+    // Collect the child's tree. Entries are not ordered parent-first, so repeat until no pid is added.
+    // A process only counts as a descendant if it was created after the root (pids get recycled).
+    int64_t rootCreate = -1;
+    forEach([&](const SysProcInfo& p) { if (pidOf(p.UniqueProcessId) == root_) rootCreate = p.CreateTime.QuadPart; });
+    tree_.clear();
+    if (rootCreate >= 0) tree_.push_back(root_);
+    for (bool grew = !tree_.empty(); grew;) {
+        grew = false;
+        forEach([&](const SysProcInfo& p) {
+            uint32_t pid = pidOf(p.UniqueProcessId), parent = pidOf(p.InheritedFromUniqueProcessId);
+            if (p.CreateTime.QuadPart < rootCreate) return;
+            if (std::find(tree_.begin(), tree_.end(), pid) != tree_.end()) return;
+            if (std::find(tree_.begin(), tree_.end(), parent) == tree_.end()) return;
+            tree_.push_back(pid);
+            grew = true;
+        });
+    }
+
+    // new members get a handle; everyone gets the counts only the snapshot has
+    forEach([&](const SysProcInfo& p) {
+        uint32_t pid = pidOf(p.UniqueProcessId);
+        if (std::find(tree_.begin(), tree_.end(), pid) == tree_.end()) return;
+        Tracked* t = find(pid, p.CreateTime.QuadPart);
+        uint64_t csw = 0;
+        auto* th = reinterpret_cast<const SysThreadInfo*>(&p + 1);
+        for (ULONG i = 0; i < p.NumberOfThreads; ++i) csw += th[i].ContextSwitches;
+        if (!t) {
+            HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+            FILETIME created{}, exited{}, kernel{}, user{};
+            // the pid may have been reused between the snapshot and OpenProcess
+            if (!h || !GetProcessTimes(h, &created, &exited, &kernel, &user) || fileTime(created) != p.CreateTime.QuadPart) {
+                if (h) CloseHandle(h);
+                return;
+            }
+            procs_.emplace_back();
+            t = &procs_.back();
+            t->h = h;
+            t->s.pid = pid;
+            t->s.parentPid = pidOf(p.InheritedFromUniqueProcessId);
+            t->s.name = narrowName(p.ImageName);
+            t->createTime = p.CreateTime.QuadPart;
+            t->cpuTime = (uint64_t)(fileTime(kernel) + fileTime(user));
+            t->cswTotal = csw;
+        }
+        t->s.threads = p.NumberOfThreads;
+        t->s.cswPerSec = dtSec > 0 ? (csw - t->cswTotal) / dtSec : 0.0;
+        t->cswTotal = csw;
+    });
+}
+
+void ProcessMonitor::sample(double dtSec) {
+    for (auto& t : procs_) {
+        ProcessSeries& s = t.s;
+        FILETIME created{}, exited{}, kernel{}, user{};
+        if (t.h && WaitForSingleObject(t.h, 0) == WAIT_OBJECT_0) {
+            CloseHandle(t.h);
+            t.h = nullptr;
+        }
+        if (!t.h || !GetProcessTimes(t.h, &created, &exited, &kernel, &user)) {
+            if (t.h) CloseHandle(t.h);   // the entry may be erased below
+            t.h = nullptr;
+            s.alive = false;
+            continue;
+        }
+        PROCESS_MEMORY_COUNTERS_EX mem{};
+        DWORD handles = 0;
+        GetProcessMemoryInfo(t.h, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&mem), sizeof(mem));
+        GetProcessHandleCount(t.h, &handles);
+        uint64_t cpuTime = (uint64_t)(fileTime(kernel) + fileTime(user));   // 100 ns units
+
+        s.alive = true;
+        s.rssMb = mem.WorkingSetSize / (1024.0 * 1024.0);
+        s.privateMb = mem.PrivateUsage / (1024.0 * 1024.0);
+        s.handles = handles;
+        s.cpuPct = dtSec > 0 ? (cpuTime - t.cpuTime) * 1e-7 / dtSec * 100.0 : 0.0;
+        t.cpuTime = cpuTime;
+
+        constexpr size_t K = ProcessSeries::kHistory;
+        size_t idx = (s.head + s.count) % K;
+        s.cpu[idx] = (float)s.cpuPct;
+        s.rss[idx] = (float)s.rssMb;
+        s.hnd[idx] = (float)s.handles;
+        s.csw[idx] = (float)s.cswPerSec;
+        if (s.count < K) ++s.count; else s.head = (s.head + 1) % K;
+    }
+    // short-lived helpers (up/down scripts) drop out once they exit; the root stays visible as dead
+    procs_.erase(std::remove_if(procs_.begin(), procs_.end(),
+        [this](const Tracked& t) { return !t.s.alive && t.s.pid != root_; }), procs_.end());
+}
+
+void ProcessMonitor::check(const ProcessLimits& limits) {
+    const char* what = nullptr;
+    const ProcessSeries* bad = nullptr;
+    for (const auto& t : procs_) {
+        if (!t.s.alive) continue;
+        if (limits.maxRssMb > 0 && t.s.rssMb > limits.maxRssMb) what = "RSS";
+        else if (limits.maxHandles > 0 && t.s.handles > limits.maxHandles) what = "handle count";
+        else if (limits.maxCpuPct > 0 && t.s.cpuPct > limits.maxCpuPct) what = "CPU";
+        if (what) { bad = &t.s; break; }
+    }
+    breachRun_ = bad ? breachRun_ + 1 : 0;
+    if (!bad || breachRun_ < std::max(1, limits.sustainSamples)) return;
+    char msg[192];
+    snprintf(msg, sizeof(msg), "%s (pid %u) %s over limit for %d samples: %.1f%% CPU, %.1f MB RSS, %u handles",
+        bad->name.c_str(), bad->pid, what, breachRun_, bad->cpuPct, bad->rssMb, bad->handles);
+    breachRun_ = 0;
+    std::lock_guard<std::mutex> lk(mu_);
+    if (restartPending_) return;
+    restartReason_ = msg;
+    restartPending_ = true;
+}
+
+// Copies the series outside the lock; the lock only covers the swap
+void ProcessMonitor::publish() {
+    back_.resize(procs_.size());
+    for (size_t i = 0; i < procs_.size(); ++i) back_[i] = procs_[i].s;
+    std::lock_guard<std::mutex> lk(mu_);
+    std::swap(back_, series_);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <windows.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --------- child process resource monitor ----------
+// Samples the OpenVPN child and everything it spawned (up/down scripts, netsh, ...) at a fixed rate.
+// Each tracked process is read through its own handle (GetProcessTimes, GetProcessMemoryInfo), so a
+// tick costs a few syscalls per process. The whole-system NtQuerySystemInformation snapshot is taken
+// only every kDiscoverTicks ticks, to find new children and to read thread and context-switch
+// counts, which have no per-process call. Its buffer is reused and the per-process series are
+// fixed-size rings, so steady-state sampling does not allocate. All of that runs on the sampler
+// thread without the lock; mu_ is only taken to publish the finished series and to read the limits,
+// so snapshot() on the UI thread never waits for a system scan.
+
+struct ProcessLimits {
+    double maxRssMb{ 0 };        // 0 = off
+    uint32_t maxHandles{ 0 };
+    double maxCpuPct{ 0 };       // one core = 100%
+    int sustainSamples{ 5 };     // consecutive breaching samples before a restart is requested
+};
+
+struct ProcessSeries {
+    static constexpr size_t kHistory = 300;   // 5 minutes at 1 Hz
+
+    uint32_t pid{ 0 }, parentPid{ 0 };
+    std::string name;
+    bool alive{ false };
+    // latest values
+    double cpuPct{ 0 }, rssMb{ 0 }, privateMb{ 0 }, cswPerSec{ 0 };
+    uint32_t handles{ 0 }, threads{ 0 };
+    // rings, oldest sample at `head`
+    std::array<float, kHistory> cpu{}, rss{}, hnd{}, csw{};
+    size_t head{ 0 }, count{ 0 };
+};
+
+class ProcessMonitor {
+public:
+    static constexpr int kDiscoverTicks = 5;
+
+    ProcessMonitor() = default;
+    ~ProcessMonitor();
+
+    void start(DWORD rootPid, std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    void stop();
+    bool running() const { return running_.load(); }
+
+    void setLimits(const ProcessLimits& l);
+    void snapshot(std::vector<ProcessSeries>& out) const;
+    // true once per breach; reason is a human-readable line for the log
+    bool takeRestartRequest(std::string& reason);
+    double lastSampleUs() const { return lastSampleUs_.load(); }   // cost of the latest tick
+
+private:
+    struct Tracked {
+        ProcessSeries s;
+        HANDLE h{ nullptr };               // PROCESS_QUERY_LIMITED_INFORMATION, null once exited
+        int64_t createTime{ 0 };           // disambiguates pid reuse
+        uint64_t cpuTime{ 0 }, cswTotal{ 0 };
+    };
+
+    void loop();
+    void discover(double dtSec);           // the system snapshot
+    void sample(double dtSec);             // the tracked handles
+    void check(const ProcessLimits& limits);
+    void publish();
+    Tracked* find(uint32_t pid, int64_t createTime);
+    void closeHandles();
+
+    DWORD root_{ 0 };
+    std::chrono::milliseconds interval_{ 1000 };
+    // sampler thread only (or while it is not running)
+    std::vector<unsigned char> buf_;       // NtQuerySystemInformation output, grown on demand only
+    std::vector<uint32_t> tree_;           // pids in the child's process tree at the last discovery
+    std::vector<Tracked> procs_;
+    std::vector<ProcessSeries> back_;      // filled without the lock, then swapped with series_
+    int breachRun_{ 0 };
+
+    mutable std::mutex mu_;                // guards series_, limits_, restart*
+    std::vector<ProcessSeries> series_;
+    ProcessLimits limits_;
+    bool restartPending_{ false };
+    std::string restartReason_;
+
+    std::condition_variable cv_;
+    std::atomic<bool> running_{ false };
+    std::atomic<double> lastSampleUs_{ 0 };
+    std::thread thread_;
+};
@@ -8,4 +8,12 @@ struct ProcessOptions {
     std::wstring workingDir;             // ɿ
     bool inheritHandles{ false };
     bool hidden{ true };
+    bool captureOutput{ false };         // stdout+stderr -> pipe, delivered to ProcessRunner's output handler
+    // with captureOutput: a pseudo console (ConPTY, Windows 10 1809+) instead of a plain pipe. The
+    // child's C runtime then sees a console and stops block-buffering its output; the bytes come back
+    // as VT text (escape sequences, lines wrapped at ptyColumns). Falls back to the pipe when unavailable.
+    bool pseudoConsole{ false };
+    short ptyColumns{ 1024 }, ptyRows{ 32 };   // fixed for the child's life: never narrowed to the log pane,
+                                               // which would hard-wrap long lines into several log rows
+    bool detached{ false };              // outlives the GUI: kept out of the job object (no captureOutput)
 };
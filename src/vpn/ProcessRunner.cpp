@@ -1,5 +1,34 @@
 #include "ProcessRunner.h"
 #include <sstream>
+#include <vector>
+
+#ifndef PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE
+#define PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE 0x00020016
+#endif
+#ifndef PROC_THREAD_ATTRIBUTE_HANDLE_LIST
+#define PROC_THREAD_ATTRIBUTE_HANDLE_LIST 0x00020002
+#endif
+
+// ConPTY is looked up at runtime: kernel32 only has it from Windows 10 1809 on
+namespace {
+using CreatePseudoConsoleFn = HRESULT(WINAPI*)(COORD, HANDLE, HANDLE, DWORD, void**);
+using ClosePseudoConsoleFn = void(WINAPI*)(void*);
+struct ConPty {
+    CreatePseudoConsoleFn create;
+    ClosePseudoConsoleFn close;
+};
+const ConPty& conPty() {
+    static const ConPty api = [] {
+        HMODULE k = GetModuleHandleW(L"kernel32.dll");
+        ConPty a{};
+        a.create = (CreatePseudoConsoleFn)GetProcAddress(k, "CreatePseudoConsole");
+        a.close = (ClosePseudoConsoleFn)GetProcAddress(k, "ClosePseudoConsole");
+        if (!a.create || !a.close) a = ConPty{};
+        return a;
+    }();
+    return api;
+}
+}
 
 static inline void appendQuoted(std::wstringstream& ss, const std::wstring& s) {
     ss << L'"';
@@ -13,21 +42,106 @@ std::wstring ProcessRunner::buildCmdLine(const ProcessOptions& opt) {
 }
 void ProcessRunner::closeHandleSafe(HANDLE& h) { if (h && h != INVALID_HANDLE_VALUE) { CloseHandle(h); h = nullptr; } }
 
+// Pipes in both directions, the console on top; outWrite/the input read end belong to the console after this
+bool ProcessRunner::openPseudoConsole(const ProcessOptions& opt, HANDLE& outWrite) {
+    if (!conPty().create) return false;
+    HANDLE inRead = nullptr;
+    if (!CreatePipe(&inRead, &ptyInput_, nullptr, 0)) return false;
+    if (!CreatePipe(&outRead_, &outWrite, nullptr, 64 * 1024)) { closeHandleSafe(inRead); closeHandleSafe(ptyInput_); return false; }
+    const HRESULT hr = conPty().create(COORD{ opt.ptyColumns, opt.ptyRows }, inRead, outWrite, 0, &pty_);
+    closeHandleSafe(inRead);   // the console has its own copies
+    closeHandleSafe(outWrite);
+    if (!SUCCEEDED(hr)) {
+        pty_ = nullptr;
+        closeHandleSafe(outRead_);
+        closeHandleSafe(ptyInput_);
+        return false;
+    }
+    return true;
+}
+
+// Also ends the reader: the console's output pipe closes once it is gone. The reader must still be
+// draining that pipe here, or closing can block on a full pipe.
+void ProcessRunner::closePseudoConsole() {
+    if (pty_) conPty().close(pty_);
+    pty_ = nullptr;
+    closeHandleSafe(ptyInput_);
+}
+
 ProcessRunner::ProcessRunner() { ZeroMemory(&pi_, sizeof(pi_)); job_ = CreateJobObjectW(nullptr, nullptr); }
 ProcessRunner::~ProcessRunner() { stop(); closeHandleSafe(job_); }
 
-bool ProcessRunner::start(const ProcessOptions& opt, std::wstring* lastError) {
+bool ProcessRunner::start(const ProcessOptions& opt, std::wstring* lastError, OutputHandler onOutput) {
     stop();
-    STARTUPINFOW si{}; si.cb = sizeof(si);
+    STARTUPINFOEXW six{};
+    STARTUPINFOW& si = six.StartupInfo;
+    si.cb = sizeof(si);
     if (opt.hidden) { si.dwFlags |= STARTF_USESHOWWINDOW; si.wShowWindow = SW_HIDE; }
     std::wstring cmd = buildCmdLine(opt);
     std::wstring work = opt.workingDir;
 
-    BOOL ok = CreateProcessW(opt.exe.c_str(), cmd.data(), nullptr, nullptr,
-        opt.inheritHandles ? TRUE : FALSE,
-        CREATE_UNICODE_ENVIRONMENT | (opt.hidden ? CREATE_NO_WINDOW : 0),
-        nullptr, work.empty() ? nullptr : work.c_str(), &si, &pi_);
+    HANDLE outWrite = nullptr;
+    HANDLE inherited[2]{};     // the only handles the child gets (bInheritHandles alone would pass all of ours)
+    DWORD nInherited = 0;
+    if (opt.captureOutput && opt.pseudoConsole && openPseudoConsole(opt, outWrite)) {
+        // nothing to inherit: the console hands the child its own handles
+    }
+    else if (opt.captureOutput) {
+        SECURITY_ATTRIBUTES sa{ sizeof(sa), nullptr, TRUE };
+        if (!CreatePipe(&outRead_, &outWrite, &sa, 64 * 1024)) {
+            if (lastError) *lastError = L"CreatePipe failed";
+            return false;
+        }
+        SetHandleInformation(outRead_, HANDLE_FLAG_INHERIT, 0);   // only the write end goes to the child
+        si.dwFlags |= STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = outWrite;
+        si.hStdError = outWrite;
+        inherited[nInherited++] = outWrite;
+        DWORD inFlags = 0;   // a GUI usually has no stdin; the list may only name inheritable handles
+        if (si.hStdInput && si.hStdInput != INVALID_HANDLE_VALUE && GetHandleInformation(si.hStdInput, &inFlags) &&
+            (inFlags & HANDLE_FLAG_INHERIT))
+            inherited[nInherited++] = si.hStdInput;
+    }
+
+    // attribute list: the pseudo console, or the handle list (unless the caller asked to inherit everything)
+    const bool handleList = nInherited && !opt.inheritHandles;
+    std::vector<char> attrs;
+    if (pty_ || handleList) {
+        SIZE_T size = 0;
+        InitializeProcThreadAttributeList(nullptr, 1, 0, &size);
+        attrs.resize(size);
+        six.lpAttributeList = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attrs.data());
+        const bool ok = InitializeProcThreadAttributeList(six.lpAttributeList, 1, 0, &size) &&
+            (pty_ ? UpdateProcThreadAttribute(six.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_PSEUDOCONSOLE, pty_, sizeof(pty_), nullptr, nullptr)
+                  : UpdateProcThreadAttribute(six.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inherited,
+                        nInherited * sizeof(HANDLE), nullptr, nullptr));
+        if (!ok) {
+            if (lastError) *lastError = pty_ ? L"cannot attach the pseudo console" : L"cannot set up handle inheritance";
+            if (six.lpAttributeList) DeleteProcThreadAttributeList(six.lpAttributeList);
+            closePseudoConsole();
+            closeHandleSafe(outWrite);
+            closeHandleSafe(outRead_);
+            return false;
+        }
+        si.cb = sizeof(six);
+    }
+
+    DWORD flags = CREATE_UNICODE_ENVIRONMENT;
+    if (six.lpAttributeList) flags |= EXTENDED_STARTUPINFO_PRESENT;
+    if (opt.hidden && !pty_) flags |= CREATE_NO_WINDOW;   // the console is windowless; CREATE_NO_WINDOW would detach from it
+    if (opt.detached) flags |= CREATE_BREAKAWAY_FROM_JOB;   // in case the GUI itself runs in a job
+    const BOOL inherit = (opt.inheritHandles || nInherited) ? TRUE : FALSE;
+    BOOL ok = CreateProcessW(opt.exe.c_str(), cmd.data(), nullptr, nullptr, inherit,
+        flags, nullptr, work.empty() ? nullptr : work.c_str(), &si, &pi_);
+    if (!ok && opt.detached && GetLastError() == ERROR_ACCESS_DENIED)   // that job forbids breakaway
+        ok = CreateProcessW(opt.exe.c_str(), cmd.data(), nullptr, nullptr, inherit,
+            flags & ~CREATE_BREAKAWAY_FROM_JOB, nullptr, work.empty() ? nullptr : work.c_str(), &si, &pi_);
+    closeHandleSafe(outWrite);   // the child holds its own copy; EOF arrives once it (and its children) exit
+    if (six.lpAttributeList) DeleteProcThreadAttributeList(six.lpAttributeList);
     if (!ok) {
+        closePseudoConsole();
+        closeHandleSafe(outRead_);
         if (lastError) {
             DWORD e = GetLastError(); wchar_t* buf = nullptr;
             FormatMessageW(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
@@ -36,13 +150,69 @@ bool ProcessRunner::start(const ProcessOptions& opt, std::wstring* lastError) {
         }
         ZeroMemory(&pi_, sizeof(pi_)); return false;
     }
-    if (job_) AssignProcessToJobObject(job_, pi_.hProcess);
+    if (job_ && !opt.detached) AssignProcessToJobObject(job_, pi_.hProcess);
+    if (outRead_) {
+        readerDone_ = false;
+        reader_ = std::thread(&ProcessRunner::readLoop, this, std::move(onOutput));
+    }
     return true;
 }
+bool ProcessRunner::attach(DWORD pid, uint64_t createdAt) {
+    stop();
+    HANDLE h = OpenProcess(PROCESS_TERMINATE | PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, pid);
+    if (!h) return false;
+    pi_.hProcess = h;
+    pi_.dwProcessId = pid;
+    if (running() && createdAt == this->createdAt()) return true;
+    release();
+    return false;
+}
+void ProcessRunner::release() {
+    closePseudoConsole();
+    joinReader();
+    closeHandleSafe(pi_.hThread);
+    closeHandleSafe(pi_.hProcess);
+    ZeroMemory(&pi_, sizeof(pi_));
+}
+HANDLE ProcessRunner::takeProcess() {
+    HANDLE h = pi_.hProcess;
+    pi_.hProcess = nullptr;
+    release();
+    return h;
+}
+bool ProcessRunner::wait(DWORD ms) const {
+    return !pi_.hProcess || WaitForSingleObject(pi_.hProcess, ms) == WAIT_OBJECT_0;
+}
+uint64_t ProcessRunner::createdAt() const {
+    FILETIME created{}, exited{}, kernel{}, user{};
+    if (!pi_.hProcess || !GetProcessTimes(pi_.hProcess, &created, &exited, &kernel, &user)) return 0;
+    return (uint64_t)created.dwHighDateTime << 32 | created.dwLowDateTime;
+}
+void ProcessRunner::readLoop(OutputHandler onOutput) {
+    char buf[64 * 1024];
+    DWORD n = 0;
+    while (ReadFile(outRead_, buf, sizeof(buf), &n, nullptr) && n)
+        if (onOutput) onOutput(buf, n);
+    if (onOutput) onOutput(nullptr, 0);   // EOF (or cancelled by stop())
+    readerDone_ = true;
+}
+void ProcessRunner::joinReader() {
+    if (!reader_.joinable()) return;
+    // A grandchild that inherited the write end keeps the pipe open after we kill openvpn,
+    // so break the blocking ReadFile instead of waiting for EOF.
+    for (int i = 0; !readerDone_ && i < 300; ++i) {
+        CancelSynchronousIo((HANDLE)reader_.native_handle());
+        Sleep(10);
+    }
+    reader_.join();
+    closeHandleSafe(outRead_);
+}
 void ProcessRunner::stop(DWORD code) {
-    if (!pi_.hProcess) return;
+    if (!pi_.hProcess) { closePseudoConsole(); joinReader(); return; }
     TerminateProcess(pi_.hProcess, code);
     WaitForSingleObject(pi_.hProcess, 3000);
+    closePseudoConsole();
+    joinReader();
     closeHandleSafe(pi_.hThread);
     closeHandleSafe(pi_.hProcess);
     ZeroMemory(&pi_, sizeof(pi_));
@@ -1,21 +1,45 @@
 #pragma once
 #include <windows.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <string>
+#include <thread>
 #include "ProcessOptions.h"
 
 class ProcessRunner {
 public:
+    // raw output chunks, called on the reader thread; a final call with len 0 marks EOF
+    using OutputHandler = std::function<void(const char* data, size_t len)>;
+
     ProcessRunner();
     ~ProcessRunner();
 
-    bool start(const ProcessOptions& opt, std::wstring* lastError = nullptr);
+    bool start(const ProcessOptions& opt, std::wstring* lastError = nullptr, OutputHandler onOutput = {});
+    // Takes over a detached child started by an earlier run; createdAt (see below) guards against a
+    // reused pid. No output pipe: the caller talks to the child some other way.
+    bool attach(DWORD pid, uint64_t createdAt);
+    void release();                      // forgets the child without stopping it
+    HANDLE takeProcess();                // release(), handing the caller the process handle (or nullptr)
+    bool wait(DWORD ms) const;           // true once the child has exited
     void stop(DWORD exitCode = 0);
     bool running() const;
     DWORD pid() const { return pi_.dwProcessId; }
+    uint64_t createdAt() const;          // process creation time (FILETIME ticks), 0 without a child
+    bool pseudoConsole() const { return pty_ != nullptr; }   // output comes through a ConPTY
 
 private:
     PROCESS_INFORMATION pi_{};
     HANDLE job_{ nullptr };
+    HANDLE outRead_{ nullptr };
+    void* pty_{ nullptr };               // HPCON
+    HANDLE ptyInput_{ nullptr };         // the console's input; held open so it stays alive
+    std::thread reader_;
+    std::atomic<bool> readerDone_{ true };
+    void readLoop(OutputHandler onOutput);
+    void joinReader();
+    bool openPseudoConsole(const ProcessOptions& opt, HANDLE& outWrite);
+    void closePseudoConsole();
     static std::wstring buildCmdLine(const ProcessOptions& opt);
     static void closeHandleSafe(HANDLE& h);
 };
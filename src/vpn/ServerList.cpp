@@ -0,0 +1,163 @@
+#include "ServerList.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <windows.h>
+
+static std::string trim(const char* b, const char* e) {
+    while (b < e && (*b == ' ' || *b == '\t')) ++b;
+    while (e > b && (e[-1] == ' ' || e[-1] == '\t' || e[-1] == '\r' || e[-1] == '\n')) --e;
+    return std::string(b, e);
+}
+
+// Splits one CSV line into five or six fields (no quoting: names and hosts never contain commas)
+static bool parseLine(const char* line, ServerEntry& e, const char*& why) {
+    std::string f[6];
+    const char* p = line;
+    for (int k = 0; k < 6; ++k) {
+        const char* comma = std::strchr(p, ',');
+        if (!comma && k < 4) { why = "expected name,host,port,lat,lon[,proto]"; return false; }
+        if (!comma) comma = p + std::strlen(p);
+        else if (k == 5) { why = "too many fields"; return false; }
+        f[k] = trim(p, comma);
+        if (!*comma) break;
+        p = comma + 1;
+    }
+    if (f[1].empty()) { why = "empty host"; return false; }
+    char* end = nullptr;
+    long port = std::strtol(f[2].c_str(), &end, 10);
+    if (*end || port <= 0 || port > 65535) { why = "bad port"; return false; }
+    double lat = std::strtod(f[3].c_str(), &end);
+    if (*end || f[3].empty() || lat < -90 || lat > 90) { why = "bad latitude"; return false; }
+    double lon = std::strtod(f[4].c_str(), &end);
+    if (*end || f[4].empty() || lon < -180 || lon > 180) { why = "bad longitude"; return false; }
+    if (!f[5].empty() && f[5].compare(0, 3, "udp") != 0 && f[5].compare(0, 3, "tcp") != 0) { why = "bad proto"; return false; }
+    e.name = f[0].empty() ? f[1] : f[0];
+    e.host = f[1];
+    e.port = (uint16_t)port;
+    e.lat = (float)lat;
+    e.lon = (float)lon;
+    e.tcp = f[5].compare(0, 3, "tcp") == 0;
+    return true;
+}
+
+bool LoadServerList(const std::string& path, std::vector<ServerEntry>& out, std::string& err) {
+    out.clear();
+    std::FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) { err = "cannot open " + path; return false; }
+    char line[1024];
+    int lineNo = 0;
+    ServerEntry e;
+    while (std::fgets(line, sizeof(line), f)) {
+        ++lineNo;
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || !*p) continue;
+        const char* why = "";
+        if (!parseLine(p, e, why)) {
+            err = path + ":" + std::to_string(lineNo) + ": " + why;
+            out.clear();
+            std::fclose(f);
+            return false;
+        }
+        out.push_back(e);
+    }
+    std::fclose(f);
+    return true;
+}
+
+void MakeDemoServers(size_t n, uint32_t seed, std::vector<ServerEntry>& out) {
+    struct City { const char* code; float lat, lon; };
+    static const City kCities[] = {
+        { "us-nyc", 40.7f, -74.0f }, { "us-lax", 34.1f, -118.2f }, { "us-chi", 41.9f, -87.6f }, { "us-dal", 32.8f, -96.8f },
+        { "ca-tor", 43.7f, -79.4f }, { "mx-mex", 19.4f, -99.1f }, { "br-sao", -23.6f, -46.6f }, { "ar-bue", -34.6f, -58.4f },
+        { "uk-lon", 51.5f, -0.1f }, { "de-fra", 50.1f, 8.7f }, { "fr-par", 48.9f, 2.4f }, { "nl-ams", 52.4f, 4.9f },
+        { "se-sto", 59.3f, 18.1f }, { "es-mad", 40.4f, -3.7f }, { "it-mil", 45.5f, 9.2f }, { "pl-waw", 52.2f, 21.0f },
+        { "tr-ist", 41.0f, 29.0f }, { "ae-dxb", 25.2f, 55.3f }, { "in-bom", 19.1f, 72.9f }, { "sg-sin", 1.35f, 103.8f },
+        { "jp-tok", 35.7f, 139.7f }, { "kr-sel", 37.6f, 127.0f }, { "hk-hkg", 22.3f, 114.2f }, { "tw-tpe", 25.0f, 121.6f },
+        { "au-syd", -33.9f, 151.2f }, { "au-mel", -37.8f, 145.0f }, { "nz-akl", -36.8f, 174.8f }, { "za-jnb", -26.2f, 28.0f },
+        { "ng-los", 6.5f, 3.4f }, { "eg-cai", 30.0f, 31.2f }, { "ke-nbo", -1.3f, 36.8f }, { "cl-scl", -33.4f, -70.6f },
+    };
+    constexpr size_t kCityCount = sizeof(kCities) / sizeof(kCities[0]);
+    uint32_t s = seed ? seed : 1;
+    auto next = [&s] { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; };   // xorshift32
+    auto unit = [&] { return (next() >> 8) * (1.0f / 16777216.0f); };
+
+    out.clear();
+    out.reserve(n);
+    unsigned perCity[kCityCount] = {};
+    char buf[64];
+    for (size_t i = 0; i < n; ++i) {
+        const size_t ci = next() % kCityCount;
+        const City& c = kCities[ci];
+        ServerEntry e;
+        // scatter within a few degrees of the city; most providers run many nodes per metro
+        const float r = 4.0f * unit() * unit(), a = 6.2831853f * unit();
+        e.lat = std::fmax(-89.0f, std::fmin(89.0f, c.lat + r * std::sin(a)));
+        e.lon = std::fmax(-179.9f, std::fmin(179.9f, c.lon + r * std::cos(a)));
+        std::snprintf(buf, sizeof(buf), "%s-%03u", c.code, ++perCity[ci]);
+        e.name = buf;
+        e.host = e.name + ".demo.invalid";   // reserved TLD: never resolves
+        e.port = 1194;
+        e.tcp = true;                        // the demo pretends to probe every endpoint
+        out.push_back(std::move(e));
+    }
+}
+
+size_t ListProfiles(const std::wstring& dir, std::vector<std::wstring>& paths, std::vector<std::string>& names) {
+    paths.clear();
+    names.clear();
+    std::wstring base = dir;
+    if (!base.empty() && base.back() != L'\\' && base.back() != L'/') base += L'\\';
+    WIN32_FIND_DATAW fd;
+    HANDLE h = FindFirstFileW((base + L"*.ovpn").c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        const int wlen = (int)wcslen(fd.cFileName) - 5;   // without ".ovpn"
+        if (wlen <= 0) continue;
+        const int n = WideCharToMultiByte(CP_UTF8, 0, fd.cFileName, wlen, nullptr, 0, nullptr, nullptr);
+        std::string name(n, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, fd.cFileName, wlen, name.data(), n, nullptr, nullptr);
+        paths.push_back(base + fd.cFileName);
+        names.push_back(std::move(name));
+    } while (FindNextFileW(h, &fd));
+    FindClose(h);
+    return paths.size();
+}
+
+bool ReadProfileRemotes(const std::wstring& path, std::vector<ProfileRemote>& out) {
+    std::ifstream in{ std::filesystem::path(path) };
+    if (!in) return false;
+    const size_t first = out.size();
+    uint16_t defaultPort = 1194;
+    std::string defaultProto;
+    std::string line, key;
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        if (!(ss >> key) || key[0] == '#' || key[0] == ';') continue;
+        if (key == "port") {
+            unsigned p = 0;
+            if (ss >> p && p && p <= 0xFFFF) defaultPort = (uint16_t)p;
+        }
+        else if (key == "proto") ss >> defaultProto;
+        else if (key == "remote") {
+            ProfileRemote r;
+            unsigned p = 0;
+            if (!(ss >> r.host)) continue;
+            r.port = 0;
+            if (ss >> p && p <= 0xFFFF) r.port = (uint16_t)p;
+            ss >> r.proto;
+            out.push_back(std::move(r));
+        }
+    }
+    for (size_t i = first; i < out.size(); ++i) {   // "port"/"proto" may come after the remotes
+        if (!out[i].port) out[i].port = defaultPort;
+        if (out[i].proto.empty()) out[i].proto = defaultProto;
+    }
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --------- VPN endpoint list ----------
+// Candidate servers shown on the map and probed for latency. Loaded from a CSV file
+// (--servers FILE), one endpoint per line:
+//     name,host,port,latitude,longitude[,proto]
+// proto is udp (the default, as in OpenVPN) or tcp; only TCP endpoints can be probed with a plain
+// connect(), so UDP ones are shown as not probed. Blank lines and lines starting with '#' are skipped.
+struct ServerEntry {
+    std::string name;
+    std::string host;
+    uint16_t port{ 0 };
+    float lat{ 0 }, lon{ 0 };   // degrees
+    bool tcp{ false };          // proto column: tcp / tcp-client / tcp4 ...; otherwise UDP
+};
+
+// false with err = "<path>:<line>: reason" on the first malformed line; out holds nothing then
+bool LoadServerList(const std::string& path, std::vector<ServerEntry>& out, std::string& err);
+// --map-demo N: n made-up endpoints clustered around real city locations (deterministic for a seed).
+// Hosts are under .invalid, so real probes fail; the demo feeds made-up latencies instead.
+void MakeDemoServers(size_t n, uint32_t seed, std::vector<ServerEntry>& out);
+
+// --profiles DIR: the .ovpn files directly in dir (not recursive). paths gets full paths for
+// OpenVpnConfig::ovpnFile, names the file names without ".ovpn" in UTF-8 for the profile finder.
+size_t ListProfiles(const std::wstring& dir, std::vector<std::wstring>& paths, std::vector<std::string>& names);
+
+// "remote host [port] [proto]" lines of an .ovpn profile, in file order, including those inside
+// <connection> blocks; port/proto default to the profile's "port"/"proto" lines (1194, unset).
+struct ProfileRemote {
+    std::string host;
+    uint16_t port{ 1194 };
+    std::string proto;   // empty = no "proto" line either (openvpn then uses udp)
+};
+bool ReadProfileRemotes(const std::wstring& path, std::vector<ProfileRemote>& out);   // appends
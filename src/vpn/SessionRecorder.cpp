@@ -0,0 +1,97 @@
+#include "SessionRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const char kMagic[8] = { 'O', 'V', 'P', 'N', 'R', 'E', 'C', 1 };
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void putVarint(std::FILE* f, uint64_t v) {
+    while (v >= 0x80) { std::fputc((int)(v | 0x80) & 0xFF, f); v >>= 7; }
+    std::fputc((int)v, f);
+}
+
+static bool getVarint(std::FILE* f, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int c = std::fgetc(f);
+        if (c == EOF) return false;
+        v |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+bool SessionRecorder::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lk(mu_);
+    f_ = std::fopen(path.c_str(), "wb");
+    if (!f_) return false;
+    io_.resize(256 * 1024);
+    std::setvbuf(f_, io_.data(), _IOFBF, io_.size());
+    std::fwrite(kMagic, 1, sizeof(kMagic), f_);
+    lastNs_ = steadyNs();
+    events_ = 0;
+    return true;
+}
+
+void SessionRecorder::close() {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (f_) { std::fclose(f_); f_ = nullptr; }
+}
+
+bool SessionRecorder::recording() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return f_ != nullptr;
+}
+
+uint64_t SessionRecorder::events() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return events_;
+}
+
+void SessionRecorder::record(SessionEvent kind, const char* data, size_t len) {
+    std::lock_guard<std::mutex> lk(mu_);
+    if (!f_) return;
+    int64_t now = steadyNs();   // taken under the lock so deltas never go negative
+    putVarint(f_, (uint64_t)(now - lastNs_));
+    lastNs_ = now;
+    len = std::min(len, kMaxEvent);
+    std::fputc((int)kind, f_);
+    putVarint(f_, len);
+    std::fwrite(data, 1, len, f_);
+    ++events_;
+}
+
+bool SessionReader::open(const std::string& path) {
+    close();
+    f_ = std::fopen(path.c_str(), "rb");
+    if (!f_) return false;
+    char magic[sizeof(kMagic)];
+    if (std::fread(magic, 1, sizeof(magic), f_) != sizeof(magic) || std::memcmp(magic, kMagic, sizeof(magic)) != 0) {
+        close();
+        return false;
+    }
+    ns_ = 0;
+    return true;
+}
+
+void SessionReader::close() {
+    if (f_) { std::fclose(f_); f_ = nullptr; }
+}
+
+bool SessionReader::next(Event& ev) {
+    uint64_t dt = 0, len = 0;
+    if (!f_ || !getVarint(f_, dt)) return false;
+    int kind = std::fgetc(f_);
+    if (kind == EOF || !getVarint(f_, len) || len > SessionRecorder::kMaxEvent) return false;
+    ev.data.resize((size_t)len);
+    if (len && std::fread(&ev.data[0], 1, (size_t)len, f_) != len) return false;
+    ns_ += (int64_t)dt;
+    ev.ns = ns_;
+    ev.kind = (SessionEvent)kind;
+    return true;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// --------- session recording ----------
+// Everything OpenVpnRunner receives from the child (raw output chunks, management lines, process
+// state messages) with its receive time, so a session can be replayed later. File layout:
+//   "OVPNREC" 0x01, then per event: LEB128 ns since the previous event, kind byte, LEB128 length, bytes.
+// Events go through a 256 KB stdio buffer, so a crash loses up to that much of the tail; what did
+// reach the file is still readable and ends at its last complete event. An event is at most
+// kMaxEvent bytes: record() cuts longer ones, and SessionReader treats a larger length as the end.
+
+enum class SessionEvent : uint8_t { Output = 1, Management = 2, State = 3 };
+
+class SessionRecorder {
+public:
+    static constexpr size_t kMaxEvent = 1 << 20;   // child output comes in 64 KB reads, lines are far shorter
+
+    ~SessionRecorder() { close(); }
+
+    bool open(const std::string& path);
+    void close();
+    bool recording() const;
+    void record(SessionEvent kind, const char* data, size_t len);   // any thread
+    uint64_t events() const;
+
+private:
+    mutable std::mutex mu_;
+    std::FILE* f_{ nullptr };
+    int64_t lastNs_{ 0 };
+    uint64_t events_{ 0 };
+    std::vector<char> io_;   // stdio buffer, events are small and frequent
+};
+
+class SessionReader {
+public:
+    struct Event {
+        int64_t ns{ 0 };     // since the start of the recording
+        SessionEvent kind{ SessionEvent::Output };
+        std::string data;
+    };
+
+    ~SessionReader() { close(); }
+    bool open(const std::string& path);
+    void close();
+    bool next(Event& ev);    // false at the end (or at a truncated or corrupt tail)
+
+private:
+    std::FILE* f_{ nullptr };
+    int64_t ns_{ 0 };
+};
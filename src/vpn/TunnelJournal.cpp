@@ -0,0 +1,115 @@
+#include "TunnelJournal.h"
+#include "../core/Utf8.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace {
+constexpr uint32_t kMagic = 0x4C4E5554;   // "TUNL"
+constexpr uint32_t kVersion = 1;
+}
+
+struct TunnelJournal::Record {
+    uint32_t magic, version;
+    uint32_t pid;
+    uint16_t managementPort, remotePort;
+    uint64_t createdAt;
+    int64_t startedUnix;
+    int32_t verb;
+    uint32_t stateLen;
+    uint64_t bytesIn, bytesOut;        // 8-byte aligned: a store never tears
+    char state[32];
+    wchar_t profile[520];
+    wchar_t remoteHost[256];
+};
+
+template <size_t N>
+static void copyWide(wchar_t (&dst)[N], const std::wstring& src) {
+    const size_t n = std::min(src.size(), N - 1);
+    std::memcpy(dst, src.data(), n * sizeof(wchar_t));
+    dst[n] = 0;
+}
+
+bool TunnelJournal::open(const std::wstring& path, std::string& err) {
+    close();
+    file_ = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) { err = "cannot open " + WideToUtf8(path); return false; }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READWRITE, 0, sizeof(Record), nullptr);   // grows the file
+    if (mapping_) rec_ = static_cast<Record*>(MapViewOfFile(mapping_, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(Record)));
+    if (!rec_) { err = "cannot map " + WideToUtf8(path); close(); return false; }
+    if (rec_->magic != kMagic || rec_->version != kVersion) {   // new file (zero-filled) or an older layout
+        std::memset(rec_, 0, sizeof(Record));
+        rec_->magic = kMagic;
+        rec_->version = kVersion;
+    }
+    return true;
+}
+
+void TunnelJournal::close() {
+    if (rec_) UnmapViewOfFile(rec_);
+    rec_ = nullptr;
+    if (mapping_) CloseHandle(mapping_);
+    mapping_ = nullptr;
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+}
+
+bool TunnelJournal::read(TunnelInfo& out) const {
+    if (!rec_ || !rec_->pid) return false;
+    out.pid = rec_->pid;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    out.createdAt = rec_->createdAt;
+    out.managementPort = rec_->managementPort;
+    out.verb = rec_->verb;
+    out.startedUnix = rec_->startedUnix;
+    out.bytesIn = rec_->bytesIn;
+    out.bytesOut = rec_->bytesOut;
+    out.state.assign(rec_->state, std::min<size_t>(rec_->stateLen, sizeof(rec_->state)));
+    out.profile.assign(rec_->profile, wcsnlen(rec_->profile, 520));
+    out.remoteHost.assign(rec_->remoteHost, wcsnlen(rec_->remoteHost, 256));
+    out.remotePort = rec_->remotePort;
+    return true;
+}
+
+void TunnelJournal::begin(const TunnelInfo& t) {
+    if (!rec_) return;
+    rec_->pid = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+    rec_->createdAt = t.createdAt;
+    rec_->managementPort = t.managementPort;
+    rec_->verb = t.verb;
+    rec_->startedUnix = t.startedUnix;
+    rec_->bytesIn = t.bytesIn;
+    rec_->bytesOut = t.bytesOut;
+    rec_->stateLen = 0;
+    copyWide(rec_->profile, t.profile);
+    copyWide(rec_->remoteHost, t.remoteHost);
+    rec_->remotePort = t.remotePort;
+    std::atomic_thread_fence(std::memory_order_release);
+    rec_->pid = t.pid;
+    FlushViewOfFile(rec_, sizeof(Record));   // rare; the identity should survive a power cut too
+}
+
+void TunnelJournal::end() {
+    if (!rec_) return;
+    rec_->pid = 0;
+    FlushViewOfFile(rec_, sizeof(Record));
+}
+
+void TunnelJournal::setState(std::string_view state) {
+    if (!rec_) return;
+    const size_t n = std::min(state.size(), sizeof(rec_->state));
+    std::memcpy(rec_->state, state.data(), n);
+    rec_->stateLen = (uint32_t)n;
+}
+
+void TunnelJournal::setVerb(int verb) {
+    if (rec_) rec_->verb = verb;
+}
+
+void TunnelJournal::setCounters(uint64_t in, uint64_t out) {
+    if (!rec_) return;
+    rec_->bytesIn = in;
+    rec_->bytesOut = out;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// --------- detached tunnel journal ----------
+// A detached openvpn.exe outlives the GUI. Its identity (pid + creation time, management port,
+// profile) and its latest state and byte counters live in one small memory-mapped file, so the
+// next GUI run can find the child and re-attach instead of reconnecting. Updates are plain stores
+// into the mapping: nothing is lost when the GUI crashes, only a machine crash can drop the tail.
+// One writer (the GUI owning the tunnel); pid is written last on begin() and cleared first on end(),
+// so a reader never sees a half-written identity. The file decides which process Stop terminates, so
+// it belongs in the per-user directory (PrivateDir.h) and is opened without write sharing.
+struct TunnelInfo {
+    uint32_t pid{ 0 };                 // 0 = no tunnel recorded
+    uint64_t createdAt{ 0 };           // process creation time, tells a reused pid apart
+    uint16_t managementPort{ 0 };
+    int verb{ 3 };
+    int64_t startedUnix{ 0 };          // seconds
+    uint64_t bytesIn{ 0 }, bytesOut{ 0 };
+    std::string state;                 // last >STATE name, e.g. CONNECTED
+    std::wstring profile;              // .ovpn path
+    std::wstring remoteHost;           // --remote override, empty = the profile's remotes
+    uint16_t remotePort{ 0 };
+};
+
+class TunnelJournal {
+public:
+    TunnelJournal() = default;
+    TunnelJournal(const TunnelJournal&) = delete;
+    TunnelJournal& operator=(const TunnelJournal&) = delete;
+    ~TunnelJournal() { close(); }
+
+    bool open(const std::wstring& path, std::string& err);   // creates the file if needed
+    void close();
+    bool isOpen() const { return rec_ != nullptr; }
+
+    bool read(TunnelInfo& out) const;                 // false when no tunnel is recorded
+    void begin(const TunnelInfo& t);                  // a detached tunnel started
+    void end();                                       // it stopped; the record is cleared
+    void setState(std::string_view state);            // management thread
+    void setCounters(uint64_t in, uint64_t out);      // management thread
+    void setVerb(int verb);                           // runtime changes, restored on re-attach
+
+private:
+    struct Record;   // file layout, TunnelJournal.cpp
+
+    HANDLE file_{ INVALID_HANDLE_VALUE };
+    HANDLE mapping_{ nullptr };
+    Record* rec_{ nullptr };
+};
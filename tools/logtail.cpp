@@ -0,0 +1,70 @@
+// logtail: follows the VPN GUI's log from another process. The GUI must run with --log-share
+// (or --log-share-name NAME); this maps its ring read-only, so it never slows the GUI down.
+//   logtail [-n LINES] [-f] [NAME]
+//     -n LINES  start this many lines back (default 20, 0 = only new lines)
+//     -f        keep following; otherwise exit once caught up
+#include <windows.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include "log/LogShare.h"
+
+static void print(const std::string& line, int64_t unixNs) {
+    const std::time_t t = (std::time_t)(unixNs / 1000000000);
+    const std::tm* tm = std::localtime(&t);
+    char stamp[16] = "??:??:??";
+    if (tm) std::strftime(stamp, sizeof(stamp), "%H:%M:%S", tm);
+    std::printf("%s.%03d %s\n", stamp, (int)(unixNs / 1000000 % 1000), line.c_str());
+}
+
+int main(int argc, char** argv) {
+    const char* name = LogShare::kDefaultName;
+    long long backlog = 20;
+    bool follow = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-f") == 0) follow = true;
+        else if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) backlog = std::atoll(argv[++i]);
+        else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "usage: logtail [-n LINES] [-f] [NAME]   (default NAME %s)\n", LogShare::kDefaultName);
+            return 2;
+        }
+        else name = argv[i];
+    }
+
+    LogShareReader reader;
+    std::string err;
+    if (!reader.open(name, err)) { std::fprintf(stderr, "logtail: %s\n", err.c_str()); return 1; }
+    if (backlog > 0) reader.rewind((uint64_t)backlog);
+
+    std::string line;
+    int64_t unixNs = 0;
+    uint64_t lost = 0;
+    uint32_t epoch = reader.epoch();
+    bool writerGone = false;
+    for (;;) {
+        bool any = false;
+        while (reader.next(line, unixNs)) {
+            if (reader.lost() != lost) {   // this reader fell a whole ring behind
+                std::printf("[logtail] %llu slots overwritten before they were read\n", (unsigned long long)(reader.lost() - lost));
+                lost = reader.lost();
+            }
+            print(line, unixNs);
+            any = true;
+        }
+        if (!follow) break;
+        if (reader.epoch() != epoch) {
+            epoch = reader.epoch();
+            writerGone = false;
+            std::printf("[logtail] the GUI restarted (pid %u)\n", reader.writerPid());
+        }
+        else if (!writerGone && !reader.writerPid()) {
+            writerGone = true;
+            std::printf("[logtail] the GUI closed the log; waiting for it to come back\n");
+        }
+        std::fflush(stdout);
+        if (!any) Sleep(20);   // idle: poll the ring 50 times a second
+    }
+    return 0;
+}